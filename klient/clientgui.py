@@ -72,6 +72,7 @@ class ClientGUI:
         # Pomocné proměnné
         self.discard = ""
         self.sequence_list = []
+        self.sequence_ids = []
         self.seq_existing = False
         self.enemy_hand_count = 0
         self.results = dict()
@@ -472,6 +473,7 @@ class ClientGUI:
 
                             sekvence = zprava[2]
                             self.sequence_list = sekvence.split(",")
+                            self.sequence_ids = zprava[5].split(",") if len(zprava) > 5 and zprava[5] else []
 
                             if len(sekvence) >= 1:
                                 self.seq_existing = True
@@ -544,6 +546,7 @@ class ClientGUI:
 
                             sekvence = zprava[2]
                             self.sequence_list = sekvence.split(",")
+                            self.sequence_ids = zprava[5].split(",") if len(zprava) > 5 and zprava[5] else []
 
                             if len(sekvence) >= 1:
                                 self.seq_existing = True
@@ -559,6 +562,7 @@ class ClientGUI:
                             self.room_owner = False
                             self.room_players_info.clear()
                             self.sequence_list = []
+                            self.sequence_ids = []
                             self.discard = ""
                         
                         elif type_msg == Message_types.ELIS.value:
@@ -620,6 +624,7 @@ class ClientGUI:
                             self.room_owner = False
                             self.room_players_info.clear()
                             self.sequence_list = []
+                            self.sequence_ids = []
                             self.discard = ""
                             self.room_status_ready = not self.room_status_ready
 
@@ -702,6 +707,7 @@ class ClientGUI:
 
                             sekvence = zprava[2]
                             self.sequence_list = sekvence.split(",")
+                            self.sequence_ids = zprava[5].split(",") if len(zprava) > 5 and zprava[5] else []
 
                             if len(sekvence) >= 1:
                                 self.seq_existing = True
@@ -765,6 +771,7 @@ class ClientGUI:
 
                             sekvence = zprava[2]
                             self.sequence_list = sekvence.split(",")
+                            self.sequence_ids = zprava[5].split(",") if len(zprava) > 5 and zprava[5] else []
 
                             if len(sekvence) >= 1:
                                 self.seq_existing = True
@@ -781,6 +788,7 @@ class ClientGUI:
 
                         elif type_msg == Message_types.STRT.value:
                             self.sequence_list = []
+                            self.sequence_ids = []
                             self.discard = False
                             self.game_console.delete()
                             self.game_state = GameState.IN_GAME
@@ -813,6 +821,7 @@ class ClientGUI:
 
                             sekvence = zprava[2]
                             self.sequence_list = sekvence.split(",")
+                            self.sequence_ids = zprava[5].split(",") if len(zprava) > 5 and zprava[5] else []
 
                             if len(sekvence) >= 1:
                                 self.seq_existing = True
@@ -1152,7 +1161,8 @@ class ClientGUI:
                                     self.game_console.log("Vybráno moc karet k přiložení", True)
 
                                 if selected:
-                                    prev_seq = item["seq_str"]
+                                    # ID postupky ze STAT, u starého serveru kódy karet
+                                    prev_seq = item["seq_id"] or item["seq_str"]
                                     new_card = selected[0]
 
                                     self.send_message(Message_types.ADDC.value, f"{prev_seq}|{new_card}")
@@ -291,9 +291,12 @@ class PageDrawer:
             total_width = 60 + (len(cards_in_seq) - 1) * x_offset_cards
             click_rect = pygame.Rect(current_x, current_y, total_width, 87)
 
+            sequence_ids = getattr(state, 'sequence_ids', [])
+
             state.sequence_rects.append({
                 "rect": click_rect,
-                "seq_str": seq_text
+                "seq_str": seq_text,
+                "seq_id": sequence_ids[seq_index] if seq_index < len(sequence_ids) else None
             })
 
             for i, card_code in enumerate(cards_in_seq):
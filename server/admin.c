@@ -0,0 +1,437 @@
+#include "admin.h"
+#include "metrics.h"
+#include "logger.h"
+#include "timer_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Rostoucí buffer odpovědi
+typedef struct{
+    char *data;
+    size_t len;
+    size_t cap;
+} AdminBuffer;
+
+static int admin_fd = -1;
+static int admin_wake_fd = -1;                  // eventfd pro ukončení (admin_stop)
+static pthread_t admin_worker;
+static AdminSnapshot admin_snapshot;            // Poslední zveřejněný snímek (jen správcovské vlákno)
+static MetricsSnapshot admin_metrics;           // Metriky ke stejnému okamžiku
+static uint64_t admin_started_ms = 0;
+
+static const char *player_status_names[PLAYER_STATUS_COUNT] = {
+    [DISCONNECTED] = "DISCONNECTED",
+    [CONNECTED] = "CONNECTED",
+    [IN_ROOM] = "IN_ROOM",
+    [ON_WAIT] = "ON_WAIT",
+    [ON_TURN] = "ON_TURN",
+    [PAUSED] = "PAUSED",
+    [GAME_DONE] = "GAME_DONE",
+};
+
+static const char *room_status_names[ROOM_STATUS_COUNT] = {
+    [ROOM_WAITING] = "WAITING",
+    [ROOM_READY] = "READY",
+    [ROOM_PLAYING] = "PLAYING",
+    [ROOM_FINISHED] = "FINISHED",
+};
+
+/**
+ * @brief Připíše formátovaný text do bufferu (při chybě alokace buffer zůstane, jak byl)
+ */
+static void admin_printf(AdminBuffer *buffer, const char *fmt, ...){
+    va_list args;
+
+    for(;;){
+        size_t space = buffer->cap - buffer->len;
+        va_start(args, fmt);
+        int written = vsnprintf(buffer->data ? buffer->data + buffer->len : NULL, space, fmt, args);
+        va_end(args);
+        if(written < 0){
+            return;
+        }
+        if((size_t)written < space){
+            buffer->len += (size_t)written;
+            return;
+        }
+
+        size_t cap = buffer->cap ? buffer->cap : ADMIN_BUFFER_MIN;
+        while(cap - buffer->len <= (size_t)written){
+            cap *= 2;
+        }
+        char *data = realloc(buffer->data, cap);
+        if(!data){
+            return;
+        }
+        buffer->data = data;
+        buffer->cap = cap;
+    }
+}
+
+/**
+ * @brief Sestaví nový snímek z počtů, které udržují vlastníci dat (tabulky klientů a místností se neprocházejí)
+ */
+static void admin_publish(void){
+    AdminSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    ClientGauges clients;
+    client_gauges(&clients);
+    memcpy(snapshot.clients, clients.status, sizeof(snapshot.clients));
+    snapshot.clients_reconnect_wait = clients.reconnect_wait;
+    snapshot.timers = clients.timers;
+
+    room_status_counts(snapshot.rooms);
+    outbound_stats(&snapshot.queues);
+
+    // games_mutex je listový a drží se jen při vydání / vrácení hry
+    game_pool_stats(&snapshot.games);
+    snapshot.log_dropped = log_dropped();
+    snapshot.published_ms = timer_now_ms();
+
+    metrics_snapshot(&admin_metrics);
+    admin_snapshot = snapshot;
+}
+
+/**
+ * @brief Prometheus text (verze 0.0.4)
+ */
+static void admin_render_metrics(AdminBuffer *out){
+    const AdminSnapshot *s = &admin_snapshot;
+
+    admin_printf(out, "# HELP zolik_clients Přihlášení klienti podle stavu\n# TYPE zolik_clients gauge\n");
+    for(int i = DISCONNECTED + 1; i < PLAYER_STATUS_COUNT; i++){
+        admin_printf(out, "zolik_clients{status=\"%s\"} %d\n", player_status_names[i], s->clients[i]);
+    }
+    admin_printf(out, "# HELP zolik_clients_reconnect_wait Odpojení klienti v lhůtě pro reconnect\n"
+                      "# TYPE zolik_clients_reconnect_wait gauge\nzolik_clients_reconnect_wait %d\n",
+                 s->clients_reconnect_wait);
+
+    admin_printf(out, "# HELP zolik_rooms Založené místnosti podle stavu\n# TYPE zolik_rooms gauge\n");
+    for(int i = 0; i < ROOM_STATUS_COUNT; i++){
+        admin_printf(out, "zolik_rooms{status=\"%s\"} %d\n", room_status_names[i], s->rooms[i]);
+    }
+
+    admin_printf(out, "# HELP zolik_games_active Rozehrané hry (GameInstance)\n# TYPE zolik_games_active gauge\n"
+                      "zolik_games_active %d\n", s->games.in_use);
+    admin_printf(out, "# HELP zolik_games_capacity Kapacita poolu her\n# TYPE zolik_games_capacity gauge\n"
+                      "zolik_games_capacity %d\n", s->games.capacity);
+    admin_printf(out, "# HELP zolik_games_high_water Nejvíc souběžných her od startu\n"
+                      "# TYPE zolik_games_high_water gauge\nzolik_games_high_water %d\n", s->games.high_water);
+    admin_printf(out, "# HELP zolik_games_exhausted_total Žádosti, na které pool her nestačil\n"
+                      "# TYPE zolik_games_exhausted_total counter\nzolik_games_exhausted_total %lu\n",
+                 s->games.exhausted);
+
+    admin_printf(out, "# HELP zolik_out_queue_bytes Neodeslané bajty v odchozích frontách\n"
+                      "# TYPE zolik_out_queue_bytes gauge\nzolik_out_queue_bytes %lu\n", s->queues.bytes);
+    admin_printf(out, "# HELP zolik_out_queue_frames Zprávy v odchozích frontách\n"
+                      "# TYPE zolik_out_queue_frames gauge\nzolik_out_queue_frames %lu\n", s->queues.frames);
+    admin_printf(out, "# HELP zolik_out_queue_peak_bytes Nejdelší odchozí fronta od startu\n"
+                      "# TYPE zolik_out_queue_peak_bytes gauge\nzolik_out_queue_peak_bytes %lu\n", s->queues.peak_bytes);
+    admin_printf(out, "# HELP zolik_out_queue_dropped_total Zprávy zahozené kvůli pomalým klientům\n"
+                      "# TYPE zolik_out_queue_dropped_total counter\nzolik_out_queue_dropped_total %lu\n",
+                 s->queues.dropped);
+    admin_printf(out, "# HELP zolik_out_queue_coalesced_total Starší zprávy nahrazené novějšími\n"
+                      "# TYPE zolik_out_queue_coalesced_total counter\nzolik_out_queue_coalesced_total %lu\n",
+                 s->queues.coalesced);
+
+    admin_printf(out, "# HELP zolik_timers Naplánované časovače\n# TYPE zolik_timers gauge\nzolik_timers %d\n",
+                 s->timers);
+    admin_printf(out, "# HELP zolik_log_dropped_total Záznamy zahozené asynchronním loggerem\n"
+                      "# TYPE zolik_log_dropped_total counter\nzolik_log_dropped_total %lu\n", s->log_dropped);
+
+    for(int c = 0; c < METRIC_COUNTER_COUNT; c++){
+        const char *name = metrics_counter_name((MetricCounter)c);
+        admin_printf(out, "# TYPE zolik_%s_total counter\nzolik_%s_total %lu\n", name, name, admin_metrics.counters[c]);
+    }
+
+    admin_printf(out, "# HELP zolik_message_duration_seconds Obsluha zprávy od naparsování po poslední odpověď\n"
+                      "# TYPE zolik_message_duration_seconds histogram\n");
+    for(int status = 0; status < PLAYER_STATUS_COUNT; status++){
+        for(int type = 0; type < MSG_COUNT; type++){
+            const unsigned long *buckets = admin_metrics.latency[status][type].buckets;
+            unsigned long count = admin_metrics.latency[status][type].count;
+            if(count == 0){
+                continue;
+            }
+
+            const char *type_name = msg_type_name((MessageType)type);
+            const char *status_name = player_status_names[status];
+            unsigned long cumulative = 0;
+            for(int b = 0; b < METRICS_LATENCY_BUCKETS - 1; b++){
+                cumulative += buckets[b];
+                admin_printf(out, "zolik_message_duration_seconds_bucket{type=\"%s\",status=\"%s\",le=\"%.9g\"} %lu\n",
+                             type_name, status_name, metrics_bucket_upper_ns(b) / 1e9, cumulative);
+            }
+            admin_printf(out, "zolik_message_duration_seconds_bucket{type=\"%s\",status=\"%s\",le=\"+Inf\"} %lu\n",
+                         type_name, status_name, count);
+            admin_printf(out, "zolik_message_duration_seconds_sum{type=\"%s\",status=\"%s\"} %.9f\n",
+                         type_name, status_name, admin_metrics.latency[status][type].sum_ns / 1e9);
+            admin_printf(out, "zolik_message_duration_seconds_count{type=\"%s\",status=\"%s\"} %lu\n",
+                         type_name, status_name, count);
+        }
+    }
+
+    admin_printf(out, "# HELP zolik_snapshot_age_seconds Stáří zveřejněného snímku\n"
+                      "# TYPE zolik_snapshot_age_seconds gauge\nzolik_snapshot_age_seconds %.3f\n",
+                 (timer_now_ms() - s->published_ms) / 1000.0);
+}
+
+/**
+ * @brief Stav serveru jako JSON
+ */
+static void admin_render_status(AdminBuffer *out){
+    const AdminSnapshot *s = &admin_snapshot;
+    uint64_t now = timer_now_ms();
+
+    admin_printf(out, "{\"uptime_s\":%.3f,\"snapshot_age_s\":%.3f,\"clients\":{",
+                 (now - admin_started_ms) / 1000.0, (now - s->published_ms) / 1000.0);
+    for(int i = DISCONNECTED + 1; i < PLAYER_STATUS_COUNT; i++){
+        admin_printf(out, "\"%s\":%d,", player_status_names[i], s->clients[i]);
+    }
+    admin_printf(out, "\"reconnect_wait\":%d},\"rooms\":{", s->clients_reconnect_wait);
+    for(int i = 0; i < ROOM_STATUS_COUNT; i++){
+        admin_printf(out, "%s\"%s\":%d", i ? "," : "", room_status_names[i], s->rooms[i]);
+    }
+    admin_printf(out, "},\"games\":{\"active\":%d,\"capacity\":%d,\"high_water\":%d,\"acquired\":%lu,\"exhausted\":%lu},",
+                 s->games.in_use, s->games.capacity, s->games.high_water, s->games.acquired, s->games.exhausted);
+    admin_printf(out, "\"out_queues\":{\"bytes\":%lu,\"frames\":%lu,\"peak_bytes\":%lu,\"dropped\":%lu,\"coalesced\":%lu},",
+                 s->queues.bytes, s->queues.frames, s->queues.peak_bytes, s->queues.dropped, s->queues.coalesced);
+    admin_printf(out, "\"timers\":%d,\"log_dropped\":%lu,\"counters\":{", s->timers, s->log_dropped);
+    for(int c = 0; c < METRIC_COUNTER_COUNT; c++){
+        admin_printf(out, "%s\"%s\":%lu", c ? "," : "", metrics_counter_name((MetricCounter)c), admin_metrics.counters[c]);
+    }
+    admin_printf(out, "},\"messages\":[");
+
+    int first = 1;
+    for(int status = 0; status < PLAYER_STATUS_COUNT; status++){
+        for(int type = 0; type < MSG_COUNT; type++){
+            const unsigned long *buckets = admin_metrics.latency[status][type].buckets;
+            unsigned long count = admin_metrics.latency[status][type].count;
+            if(count == 0){
+                continue;
+            }
+
+            admin_printf(out, "%s{\"type\":\"%s\",\"status\":\"%s\",\"count\":%lu,\"avg_us\":%.1f,"
+                              "\"p50_us\":%.1f,\"p99_us\":%.1f}",
+                         first ? "" : ",", msg_type_name((MessageType)type), player_status_names[status], count,
+                         admin_metrics.latency[status][type].sum_ns / 1000.0 / count,
+                         metrics_quantile_ns(buckets, count, 0.50) / 1000.0,
+                         metrics_quantile_ns(buckets, count, 0.99) / 1000.0);
+            first = 0;
+        }
+    }
+    admin_printf(out, "]}\n");
+}
+
+/**
+ * @brief Odešle celou odpověď HTTP/1.0 (spojení se po ní zavře)
+ */
+static void admin_reply(int sock, const char *status, const char *content_type, const AdminBuffer *body){
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                       status, content_type, body->len);
+
+    if(send(sock, header, (size_t)len, MSG_NOSIGNAL) == len && body->len > 0){
+        size_t sent = 0;
+        while(sent < body->len){
+            ssize_t r = send(sock, body->data + sent, body->len - sent, MSG_NOSIGNAL);
+            if(r <= 0){
+                break;
+            }
+            sent += (size_t)r;
+        }
+    }
+}
+
+/**
+ * @brief Přečte požadavek a odpoví z posledního snímku
+ */
+static void admin_serve(int sock){
+    char request[ADMIN_REQUEST_MAX + 1];
+    size_t len = 0;
+
+    // Stačí první řádek požadavku, čeká se na konec hlavičky (nebo plný buffer)
+    while(len < ADMIN_REQUEST_MAX){
+        ssize_t r = recv(sock, request + len, ADMIN_REQUEST_MAX - len, 0);
+        if(r <= 0){
+            break;
+        }
+        len += (size_t)r;
+        request[len] = '\0';
+        if(strstr(request, "\r\n\r\n") || strstr(request, "\n\n")){
+            break;
+        }
+    }
+    request[len] = '\0';
+
+    char method[8] = "", path[64] = "";
+    AdminBuffer body = {NULL, 0, 0};
+
+    if(sscanf(request, "%7s %63s", method, path) != 2 || strcmp(method, "GET") != 0){
+        admin_printf(&body, "Podporováno jen GET /metrics a GET /status\n");
+        admin_reply(sock, "405 Method Not Allowed", "text/plain; charset=utf-8", &body);
+    } else if(strcmp(path, "/metrics") == 0){
+        admin_render_metrics(&body);
+        admin_reply(sock, "200 OK", "text/plain; version=0.0.4; charset=utf-8", &body);
+    } else if(strcmp(path, "/status") == 0 || strcmp(path, "/") == 0){
+        admin_render_status(&body);
+        admin_reply(sock, "200 OK", "application/json", &body);
+    } else{
+        admin_printf(&body, "Neznámá cesta, použij /metrics nebo /status\n");
+        admin_reply(sock, "404 Not Found", "text/plain; charset=utf-8", &body);
+    }
+    free(body.data);
+}
+
+/**
+ * @brief Vlákno správcovského rozhraní: zveřejňuje snímek každých ADMIN_PUBLISH_MS a obsluhuje dotazy po jednom
+ */
+static void* admin_thread(void *arg){
+    (void)arg;
+    struct pollfd pfd[2] = {{.fd = admin_fd, .events = POLLIN}, {.fd = admin_wake_fd, .events = POLLIN}};
+    struct timeval timeout = {ADMIN_IO_TIMEOUT_MS / 1000, (ADMIN_IO_TIMEOUT_MS % 1000) * 1000};
+
+    admin_publish();
+    while(1){
+        int wait_ms = (int)(admin_snapshot.published_ms + ADMIN_PUBLISH_MS - timer_now_ms());
+        int ready = poll(pfd, 2, wait_ms > 0 ? wait_ms : 0);
+        if(ready < 0 && errno != EINTR){
+            LOG_ERROR("Správcovské rozhraní: poll selhal (errno=%d)\n", errno);
+            break;
+        }
+        // Probuzení z admin_stop
+        if(ready > 0 && (pfd[1].revents & POLLIN)){
+            break;
+        }
+
+        if(timer_now_ms() >= admin_snapshot.published_ms + ADMIN_PUBLISH_MS){
+            admin_publish();
+        }
+        if(ready <= 0 || !(pfd[0].revents & POLLIN)){
+            continue;
+        }
+
+        int sock = accept(admin_fd, NULL, NULL);
+        if(sock < 0){
+            continue;
+        }
+
+        // Pomalý nebo nečinný dotaz nesmí zdržet zveřejňování snímků
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        admin_serve(sock);
+        close(sock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Otevře naslouchající socket (port: TCP jen na loopbacku, cesta: UNIX socket s právy 0600)
+ * @return Socket, -1: ERROR
+ */
+static int admin_listen(const char *endpoint){
+    int fd;
+
+    if(strchr(endpoint, '/')){
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if(strlen(endpoint) >= sizeof(address.sun_path)){
+            return -1;
+        }
+        strcpy(address.sun_path, endpoint);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0){
+            return -1;
+        }
+        // Socket po předchozím běhu
+        unlink(endpoint);
+        if(bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || chmod(endpoint, 0600) != 0){
+            close(fd);
+            return -1;
+        }
+    } else{
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((uint16_t)atoi(endpoint));
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0){
+            return -1;
+        }
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if(bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0){
+            close(fd);
+            return -1;
+        }
+    }
+
+    if(listen(fd, ADMIN_BACKLOG) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int admin_start(const char *endpoint){
+    if(!endpoint || admin_fd >= 0){
+        return -1;
+    }
+
+    admin_fd = admin_listen(endpoint);
+    if(admin_fd < 0){
+        LOG_ERROR("Správcovské rozhraní: nelze naslouchat na %s (errno=%d)\n", endpoint, errno);
+        return -1;
+    }
+    admin_started_ms = timer_now_ms();
+
+    admin_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(admin_wake_fd < 0 || pthread_create(&admin_worker, NULL, admin_thread, NULL) != 0){
+        if(admin_wake_fd >= 0){
+            close(admin_wake_fd);
+            admin_wake_fd = -1;
+        }
+        close(admin_fd);
+        admin_fd = -1;
+        return -1;
+    }
+
+    LOG_INFO("Správcovské rozhraní na %s (GET /metrics, /status)\n", endpoint);
+    return 0;
+}
+
+void admin_stop(void){
+    if(admin_wake_fd < 0){
+        return;
+    }
+
+    uint64_t one = 1;
+    if(write(admin_wake_fd, &one, sizeof(one)) != sizeof(one)){
+        LOG_ERROR("Správcovské rozhraní: nelze probudit vlákno (errno=%d)\n", errno);
+        return;
+    }
+    pthread_join(admin_worker, NULL);
+
+    close(admin_wake_fd);
+    admin_wake_fd = -1;
+    close(admin_fd);
+    admin_fd = -1;
+}
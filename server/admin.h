@@ -0,0 +1,44 @@
+#ifndef ADMIN_H
+#define ADMIN_H
+
+#include <stdint.h>
+#include "config.h"
+#include "client_manager.h"
+#include "room_manager.h"
+#include "game_manager.h"
+#include "outbound.h"
+
+/*
+ * Správcovské rozhraní (--admin): HTTP na loopbacku nebo UNIX socketu.
+ *  - GET /metrics: Prometheus text
+ *  - GET /status: JSON
+ * Dotaz jen kopíruje poslední zveřejněný snímek. Ten správcovské vlákno sestaví jednou za ADMIN_PUBLISH_MS
+ * z atomických počtů, které udržují změny stavu klientů, místností a front (client_gauges, room_status_counts,
+ * outbound_stats); jednotlivé hodnoty jsou přesné, snímek jako celek nemusí být konzistentní.
+ */
+
+// Stav serveru v okamžiku zveřejnění
+typedef struct{
+    uint64_t published_ms;                          // timer_now_ms při sestavení snímku
+    int clients[PLAYER_STATUS_COUNT];               // Přihlášení klienti podle stavu (DISCONNECTED: 0)
+    int clients_reconnect_wait;                     // Odpojení klienti, kteří mohou provést reconnect
+    int rooms[ROOM_STATUS_COUNT];                   // Založené místnosti podle stavu
+    GamePoolStats games;                            // Pool her (in_use: aktivní GameInstance)
+    OutboundStats queues;                           // Souhrn odchozích front
+    int timers;                                     // Naplánované časovače v kole serveru (po posledním ticku)
+    unsigned long log_dropped;                      // Zahozené záznamy asynchronního loggeru
+} AdminSnapshot;
+
+/**
+ * @brief Otevře správcovský socket a spustí jeho vlákno
+ * @param endpoint Číslo portu (TCP na 127.0.0.1) nebo cesta k UNIX socketu (obsahuje '/')
+ * @return 0: SUCCESS, -1: ERROR
+ */
+int admin_start(const char *endpoint);
+
+/**
+ * @brief Zastaví a připojí správcovské vlákno, zavře socket (při ukončení serveru)
+ */
+void admin_stop(void);
+
+#endif
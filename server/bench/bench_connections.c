@@ -0,0 +1,182 @@
+/**
+ * Benchmark připojování klientů: otevře N spojení, každé se přihlásí (LOGI) a čeká na odpověď.
+ * Měří počet přihlášených spojení za sekundu a (se zadaným PID serveru) paměť na nečinného klienta.
+ *
+ * Použití: bench_connections <adresa> <port> <pocet> [pid_serveru]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define HEADER_LEN 12
+
+/**
+ * @brief Monotónní čas v sekundách
+ */
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Přečte hodnotu položky (v kB nebo kusech) z /proc/<pid>/status
+ */
+static long proc_status_value(int pid, const char *key){
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *f = fopen(path, "r");
+    if(!f){
+        return -1;
+    }
+
+    char line[256];
+    long value = -1;
+    size_t key_len = strlen(key);
+    while(fgets(line, sizeof(line), f)){
+        if(strncmp(line, key, key_len) == 0 && line[key_len] == ':'){
+            value = strtol(line + key_len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+/**
+ * @brief Přečte přesně count bajtů
+ */
+static int read_exact(int sock, char *buf, size_t count){
+    size_t total = 0;
+    while(total < count){
+        ssize_t r = recv(sock, buf + total, count - total, 0);
+        if(r <= 0){
+            return -1;
+        }
+        total += r;
+    }
+    return 0;
+}
+
+/**
+ * @brief Připojí se a přihlásí, vrací socket nebo -1 (-2 pokud server odpověděl chybou)
+ */
+static int connect_and_login(struct sockaddr_in *addr, int id){
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if(sock < 0){
+        return -1;
+    }
+    if(connect(sock, (struct sockaddr*)addr, sizeof(*addr)) < 0){
+        close(sock);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    char nick[32];
+    int nick_len = snprintf(nick, sizeof(nick), "b%d", id);
+    char packet[64];
+    int len = snprintf(packet, sizeof(packet), "JOKELOGI%04d%s", nick_len, nick);
+    if(send(sock, packet, len, 0) != len){
+        close(sock);
+        return -1;
+    }
+
+    char header[HEADER_LEN + 1];
+    if(read_exact(sock, header, HEADER_LEN) != 0){
+        close(sock);
+        return -1;
+    }
+    header[HEADER_LEN] = '\0';
+
+    int body_len = atoi(header + 8);
+    char body[10000];
+    if(body_len > 0 && read_exact(sock, body, body_len) != 0){
+        close(sock);
+        return -1;
+    }
+
+    if(strncmp(header + 4, "OKAY", 4) != 0){
+        close(sock);
+        return -2;
+    }
+    return sock;
+}
+
+int main(int argc, char **argv){
+    if(argc < 4){
+        fprintf(stderr, "Použití: %s <adresa> <port> <pocet> [pid_serveru]\n", argv[0]);
+        return 1;
+    }
+
+    int count = atoi(argv[3]);
+    int pid = argc > 4 ? atoi(argv[4]) : 0;
+    if(count <= 0){
+        fprintf(stderr, "Neplatný počet spojení\n");
+        return 1;
+    }
+
+    // Pro tisíce spojení je potřeba zvednout limit deskriptorů
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0){
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(argv[2]));
+    if(inet_pton(AF_INET, argv[1], &addr.sin_addr) <= 0){
+        fprintf(stderr, "Neplatná adresa %s\n", argv[1]);
+        return 1;
+    }
+
+    long rss_before = pid ? proc_status_value(pid, "VmRSS") : -1;
+    long threads_before = pid ? proc_status_value(pid, "Threads") : -1;
+
+    int *socks = calloc(count, sizeof(int));
+    int ok = 0, rejected = 0, failed = 0;
+
+    double start = now_sec();
+    for(int i = 0; i < count; i++){
+        int sock = connect_and_login(&addr, i);
+        if(sock >= 0){
+            socks[ok++] = sock;
+        } else if(sock == -2){
+            rejected++;
+        } else{
+            failed++;
+        }
+    }
+    double elapsed = now_sec() - start;
+
+    // Nech server dokončit práci, ať se měří klidový stav
+    usleep(200000);
+
+    printf("spojení: %d ok, %d odmítnuto, %d chyba\n", ok, rejected, failed);
+    printf("čas: %.3f s, %.0f spojení/s\n", elapsed, elapsed > 0 ? ok / elapsed : 0.0);
+
+    if(pid){
+        long rss_after = proc_status_value(pid, "VmRSS");
+        long threads_after = proc_status_value(pid, "Threads");
+        printf("RSS serveru: %ld kB -> %ld kB", rss_before, rss_after);
+        if(ok > 0){
+            printf(" (%.1f kB na nečinného klienta)", (double)(rss_after - rss_before) / ok);
+        }
+        printf("\nvlákna serveru: %ld -> %ld\n", threads_before, threads_after);
+    }
+
+    for(int i = 0; i < ok; i++){
+        close(socks[i]);
+    }
+    free(socks);
+    return 0;
+}
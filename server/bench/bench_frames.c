@@ -0,0 +1,143 @@
+/**
+ * Mikrobenchmark parseru zpráv: porovnává původní read_full_message (recv po bajtech)
+ * s kruhovým bufferem frame_buffer (velké bloky, více zpráv na jedno recv).
+ * Počet systémových volání se počítá obalením recv (-Wl,--wrap=recv).
+ *
+ * Použití: bench_frames [pocet_zprav] [bordel_pred_zpravou]
+ */
+#include "../protocol.h"
+#include "../frame_buffer.h"
+#include "../logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static unsigned long recv_count = 0;
+
+ssize_t __real_recv(int sock, void *buf, size_t len, int flags);
+
+ssize_t __wrap_recv(int sock, void *buf, size_t len, int flags){
+    recv_count++;
+    return __real_recv(sock, buf, len, flags);
+}
+
+// Data, která posílá zapisovací vlákno
+typedef struct{
+    int sock;
+    char *data;
+    size_t len;
+} WriterArgs;
+
+static void* writer_thread(void *arg){
+    WriterArgs *w = (WriterArgs*)arg;
+    size_t sent = 0;
+    while(sent < w->len){
+        ssize_t r = write(w->sock, w->data + sent, w->len - sent);
+        if(r <= 0){
+            break;
+        }
+        sent += r;
+    }
+    return NULL;
+}
+
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Sestaví proud zpráv typické hry (PONG, THRW, UNLO, ADDC), volitelně s bordelem před každou
+ */
+static char* build_stream(int count, int garbage, size_t *len_out){
+    const char *types[] = {"PONG", "THRW", "UNLO", "ADDC", "TAKP"};
+    const char *bodies[] = {"", "AH", "2H3H4H5H", "2H3H4H|5H", ""};
+    size_t cap = (size_t)count * (HEADER_LEN + 16 + garbage);
+    char *data = malloc(cap);
+    size_t len = 0;
+
+    for(int i = 0; i < count; i++){
+        int k = i % 5;
+        for(int g = 0; g < garbage; g++){
+            data[len++] = 'x';
+        }
+        len += sprintf(data + len, "%s%s%04d%s", MAGIC, types[k], (int)strlen(bodies[k]), bodies[k]);
+    }
+    *len_out = len;
+    return data;
+}
+
+/**
+ * @brief Spustí jeden průchod parserem nad socketpairem a vypíše výsledky
+ * @param legacy 1: read_full_message, 0: frame_read_message
+ */
+static void run(const char *label, int legacy, char *data, size_t len, int count){
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0){
+        perror("socketpair");
+        exit(1);
+    }
+
+    WriterArgs w = { sv[1], data, len };
+    pthread_t writer;
+    pthread_create(&writer, NULL, writer_thread, &w);
+
+    FrameBuffer fb;
+    frame_buffer_init(&fb);
+
+    recv_count = 0;
+    int parsed = 0;
+    double start = now_sec();
+    for(int i = 0; i < count; i++){
+        ProtocolHeader header;
+        char *body = NULL;
+        int status;
+        if(legacy){
+            status = read_full_message(sv[0], &header, &body);
+            free(body);
+        } else{
+            status = frame_read_message(&fb, sv[0], &header, &body);
+        }
+        if(status != 0){
+            fprintf(stderr, "%s: chyba %d u zprávy %d\n", label, status, i);
+            break;
+        }
+        parsed++;
+    }
+    double elapsed = now_sec() - start;
+
+    pthread_join(writer, NULL);
+    frame_buffer_free(&fb);
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("%-22s %8d zpráv  %10.0f zpráv/s  %6.3f recv/zprávu\n",
+           label, parsed, elapsed > 0 ? parsed / elapsed : 0.0, parsed ? (double)recv_count / parsed : 0.0);
+}
+
+int main(int argc, char **argv){
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    int garbage = argc > 2 ? atoi(argv[2]) : 0;
+    if(count <= 0 || garbage < 0 || garbage > MAX_GARBAGE - MAGIC_LEN){
+        fprintf(stderr, "Použití: %s [pocet_zprav] [bordel_pred_zpravou 0..%d]\n", argv[0], MAX_GARBAGE - MAGIC_LEN);
+        return 1;
+    }
+
+    // send_error při bordelu loguje -> bez výstupu
+    log_init(NULL, LOG_FATAL);
+
+    size_t len;
+    char *data = build_stream(count, garbage, &len);
+    printf("%d zpráv, %zu B, %d B bordelu před každou\n", count, len, garbage);
+
+    run("read_full_message", 1, data, len, count);
+    run("frame_buffer", 0, data, len, count);
+
+    free(data);
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * Benchmark loggeru: T vláken zapisuje řádky ve tvaru odesílání paketu (LOG_DEBUG v send_message).
+ * Měří průměrnou a nejhorší dobu volání log_msg pro producenta v synchronním režimu (zámek, fprintf
+ * a fflush na řádek) a v asynchronním (záznam do fronty, zápis zapisovacím vláknem), u asynchronního
+ * i počet zahozených záznamů. Třetí měření volá makro LOG_DEBUG (synchronně, omezovač místa volání
+ * LOG_RATE_LIMIT zpráv za sekundu), čtvrté zapisuje stejnou událost binárním trasováním (TRACE, trace.h).
+ * Soubory se po měření smažou.
+ *
+ * Použití: bench_logger [vlaken] [radku_na_vlakno] [zaznamu_fronty] [soubor]
+ */
+#include "../logger.h"
+#include "../trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Co producent volá
+typedef enum{
+    BENCH_LOG,                      // Přímo log_msg
+    BENCH_LIMITED,                  // Makro LOG_DEBUG s omezovačem
+    BENCH_TRACE                     // Binární záznam TRACE
+} BenchMode;
+
+// Jedno vlákno producenta
+typedef struct{
+    int id;
+    long lines;
+    BenchMode mode;
+    pthread_barrier_t *barrier;
+    double total_ns;                // Součet dob volání
+    double max_ns;                  // Nejdelší volání
+} LoggerBench;
+
+/**
+ * @brief Monotónní čas v nanosekundách
+ */
+static double now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Počet záznamů v souboru logu (řádky s hlavičkou)
+ */
+static long count_records(const char *path){
+    FILE *file = fopen(path, "r");
+    char line[512];
+    long records = 0;
+
+    while(file && fgets(line, sizeof(line), file)){
+        records += line[0] == '[';
+    }
+    if(file){
+        fclose(file);
+    }
+    return records;
+}
+
+static void *producer_thread(void *arg){
+    LoggerBench *bench = (LoggerBench*)arg;
+
+    pthread_barrier_wait(bench->barrier);
+    for(long i = 0; i < bench->lines; i++){
+        double start = now_ns();
+        if(bench->mode == BENCH_TRACE){
+            TRACE(MSG_OUT, -1, -1, trace_fourcc("STAT"), i, bench->id);
+        } else if(bench->mode == BENCH_LIMITED){
+            LOG_DEBUG("Sending to client socket %d: %.4s (%zu B)\n", bench->id, "STAT", (size_t)i);
+        } else{
+            log_msg(LOG_DEBUG, __FILE__, __LINE__, "Sending to client socket %d: %.4s (%zu B)\n", bench->id, "STAT",
+                    (size_t)i);
+        }
+        double elapsed = now_ns() - start;
+
+        bench->total_ns += elapsed;
+        if(elapsed > bench->max_ns){
+            bench->max_ns = elapsed;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Jedno měření (records 0: synchronní logger)
+ */
+static int run(const char *path, const char *trace_path, int threads, long lines, size_t records, BenchMode mode){
+    if(mode == BENCH_TRACE && trace_open(trace_path, (size_t)TRACE_DEFAULT_MB * 1024 * 1024) != 0){
+        fprintf(stderr, "Nelze otevřít %s\n", trace_path);
+        return -1;
+    }
+    if(log_init(path, LOG_DEBUG) != 0){
+        fprintf(stderr, "Nelze otevřít %s\n", path);
+        return -1;
+    }
+    log_delete();
+    if(records > 0 && log_start_async(records) != 0){
+        fprintf(stderr, "Nelze spustit asynchronní logger (fronta %zu)\n", records);
+        log_close();
+        return -1;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+    LoggerBench *benches = calloc((size_t)threads, sizeof(LoggerBench));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+
+    for(int i = 0; i < threads; i++){
+        benches[i].id = i;
+        benches[i].lines = lines;
+        benches[i].mode = mode;
+        benches[i].barrier = &barrier;
+        pthread_create(&tids[i], NULL, producer_thread, &benches[i]);
+    }
+
+    unsigned long dropped_before = log_dropped();
+    pthread_barrier_wait(&barrier);
+    double start = now_ns();
+    for(int i = 0; i < threads; i++){
+        pthread_join(tids[i], NULL);
+    }
+    double produced = now_ns() - start;
+    unsigned long dropped = log_dropped() - dropped_before;
+    log_close();
+    trace_close();
+    double flushed = now_ns() - start;
+
+    double total = 0, max = 0;
+    for(int i = 0; i < threads; i++){
+        total += benches[i].total_ns;
+        max = benches[i].max_ns > max ? benches[i].max_ns : max;
+    }
+
+    long all = lines * threads;
+    long written = count_records(path);
+    if(mode == BENCH_TRACE){
+        printf("trace:              ");
+        written = all;
+    } else if(records > 0){
+        printf("async (fronta %zu): ", records);
+    } else if(mode == BENCH_LIMITED){
+        printf("sync + limit %d/s:  ", LOG_RATE_LIMIT);
+    } else{
+        printf("sync:               ");
+    }
+    printf("%.0f ns/volání, max %.1f us, producenti %.1f ms, do zápisu %.1f ms, zahozeno %lu, zapsáno %ld/%ld\n",
+           total / all, max / 1000.0, produced / 1e6, flushed / 1e6, dropped, written, all);
+
+    pthread_barrier_destroy(&barrier);
+    free(benches);
+    free(tids);
+    return 0;
+}
+
+int main(int argc, char **argv){
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    long lines = argc > 2 ? atol(argv[2]) : 100000;
+    long records = argc > 3 ? atol(argv[3]) : 4096;
+    const char *path = argc > 4 ? argv[4] : "bench_logger.log";
+    char trace_path[512];
+    snprintf(trace_path, sizeof(trace_path), "%s.trace", path);
+
+    if(threads <= 0 || lines <= 0 || records < 2 || (records & (records - 1)) != 0){
+        fprintf(stderr, "Použití: %s [vlaken] [radku_na_vlakno] [zaznamu_fronty (mocnina dvou)] [soubor]\n", argv[0]);
+        return 1;
+    }
+
+    printf("vláken: %d, řádků na vlákno: %ld\n", threads, lines);
+    int result = run(path, trace_path, threads, lines, 0, BENCH_LOG) |
+                 run(path, trace_path, threads, lines, (size_t)records, BENCH_LOG) |
+                 run(path, trace_path, threads, lines, 0, BENCH_LIMITED) |
+                 run(path, trace_path, threads, lines, 0, BENCH_TRACE);
+    unlink(path);
+    unlink(trace_path);
+    return result ? 1 : 0;
+}
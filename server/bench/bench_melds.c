@@ -0,0 +1,367 @@
+/**
+ * Validátor kombinací: porovná meld_classify s původní kontrolou z UNLO (set, dvojí bublinkové řazení
+ * s esem dole a nahoře, procházení mezer se žolíky) a změří propustnost obou.
+ *
+ * Správnost: všechny multimnožiny 1..5 karet (dva balíčky + 4 žolíci), všechny podmnožiny hodnot jedné
+ * barvy s 0..4 žolíky a náhodné multimnožiny 6..14 karet. U platných kombinací kontroluje i kanonické
+ * pořadí (permutace vstupu, set podle barev, postupka navazuje, žolíci na označených pozicích).
+ *
+ * Použití: bench_melds [nahodnych_vzorku] [opakovani_mereni]
+ */
+#include "../card.h"
+#include "../meld.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FACE_COUNT (CARD_SUITS * CARD_RANKS + 1)   // 52 kódů + žolík
+#define MAX_SAMPLE 14                               // Nejvíc karet vyložitelných z ruky
+
+// Vzorky pro měření propustnosti
+typedef struct{
+    Card cards[MAX_SAMPLE];
+    int count;
+} Sample;
+
+static Sample *samples = NULL;
+static size_t sample_count = 0;
+static size_t sample_capacity = 0;
+
+static unsigned long checked = 0;
+static unsigned long valid_sets = 0;
+static unsigned long valid_sequences = 0;
+static unsigned long failures = 0;
+
+/**
+ * @brief Monotónní čas v sekundách
+ */
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Původní kontrola z UNLO (set, jinak postupka), převzatá beze změny logiky
+ * @return 1: set, 2: postupka, 0: neplatné
+ */
+static int legacy_classify(const Card *cards_to_unload, int parsed_count){
+    // SET - stejná hodnota, každá barva maximálně jednou
+    int is_set = 1;
+
+    if (parsed_count > 4) {
+        is_set = 0;
+    }
+
+    if (is_set) {
+        int first_value = -1;
+        for (int i = 0; i < parsed_count; i++) {
+            if (!card_is_joker(cards_to_unload[i])) {
+                first_value = card_value(cards_to_unload[i]);
+                break;
+            }
+        }
+
+        if (first_value == -1) {
+            is_set = 0;
+        }
+
+        for (int i = 0; i < parsed_count && is_set; i++) {
+            if (!card_is_joker(cards_to_unload[i]) && card_value(cards_to_unload[i]) != first_value) {
+                is_set = 0;
+            }
+        }
+
+        if (is_set) {
+            unsigned suits_used = 0;
+
+            for (int i = 0; i < parsed_count; i++) {
+                if (card_is_joker(cards_to_unload[i])){
+                    continue;
+                }
+
+                unsigned suit_bit = 1u << card_suit(cards_to_unload[i]);
+
+                if (suits_used & suit_bit) {
+                    is_set = 0;
+                    break;
+                }
+                suits_used |= suit_bit;
+            }
+        }
+    }
+
+    if (is_set) {
+        return 1;
+    }
+
+    // POSTUPKA (sequence) - stejná barva, rostoucí hodnoty
+    int first_suit = -1;
+
+    for (int i = 0; i < parsed_count; i++) {
+        if (!card_is_joker(cards_to_unload[i])) {
+            if (first_suit == -1) {
+                first_suit = card_suit(cards_to_unload[i]);
+            } else if (card_suit(cards_to_unload[i]) != first_suit) {
+                return 0;
+            }
+        }
+    }
+    if (first_suit == -1) {
+        return 0;
+    }
+
+    int sorted[MAX_SEQUENCE_CARDS];
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int normal_count = 0;
+        int jokers_avail = 0;
+        for (int i = 0; i < parsed_count; i++) {
+            if (card_is_joker(cards_to_unload[i])) {
+                jokers_avail++;
+                continue;
+            }
+            sorted[normal_count] = card_value(cards_to_unload[i]);
+            if (attempt == 1 && sorted[normal_count] == 1) {
+                sorted[normal_count] = 14;
+            }
+            normal_count++;
+        }
+
+        // Seřazení (Bubble sort)
+        for (int i = 0; i < normal_count - 1; i++) {
+            for (int j = i + 1; j < normal_count; j++) {
+                if (sorted[i] > sorted[j]) {
+                    int tmp = sorted[i]; sorted[i] = sorted[j]; sorted[j] = tmp;
+                }
+            }
+        }
+
+        int is_sequence = 1;
+        int current_val = sorted[0];
+        for (int i = 1; i < normal_count; i++) {
+            int gap = sorted[i] - current_val;
+            if (gap == 1) {
+                current_val = sorted[i];
+            } else if (gap > 1 && (gap - 1) <= jokers_avail) {
+                jokers_avail -= (gap - 1);
+                current_val = sorted[i];
+            } else {
+                is_sequence = 0;
+                break;
+            }
+        }
+
+        if (is_sequence) {
+            return 2;
+        }
+
+        int has_ace = 0;
+        for(int i=0; i<parsed_count; i++) if(!card_is_joker(cards_to_unload[i]) && card_value(cards_to_unload[i]) == 1) has_ace = 1;
+        if(!has_ace) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Kontrola kanonického pořadí platné kombinace
+ * @return 0: v pořádku, -1: chyba
+ */
+static int check_order(const Card *cards, int count, const Meld *meld){
+    // Permutace vstupu (kódy karet)
+    int in_hist[CARD_COUNT] = {0};
+    for(int i = 0; i < count; i++){
+        in_hist[cards[i]]++;
+    }
+    for(int i = 0; i < meld->count; i++){
+        if(--in_hist[meld->cards[i]] < 0){
+            return -1;
+        }
+    }
+    if(meld->count != count){
+        return -1;
+    }
+
+    int prev_suit = -1;
+    for(int i = 0; i < count; i++){
+        int is_joker = card_is_joker(meld->cards[i]);
+
+        if(is_joker != (int)((meld->joker_positions >> i) & 1u)){
+            return -1;
+        }
+        if(is_joker){
+            continue;
+        }
+
+        if(meld->kind == MELD_SET){
+            // Barvy vzestupně, žolíci až za normálními kartami
+            if(card_suit(meld->cards[i]) <= prev_suit || (i > 0 && card_is_joker(meld->cards[i - 1]))){
+                return -1;
+            }
+            prev_suit = card_suit(meld->cards[i]);
+        } else{
+            // Pozice i má hodnotu low + i (eso 1 nebo 14)
+            int value = meld->low + i;
+            int card_val = card_value(meld->cards[i]);
+            if(!(card_val == value || (card_val == 1 && value == MELD_ACE_HIGH))){
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Porovná obě implementace na jedné multimnožině a uloží ji jako vzorek pro měření
+ */
+static void check(const Card *cards, int count){
+    Meld meld;
+    int legacy = legacy_classify(cards, count);
+    MeldKind kind = meld_classify(cards, count, &meld);
+
+    checked++;
+    if((int)kind != legacy || (kind != MELD_INVALID && check_order(cards, count, &meld) != 0)){
+        if(failures++ < 10){
+            printf("NESHODA:");
+            for(int i = 0; i < count; i++){
+                printf(" %s", card_code(cards[i]));
+            }
+            printf(" -> původní %d, nový %d\n", legacy, kind);
+        }
+    }
+    valid_sets += kind == MELD_SET;
+    valid_sequences += kind == MELD_SEQUENCE;
+
+    if(count >= 3){
+        if(sample_count == sample_capacity){
+            sample_capacity = sample_capacity ? sample_capacity * 2 : 1 << 16;
+            samples = realloc(samples, sample_capacity * sizeof(Sample));
+        }
+        memcpy(samples[sample_count].cards, cards, count);
+        samples[sample_count].count = count;
+        sample_count++;
+    }
+}
+
+/**
+ * @brief Všechny multimnožiny dané velikosti (kód karty nejvýše 2x, žolík 4x)
+ */
+static void enumerate(Card *cards, int depth, int size, int face){
+    if(depth == size){
+        check(cards, size);
+        return;
+    }
+
+    for(int f = face; f < FACE_COUNT; f++){
+        Card card = f < FACE_COUNT - 1 ? card_make(f / CARD_RANKS, f % CARD_RANKS) : CARD_JOKER;
+        int limit = f < FACE_COUNT - 1 ? CARD_DECKS : CARD_JOKERS;
+
+        // Kolik kopií už je v multimnožině (stejný kód je vždy na konci)
+        int used = 0;
+        for(int i = depth - 1; i >= 0 && cards[i] == card; i--){
+            used++;
+        }
+        if(used >= limit){
+            continue;
+        }
+
+        cards[depth] = card;
+        enumerate(cards, depth + 1, size, f);
+    }
+}
+
+int main(int argc, char **argv){
+    long random_samples = argc > 1 ? atol(argv[1]) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+    if(random_samples < 0 || rounds <= 0){
+        fprintf(stderr, "Použití: %s [nahodnych_vzorku] [opakovani_mereni]\n", argv[0]);
+        return 1;
+    }
+
+    Card cards[MAX_SAMPLE];
+
+    // Všechny multimnožiny do 5 karet
+    for(int size = 1; size <= 5; size++){
+        enumerate(cards, 0, size, 0);
+    }
+
+    // Všechny postupky jedné barvy (podmnožiny hodnot) s 0..4 žolíky
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        for(unsigned mask = 1; mask < (1u << CARD_RANKS); mask++){
+            for(int jokers = 0; jokers <= CARD_JOKERS; jokers++){
+                int count = 0;
+                for(int rank = 0; rank < CARD_RANKS; rank++){
+                    if((mask >> rank) & 1u){
+                        cards[count++] = card_make(suit, rank);
+                    }
+                }
+                if(count + jokers > MAX_SAMPLE){
+                    continue;
+                }
+                for(int j = 0; j < jokers; j++){
+                    cards[count++] = CARD_JOKER;
+                }
+                check(cards, count);
+            }
+        }
+    }
+
+    // Náhodné multimnožiny 6..14 karet (náhodný výběr bez vracení z obou balíčků)
+    srand(12345);
+    for(long n = 0; n < random_samples; n++){
+        Card deck[CARD_COUNT];
+        for(int i = 0; i < CARD_COUNT; i++){
+            deck[i] = (Card)i;
+        }
+
+        int count = 6 + rand() % (MAX_SAMPLE - 5);
+        // Polovina vzorků z jedné barvy, jinak by platné postupky skoro nevznikaly
+        int one_suit = rand() % 2;
+        int suit = rand() % CARD_SUITS;
+        int picked = 0;
+        int available = CARD_COUNT;
+
+        while(picked < count && available > 0){
+            int j = rand() % available;
+            Card card = deck[j];
+            deck[j] = deck[--available];
+
+            if(one_suit && !card_is_joker(card) && card_suit(card) != suit){
+                continue;
+            }
+            cards[picked++] = card;
+        }
+        check(cards, picked);
+    }
+
+    printf("zkontrolováno: %lu kombinací (set: %lu, postupka: %lu), neshod: %lu\n",
+           checked, valid_sets, valid_sequences, failures);
+
+    // Propustnost na vzorcích 3+ karet (velikost UNLO)
+    volatile int sink = 0;
+    for(int round = 0; round < rounds; round++){
+        double start = now_sec();
+        for(size_t i = 0; i < sample_count; i++){
+            sink += legacy_classify(samples[i].cards, samples[i].count);
+        }
+        double legacy_time = now_sec() - start;
+
+        start = now_sec();
+        for(size_t i = 0; i < sample_count; i++){
+            Meld meld;
+            sink += meld_classify(samples[i].cards, samples[i].count, &meld);
+        }
+        double meld_time = now_sec() - start;
+
+        printf("kolo %d: %zu kombinací, původní %.1f M/s, meld_classify %.1f M/s (%.2fx)\n",
+               round + 1, sample_count, sample_count / legacy_time / 1e6, sample_count / meld_time / 1e6,
+               legacy_time / meld_time);
+    }
+    (void)sink;
+
+    free(samples);
+    return failures ? 1 : 0;
+}
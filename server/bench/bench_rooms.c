@@ -0,0 +1,276 @@
+/**
+ * Benchmark souběhu místností: v každé místnosti hrají dva klienti, hráč na tahu opakovaně posílá tah.
+ * Měří počet zpracovaných tahů za sekundu v závislosti na počtu současně aktivních místností
+ * a dobu odezvy klienta v lobby (RLIS), jehož obsluha drží clients_mutex.
+ * Souběh místností ukáže až srovnání běhu na jednom a na více CPU (bench/run_rooms.sh).
+ *
+ * Použití: bench_rooms <adresa> <port> <pocet_mistnosti> [sekundy]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define HEADER_LEN 12
+#define BODY_MAX 10000
+
+// Jedna místnost benchmarku
+typedef struct{
+    int id;                         // Pořadí místnosti
+    struct sockaddr_in *addr;       // Adresa serveru
+    pthread_barrier_t *barrier;     // Start měření (po přípravě všech místností)
+    double seconds;                 // Délka měření
+    long moves;                     // Počet potvrzených tahů
+    int ok;                         // 1: příprava místnosti proběhla
+} RoomBench;
+
+// Klient v lobby měřící odezvu během hry v místnostech
+typedef struct{
+    struct sockaddr_in *addr;       // Adresa serveru
+    pthread_barrier_t *barrier;     // Start měření
+    double seconds;                 // Délka měření
+    long requests;                  // Počet zodpovězených RLIS
+    double total_sec;               // Součet dob odezvy
+    double max_sec;                 // Nejdelší odezva
+} LobbyBench;
+
+/**
+ * @brief Monotónní čas v sekundách
+ */
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Přečte přesně count bajtů
+ */
+static int read_exact(int sock, char *buf, size_t count){
+    size_t total = 0;
+    while(total < count){
+        ssize_t r = recv(sock, buf + total, count - total, 0);
+        if(r <= 0){
+            return -1;
+        }
+        total += r;
+    }
+    return 0;
+}
+
+/**
+ * @brief Odešle zprávu protokolu
+ */
+static int send_frame(int sock, const char *type, const char *body){
+    char packet[128];
+    int len = snprintf(packet, sizeof(packet), "JOKE%s%04zu%s", type, strlen(body), body);
+    return send(sock, packet, len, 0) == len ? 0 : -1;
+}
+
+/**
+ * @brief Čte zprávy, dokud nepřijde jeden z typů (ostatní, např. PING a RLIS, přeskakuje)
+ * @return index nalezeného typu, -1: chyba spojení
+ */
+static int read_until(int sock, const char *const *types, int type_count, char *body, size_t body_size){
+    char header[HEADER_LEN + 1];
+    char skip[BODY_MAX];
+
+    for(;;){
+        if(read_exact(sock, header, HEADER_LEN) != 0){
+            return -1;
+        }
+        header[HEADER_LEN] = '\0';
+
+        int len = atoi(header + 8);
+        char *dst = body && (size_t)len < body_size ? body : skip;
+        if(len < 0 || len >= BODY_MAX || (len > 0 && read_exact(sock, dst, len) != 0)){
+            return -1;
+        }
+        dst[len] = '\0';
+
+        for(int i = 0; i < type_count; i++){
+            if(strncmp(header + 4, types[i], 4) == 0){
+                if(body && dst != body){
+                    body[0] = '\0';
+                }
+                return i;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Připojí se a přihlásí pod daným nickem
+ */
+static int connect_and_login(struct sockaddr_in *addr, const char *nick){
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if(sock < 0){
+        return -1;
+    }
+    if(connect(sock, (struct sockaddr*)addr, sizeof(*addr)) < 0){
+        close(sock);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    const char *okay[] = {"OKAY", "ERRR"};
+    if(send_frame(sock, "LOGI", nick) != 0 || read_until(sock, okay, 2, NULL, 0) != 0){
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * @brief Vlákno místnosti: příprava hry a smyčka tahů
+ */
+static void *room_thread(void *arg){
+    RoomBench *bench = (RoomBench*)arg;
+    char nick[32], room_name[16], body[BODY_MAX] = "";
+    int socks[2] = {-1, -1};
+
+    for(int i = 0; i < 2; i++){
+        snprintf(nick, sizeof(nick), "r%d%c", bench->id, 'a' + i);
+        socks[i] = connect_and_login(bench->addr, nick);
+    }
+
+    const char *ocrt[] = {"OCRT", "ECRT"};
+    const char *ocnt[] = {"OCNT", "ECNT"};
+    const char *prdy[] = {"PRDY"};
+    const char *turn[] = {"TURN", "WAIT"};
+    int on_turn = -1;
+
+    snprintf(room_name, sizeof(room_name), "b%d", bench->id);
+    if(socks[0] >= 0 && socks[1] >= 0
+        && send_frame(socks[0], "RCRT", room_name) == 0 && read_until(socks[0], ocrt, 2, body, sizeof(body)) == 0
+        && send_frame(socks[1], "RCNT", body) == 0 && read_until(socks[1], ocnt, 2, NULL, 0) == 0
+        && send_frame(socks[0], "REDY", "1") == 0 && send_frame(socks[1], "REDY", "1") == 0){
+        // Start až po potvrzení, že jsou připraveni oba
+        body[0] = '\0';
+        while(strcmp(body, "(2/2)") != 0){
+            if(read_until(socks[0], prdy, 1, body, sizeof(body)) != 0){
+                break;
+            }
+        }
+    }
+    if(strcmp(body, "(2/2)") == 0 && send_frame(socks[0], "STRT", "") == 0){
+        int first = read_until(socks[0], turn, 2, NULL, 0);
+        on_turn = first == 0 ? 0 : (first == 1 ? 1 : -1);
+    }
+    bench->ok = on_turn >= 0;
+
+    pthread_barrier_wait(bench->barrier);
+
+    // Hráč na tahu opakovaně zkouší líznout, server tah zpracuje v místnosti a odpoví
+    const char *reply[] = {"ERRR", "STAT"};
+    double end = now_sec() + bench->seconds;
+    while(bench->ok && now_sec() < end){
+        if(send_frame(socks[on_turn], "TAKP", "") != 0 || read_until(socks[on_turn], reply, 2, NULL, 0) < 0){
+            bench->ok = 0;
+            break;
+        }
+        bench->moves++;
+    }
+
+    for(int i = 0; i < 2; i++){
+        if(socks[i] >= 0){
+            close(socks[i]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Vlákno lobby: opakovaně žádá o seznam místností a měří odezvu
+ */
+static void *lobby_thread(void *arg){
+    LobbyBench *bench = (LobbyBench*)arg;
+    int sock = connect_and_login(bench->addr, "lobby");
+
+    pthread_barrier_wait(bench->barrier);
+
+    const char *reply[] = {"RLIS", "ELIS"};
+    double end = now_sec() + bench->seconds;
+    while(sock >= 0 && now_sec() < end){
+        double sent = now_sec();
+        if(send_frame(sock, "RLIS", "") != 0 || read_until(sock, reply, 2, NULL, 0) < 0){
+            break;
+        }
+        double elapsed = now_sec() - sent;
+        bench->requests++;
+        bench->total_sec += elapsed;
+        if(elapsed > bench->max_sec){
+            bench->max_sec = elapsed;
+        }
+    }
+
+    if(sock >= 0){
+        close(sock);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv){
+    if(argc < 4){
+        fprintf(stderr, "Použití: %s <adresa> <port> <pocet_mistnosti> [sekundy]\n", argv[0]);
+        return 1;
+    }
+
+    int room_count = atoi(argv[3]);
+    double seconds = argc > 4 ? atof(argv[4]) : 3.0;
+    if(room_count <= 0 || seconds <= 0){
+        fprintf(stderr, "Neplatné parametry\n");
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(argv[2]));
+    if(inet_pton(AF_INET, argv[1], &addr.sin_addr) <= 0){
+        fprintf(stderr, "Neplatná adresa %s\n", argv[1]);
+        return 1;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, room_count + 1);
+
+    RoomBench *benches = calloc(room_count, sizeof(RoomBench));
+    pthread_t *threads = calloc(room_count, sizeof(pthread_t));
+    for(int i = 0; i < room_count; i++){
+        benches[i].id = i;
+        benches[i].addr = &addr;
+        benches[i].barrier = &barrier;
+        benches[i].seconds = seconds;
+        pthread_create(&threads[i], NULL, room_thread, &benches[i]);
+    }
+
+    LobbyBench lobby = {.addr = &addr, .barrier = &barrier, .seconds = seconds};
+    pthread_t lobby_tid;
+    pthread_create(&lobby_tid, NULL, lobby_thread, &lobby);
+
+    long moves = 0;
+    int ready = 0;
+    for(int i = 0; i < room_count; i++){
+        pthread_join(threads[i], NULL);
+        moves += benches[i].moves;
+        ready += benches[i].ok;
+    }
+    pthread_join(lobby_tid, NULL);
+
+    printf("místnosti: %d (%d hrálo do konce), tahů: %ld, %.0f tahů/s, lobby RLIS: %.1f us průměr, %.1f us max\n",
+           room_count, ready, moves, moves / seconds,
+           lobby.requests ? lobby.total_sec / lobby.requests * 1e6 : 0.0, lobby.max_sec * 1e6);
+
+    pthread_barrier_destroy(&barrier);
+    free(benches);
+    free(threads);
+    return 0;
+}
@@ -0,0 +1,243 @@
+/**
+ * Kontrola a měření solveru tahů (solver.c).
+ *
+ * Správnost:
+ *  - vyjmenování kombinací proti hrubé síle: všechny podmnožiny různých kódů ruky s 0..žolíků žolíky přes
+ *    meld_classify, obě množiny se musí shodovat (ruce z prvních her),
+ *  - každý plán se v enginu provede (UNLO, pak ADDC), všechny tahy musí projít a ruka se zmenšit o discharged.
+ *
+ * Hry hrají dva boti podle plánu solveru (pak vyhodí nejdražší kartu), měří se doba solver_plan na tah.
+ *
+ * Použití: bench_solver [her] [rozpocet_us]
+ */
+#include "../game_engine.h"
+#include "../solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_TURNS 400                       // Nejvíc kol jedné hry
+#define BRUTE_GAMES 50                      // Kolik her projde i kontrolou hrubou silou
+#define JOKER_KEY_SHIFT 56                  // Klíč kombinace: bity 0..51 kódy, od 56 počet žolíků
+
+static unsigned long failures = 0;
+
+/**
+ * @brief Monotónní čas v nanosekundách
+ */
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Klíč multimnožiny karet kombinace (kódy jsou v kombinaci nejvýše jednou)
+ */
+static uint64_t meld_key(const Card *cards, int count){
+    uint64_t key = 0;
+
+    for(int i = 0; i < count; i++){
+        if(card_is_joker(cards[i])){
+            key += 1ULL << JOKER_KEY_SHIFT;
+        } else{
+            key |= 1ULL << card_face(cards[i]);
+        }
+    }
+    return key;
+}
+
+static int key_cmp(const void *a, const void *b){
+    uint64_t ka = *(const uint64_t*)a;
+    uint64_t kb = *(const uint64_t*)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+/**
+ * @brief Porovná solver_enumerate_melds s hrubou silou nad rukou
+ */
+static void check_enumeration(const CardHand *hand){
+    static Meld melds[SOLVER_MAX_MELDS];
+    static uint64_t enumerated[SOLVER_MAX_MELDS];
+    static uint64_t brute[1 << 20];
+    int count = solver_enumerate_melds(hand, melds, SOLVER_MAX_MELDS);
+    int brute_count = 0;
+
+    for(int i = 0; i < count; i++){
+        enumerated[i] = meld_key(melds[i].cards, melds[i].count);
+    }
+
+    // Různé kódy v ruce
+    Card faces[CARD_SUITS * CARD_RANKS];
+    int face_count = 0;
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        for(int rank = 0; rank < CARD_RANKS; rank++){
+            if((hand->ranks[suit] >> rank) & 1u){
+                faces[face_count++] = card_make(suit, rank);
+            }
+        }
+    }
+
+    for(uint32_t mask = 1; mask < (1u << face_count); mask++){
+        Card cards[MAX_SEQUENCE_CARDS];
+        int n = 0;
+
+        if(__builtin_popcount(mask) + hand->jokers < 3 || __builtin_popcount(mask) > MAX_SEQUENCE_CARDS){
+            continue;
+        }
+        for(int i = 0; i < face_count; i++){
+            if((mask >> i) & 1u){
+                cards[n++] = faces[i];
+            }
+        }
+        for(int j = 0; j <= hand->jokers && n + j <= MAX_SEQUENCE_CARDS; j++){
+            Meld meld;
+            if(n + j >= 3 && meld_classify(cards, n + j, &meld) != MELD_INVALID){
+                brute[brute_count++] = meld_key(cards, n + j);
+            }
+            cards[n + j] = CARD_JOKER;
+        }
+    }
+
+    qsort(enumerated, (size_t)count, sizeof(uint64_t), key_cmp);
+    qsort(brute, (size_t)brute_count, sizeof(uint64_t), key_cmp);
+
+    int duplicate = 0;
+    for(int i = 1; i < count; i++){
+        duplicate |= enumerated[i] == enumerated[i - 1];
+    }
+    if(duplicate || count != brute_count || memcmp(enumerated, brute, sizeof(uint64_t) * count) != 0){
+        char hand_str[64];
+        card_hand_format(hand, "", hand_str, sizeof(hand_str));
+        if(failures++ < 10){
+            printf("NESHODA výčtu: ruka %s, solver %d, hrubá síla %d%s\n", hand_str, count, brute_count,
+                   duplicate ? " (duplicity)" : "");
+        }
+    }
+}
+
+/**
+ * @brief Provede plán v enginu, všechny tahy musí projít
+ */
+static void apply_plan(GameInstance *game, PlayerGameState *player, const SolverPlan *plan){
+    int before = player->hand.count;
+    char body[MAX_SEQUENCE_CARDS * 2 + 8];
+
+    for(int m = 0; m < plan->meld_count; m++){
+        for(int i = 0; i < plan->melds[m].count; i++){
+            memcpy(body + i * 2, card_code(plan->melds[m].cards[i]), 2);
+        }
+        body[plan->melds[m].count * 2] = '\0';
+
+        int result = engine_apply_move(game, player->client_index, MSG_UNLO, body);
+        if(result != 0 && failures++ < 10){
+            printf("NESHODA: UNLO %s odmítnuto (%d)\n", body, result);
+        }
+    }
+    for(int a = 0; a < plan->attach_count; a++){
+        snprintf(body, sizeof(body), "%u|%s", plan->attaches[a].seq_id, card_code(plan->attaches[a].card));
+
+        int result = engine_apply_move(game, player->client_index, MSG_ADDC, body);
+        if(result != 0 && failures++ < 10){
+            printf("NESHODA: ADDC %s odmítnuto (%d)\n", body, result);
+        }
+    }
+    if(before - player->hand.count != plan->discharged && failures++ < 10){
+        printf("NESHODA: plán %d karet, z ruky odešlo %d\n", plan->discharged, before - player->hand.count);
+    }
+    engine_changes_reset(game);
+}
+
+/**
+ * @brief Nejdražší karta ruky kromě žolíka (vyhození)
+ */
+static Card costliest_card(const CardHand *hand){
+    for(int rank = CARD_RANKS - 1; rank >= 0; rank--){
+        for(int suit = 0; suit < CARD_SUITS; suit++){
+            if((hand->ranks[suit] >> rank) & 1u){
+                return card_make(suit, rank);
+            }
+        }
+    }
+    return CARD_JOKER;
+}
+
+static int u64_cmp(const void *a, const void *b){
+    return key_cmp(a, b);
+}
+
+int main(int argc, char **argv){
+    long games = argc > 1 ? atol(argv[1]) : 5000;
+    unsigned budget_us = argc > 2 ? (unsigned)atoi(argv[2]) : 0;
+    if(games <= 0){
+        fprintf(stderr, "Použití: %s [her] [rozpocet_us]\n", argv[0]);
+        return 1;
+    }
+
+    size_t sample_capacity = (size_t)games * 64;
+    uint64_t *samples = malloc(sample_capacity * sizeof(uint64_t));
+    size_t sample_count = 0;
+    unsigned long nodes = 0, incomplete = 0, discharged = 0, finished = 0;
+    static const int ids[2] = {0, 1};
+    GameInstance *game = aligned_alloc(CACHE_LINE_SIZE, sizeof(GameInstance));
+
+    for(long g = 0; g < games; g++){
+        engine_setup(game, ids, 2, (uint64_t)g + 1);
+        engine_start(game);
+
+        for(int turn = 0; turn < MAX_TURNS && game->state == GAME_STATE_PLAYING; turn++){
+            PlayerGameState *player = &game->players[game->current_player_index];
+            int id = player->client_index;
+
+            if(!(player->takes_15 && player->turns_played == 0) && engine_apply_move(game, id, MSG_TAKP, NULL) == -5){
+                engine_apply_move(game, id, MSG_TAKP, NULL);
+            }
+            if(g < BRUTE_GAMES){
+                check_enumeration(&player->hand);
+            }
+
+            SolverPlan plan;
+            uint64_t start = now_ns();
+            solver_plan(&player->hand, game->sequences, game->sequence_count, budget_us, &plan);
+            uint64_t elapsed = now_ns() - start;
+
+            if(sample_count < sample_capacity){
+                samples[sample_count++] = elapsed;
+            }
+            nodes += plan.nodes;
+            incomplete += !plan.complete;
+            discharged += (unsigned long)plan.discharged;
+
+            apply_plan(game, player, &plan);
+
+            if(player->hand.count == 1){
+                char last[64];
+                card_hand_format(&player->hand, "", last, sizeof(last));
+                engine_apply_move(game, id, MSG_CLOS, last);
+            } else{
+                engine_apply_move(game, id, MSG_THRW, card_code(costliest_card(&player->hand)));
+            }
+            engine_changes_reset(game);
+        }
+        finished += game->state == GAME_STATE_FINISHED;
+    }
+
+    qsort(samples, sample_count, sizeof(uint64_t), u64_cmp);
+    uint64_t total = 0;
+    for(size_t i = 0; i < sample_count; i++){
+        total += samples[i];
+    }
+
+    printf("her: %ld (dohráno %lu), plánů: %zu, rozpočet: %u us\n", games, finished, sample_count, budget_us);
+    printf("solver_plan: průměr %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us\n",
+           total / 1000.0 / sample_count, samples[sample_count / 2] / 1000.0,
+           samples[sample_count * 99 / 100] / 1000.0, samples[sample_count - 1] / 1000.0);
+    printf("uzlů na plán: %.1f, nedokončeno: %lu, karet z ruky na plán: %.2f\n",
+           (double)nodes / sample_count, incomplete, (double)discharged / sample_count);
+    printf("neshod: %lu\n", failures);
+
+    free(game);
+    free(samples);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * Serializace STAT na tah: původní game_get_full_state (celý stav s snprintf pro každého příjemce) proti
+ * snímku sdílené části (jednou na tah) + soukromé části příjemce rozložené do iovec.
+ * Měří cenu serializace jednoho tahu podle počtu příjemců (hráči + případní diváci), bez odesílání.
+ * Na začátku ověří, že obě cesty dávají stejné bajty.
+ *
+ * Použití: bench_state [tahu_na_mereni] [pocet_kombinaci_na_stole]
+ */
+#include "../game_manager.h"
+#include "../room_manager.h"
+#include "../client_manager.h"
+#include "../logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Symboly serveru, které game_manager.c potřebuje jen mimo měřenou cestu
+GameRoom *rooms = NULL;
+void server_timer_schedule(TimerNode *timer, uint64_t deadline_ms){ (void)timer; (void)deadline_ms; }
+void server_timer_cancel(TimerNode *timer){ (void)timer; }
+
+static const int recipient_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+/**
+ * @brief Monotónní čas v sekundách
+ */
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Původní formátování STAT (před snímky), převzaté beze změny logiky
+ */
+static int legacy_full_state(GameInstance *game, int client_index, char *buffer, size_t buffer_size){
+    if(!game || !buffer || buffer_size == 0) return -1;
+
+    PlayerGameState *player = NULL;
+    int enemy_card_count = 0;
+
+    for(int i = 0; i < game->player_count; i++){
+        if(game->players[i].client_index == client_index){
+            player = &game->players[i];
+        } else {
+            // Přičítáme jen pokud je slot platný (např. index není -1)
+            if(game->players[i].client_index != -1) {
+                enemy_card_count += game->players[i].hand.count;
+            }
+        }
+    }
+    if(!player) return -1;
+
+    char *ptr = buffer;
+    size_t rem = buffer_size;
+    int written;
+
+    // Ruka
+    written = card_hand_format(&player->hand, "", ptr, rem);
+    if(written < 0) return -2;
+    ptr += written; rem -= written;
+
+    // Delim 1
+    written = snprintf(ptr, rem, "|");
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written; // Tady jsi v původním kódu aktualizaci měl
+
+    // Discard pile
+    if(game->discard_count > 0){
+        written = snprintf(ptr, rem, "%s", card_code(game->discard_deck[game->discard_count-1]));
+    } else {
+        written = 0; 
+    }
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    // Delim 2
+    written = snprintf(ptr, rem, "|");
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    // Postupky
+    for(int i = 0; i < game->sequence_count; i++){
+        if(i > 0){
+            written = snprintf(ptr, rem, ",");
+            if(written < 0 || (size_t)written >= rem) return -2;
+            ptr += written; rem -= written;
+        }
+        for(int j = 0; j < game->sequences[i].count; j++){
+            written = snprintf(ptr, rem, "%s", card_code(game->sequences[i].cards[j]));
+            if(written < 0 || (size_t)written >= rem) return -2;
+            ptr += written; rem -= written;
+        }
+    }
+
+    // Delim 3
+    written = snprintf(ptr, rem, "|");
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    int active_client_index = game->players[game->current_player_index].client_index;
+
+    if(active_client_index == client_index) {
+        written = snprintf(ptr, rem, "TURN");
+    } else {
+        written = snprintf(ptr, rem, "WAIT");
+    }
+
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    // Delim 4
+    written = snprintf(ptr, rem, "|");
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    // Enemy card count
+    written = snprintf(ptr, rem, "%d", enemy_card_count);
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    // Delim 5 + ID postupek ve stejném pořadí (starší klienti pole navíc ignorují)
+    written = snprintf(ptr, rem, "|");
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    for(int i = 0; i < game->sequence_count; i++){
+        written = snprintf(ptr, rem, i > 0 ? ",%u" : "%u", game->sequences[i].id);
+        if(written < 0 || (size_t)written >= rem) return -2;
+        ptr += written; rem -= written;
+    }
+
+    // Delim 6 + verze stavu (základ pro DLTA)
+    written = snprintf(ptr, rem, "|%u", game->state_version);
+    if(written < 0 || (size_t)written >= rem) return -2;
+    ptr += written; rem -= written;
+
+    return (int)(buffer_size - rem);
+}
+
+
+/**
+ * @brief Rozehraná hra: dva hráči s rukou, odhozená karta a kombinace na stole
+ */
+static void bench_game_setup(GameInstance *game, int melds){
+    memset(game, 0, sizeof(*game));
+    game->player_count = 2;
+    game->state = GAME_STATE_PLAYING;
+    game->state_version = 1;
+
+    for(int p = 0; p < 2; p++){
+        game->players[p].client_index = p;
+        card_hand_clear(&game->players[p].hand);
+        for(int i = 0; i < 12; i++){
+            card_hand_add(&game->players[p].hand, (Card)((p * 37 + i * 7) % CARD_NORMAL_COUNT));
+        }
+    }
+
+    game->discard_deck[0] = card_make(2, 9);
+    game->discard_count = 1;
+
+    // Postupky po 4 kartách napříč barvami a balíčky
+    for(int i = 0; i < melds && i < MAX_SEQUENCES; i++){
+        CardSequence *seq = &game->sequences[game->sequence_count++];
+        int suit = i % CARD_SUITS;
+        int low = (i / CARD_SUITS) % (CARD_RANKS - 4);
+
+        seq->count = 4;
+        seq->id = (uint16_t)game->sequence_count;
+        for(int j = 0; j < 4; j++){
+            seq->cards[j] = card_make(suit, low + j);
+        }
+        if(i % 3 == 0){
+            seq->cards[3] = CARD_JOKER;
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    long moves = argc > 1 ? atol(argv[1]) : 20000;
+    int melds = argc > 2 ? atoi(argv[2]) : 12;
+    if(moves <= 0 || melds < 0){
+        fprintf(stderr, "Použití: %s [tahu_na_mereni] [pocet_kombinaci_na_stole]\n", argv[0]);
+        return 1;
+    }
+    log_init("/dev/null", LOG_ERROR);
+
+    GameInstance *game = aligned_alloc(CACHE_LINE_SIZE, sizeof(GameInstance));
+    bench_game_setup(game, melds);
+
+    // Správnost: obě cesty musí dát stejné bajty
+    for(int p = 0; p < 2; p++){
+        char legacy_buffer[4096], new_buffer[4096];
+        int legacy_len = legacy_full_state(game, p, legacy_buffer, sizeof(legacy_buffer));
+        int new_len = game_get_full_state(game, p, new_buffer, sizeof(new_buffer));
+
+        if(legacy_len != new_len || memcmp(legacy_buffer, new_buffer, legacy_len) != 0){
+            printf("NESHODA pro hráče %d:\n  původní: %.*s\n  snímek:  %.*s\n", p,
+                   legacy_len, legacy_buffer, new_len, new_buffer);
+            return 1;
+        }
+        if(p == 0){
+            printf("STAT (%d B): %.*s\n", new_len, new_len, new_buffer);
+        }
+    }
+
+    printf("%-10s %16s %16s %8s\n", "příjemců", "původní ns/tah", "snímek ns/tah", "zrychl.");
+
+    volatile size_t sink = 0;
+    for(size_t r = 0; r < sizeof(recipient_counts) / sizeof(recipient_counts[0]); r++){
+        int recipients = recipient_counts[r];
+
+        // Původní cesta: celý STAT pro každého příjemce
+        double start = now_sec();
+        for(long m = 0; m < moves; m++){
+            game->state_version++;
+            for(int i = 0; i < recipients; i++){
+                char buffer[4096];
+                sink += legacy_full_state(game, i & 1, buffer, sizeof(buffer));
+            }
+        }
+        double legacy_time = now_sec() - start;
+
+        // Snímek: sdílená část jednou za tah, pro příjemce jen ruka a tah do iovec
+        start = now_sec();
+        for(long m = 0; m < moves; m++){
+            game->state_version++;
+            GameSnapshot *snapshot = game_snapshot_acquire(game);
+            for(int i = 0; i < recipients; i++){
+                struct iovec parts[GAME_STATE_PARTS];
+                char private_state[GAME_PRIVATE_STATE_BUFFER];
+                sink += game_get_state_parts(game, i & 1, snapshot, parts, private_state, sizeof(private_state));
+            }
+            game_snapshot_release(snapshot);
+        }
+        double snapshot_time = now_sec() - start;
+
+        printf("%-10d %16.0f %16.0f %7.2fx\n", recipients,
+               legacy_time / moves * 1e9, snapshot_time / moves * 1e9, legacy_time / snapshot_time);
+    }
+    (void)sink;
+
+    game_snapshot_release(game->snapshot);
+    free(game);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# Porovnání režimu vlákno na klienta a epoll reaktorů (spojení/s a paměť na nečinného klienta)
+# Použití: bench/run_connections.sh <pocet_spojeni> [port] [prepinace_serveru...]
+set -euo pipefail
+
+COUNT=${1:-10}
+PORT=${2:-10500}
+shift $(( $# > 2 ? 2 : $# ))
+EXTRA_ARGS=("$@")
+DIR="$(cd "$(dirname "$0")/.." && pwd)"
+WORKDIR="$(mktemp -d)"
+trap 'rm -rf "$WORKDIR"' EXIT
+
+run_mode() {
+  local label="$1"; shift
+  # Kapacita tabulky klientů pro všechna spojení benchmarku (výchozí --max-clients je malé)
+  (cd "$WORKDIR" && exec "$DIR/zolik_server" --max-clients=$((COUNT + 16)) "$@" "${EXTRA_ARGS[@]}" \
+      127.0.0.1 "$PORT" >/dev/null) &
+  local pid=$!
+  sleep 0.5
+  echo "===== $label ====="
+  "$DIR/bench_connections" 127.0.0.1 "$PORT" "$COUNT" "$pid"
+  kill "$pid" 2>/dev/null || true
+  wait "$pid" 2>/dev/null || true
+  sleep 0.5
+}
+
+run_mode "vlákno na klienta"
+run_mode "epoll (--reactor=2)" --reactor=2
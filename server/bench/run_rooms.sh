@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Škálování propustnosti tahů s počtem současně hraných místností, server na jednom CPU a na všech CPU
+# (tahy v různých místnostech běží souběžně -> na více CPU roste propustnost s počtem místností)
+# Použití: bench/run_rooms.sh [sekundy] [port] [rezim_serveru...]
+set -euo pipefail
+
+SECONDS_PER_RUN=${1:-3}
+PORT=${2:-10600}
+shift $(( $# > 2 ? 2 : $# ))
+DIR="$(cd "$(dirname "$0")/.." && pwd)"
+WORKDIR="$(mktemp -d)"
+trap 'rm -rf "$WORKDIR"' EXIT
+
+CPUS=$(nproc)
+if [ "$CPUS" -lt 2 ]; then
+  echo "Pozor: k dispozici je $CPUS CPU, souběh místností se neprojeví" >&2
+fi
+
+for CPU_SET in 0 "0-$((CPUS - 1))"; do
+  echo "===== server na CPU $CPU_SET ====="
+  for ROOMS in 1 2 4 8 16 32; do
+    (cd "$WORKDIR" && exec taskset -c "$CPU_SET" "$DIR/zolik_server" "$@" --max-clients=$((ROOMS * 2 + 8)) \
+        --max-rooms=$((ROOMS + 4)) 127.0.0.1 "$PORT" >/dev/null) &
+    pid=$!
+    sleep 0.5
+    "$DIR/bench_rooms" 127.0.0.1 "$PORT" "$ROOMS" "$SECONDS_PER_RUN"
+    kill "$pid" 2>/dev/null || true
+    wait "$pid" 2>/dev/null || true
+    PORT=$((PORT + 1))
+  done
+  [ "$CPUS" -lt 2 ] && break
+done
@@ -0,0 +1,518 @@
+/**
+ * Simulátor samohry: N celých her dvou botů přes engine (engine_apply_move), paralelně na všech jádrech.
+ * Hra i = seed + i (míchání i rozhodování náhodného bota), výsledky tedy nezávisí na počtu vláken
+ * a kontrolní součet se dá porovnat mezi verzemi enginu.
+ *
+ * Politiky: greedy (bere vyhozenou, když se hodí, vykládá a přikládá, co může, vyhazuje nejdražší
+ * osamocenou kartu), random (líže z balíčku, vykládá, vyhazuje náhodnou kartu), solver (líže a vyhazuje
+ * jako greedy, vykládá a přikládá podle solver_plan).
+ *
+ * Výstup: hry/s, tahy/s, průměrná délka hry, výhry podle politik a rozdělení bodů poraženého.
+ *
+ * Použití: zolik_sim [her] [vlaken] [seed] [politika_hrace_1] [politika_hrace_2]
+ */
+#include "../game_engine.h"
+#include "../meld.h"
+#include "../solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SIM_PLAYERS 2
+#define SIM_MAX_TURNS 1000                 // Hra bez zavření do tohoto počtu tahů se počítá jako nedohraná
+#define SIM_SCORE_BINS 512                 // Histogram bodů (poslední přihrádka: víc)
+
+typedef enum{
+    POLICY_GREEDY,
+    POLICY_RANDOM,
+    POLICY_SOLVER
+} SimPolicy;
+
+static const char *policy_names[] = {"greedy", "random", "solver"};
+
+// Výsledky jednoho vlákna (zarovnané, vlákna nesdílí řádky)
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))){
+    long first_game;                        // Hry first_game, first_game + step, ...
+    long step;
+    long games;
+    uint64_t seed;
+    SimPolicy policies[SIM_PLAYERS];
+
+    long finished;                          // Zavřené hry
+    long moves;                             // Přijaté tahy
+    long rejected;                          // Odmítnuté tahy (chyba bota)
+    long reshuffles;                        // TAKP nad prázdným balíčkem (engine zamíchal odhazovací balíček)
+    long turns;                             // Odehraná kola hráčů v dohraných hrách
+    long wins[SIM_PLAYERS];                 // Výhry podle místa u stolu
+    long score_bins[SIM_SCORE_BINS];        // Body poraženého
+} SimWorker;
+
+/**
+ * @brief Monotónní čas v sekundách
+ */
+static double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Tah přes engine, počítá přijaté a odmítnuté
+ */
+static int sim_move(SimWorker *w, GameInstance *game, int client_index, MessageType action, const char *body){
+    int result = engine_apply_move(game, client_index, action, body);
+
+    if(result == 0){
+        w->moves++;
+    } else if(action == MSG_TAKP && result == -5){
+        w->reshuffles++;
+    } else{
+        w->rejected++;
+    }
+    // Server log změn po každém tahu rozešle a vynuluje, simulátor ho jen vynuluje
+    engine_changes_reset(game);
+    return result;
+}
+
+/**
+ * @brief Karty v ruce jako pole (zástupci kódů, duplicity dvakrát)
+ * @return počet karet
+ */
+static int hand_cards(const CardHand *hand, Card *out){
+    int count = 0;
+
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        for(int rank = 0; rank < CARD_RANKS; rank++){
+            if((hand->ranks[suit] >> rank) & 1u){
+                out[count++] = card_make(suit, rank);
+            }
+            if((hand->doubles[suit] >> rank) & 1u){
+                out[count++] = card_make(suit, rank);
+            }
+        }
+    }
+    for(int j = 0; j < hand->jokers; j++){
+        out[count++] = CARD_JOKER;
+    }
+    return count;
+}
+
+/**
+ * @brief Zapíše kódy karet za sebou (tělo UNLO)
+ */
+static void cards_to_body(const Card *cards, int count, char *body){
+    for(int i = 0; i < count; i++){
+        memcpy(body + i * 2, card_code(cards[i]), 2);
+    }
+    body[count * 2] = '\0';
+}
+
+/**
+ * @brief Najde v ruce největší kombinaci (postupka podle barvy, set podle hodnoty, chybějící kartu doplní žolík)
+ * @param hand Ruka
+ * @param cards Výstup karet kombinace
+ * @param limit Nejvíc karet (v ruce musí zůstat aspoň jedna)
+ * @return počet karet, 0: nic
+ */
+static int find_meld(const CardHand *hand, Card *cards, int limit){
+    int best = 0;
+    int use_joker = hand->jokers > 0;
+
+    // Postupky: nejdelší běh hodnot v barvě (eso i nad králem), s žolíkem přes jednu mezeru
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        uint32_t mask = hand->ranks[suit] | ((uint32_t)(hand->ranks[suit] & 1u) << CARD_RANKS);
+
+        for(int start = 0; start <= CARD_RANKS; start++){
+            if(!((mask >> start) & 1u)){
+                continue;
+            }
+
+            int jokers = use_joker;
+            int len = 0;
+            Card run[MAX_SEQUENCE_CARDS];
+            for(int rank = start; rank <= CARD_RANKS && len < limit; rank++){
+                if((mask >> rank) & 1u){
+                    run[len++] = card_make(suit, rank % CARD_RANKS);
+                } else if(jokers > 0 && rank < CARD_RANKS && ((mask >> (rank + 1)) & 1u)){
+                    run[len++] = CARD_JOKER;
+                    jokers--;
+                } else{
+                    break;
+                }
+            }
+
+            if(len >= 3 && len > best){
+                best = len;
+                memcpy(cards, run, len);
+            }
+        }
+    }
+
+    // Sety: stejná hodnota v různých barvách, dvojici doplní žolík
+    for(int rank = 0; rank < CARD_RANKS; rank++){
+        Card set[CARD_SUITS];
+        int len = 0;
+
+        for(int suit = 0; suit < CARD_SUITS && len < limit; suit++){
+            if((hand->ranks[suit] >> rank) & 1u){
+                set[len++] = card_make(suit, rank);
+            }
+        }
+        if(len == 2 && use_joker && len < limit){
+            set[len++] = CARD_JOKER;
+        }
+        if(len >= 3 && len > best){
+            best = len;
+            memcpy(cards, set, len);
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Jak moc karta v ruce souvisí s ostatními (sousední hodnoty v barvě, stejná hodnota jinde)
+ */
+static int card_links(const CardHand *hand, Card card){
+    int suit = card_suit(card);
+    int rank = card_rank(card);
+    int links = 0;
+
+    for(int d = -2; d <= 2; d++){
+        int r = rank + d;
+        if(d != 0 && r >= 0 && r < CARD_RANKS && ((hand->ranks[suit] >> r) & 1u)){
+            links += (d == -1 || d == 1) ? 2 : 1;
+        }
+    }
+    for(int s = 0; s < CARD_SUITS; s++){
+        if(s != suit && ((hand->ranks[s] >> rank) & 1u)){
+            links += 2;
+        }
+    }
+    return links;
+}
+
+/**
+ * @brief Hodí se karta do ruky (vytvoří dvojici nebo sousedy)?
+ */
+static int card_fits(const CardHand *hand, Card card){
+    if(card_is_joker(card)){
+        return 1;
+    }
+    return card_links(hand, card) >= 3;
+}
+
+/**
+ * @brief Přiloží karty z ruky ke kombinacím na stole (jen platná přiložení, ověřená meld_classify)
+ */
+static void add_to_table(SimWorker *w, GameInstance *game, PlayerGameState *player){
+    int added = 1;
+
+    while(added && player->hand.count > 1){
+        Card cards[CARD_COUNT];
+        int count = hand_cards(&player->hand, cards);
+        added = 0;
+
+        for(int i = 0; i < count && !added; i++){
+            // Žolíky si bot nechává na vlastní kombinace
+            if(card_is_joker(cards[i])){
+                continue;
+            }
+
+            for(int s = 0; s < game->sequence_count; s++){
+                CardSequence *seq = &game->sequences[s];
+                Card extended[MAX_SEQUENCE_CARDS];
+                Meld meld;
+
+                if(seq->count >= MAX_SEQUENCE_CARDS){
+                    continue;
+                }
+                memcpy(extended, seq->cards, seq->count);
+                extended[seq->count] = cards[i];
+                if(meld_classify(extended, seq->count + 1, &meld) != (MeldKind)seq->kind){
+                    continue;
+                }
+
+                char body[16];
+                snprintf(body, sizeof(body), "%u|%s", seq->id, card_code(cards[i]));
+                if(sim_move(w, game, player->client_index, MSG_ADDC, body) == 0){
+                    added = 1;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Vyloží a přiloží podle plánu solveru (bez časového rozpočtu, výsledek nezávisí na stroji)
+ */
+static void play_plan(SimWorker *w, GameInstance *game, PlayerGameState *player){
+    SolverPlan plan;
+    char body[MAX_SEQUENCE_CARDS * 2 + 1];
+
+    solver_plan(&player->hand, game->sequences, game->sequence_count, 0, &plan);
+
+    for(int m = 0; m < plan.meld_count; m++){
+        cards_to_body(plan.melds[m].cards, plan.melds[m].count, body);
+        sim_move(w, game, player->client_index, MSG_UNLO, body);
+    }
+    for(int a = 0; a < plan.attach_count; a++){
+        snprintf(body, sizeof(body), "%u|%s", plan.attaches[a].seq_id, card_code(plan.attaches[a].card));
+        sim_move(w, game, player->client_index, MSG_ADDC, body);
+    }
+}
+
+/**
+ * @brief Karta k vyhození podle politiky (greedy: nejdražší osamocená, random: libovolná kromě žolíka)
+ */
+static Card pick_throw(const CardHand *hand, SimPolicy policy, Rng *rng){
+    Card cards[CARD_COUNT];
+    int count = hand_cards(hand, cards);
+    int normal = count - hand->jokers;
+
+    if(normal == 0){
+        return CARD_JOKER;
+    }
+    if(policy == POLICY_RANDOM){
+        return cards[rng_below(rng, (uint32_t)normal)];
+    }
+
+    Card best = cards[0];
+    int best_score = -1000;
+    for(int i = 0; i < normal; i++){
+        int score = card_value(cards[i]) - 4 * card_links(hand, cards[i]);
+        if(score > best_score){
+            best_score = score;
+            best = cards[i];
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Jedno kolo hráče na tahu: líznutí, vykládání, přikládání, vyhození nebo zavření
+ */
+static void play_turn(SimWorker *w, GameInstance *game, SimPolicy policy, Rng *rng){
+    PlayerGameState *player = &game->players[game->current_player_index];
+    int id = player->client_index;
+
+    // Líznutí (první hráč s 15 kartami v prvním kole nelíže)
+    if(!(player->takes_15 && player->turns_played == 0)){
+        int took = -1;
+
+        if(policy != POLICY_RANDOM && game->discard_count > 0 &&
+           card_fits(&player->hand, game->discard_deck[game->discard_count - 1])){
+            took = sim_move(w, game, id, MSG_TAKT, NULL);
+        }
+        if(took != 0){
+            took = sim_move(w, game, id, MSG_TAKP, NULL);
+            if(took == -5){
+                // Došel balíček, engine zamíchal odhazovací
+                took = sim_move(w, game, id, MSG_TAKP, NULL);
+            }
+            if(took == -6){
+                // Není z čeho lízat, zbývá vyhozená karta
+                sim_move(w, game, id, MSG_TAKT, NULL);
+            }
+        }
+    }
+
+    if(policy == POLICY_SOLVER){
+        play_plan(w, game, player);
+    } else{
+        // Vykládání, dokud něco jde (v ruce zůstane aspoň jedna karta)
+        Card meld[MAX_SEQUENCE_CARDS];
+        int count;
+        while((count = find_meld(&player->hand, meld, player->hand.count - 1)) > 0){
+            char body[MAX_SEQUENCE_CARDS * 2 + 1];
+            cards_to_body(meld, count, body);
+            if(sim_move(w, game, id, MSG_UNLO, body) != 0){
+                break;
+            }
+        }
+
+        if(policy == POLICY_GREEDY){
+            add_to_table(w, game, player);
+        }
+    }
+
+    // Poslední kartou se zavírá, jinak vyhození
+    if(player->hand.count == 1){
+        Card last;
+        hand_cards(&player->hand, &last);
+        sim_move(w, game, id, MSG_CLOS, card_code(last));
+        return;
+    }
+    sim_move(w, game, id, MSG_THRW, card_code(pick_throw(&player->hand, policy, rng)));
+}
+
+/**
+ * @brief Jedna celá hra se seedem seed (míchání i náhodný bot)
+ */
+static void play_game(SimWorker *w, GameInstance *game, uint64_t seed){
+    static const int client_indexes[SIM_PLAYERS] = {0, 1};
+    Rng rng;
+    int turns = 0;
+
+    rng_seed(&rng, seed ^ 0x5EEDB07ULL);
+    engine_setup(game, client_indexes, SIM_PLAYERS, seed);
+    engine_start(game);
+
+    while(game->state == GAME_STATE_PLAYING && turns < SIM_MAX_TURNS){
+        play_turn(w, game, w->policies[game->current_player_index], &rng);
+        turns++;
+    }
+
+    if(game->state != GAME_STATE_FINISHED){
+        return;
+    }
+
+    engine_calculate_scores(game);
+    w->finished++;
+    w->turns += turns;
+
+    for(int p = 0; p < SIM_PLAYERS; p++){
+        int score = game->players[p].score;
+
+        if(game->players[p].hand.count == 0){
+            w->wins[p]++;
+        } else{
+            w->score_bins[score < SIM_SCORE_BINS ? score : SIM_SCORE_BINS - 1]++;
+        }
+    }
+}
+
+static void *sim_worker(void *arg){
+    SimWorker *w = (SimWorker*)arg;
+    GameInstance *game = aligned_alloc(CACHE_LINE_SIZE, sizeof(GameInstance));
+
+    if(!game){
+        return NULL;
+    }
+    for(long i = w->first_game; i < w->games; i += w->step){
+        play_game(w, game, w->seed + (uint64_t)i);
+    }
+    free(game);
+    return NULL;
+}
+
+/**
+ * @brief Percentil z histogramu
+ */
+static int histogram_percentile(const long *bins, long total, double fraction){
+    long target = (long)(total * fraction);
+    long seen = 0;
+
+    for(int i = 0; i < SIM_SCORE_BINS; i++){
+        seen += bins[i];
+        if(seen > target){
+            return i;
+        }
+    }
+    return SIM_SCORE_BINS - 1;
+}
+
+static int parse_policy(const char *name, SimPolicy *policy){
+    for(int i = 0; i < (int)(sizeof(policy_names) / sizeof(policy_names[0])); i++){
+        if(strcmp(name, policy_names[i]) == 0){
+            *policy = (SimPolicy)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv){
+    long games = argc > 1 ? atol(argv[1]) : 100000;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = argc > 2 ? atoi(argv[2]) : (cpus > 0 ? (int)cpus : 1);
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+    SimPolicy policies[SIM_PLAYERS] = {POLICY_GREEDY, POLICY_GREEDY};
+
+    if(games <= 0 || threads <= 0 ||
+       (argc > 4 && parse_policy(argv[4], &policies[0]) != 0) ||
+       (argc > 5 && parse_policy(argv[5], &policies[1]) != 0)){
+        fprintf(stderr, "Použití: %s [her] [vlaken] [seed] [greedy|random|solver] [greedy|random|solver]\n", argv[0]);
+        return 1;
+    }
+
+    SimWorker *workers = aligned_alloc(CACHE_LINE_SIZE, (size_t)threads * sizeof(SimWorker));
+    pthread_t *tids = malloc((size_t)threads * sizeof(pthread_t));
+    if(!workers || !tids){
+        fprintf(stderr, "Nelze alokovat vlákna\n");
+        return 1;
+    }
+    memset(workers, 0, (size_t)threads * sizeof(SimWorker));
+
+    double start = now_sec();
+    for(int t = 0; t < threads; t++){
+        workers[t].first_game = t;
+        workers[t].step = threads;
+        workers[t].games = games;
+        workers[t].seed = seed;
+        memcpy(workers[t].policies, policies, sizeof(policies));
+        pthread_create(&tids[t], NULL, sim_worker, &workers[t]);
+    }
+
+    // Sloučení výsledků vláken
+    SimWorker total;
+    memset(&total, 0, sizeof(total));
+    for(int t = 0; t < threads; t++){
+        pthread_join(tids[t], NULL);
+
+        total.finished += workers[t].finished;
+        total.moves += workers[t].moves;
+        total.rejected += workers[t].rejected;
+        total.reshuffles += workers[t].reshuffles;
+        total.turns += workers[t].turns;
+        for(int p = 0; p < SIM_PLAYERS; p++){
+            total.wins[p] += workers[t].wins[p];
+        }
+        for(int i = 0; i < SIM_SCORE_BINS; i++){
+            total.score_bins[i] += workers[t].score_bins[i];
+        }
+    }
+    double elapsed = now_sec() - start;
+
+    long losers = 0;
+    double score_sum = 0;
+    for(int i = 0; i < SIM_SCORE_BINS; i++){
+        losers += total.score_bins[i];
+        score_sum += (double)i * total.score_bins[i];
+    }
+
+    printf("her: %ld (%s vs %s), vláken: %d, seed: %llu\n", games, policy_names[policies[0]],
+           policy_names[policies[1]], threads, (unsigned long long)seed);
+    printf("čas: %.2f s, %.0f her/s, %.0f tahů/s\n", elapsed, games / elapsed, total.moves / elapsed);
+    printf("dohráno: %ld (%.1f %%), odmítnutých tahů: %ld, nových balíčků: %ld\n", total.finished,
+           100.0 * total.finished / games, total.rejected, total.reshuffles);
+    if(total.finished > 0){
+        printf("délka hry: %.1f kol, %.1f tahů\n", (double)total.turns / total.finished,
+               (double)total.moves / games);
+        printf("výhry: hráč 1 (%s) %.1f %%, hráč 2 (%s) %.1f %%\n",
+               policy_names[policies[0]], 100.0 * total.wins[0] / total.finished,
+               policy_names[policies[1]], 100.0 * total.wins[1] / total.finished);
+    }
+    if(losers > 0){
+        printf("body poraženého: průměr %.1f, p10 %d, p50 %d, p90 %d, p99 %d\n", score_sum / losers,
+               histogram_percentile(total.score_bins, losers, 0.10),
+               histogram_percentile(total.score_bins, losers, 0.50),
+               histogram_percentile(total.score_bins, losers, 0.90),
+               histogram_percentile(total.score_bins, losers, 0.99));
+    }
+
+    // Kontrolní součet ze sloučených výsledků (nezávisí na rozdělení her mezi vlákna)
+    uint64_t repeatable = 0;
+    for(int i = 0; i < SIM_SCORE_BINS; i++){
+        repeatable = repeatable * 1099511628211ULL + (uint64_t)total.score_bins[i];
+    }
+    repeatable ^= (uint64_t)total.moves * 31 + (uint64_t)total.turns;
+    printf("kontrolní součet: %016llx\n", (unsigned long long)repeatable);
+
+    free(tids);
+    free(workers);
+    return 0;
+}
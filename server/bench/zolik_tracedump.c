@@ -0,0 +1,146 @@
+/**
+ * Dekodér binárního trasování serveru (--trace=soubor, trace.h) do textu nebo CSV.
+ * Záznamy vypisuje od nejstaršího, který v kruhovém souboru zůstal, sloty rozepsané v okamžiku
+ * pádu nebo ukončení přeskočí. Payload s popisem "typ" se vypíše jako typ zprávy (4 znaky).
+ *
+ * Použití: zolik_tracedump [--csv] <soubor>
+ */
+#include "../trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char *event_names[TRACE_EVENT_COUNT] = {
+    [TRACE_NONE] = "NONE",
+#define TRACE_NAME_ENTRY(name, a, b, c) [TRACE_##name] = #name,
+    TRACE_EVENTS(TRACE_NAME_ENTRY)
+#undef TRACE_NAME_ENTRY
+};
+
+static const char *payload_labels[TRACE_EVENT_COUNT][3] = {
+#define TRACE_LABEL_ENTRY(name, a, b, c) [TRACE_##name] = {a, b, c},
+    TRACE_EVENTS(TRACE_LABEL_ENTRY)
+#undef TRACE_LABEL_ENTRY
+};
+
+/**
+ * @brief Zapíše hodnotu payloadu podle popisu (typ zprávy, znaménkový výsledek, číslo)
+ */
+static void print_payload(const char *label, uint32_t value){
+    if(strcmp(label, "typ") == 0){
+        char type[5];
+        for(int i = 0; i < 4; i++){
+            unsigned char ch = (unsigned char)(value >> (8 * i));
+            type[i] = ch >= 32 && ch < 127 ? (char)ch : '?';
+        }
+        type[4] = '\0';
+        printf("%s", type);
+    } else if(strcmp(label, "výsledek") == 0 || strcmp(label, "kód") == 0){
+        printf("%d", (int32_t)value);
+    } else{
+        printf("%u", value);
+    }
+}
+
+int main(int argc, char **argv){
+    int csv = 0;
+    const char *path = NULL;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--csv") == 0){
+            csv = 1;
+        } else{
+            path = argv[i];
+        }
+    }
+    if(!path){
+        fprintf(stderr, "Použití: %s [--csv] <soubor>\n", argv[0]);
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceHeader)){
+        fprintf(stderr, "Nelze číst %s\n", path);
+        return 1;
+    }
+
+    const TraceHeader *header = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(header == MAP_FAILED || header->magic != TRACE_MAGIC || header->version != TRACE_VERSION ||
+       header->record_size != sizeof(TraceRecord) ||
+       sizeof(TraceHeader) + header->capacity * sizeof(TraceRecord) > (size_t)st.st_size){
+        fprintf(stderr, "%s není soubor trasování (verze %d)\n", path, TRACE_VERSION);
+        return 1;
+    }
+
+    const TraceRecord *records = (const TraceRecord*)(header + 1);
+    uint64_t next = atomic_load(&((TraceHeader*)header)->next);
+    uint64_t first = next > header->capacity ? next - header->capacity : 0;
+    unsigned long skipped = 0;
+
+    if(csv){
+        printf("cas_ns,realny_cas_ns,vlakno,udalost,klient,mistnost,a,b,c\n");
+    }
+
+    for(uint64_t pos = first; pos < next; pos++){
+        const TraceRecord *r = &records[pos & (header->capacity - 1)];
+        uint32_t thread_event = atomic_load_explicit((_Atomic uint32_t*)&r->thread_event, memory_order_acquire);
+        TraceEvent event = trace_record_event(thread_event);
+        uint32_t thread = trace_record_thread(thread_event);
+
+        if(event == TRACE_NONE || event >= TRACE_EVENT_COUNT){
+            skipped++;
+            continue;
+        }
+
+        uint64_t relative = r->timestamp_ns - header->start_monotonic_ns;
+        uint64_t realtime = header->start_realtime_ns + relative;
+        const char *const *labels = payload_labels[event];
+        uint32_t values[3] = {r->a, r->b, r->c};
+
+        if(csv){
+            printf("%llu,%llu,%u,%s,%d,%d", (unsigned long long)r->timestamp_ns, (unsigned long long)realtime,
+                   thread, event_names[event], r->client_index, r->room_id);
+            for(int i = 0; i < 3; i++){
+                printf(",");
+                print_payload(labels[i], values[i]);
+            }
+            printf("\n");
+            continue;
+        }
+
+        time_t seconds = (time_t)(realtime / 1000000000ULL);
+        struct tm tm;
+        char timebuf[32];
+        localtime_r(&seconds, &tm);
+        strftime(timebuf, sizeof(timebuf), "%Y-%m-%d %H:%M:%S", &tm);
+
+        printf("%s.%06llu +%.6f T%u %-17s", timebuf, (unsigned long long)(realtime % 1000000000ULL / 1000),
+               relative / 1e9, thread, event_names[event]);
+        if(r->client_index >= 0){
+            printf(" klient=%d", r->client_index);
+        }
+        if(r->room_id >= 0){
+            printf(" místnost=%d", r->room_id);
+        }
+        for(int i = 0; i < 3; i++){
+            if(strcmp(labels[i], "-") != 0){
+                printf(" %s=", labels[i]);
+                print_payload(labels[i], values[i]);
+            }
+        }
+        printf("\n");
+    }
+
+    fprintf(stderr, "záznamů: %llu (v souboru %llu, kapacita %llu), rozepsaných: %lu\n",
+            (unsigned long long)next, (unsigned long long)(next - first),
+            (unsigned long long)header->capacity, skipped);
+    munmap((void*)header, (size_t)st.st_size);
+    return 0;
+}
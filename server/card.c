@@ -0,0 +1,216 @@
+#include "card.h"
+#include <string.h>
+
+// Řádky tabulek pro jednu barvu (13 hodnot), tabulky se skládají při překladu
+#define CARD_ROW_RANKS 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12
+#define CARD_ROW_VALUES 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13
+#define CARD_ROW_SUIT(s) s, s, s, s, s, s, s, s, s, s, s, s, s
+#define CARD_ROW_CODES(s) \
+    {'A', s, 0}, {'2', s, 0}, {'3', s, 0}, {'4', s, 0}, {'5', s, 0}, {'6', s, 0}, {'7', s, 0}, \
+    {'8', s, 0}, {'9', s, 0}, {'X', s, 0}, {'J', s, 0}, {'Q', s, 0}, {'K', s, 0}
+
+// Jeden balíček: barvy H, D, C, S
+#define CARD_DECK_RANKS CARD_ROW_RANKS, CARD_ROW_RANKS, CARD_ROW_RANKS, CARD_ROW_RANKS
+#define CARD_DECK_VALUES CARD_ROW_VALUES, CARD_ROW_VALUES, CARD_ROW_VALUES, CARD_ROW_VALUES
+#define CARD_DECK_SUITS CARD_ROW_SUIT(0), CARD_ROW_SUIT(1), CARD_ROW_SUIT(2), CARD_ROW_SUIT(3)
+#define CARD_DECK_CODES CARD_ROW_CODES('H'), CARD_ROW_CODES('D'), CARD_ROW_CODES('C'), CARD_ROW_CODES('S')
+
+const uint8_t card_rank_table[CARD_COUNT] = {
+    CARD_DECK_RANKS, CARD_DECK_RANKS,
+    CARD_JOKER_RANK, CARD_JOKER_RANK, CARD_JOKER_RANK, CARD_JOKER_RANK
+};
+
+const uint8_t card_suit_table[CARD_COUNT] = {
+    CARD_DECK_SUITS, CARD_DECK_SUITS,
+    CARD_JOKER_SUIT, CARD_JOKER_SUIT, CARD_JOKER_SUIT, CARD_JOKER_SUIT
+};
+
+const uint8_t card_value_table[CARD_COUNT] = {
+    CARD_DECK_VALUES, CARD_DECK_VALUES,
+    CARD_JOKER_VALUE, CARD_JOKER_VALUE, CARD_JOKER_VALUE, CARD_JOKER_VALUE
+};
+
+const char card_code_table[CARD_COUNT][3] = {
+    CARD_DECK_CODES, CARD_DECK_CODES,
+    "YY", "YY", "YY", "YY"
+};
+
+// Znak kódu -> hodnota + 1 / barva + 1 (0: neplatný znak)
+static const uint8_t rank_of_char[128] = {
+    ['A'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4, ['5'] = 5, ['6'] = 6, ['7'] = 7,
+    ['8'] = 8, ['9'] = 9, ['X'] = 10, ['J'] = 11, ['Q'] = 12, ['K'] = 13
+};
+static const uint8_t suit_of_char[128] = {
+    ['H'] = 1, ['D'] = 2, ['C'] = 3, ['S'] = 4
+};
+
+// Bitové roviny bodových hodnot: bit r roviny b je nastaven, pokud hodnota r + 1 má bit b
+static const uint16_t value_planes[4] = {
+    0x1555,     // 1, 3, 5, 7, 9, 11, 13
+    0x0666,     // 2, 3, 6, 7, 10, 11
+    0x1878,     // 4..7, 12, 13
+    0x1F80      // 8..13
+};
+
+Card card_from_chars(const char *code){
+    unsigned char r = (unsigned char)code[0];
+    unsigned char s = (unsigned char)code[1];
+
+    if(r == 'Y' && s == 'Y'){
+        return CARD_JOKER;
+    }
+    if(r >= 128 || s >= 128 || !rank_of_char[r] || !suit_of_char[s]){
+        return CARD_NONE;
+    }
+    return card_make(suit_of_char[s] - 1, rank_of_char[r] - 1);
+}
+
+Card card_from_code(const char *code){
+    if(!code || strlen(code) != 2){
+        return CARD_NONE;
+    }
+    return card_from_chars(code);
+}
+
+void card_hand_clear(CardHand *hand){
+    memset(hand, 0, sizeof(*hand));
+}
+
+int card_hand_add(CardHand *hand, Card card){
+    if(card >= CARD_COUNT){
+        return -1;
+    }
+
+    if(card_is_joker(card)){
+        if(hand->jokers >= CARD_JOKERS){
+            return -1;
+        }
+        hand->jokers++;
+    } else{
+        int suit = card_suit(card);
+        uint16_t bit = (uint16_t)(1u << card_rank(card));
+
+        if(hand->doubles[suit] & bit){
+            return -1;
+        }
+        if(hand->ranks[suit] & bit){
+            hand->doubles[suit] |= bit;
+        } else{
+            hand->ranks[suit] |= bit;
+        }
+    }
+
+    hand->count++;
+    return 0;
+}
+
+int card_hand_remove(CardHand *hand, Card card){
+    if(card >= CARD_COUNT){
+        return -1;
+    }
+
+    if(card_is_joker(card)){
+        if(hand->jokers == 0){
+            return -1;
+        }
+        hand->jokers--;
+    } else{
+        int suit = card_suit(card);
+        uint16_t bit = (uint16_t)(1u << card_rank(card));
+
+        if(hand->doubles[suit] & bit){
+            hand->doubles[suit] &= (uint16_t)~bit;
+        } else if(hand->ranks[suit] & bit){
+            hand->ranks[suit] &= (uint16_t)~bit;
+        } else{
+            return -1;
+        }
+    }
+
+    hand->count--;
+    return 0;
+}
+
+int card_hand_copies(const CardHand *hand, Card card){
+    if(card >= CARD_COUNT){
+        return 0;
+    }
+    if(card_is_joker(card)){
+        return hand->jokers;
+    }
+
+    int suit = card_suit(card);
+    uint16_t bit = (uint16_t)(1u << card_rank(card));
+    return ((hand->ranks[suit] & bit) != 0) + ((hand->doubles[suit] & bit) != 0);
+}
+
+int card_hand_value(const CardHand *hand){
+    int value = hand->jokers * CARD_JOKER_VALUE;
+
+    // Součet hodnot = součet přes bitové roviny hodnot (popcount * váha roviny)
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        for(int plane = 0; plane < 4; plane++){
+            value += (__builtin_popcount(hand->ranks[suit] & value_planes[plane])
+                    + __builtin_popcount(hand->doubles[suit] & value_planes[plane])) << plane;
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Připojí kód karty (s oddělovačem) do bufferu
+ * @return 0: SUCCESS, -1: ERROR (buffer nestačí)
+ */
+static int card_format_append(Card card, const char *separator, size_t sep_len,
+                              char *buffer, size_t buffer_size, size_t *pos){
+    size_t need = (*pos > 0 ? sep_len : 0) + 2;
+
+    if(*pos + need >= buffer_size){
+        return -1;
+    }
+    if(*pos > 0){
+        memcpy(buffer + *pos, separator, sep_len);
+        *pos += sep_len;
+    }
+    memcpy(buffer + *pos, card_code(card), 2);
+    *pos += 2;
+    return 0;
+}
+
+int card_hand_format(const CardHand *hand, const char *separator, char *buffer, size_t buffer_size){
+    size_t sep_len = strlen(separator);
+    size_t pos = 0;
+
+    if(buffer_size == 0){
+        return -1;
+    }
+
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        uint16_t ranks = hand->ranks[suit];
+
+        // Jen nastavené bity, druhý exemplář hned za prvním
+        while(ranks){
+            int rank = __builtin_ctz(ranks);
+            Card card = card_make(suit, rank);
+            ranks &= (uint16_t)(ranks - 1);
+
+            if(card_format_append(card, separator, sep_len, buffer, buffer_size, &pos) != 0){
+                return -1;
+            }
+            if((hand->doubles[suit] >> rank) & 1u){
+                if(card_format_append(card, separator, sep_len, buffer, buffer_size, &pos) != 0){
+                    return -1;
+                }
+            }
+        }
+    }
+
+    for(int j = 0; j < hand->jokers; j++){
+        if(card_format_append(CARD_JOKER, separator, sep_len, buffer, buffer_size, &pos) != 0){
+            return -1;
+        }
+    }
+
+    buffer[pos] = '\0';
+    return (int)pos;
+}
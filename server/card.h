@@ -0,0 +1,142 @@
+#ifndef CARD_H
+#define CARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CARD_SUITS 4                                            // H, D, C, S
+#define CARD_RANKS 13                                           // A..K
+#define CARD_DECKS 2                                            // Hraje se se dvěma balíčky
+#define CARD_JOKERS 4
+#define CARD_NORMAL_COUNT (CARD_DECKS * CARD_SUITS * CARD_RANKS) // 104
+#define CARD_COUNT (CARD_NORMAL_COUNT + CARD_JOKERS)            // 108
+
+#define CARD_JOKER CARD_NORMAL_COUNT                            // Kanonický žolík
+#define CARD_NONE 0xFF                                          // Neplatná karta
+#define CARD_JOKER_RANK CARD_RANKS                              // Hodnota žolíka v card_rank_table
+#define CARD_JOKER_SUIT CARD_SUITS                              // Barva žolíka v card_suit_table
+#define CARD_JOKER_VALUE 50                                     // Body za žolíka v ruce
+#define CARD_RANK_MASK ((1u << CARD_RANKS) - 1)                 // Všechny hodnoty jedné barvy
+
+/**
+ * Karta jako jeden bajt: (balíček * 4 + barva) * 13 + hodnota, žolíci 104..107.
+ * Karty se stejným kódem (dva balíčky, čtyři žolíci) jsou ve hře zaměnitelné.
+ */
+typedef uint8_t Card;
+
+/** Hodnota 0..12 (A..K), žolík CARD_JOKER_RANK */
+extern const uint8_t card_rank_table[CARD_COUNT];
+/** Barva 0..3 (H, D, C, S), žolík CARD_JOKER_SUIT */
+extern const uint8_t card_suit_table[CARD_COUNT];
+/** Bodová hodnota 1..13, žolík CARD_JOKER_VALUE */
+extern const uint8_t card_value_table[CARD_COUNT];
+/** Dvouznakový kód karty protokolu ("AH", "XS", "YY") */
+extern const char card_code_table[CARD_COUNT][3];
+
+static inline int card_is_joker(Card card){
+    return card >= CARD_NORMAL_COUNT;
+}
+
+static inline int card_rank(Card card){
+    return card_rank_table[card];
+}
+
+static inline int card_suit(Card card){
+    return card_suit_table[card];
+}
+
+static inline int card_value(Card card){
+    return card_value_table[card];
+}
+
+static inline const char *card_code(Card card){
+    return card_code_table[card];
+}
+
+/**
+ * @brief Zástupce karty se stejným kódem (první balíček, žolík -> CARD_JOKER)
+ * @param card Karta
+ */
+static inline Card card_face(Card card){
+    return card_is_joker(card) ? (Card)CARD_JOKER : (Card)(card % (CARD_SUITS * CARD_RANKS));
+}
+
+/**
+ * @brief Karta prvního balíčku pro danou barvu a hodnotu
+ * @param suit Barva 0..3
+ * @param rank Hodnota 0..12
+ */
+static inline Card card_make(int suit, int rank){
+    return (Card)(suit * CARD_RANKS + rank);
+}
+
+/**
+ * @brief Převod kódu protokolu na kartu (prvního balíčku, žolík -> CARD_JOKER)
+ * @param code Přesně dva znaky zakončené nulou
+ * @return karta, CARD_NONE: neplatný kód
+ */
+Card card_from_code(const char *code);
+
+/**
+ * @brief Převod dvou znaků kódu (bez zakončení) na kartu
+ * @param code Ukazatel na dva znaky
+ * @return karta, CARD_NONE: neplatný kód
+ */
+Card card_from_chars(const char *code);
+
+// Ruka jako bitové masky hodnot po barvách, druhý exemplář karty má vlastní masku
+typedef struct{
+    uint16_t ranks[CARD_SUITS];     // Bit r: v ruce je alespoň jedna karta hodnoty r
+    uint16_t doubles[CARD_SUITS];   // Bit r: v ruce jsou oba exempláře
+    uint8_t jokers;                 // Počet žolíků
+    uint8_t count;                  // Počet karet v ruce
+} CardHand;
+
+/**
+ * @brief Vyprázdní ruku
+ * @param hand Ruka
+ */
+void card_hand_clear(CardHand *hand);
+
+/**
+ * @brief Přidá kartu do ruky
+ * @param hand Ruka
+ * @param card Karta
+ * @return 0: SUCCESS, -1: ERROR (neplatná karta nebo víc exemplářů, než je v balíčcích)
+ */
+int card_hand_add(CardHand *hand, Card card);
+
+/**
+ * @brief Odebere z ruky jednu kartu se stejným kódem
+ * @param hand Ruka
+ * @param card Karta
+ * @return 0: SUCCESS, -1: ERROR (karta není v ruce)
+ */
+int card_hand_remove(CardHand *hand, Card card);
+
+/**
+ * @brief Počet karet se stejným kódem v ruce
+ * @param hand Ruka
+ * @param card Karta
+ * @return 0..2, u žolíka 0..4
+ */
+int card_hand_copies(const CardHand *hand, Card card);
+
+/**
+ * @brief Součet bodových hodnot karet v ruce
+ * @param hand Ruka
+ * @return body
+ */
+int card_hand_value(const CardHand *hand);
+
+/**
+ * @brief Zapíše kódy karet v ruce (po barvách a hodnotách, žolíci na konci)
+ * @param hand Ruka
+ * @param separator Oddělovač mezi kartami ("" bez oddělovače)
+ * @param buffer Buffer
+ * @param buffer_size Velikost bufferu
+ * @return počet zapsaných znaků, -1: ERROR (buffer nestačí)
+ */
+int card_hand_format(const CardHand *hand, const char *separator, char *buffer, size_t buffer_size);
+
+#endif
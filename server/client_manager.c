@@ -2,25 +2,330 @@
 #include "room_manager.h"
 #include "game_manager.h"
 #include "logger.h"
+#include "frame_buffer.h"
+#include "slot_index.h"
+#include "rng.h"
+#include "trace.h"
+#include "metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <stddef.h>
+#include <stdatomic.h>
 #include <sys/socket.h> // pro shutdown
 
 // #include "game_manager.h"
 
 
 
-ClientContext clients[MAX_CLIENTS];
+ClientContext *clients = NULL;
+int max_clients = 0;
+TimerWheel server_timers;
+static pthread_mutex_t server_timers_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-void initialize_clients(){
+// Zásobník volných slotů (chráněno clients_mutex)
+static int *free_client_slots = NULL;
+static int free_client_count = 0;
+static unsigned char *client_slot_listed = NULL;    // 1: slot je v zásobníku
+
+// Hash indexy přihlášených slotů (chráněno clients_mutex)
+static SlotIndex nick_index;
+static SlotIndex token_index;
+// Abeceda tokenu pro reconnect
+static const char token_charset[] = "abcdefghijklmnopqrstuvwxyz";
+// Délka tokenu zvolená podle kapacity (initialize_clients)
+static int token_len = TOKEN_LEN_MIN;
+// Počty pro správcovské rozhraní, udržují je změny stavu (client_set_status) a lhůty pro reconnect
+static atomic_int client_status_counts[PLAYER_STATUS_COUNT];
+static atomic_int client_reconnect_wait_count;
+static atomic_int server_timers_count;
+
+static const char *client_nick_of(int slot){
+    return clients[slot].nick;
+}
+
+static const char *client_token_of(int slot){
+    return clients[slot].token;
+}
+
+/**
+ * @brief Odstraní slot z indexů nicku a tokenu (volat pod clients_mutex, před smazáním nicku)
+ */
+static void client_unindex_locked(int client_index){
+    if(clients[client_index].nick[0] != '\0'){
+        slot_index_remove(&nick_index, client_index);
+    }
+    if(clients[client_index].token[0] != '\0'){
+        slot_index_remove(&token_index, client_index);
+    }
+}
+
+void client_set_status(ClientContext *client, PlayerStatus status){
+    PlayerStatus previous = client->status;
+    client->status = status;
+    if(previous == status){
+        return;
+    }
+
+    if(previous > DISCONNECTED && previous < PLAYER_STATUS_COUNT){
+        atomic_fetch_sub_explicit(&client_status_counts[previous], 1, memory_order_relaxed);
+    }
+    if(status > DISCONNECTED && status < PLAYER_STATUS_COUNT){
+        atomic_fetch_add_explicit(&client_status_counts[status], 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Klient už nečeká na reconnect (vrátil se nebo byl smazán), volat pod clients_mutex
+ */
+static void client_reconnect_wait_end_locked(ClientContext *client){
+    if(client->reconnect_waiting){
+        client->reconnect_waiting = 0;
+        atomic_fetch_sub_explicit(&client_reconnect_wait_count, 1, memory_order_relaxed);
+    }
+}
+
+void client_gauges(ClientGauges *gauges){
+    for(int i = 0; i < PLAYER_STATUS_COUNT; i++){
+        gauges->status[i] = atomic_load_explicit(&client_status_counts[i], memory_order_relaxed);
+    }
+    gauges->reconnect_wait = atomic_load_explicit(&client_reconnect_wait_count, memory_order_relaxed);
+    gauges->timers = atomic_load_explicit(&server_timers_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Vynuluje slot klienta kromě odchozí fronty (ta žije po celou dobu běhu serveru)
+ */
+static void client_slot_reset(ClientContext *client){
+    // Počty pro správcovské rozhraní se srovnají ještě před smazáním stavu
+    client_set_status(client, DISCONNECTED);
+    client_reconnect_wait_end_locked(client);
+
+    memset(client, 0, offsetof(ClientContext, out));
+    client->socket_fd = -1;
+    client->player_id = -1;
+    client->status = DISCONNECTED;
+}
+
+/**
+ * @brief Označí klienta za odpojeného a spustí lhůtu pro reconnect (volat pod clients_mutex)
+ */
+static void client_mark_disconnected_locked(ClientContext *client){
+    client->disconnect_time = timer_now_ms();
+
+    // Nepřihlášený klient nemá co obnovovat
+    if(client->nick[0] != '\0'){
+        server_timer_schedule(&client->reconnect_timer, client->disconnect_time + RECONNECT_TIMEOUT * 1000ULL);
+        if(!client->reconnect_waiting){
+            client->reconnect_waiting = 1;
+            atomic_fetch_add_explicit(&client_reconnect_wait_count, 1, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Přihlášený klient: spustí PING a hlídání heartbeatu, zruší lhůtu pro reconnect (volat pod clients_mutex)
+ */
+static void client_arm_timers_locked(ClientContext *client){
+    uint64_t now = timer_now_ms();
+    server_timer_cancel(&client->reconnect_timer);
+    client_reconnect_wait_end_locked(client);
+    server_timer_schedule(&client->ping_timer, now + CLIENT_PING_INTERVAL_MS);
+    server_timer_schedule(&client->heartbeat_timer, client->last_heartbeat + HEARTBEAT_TIMEOUT * 1000ULL);
+}
+
+/**
+ * @brief PING časovač: pošle PING a naplánuje další, dokud je klient připojen
+ */
+static void client_ping_expired(TimerNode *timer){
+    ClientContext *client = (ClientContext*)timer->arg;
+
     pthread_mutex_lock(&clients_mutex);
-    
+    if(client->is_connected && client->socket_fd >= 0){
+        client_send(client, PING, "");
+        server_timer_schedule(timer, timer_now_ms() + CLIENT_PING_INTERVAL_MS);
+    }
+    pthread_mutex_unlock(&clients_mutex);
+}
+
+/**
+ * @brief Heartbeat časovač: pokud mezitím přišla zpráva, jen se posune na nový deadline, jinak odpojí klienta
+ */
+static void client_heartbeat_expired(TimerNode *timer){
+    ClientContext *client = (ClientContext*)timer->arg;
+    int client_index = (int)(client - clients);
+
+    pthread_mutex_lock(&clients_mutex);
+
+    if(!client->is_connected){
+        pthread_mutex_unlock(&clients_mutex);
+        return;
+    }
+
+    // last_heartbeat se obnovuje s každou zprávou, časovač se přeplánuje až tady
+    uint64_t deadline = client->last_heartbeat + HEARTBEAT_TIMEOUT * 1000ULL;
+    if(deadline > timer_now_ms()){
+        server_timer_schedule(timer, deadline);
+        pthread_mutex_unlock(&clients_mutex);
+        return;
+    }
+
+    LOG_INFO("Klient '%s' timeout (heartbeat) - odpojuji \n", client->nick);
+    TRACE(HEARTBEAT_TIMEOUT, client_index, client->current_room ? client->current_room->room_id : -1,
+          client->socket_fd, 0, 0);
+    metrics_add(METRIC_HEARTBEAT_TIMEOUTS, 1);
+
+    int oldfd = client->socket_fd;
+    GameRoom *room = client->current_room;
+
+    if (oldfd >= 0) {
+        client_send(client, LBBY, "Ztraceno spojení (heartbeat)");
+    }
+
+    if (room) {
+        pthread_mutex_lock(&room->lock);
+    }
+
+    client->socket_fd = -1;
+    client->is_connected = 0;
+    client->is_active = 0;
+    client->last_status = client->status;
+    client_mark_disconnected_locked(client);
+
+    if (room) {
+        broadcast_to_room_locked(room, LBBY, "Protihráč se odpojil", client_index);
+        if (room->game_instance) {
+            game_pause((GameInstance*)room->game_instance, "Protihráč se odpojil");
+        }
+        pthread_mutex_unlock(&room->lock);
+    }
+
+    pthread_mutex_unlock(&clients_mutex);
+
+    if (oldfd >= 0) {
+        // probudit recv() ve starém klientském vlákně / reaktoru, socket zavře jeho vlastník
+        shutdown(oldfd, SHUT_RDWR);
+    }
+}
+
+/**
+ * @brief Reconnect časovač: klient se nevrátil včas -> ukonči jeho hru a smaž data slotu
+ */
+static void client_reconnect_expired(TimerNode *timer){
+    ClientContext *client = (ClientContext*)timer->arg;
+    int i = (int)(client - clients);
+
+    pthread_mutex_lock(&clients_mutex);
+
+    // Mezitím se vrátil (nebo slot už někdo vyčistil)
+    if(client->is_connected || client->is_active || client->nick[0] == '\0'){
+        pthread_mutex_unlock(&clients_mutex);
+        return;
+    }
+
+    // Odpojení se mezitím opakovalo -> počítá se od posledního
+    uint64_t deadline = client->disconnect_time + RECONNECT_TIMEOUT * 1000ULL;
+    if(deadline > timer_now_ms()){
+        server_timer_schedule(timer, deadline);
+        pthread_mutex_unlock(&clients_mutex);
+        return;
+    }
+
+    LOG_INFO("Mažu data hráče '%s' (reconnect timeout)\n", clients[i].nick);
+
+    if (clients[i].current_room) {
+        GameRoom *room = clients[i].current_room;
+        int room_id = room->room_id;
+
+        pthread_mutex_lock(&room->lock);
+
+        if (room->game_instance) {
+            broadcast_to_room_locked(room, LBBY, "Protihráč se nestihl znovu připojit. Hra končí.", i);
+            
+            game_destroy((GameInstance*)room->game_instance);
+            room->game_instance = NULL;
+            room_set_status(room, ROOM_WAITING);
+            room->player_count--;
+            room_list_invalidate();
+            delete_room(room->room_id);
+        }
+
+        for (int j = 0; j < MAX_PLAYERS_PER_ROOM; j++) {
+            int other_idx = room->player_indexes[j];
+            if (other_idx != -1 && other_idx != i) {
+                client_set_status(&clients[other_idx], CONNECTED);
+                room->ready_players[j] = 0;
+            }
+        }
+        room->ready_count = 0;
+
+        leave_room(room_id, i);
+        pthread_mutex_unlock(&room->lock);
+    }
+
+    server_timer_cancel(&clients[i].ping_timer);
+    server_timer_cancel(&clients[i].heartbeat_timer);
+    client_unindex_locked(i);
+    client_slot_reset(&clients[i]);
+    client_slot_release_locked(i);
+
+    pthread_mutex_unlock(&clients_mutex);
+}
+
+int initialize_clients(int capacity){
+    // Jeden souvislý, na cache line zarovnaný blok pro všechny sloty
+    void *table = NULL;
+    if(capacity <= 0 || posix_memalign(&table, CACHE_LINE_SIZE, (size_t)capacity * sizeof(ClientContext)) != 0){
+        LOG_ERROR("Nelze alokovat tabulku klientů (%d)\n", capacity);
+        return -1;
+    }
+    memset(table, 0, (size_t)capacity * sizeof(ClientContext));
+
+    free_client_slots = (int*)malloc((size_t)capacity * sizeof(int));
+    client_slot_listed = (unsigned char*)calloc((size_t)capacity, 1);
+    if(!free_client_slots || !client_slot_listed){
+        LOG_ERROR("Nelze alokovat zásobník volných slotů\n");
+        free(table);
+        free(free_client_slots);
+        free(client_slot_listed);
+        return -1;
+    }
+
+    if(slot_index_init(&nick_index, capacity, client_nick_of) != 0 || slot_index_init(&token_index, capacity, client_token_of) != 0){
+        LOG_ERROR("Nelze alokovat hash indexy klientů\n");
+        free(table);
+        free(free_client_slots);
+        free(client_slot_listed);
+        free(nick_index.entries);
+        return -1;
+    }
+
+    // Nejkratší token, u kterého na každý slot připadá aspoň TOKEN_SPACE_PER_CLIENT možností
+    unsigned long long token_space = 1;
+    token_len = 0;
+    while(token_len < TOKEN_LEN_MAX &&
+          (token_len < TOKEN_LEN_MIN || token_space < (unsigned long long)capacity * TOKEN_SPACE_PER_CLIENT)){
+        token_space *= sizeof(token_charset) - 1;
+        token_len++;
+    }
+    LOG_INFO("Délka tokenu pro reconnect: %d (kapacita %d)\n", token_len, capacity);
+
+    pthread_mutex_lock(&clients_mutex);
+
+    clients = (ClientContext*)table;
+    max_clients = capacity;
+    timer_wheel_init(&server_timers, timer_now_ms(), TIMER_TICK_MS);
+    free_client_count = 0;
+
     // Inicializuj všechny sloty jako prázdné
-    for(int i = 0; i < MAX_CLIENTS; i++) {
-        memset(&clients[i], 0, sizeof(ClientContext));
+    for(int i = 0; i < max_clients; i++) {
+        client_slot_reset(&clients[i]);
+        out_queue_init(&clients[i].out);
+        timer_init(&clients[i].ping_timer, client_ping_expired, &clients[i]);
+        timer_init(&clients[i].heartbeat_timer, client_heartbeat_expired, &clients[i]);
+        timer_init(&clients[i].reconnect_timer, client_reconnect_expired, &clients[i]);
         clients[i].socket_fd = -1;
         clients[i].player_id = -1;
         clients[i].is_connected = 0;
@@ -29,1258 +334,1483 @@ void initialize_clients(){
         clients[i].last_heartbeat = 0;
         clients[i].disconnect_time = 0;
     }
-    
+
+    // Pozpátku, aby se sloty přidělovaly od nejnižšího indexu
+    for(int i = max_clients - 1; i >= 0; i--){
+        client_slot_release_locked(i);
+    }
+
     pthread_mutex_unlock(&clients_mutex);
-    LOG_INFO("Klienti nainicializováni (MAX_CLIENTS=%d)\n", MAX_CLIENTS);
+    LOG_INFO("Klienti nainicializováni (max_clients=%d, slot=%zu B)\n", max_clients, sizeof(ClientContext));
+    return 0;
+}
+
+int client_slot_acquire_locked(){
+    while(free_client_count > 0){
+        int index = free_client_slots[--free_client_count];
+        client_slot_listed[index] = 0;
+
+        // Slot mohl být mezitím obsazen jinou cestou -> vrátí se, až se znovu uvolní
+        if(clients[index].socket_fd == -1 && clients[index].nick[0] == '\0'){
+            return index;
+        }
+    }
+    return -1;
+}
+
+void client_slot_release_locked(int client_index){
+    if(client_index < 0 || client_index >= max_clients || client_slot_listed[client_index]){
+        return;
+    }
+
+    // Slot s nickem drží data pro reconnect
+    if(clients[client_index].socket_fd != -1 || clients[client_index].nick[0] != '\0'){
+        return;
+    }
+
+    client_slot_listed[client_index] = 1;
+    free_client_slots[free_client_count++] = client_index;
 }
 
 void remove_client(int client_socket){
     pthread_mutex_lock(&clients_mutex);
     // odstraní klienta z paměti
-    for(int i = 0; i < MAX_CLIENTS; i++) {
+    for(int i = 0; i < max_clients; i++) {
         if(clients[i].socket_fd == client_socket) {
+            out_queue_detach(&clients[i].out, client_socket);
             close(clients[i].socket_fd);
             clients[i].socket_fd = -1;
             clients[i].is_connected = 0;
             clients[i].is_active = 0;
-            clients[i].disconnect_time = time(NULL);
+            client_mark_disconnected_locked(&clients[i]);
+            client_slot_release_locked(i);
             break;
         }
     }
     pthread_mutex_unlock(&clients_mutex);
 }
 
+int client_send_len(ClientContext *client, const char *type_msg, const char *message, size_t msg_len){
+    return out_queue_send(&client->out, type_msg, message, msg_len);
+}
+
+int client_sendv(ClientContext *client, const char *type_msg, const struct iovec *parts, int count){
+    return out_queue_sendv(&client->out, type_msg, parts, count);
+}
+
+int client_send(ClientContext *client, const char *type_msg, const char *message){
+    return client_send_len(client, type_msg, message, strlen(message));
+}
+
+int client_send_error(ClientContext *client, const char *err_msg){
+    return client_send(client, ERRR, err_msg);
+}
+
 int find_player_by_nick(const char* nick){
-    for(int i = 0; i < MAX_CLIENTS; i++){
-        if(clients[i].nick[0] != '\0' && strcmp(clients[i].nick, nick) == 0){
-            return i;
-        }
-    }
+    return slot_index_find(&nick_index, nick);
+}
 
-    return -1;
+int find_player_by_token(const char* token){
+    return slot_index_find(&token_index, token);
 }
 
 void broadcast(const char *type_msg, const char *msg){
-    for(int i = 0; i < MAX_CLIENTS; i++){
-        if(clients[i].socket_fd >= 0 && clients[i].status == CONNECTED){
-            if(strcmp(type_msg, RLIS) == 0){
-                char room_list[4096];
-                int count = get_room_list(room_list, sizeof(room_list));
+    if(strcmp(type_msg, RLIS) != 0){
+        return;
+    }
 
-                if(count > 0){
-                    send_message(clients[i].socket_fd, type_msg, room_list);
-                }
-            }
-        }   
+    // Sdílená zpráva se seznamem místností, sestavuje se jen po změně místností
+    OutFrame *frame = room_list_frame(NULL);
+    if(!frame){
+        return;
     }
+
+    pthread_mutex_lock(&clients_mutex);
+    for(int i = 0; i < max_clients; i++){
+        if(clients[i].socket_fd >= 0 && clients[i].status == CONNECTED){
+            out_queue_push(&clients[i].out, frame);
+        }
+    }
+    pthread_mutex_unlock(&clients_mutex);
+
+    out_frame_release(frame);
+}
+
+void server_timer_schedule(TimerNode *timer, uint64_t deadline_ms){
+    pthread_mutex_lock(&server_timers_mutex);
+    timer_schedule(&server_timers, timer, deadline_ms);
+    pthread_mutex_unlock(&server_timers_mutex);
+}
+
+void server_timer_cancel(TimerNode *timer){
+    pthread_mutex_lock(&server_timers_mutex);
+    timer_cancel(&server_timers, timer);
+    pthread_mutex_unlock(&server_timers_mutex);
 }
 
 void check_client_timeouts(){
-    time_t now = time(NULL);
+    for(;;){
+        // Kolo se zamyká jen na vyzvednutí, obsluha si vezme zámky vlastníka časovače (klient / místnost)
+        pthread_mutex_lock(&server_timers_mutex);
+        TimerNode *timer = timer_wheel_expire(&server_timers, timer_now_ms());
+        if(!timer){
+            // Počet časovačů pro správcovské rozhraní, jednou za tick
+            atomic_store_explicit(&server_timers_count, server_timers.count, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&server_timers_mutex);
 
-    pthread_mutex_lock(&clients_mutex);
-    for(int i = 0; i < MAX_CLIENTS; i++){
-        if(clients[i].socket_fd == -1 && !clients[i].is_active && clients[i].nick[0] == '\0'){
-            continue;
+        if(!timer){
+            break;
         }
+        timer->callback(timer);
+    }
+}
 
-        if(clients[i].is_connected){
-            if(clients[i].socket_fd >= 0){
-                send_message(clients[i].socket_fd, "PING", "");
-            }
+void generate_token(char *token, int length) {
+    // Generátor vlákna (rand() je sdílený a volá se z více klientských vláken)
+    rng_token(token, length, token_charset);
+}
 
-            if (now - clients[i].last_heartbeat > HEARTBEAT_TIMEOUT) {
-    LOG_INFO("Klient '%s' timeout (heartbeat) - odpojuji \n", clients[i].nick);
+void client_attach(ThreadContext *ctx){
+    int client_sock = ctx->socket_fd;
+    int client_index = ctx->client_index;
+    ClientContext *client = &clients[client_index];
 
-    // DLOG("HB TIMEOUT idx=%d nick='%s' fd=%d is_conn=%d last_hb=%ld now=%ld",
-    //      i, clients[i].nick, clients[i].socket_fd, clients[i].is_connected,
-    //      (long)clients[i].last_heartbeat, (long)now);
+    // Inicializace klienta
+    pthread_mutex_lock(&clients_mutex);
+    client->socket_fd = client_sock;
+    client->player_id = client_index;
+    client_set_status(client, DISCONNECTED);
+    client->invalid_message_count = 0;
+    client->is_active = 1;
+    client->is_connected = 0;
+    client->disconnect_time = 0;
+    client->last_heartbeat = timer_now_ms();
+    // memset(client->nick, 0, NICK_LEN + 1);   // Jméno nenastavovat -> nebylo by možné dohledat klienty
+    out_queue_attach(&client->out, client_sock);
+    pthread_mutex_unlock(&clients_mutex);
 
-    int oldfd = clients[i].socket_fd;
-    GameRoom *room = clients[i].current_room;
+    LOG_INFO("Spojení převzato pro klienta (fd=%d, index=%d)\n", client_sock, client_index);
+    TRACE(CONNECT, client_index, -1, client_sock, 0, 0);
+}
 
-    clients[i].socket_fd = -1;
-    clients[i].is_connected = 0;
-    clients[i].disconnect_time = now;
-    clients[i].is_active = 0;
+// Kontext zpracovávané zprávy, předává se obslužným funkcím z dispatch tabulky
+typedef struct{
+    ThreadContext *ctx;                     // Kontext spojení (při reconnectu se mění index)
+    int client_sock;                        // Socket spojení
+    int client_index;                       // Index klienta
+    ClientContext *client;                  // Klient
+    const ProtocolHeader *header;           // Hlavička zprávy
+    char *message_body;                     // Tělo zprávy
+    GameRoom *room;                         // Místnost klienta (nastaví guard stavu, její zámek je držen)
+    GameInstance *game;                     // Hra v místnosti (nastaví guard stavu)
+    int room_id;                            // Identifikátor místnosti
+    int should_disconnect;                  // 1: klient má být odpojen
+} MessageContext;
+
+// Obsluha jedné zprávy, volá se pod clients_mutex a zámkem místnosti klienta (pokud v nějaké je)
+typedef void (*MessageHandler)(MessageContext *m);
+
+// Obsluha všech zpráv v jednom stavu klienta
+typedef struct{
+    int (*guard)(MessageContext *m);        // Předpoklady stavu (NULL: žádné), 0: zprávu nezpracovávat
+    int room_only;                          // 1: obsluhy stačí zámek místnosti, clients_mutex se před nimi uvolní
+    MessageHandler fallback;                // Obsluha zprávy, která v tomto stavu nemá handler
+    MessageHandler handlers[MSG_COUNT];     // Obsluha podle typu zprávy
+} StatusDispatch;
+
+/**
+ * @brief Pošle hráči jeho stav hry: DLTA, pokud si ho vyžádal a má verzi, od které se vede log změn, jinak STAT
+ * (volat pod zámkem místnosti)
+ * @param game Instance hry
+ * @param client Klient (hráč)
+ * @param allow_delta 0: vždy plný STAT (vstup do hry, reconnect)
+ */
+static void send_state_to_client(GameInstance *game, ClientContext *client, int allow_delta){
+    char state[4096];
+    int written;
+
+    if(allow_delta && client->delta_stat){
+        written = game_get_delta_state(game, client->player_id, client->stat_version, state, sizeof(state));
+
+        if(written > 0){
+            client_send_len(client, DLTA, state, written);
+            client->stat_version = game->state_version;
+            return;
+        }
+    }
 
-    clients[i].last_status = clients[i].status;
+    // Sdílená část je pro všechny hráče stejná, doplní se jen ruka a tah klienta
+    GameSnapshot *snapshot = game_snapshot_acquire(game);
+    if(!snapshot){
+        return;
+    }
 
-    pthread_mutex_unlock(&clients_mutex);
+    struct iovec parts[GAME_STATE_PARTS];
+    written = game_get_state_parts(game, client->player_id, snapshot, parts, state, sizeof(state));
 
-    if (oldfd >= 0) {
-        send_message(oldfd, LBBY, "Ztraceno spojení (heartbeat)");
+    if(written > 0){
+        client_sendv(client, STAT, parts, GAME_STATE_PARTS);
+        client->stat_version = game->state_version;
+    }
+    game_snapshot_release(snapshot);
+}
 
-        // probudit recv() ve starém klientském vlákně
-        shutdown(oldfd, SHUT_RDWR);
-        close(oldfd);
+/**
+ * @brief Pošle všem hráčům v místnosti jejich personalizovaný stav hry (STAT nebo DLTA) a začne nový log změn
+ */
+static void send_state_to_players(GameRoom *room){
+    if(!room->game_instance){
+        return;
     }
+    GameInstance *game = (GameInstance*)room->game_instance;
 
-    if (room) {
-        broadcast_to_room(room->room_id, LBBY, "Protihráč se odpojil", -1);
-        if (room->game_instance) {
-            game_pause((GameInstance*)room->game_instance, "Protihráč se odpojil");
+    // Projdeme všechny sloty pro hráče v místnosti
+    for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+        int idx = room->player_indexes[i];
+
+        // Kontrola, zda je na tomto indexu připojený klient
+        if(idx != -1 && idx < max_clients){
+            send_state_to_client(game, &clients[idx], 1);
         }
     }
 
-    pthread_mutex_lock(&clients_mutex);
+    game_delta_reset(game);
 }
-        }
-         else {
-            if(clients[i].is_active){
-                continue;
-            }
-            if (now - clients[i].disconnect_time > RECONNECT_TIMEOUT) {
-                LOG_INFO("Mažu data hráče '%s' (reconnect timeout)\n", clients[i].nick);
-
-                if (clients[i].current_room) {
-                    GameRoom *room = clients[i].current_room;
-                    int room_id = room->room_id;
-
-                    if (room->game_instance) {
-                        pthread_mutex_unlock(&clients_mutex);
-                        broadcast_to_room(room_id, LBBY, "Protihráč se nestihl znovu připojit. Hra končí.", i);
-                        pthread_mutex_lock(&clients_mutex);
-                        
-                        game_destroy((GameInstance*)room->game_instance);
-                        room->game_instance = NULL;
-                        room->status = ROOM_WAITING;
-                        room->player_count--;
-                        delete_room(room->room_id);
-                    }
 
-                    for (int j = 0; j < MAX_PLAYERS_PER_ROOM; j++) {
-                        int other_idx = room->player_indexes[j];
-                        if (other_idx != -1 && other_idx != i) {
-                            clients[other_idx].status = CONNECTED;
-                            room->ready_players[j] = 0;
-                        }
-                    }
-                    room->ready_count = 0;
+/**
+ * @brief Rozdá po startu hry tahy (TURN/WAIT) a karty (CRDS) všem hráčům v místnosti
+ */
+static void send_game_start(GameRoom *room){
+    if(!room->game_instance){
+        return;
+    }
+    GameInstance *game = (GameInstance*)room->game_instance;
 
-                    leave_room(room_id, i);
-                }
+    for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+        int idx = room->player_indexes[i];
+
+        if(idx != -1 && idx < max_clients){
+            int current_player_idx = room->player_indexes[game->current_player_index];
+
+            // Nová hra: první stav dostane klient celý
+            clients[idx].stat_version = 0;
 
-                memset(&clients[i], 0, sizeof(ClientContext));
-                clients[i].socket_fd = -1;
-                clients[i].player_id = -1;
-                clients[i].status = DISCONNECTED;
-                clients[i].nick[0] = '\0'; 
+            if(idx == current_player_idx){
+                client_set_status(&clients[idx], ON_TURN);
+                client_send(&clients[idx], TURN, "Jsi na tahu");
+            } else{
+                client_set_status(&clients[idx], ON_WAIT);
+                client_send(&clients[idx], WAIT, "Čekej");
+            }
+
+            char hand_cards[2048];
+            if(game_get_player_cards(game, idx, hand_cards, sizeof(hand_cards)) > 0){
+                client_send(&clients[idx], CRDS, hand_cards);
             }
         }
     }
-    pthread_mutex_unlock(&clients_mutex);
 }
 
-void generate_token(char *token, int length) {
-    // Definice povolených znaků (abeceda pro token)
-    // const char charset[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    const char charset[] = "abcdefghijklmnopqrstuvwxyz";
-    int charset_size = sizeof(charset) - 1;
+// ________ Předpoklady stavů ________
+
+/**
+ * @brief Klient musí být v místnosti (IN_ROOM)
+ */
+static int guard_room(MessageContext *m){
+    m->room = m->client->current_room;
 
-    for (int i = 0; i < length; i++) {
-        int key = rand() % charset_size;
-        token[i] = charset[key];
-        // token[i] = charset[0];
+    if(!m->room){
+        client_send_error(m->client, "Nejsi v místnosti");
+        client_set_status(m->client, CONNECTED);
+        return 0;
     }
-    
-    // Každý řetězec v C musí být zakončen nulovým znakem
-    token[length] = '\0';
+    m->room_id = m->room->room_id;
+    return 1;
 }
 
-void* client_handler(void* arg){
-    // Předání kontextu uživatele
-    ThreadContext *context = (ThreadContext*)arg;
-    int client_sock = context->socket_fd;
-    int client_index = context->client_index;
-    free(context);
+/**
+ * @brief V místnosti klienta musí běžet hra (ON_TURN, ON_WAIT, GAME_DONE)
+ */
+static int guard_game(MessageContext *m){
+    m->room = m->client->current_room;
 
-    ClientContext *client = &clients[client_index];
+    if(!m->room || !m->room->game_instance){
+        client_send_error(m->client, "Hra neběží");
+        client_set_status(m->client, CONNECTED);
+        return 0;
+    }
+    m->game = (GameInstance*)m->room->game_instance;
+    m->room_id = m->room->room_id;
+    return 1;
+}
 
-    // Inicializace klienta
-    pthread_mutex_lock(&clients_mutex);
+// ________ Společné obsluhy ________
+
+/**
+ * @brief Zpráva bez reakce (PONG, PING před přihlášením) -> heartbeat už je aktualizován
+ */
+static void on_ignore(MessageContext *m){
+    (void)m;
+}
+
+/**
+ * @brief DLTA: klient zapíná ("1") nebo vypíná ("0") změny stavu místo STAT, ve hře dostane hned celý STAT
+ * (zároveň slouží jako žádost o nový STAT, když klient nesedí verze)
+ */
+static void on_delta(MessageContext *m){
+    m->client->delta_stat = !(m->message_body && strcmp(m->message_body, "0") == 0);
+    client_send(m->client, OKAY, "DLTA");
+
+    if(m->game && m->game->state == GAME_STATE_PLAYING){
+        send_state_to_client(m->game, m->client, 0);
+    }
+}
+
+/**
+ * @brief Uživatel se odpojuje
+ */
+static void on_quit(MessageContext *m){
+    m->should_disconnect = 1;
+}
+
+// ________ DISCONNECTED ________
+
+/**
+ * @brief LOGI: přihlášení nového hráče nebo reconnect podle nicku (a tokenu)
+ */
+static void on_login(MessageContext *m){
+    ClientContext *client = m->client;
+    char *message_body = m->message_body;
+    int client_sock = m->client_sock;
+    int client_index = m->client_index;
+
+    if(!message_body || strlen(message_body) == 0 || strlen(message_body) > NICK_LEN) {
+        client_send_error(client, "Neplatná délka nicku");
+        shutdown(client_sock, SHUT_RDWR);
+        return;
+    }
+
+    // Tady je potřeba pokus o rozparsování, pokud se ve zprávě nachází | delimeter
+    char nick[NICK_LEN + 1] = {0};
+    char token[TOKEN_LEN_MAX + 1] = {0};
+    int has_token = 0;
+
+    const char *sep = strchr(message_body, '|');
+
+    // Pokud přišel požadavek s tokenem
+    if (sep) {
+        size_t nick_len = sep - message_body;
+
+        const char *token_ptr = sep + 1;
+        size_t token_len_received = strlen(token_ptr);
+
+        if (nick_len == 0 || nick_len > NICK_LEN) {
+            client_send_error(client, "Neplatná délka nicku");
+            return;
+        }
+
+        if (token_len_received != (size_t)token_len) {
+            client_send_error(client, "Neplatná délka tokenu");
+            return;
+        }
+
+        memcpy(nick, message_body, nick_len);
+        nick[nick_len] = '\0';
+
+        memcpy(token, token_ptr, token_len);
+        token[token_len] = '\0';
+
+        has_token = 1;
+        printf("Reconnect pokus: nick=%s, token=%s\n", nick, token);
+    }
+    // Pokud nepřišel požadavek s tokenem
+    else{
+        size_t nick_len = strlen(message_body);
+
+        if(nick_len == 0 || nick_len > NICK_LEN){
+            client_send_error(client, "Neplatná délka nicku");
+            return;
+        }
+        strncpy(nick, message_body, NICK_LEN);
+        nick[NICK_LEN] = '\0';
+
+        printf("Nové připojení: nick=%s\n", nick);
+    }
+
+    // POKUS O RECONNECT - najdi hráče podle tokenu (musí sedět i nick), jinak podle nicku
+    int existing_idx = has_token ? find_player_by_token(token) : -1;
+    if(existing_idx >= 0 && strcmp(clients[existing_idx].nick, nick) != 0){
+        existing_idx = -1;
+    }
+    if(existing_idx < 0){
+        existing_idx = find_player_by_nick(nick);
+    }
+    LOG_INFO("Nick: %s, has_token:%d, token:%s", nick, has_token, token);
+
+    if(existing_idx >= 0) {
+        if(clients[existing_idx].is_connected /*|| !has_token*/){
+            LOG_DEBUG("DEBUG: Jméno je obsazené (is_connected=1)\n");
+            client_send_error(client, "Uživatel již existuje");
+            shutdown(client->socket_fd, SHUT_RDWR);
+            return;
+        }
+
+        // Porovnání tokenů
+        // if (strcmp(clients[existing_idx].token, token) != 0){
+        //     client_send_error(client, "Neplatný token");
+        //     return;
+        // }
+        if (existing_idx != client_index){
+            clients[existing_idx].socket_fd = client_sock;
+            clients[existing_idx].is_active = 1;
+
+            client->socket_fd = -1;
+            client->is_active = 0;
+
+            // Odchozí fronta jde se socketem do původního slotu
+            out_queue_detach(&client->out, client_sock);
+            out_queue_attach(&clients[existing_idx].out, client_sock);
+
+            // Dočasný slot nového spojení je znovu volný
+            client_slot_release_locked(client_index);
+
+            client_index = existing_idx;
+            client = &clients[client_index];
+            m->ctx->client_index = client_index;
+            m->client_index = client_index;
+            m->client = client;
+        } else{
+            client->socket_fd = client_sock;
+            client->is_active = 1;
+        }
+
+        clients[client_index].is_connected = 1;
+        clients[client_index].last_heartbeat = timer_now_ms();
+        client_arm_timers_locked(&clients[client_index]);
+
+        // Status hráče v místnosti patří pod zámek místnosti
+        GameRoom *last_room = clients[client_index].current_room;
+        if(last_room){
+            pthread_mutex_lock(&last_room->lock);
+        }
+        client_set_status(&clients[client_index], clients[client_index].last_status);
+        if(last_room){
+            pthread_mutex_unlock(&last_room->lock);
+        }
+
+        pthread_mutex_unlock(&clients_mutex);
+        client_send(&clients[client_index], RECO, "Reconnect úspěšný");
+
+        // Na základě posledního statu před odhlášením pošli poslední stav
+        // Stav se nemohl změnit, protože klient byl odpojen ve chvíli, kdy druhý uživatel nemohl učinit další tah
+        switch(client->last_status){
+            case CONNECTED:
+                client_send(client, OKAY, "LOBBY");
+                break;
+
+            case IN_ROOM:
+                client_send(client, OKAY, "LOBBY");
+                break;
+
+            case ON_TURN:
+                client_send(client, OKAY, "TURN");
+                break;
+
+            case ON_WAIT:
+                client_send(client, OKAY, "WAIT");
+                break;
+
+            case GAME_DONE:
+                client_send(client, OKAY, "LOBBY");
+                break;
+
+            case PAUSED:
+                client_send(client, OKAY, "PAUSED");
+                break;
+
+            default:
+                client_send(client, OKAY, "LOBBY");
+                break;
+        }
+        LOG_INFO("Reconnect úspesny");
+        TRACE(RECONNECT, client_index, last_room ? last_room->room_id : -1, client_sock, 0, 0);
+        metrics_add(METRIC_RECONNECTS, 1);
+
+        // Stav hry dorazí po RECO a OKAY (pořadí drží odchozí fronta), obsluhy se volají pod clients_mutex
+        pthread_mutex_lock(&clients_mutex);
+        GameRoom *room = clients[client_index].current_room;
+
+        if (room) {
+            pthread_mutex_lock(&room->lock);
+            GameInstance *game = room->game_instance;
+
+            if (game && game->state == GAME_STATE_PAUSED) {
+                game_resume(game);
+            }
+
+            if (game) {
+                send_state_to_client(game, &clients[client_index], 0);
+
+                broadcast_to_room_locked(room, RESU, "Hráč se vrátil do hry, obnovuji hru", -1);
+            } else{
+                client_set_status(client, CONNECTED);
+            }
+            pthread_mutex_unlock(&room->lock);
+        }
+        return;
+    }
+
+
+    // Nejedná se o reconnect, ale o nového hráče
+    LOG_DEBUG("Vytvářím nového hráče '%s' na slotu %d\n", nick, client_index);
+
+    // Token musí být unikátní, bez něj by reconnect nenašel slot -> přihlášení se odmítne
+    int token_indexed = 0;
+    for(int attempt = 0; attempt < TOKEN_ATTEMPTS && !token_indexed; attempt++){
+        generate_token(client->token, token_len);
+        token_indexed = slot_index_insert(&token_index, client_index) == 0;
+    }
+    if(!token_indexed){
+        LOG_ERROR("Nelze přidělit unikátní token (nick=%s, slot=%d, délka %d)\n", nick, client_index, token_len);
+        client->token[0] = '\0';
+        client_send_error(client, "Nelze přidělit token, zkus to později");
+        shutdown(client_sock, SHUT_RDWR);
+        return;
+    }
+
+    strncpy(client->nick, nick, NICK_LEN);
+    client->nick[NICK_LEN] = '\0';
+    client_set_status(client, CONNECTED);
+    client->is_connected = 1;
+    client->invalid_message_count = 0;
     client->socket_fd = client_sock;
     client->player_id = client_index;
-    client->status = DISCONNECTED;
-    client->invalid_message_count = 0;
-    client->is_active = 1;
-    client->is_connected = 0;
-    client->disconnect_time = 0;
-    client->last_heartbeat = time(NULL);
-    // memset(client->nick, 0, NICK_LEN + 1);   // Jméno nenastavovat -> nebylo by možné dohledat klienty
-    pthread_mutex_unlock(&clients_mutex);
+    slot_index_insert(&nick_index, client_index);
+    client_arm_timers_locked(client);
+
+    // Vygenerovaný token pošli s potvrzovací zprávou
+    char message[40];
+    snprintf(message, sizeof(message), "Vítej ve hře!|%s", client->token);
+    client_send(client, OKAY, message);
+
+    LOG_INFO("Nový klient '%s' přihlášen (fd=%d, slot=%d, token=%s)\n",
+           client->nick, client->socket_fd, client_index, client->token);
+    TRACE(LOGIN, client_index, -1, client->socket_fd, 0, 0);
+}
+
+/**
+ * @brief Pokud přijde cokoliv jiného než očekáváno, odpoj klienta
+ */
+static void on_expect_login(MessageContext *m){
+    client_send_error(m->client, "Očekáván příkaz LOGI");
+    m->should_disconnect = 1;
+}
+
+// ________ CONNECTED ________
+
+/**
+ * @brief RLIS: zašli klientovi aktuální místnosti, pokud existují
+ */
+static void on_room_list(MessageContext *m){
+    OutFrame *room_list = room_list_frame(NULL);
+
+    if(room_list){
+        out_queue_push(&m->client->out, room_list);
+        out_frame_release(room_list);
+    } else{
+        client_send(m->client, ELIS, "Žádné místnosti");
+    }
+}
+
+/**
+ * @brief RCRT: vytvoř místnost, pokud to lze a připoj tvůrce do místnosti
+ */
+static void on_room_create(MessageContext *m){
+    ClientContext *client = m->client;
+
+    if(!m->message_body || strlen(m->message_body) == 0) {
+        client_send(client, ECRT, "Chybí název");
+        return;
+    }
+
+    int room_id = create_room(m->message_body, client->player_id);
+
+    if(room_id >= 0){
+        char room_id_str[12];
+        snprintf(room_id_str, sizeof(room_id_str), "%d", room_id);
+
+        GameRoom *room = &rooms[room_id];
+        pthread_mutex_lock(&room->lock);
+        client_set_status(client, IN_ROOM);
+        client->current_room = room;
+        pthread_mutex_unlock(&room->lock);
+
+        client_send(client, OCRT, room_id_str);
+        client_send(client, BOSS, "1");
+
+        pthread_mutex_unlock(&clients_mutex);
+        broadcast(RLIS, "");
+        pthread_mutex_lock(&clients_mutex);
+    } else{
+        client_send(client, ECRT, "Nelze vytvořit");
+    }
+}
+
+/**
+ * @brief RCNT: pokud existuje požadovaná místnost, připoj klienta do místnosti, pokud tak může učinit
+ */
+static void on_room_connect(MessageContext *m){
+    ClientContext *client = m->client;
+
+    if(!m->message_body || strlen(m->message_body) == 0){
+        client_send(client, ECNT, "Chybí ID");
+        return;
+    }
+
+    int room_id = atoi(m->message_body);
+    GameRoom *room = find_room(room_id);
+    int connected = 0;
+
+    if(room){
+        pthread_mutex_lock(&room->lock);
+        if(connect_room(room_id, client->player_id) >= 0){
+            client_set_status(client, IN_ROOM);
+            client->current_room = room;
+            connected = 1;
+        }
+        pthread_mutex_unlock(&room->lock);
+    }
+
+    if(connected){
+        client_send(client, OCNT, m->message_body);
+    } else {
+        client_send(client, ECNT, "Nelze připojit");
+    }
+}
 
-    // DLOG("THREAD START slot=%d fd=%d nick='%s' is_conn=%d",
-    // client_index, client_sock, client->nick, client->is_connected);
-    // printf("=== ClientContext ===\n");
-    // printf("socket_fd           : %d\n", client->socket_fd);
-    // printf("player_id           : %d\n", client->player_id);
-    // printf("nick                : '%s'\n", client->nick);
-    // printf("status              : %d\n", client->status);
-    // printf("last_status         : %d\n", client->last_status);
-    // printf("is_active           : %d\n", client->is_active);
-    // printf("is_connected        : %d\n", client->is_connected);
-    // printf("invalid_msg_count   : %d\n", client->invalid_message_count);
+/**
+ * @brief Neznámý příkaz v lobby -> odpoj klienta
+ */
+static void on_lobby_unknown(MessageContext *m){
+    client_send_error(m->client, "Neznámý příkaz (CONNECTED)");
+    m->client->invalid_message_count++;
+    metrics_add(METRIC_INVALID_FRAMES, 1);
+    m->should_disconnect = 1;
+}
 
-    // printf("last_heartbeat      : %ld\n", (long)client->last_heartbeat);
-    // printf("disconnect_time     : %ld\n", (long)client->disconnect_time);
+// ________ IN_ROOM ________
 
-    // printf("current_room        : %p\n", (void *)client->current_room);
-    // printf("token               : '%s'\n", client->token);
+/**
+ * @brief RDIS: pokud lze, odpoj klienta z místnosti, předej vedení, případně smaž místnost
+ */
+static void on_room_leave(MessageContext *m){
+    int room_id = m->room_id;
 
-    // printf("=====================\n");
-    LOG_INFO("Vlákno spuštěno pro klienta (fd=%d, index=%d)\n", client_sock, client_index);
+    leave_room(room_id, m->client_index);
+    if(delete_room(room_id) == -1){
+        broadcast_to_room_locked(m->room, BOSS, "Byl jsi jmenován vlastníkem", -1);
+    }
 
-    while(1){
-        ProtocolHeader header;
-        memset(&header, 0, sizeof(header));
-        char* message_body = NULL;
+    m->client->current_room = NULL;
+    client_set_status(m->client, CONNECTED);
 
-        int message_status = read_full_message(client_sock, &header, &message_body);
+    client_send(m->client, ODIS, "Opuštěno");
+}
 
-        if (message_status == -1) {
-            LOG_INFO("Klient se odpojil (fd=%d, idx=%d, nick=%s)\n",
-                    client_sock, client_index, clients[client_index].nick);
+/**
+ * @brief REDY: od/připrav klienta v místnosti
+ */
+static void on_ready(MessageContext *m){
+    int room_id = m->room_id;
+    int ready = (m->message_body && m->message_body[0] == '1') ? 1 : 0;
+
+    if(set_player_ready(room_id, m->client_index, ready) == 0){
+        char ready_players_str[128];
+        char room_info[1024];
+        GameRoom *room = m->room;
+
+        snprintf(ready_players_str, sizeof(ready_players_str),
+                "(%d/%d)", room->ready_count, room->max_players);
+
+        get_room_info(room_id, room_info, sizeof(room_info));
+        broadcast_to_room_locked(room, PRDY, ready_players_str, -1);
+        broadcast_to_room_locked(room, RINF, room_info, -1);
+    } else{
+        client_send_error(m->client, "Chyba ready");
+    }
+}
 
-            // DLOG("DISCONNECT fd=%d slot=%d (before) ctx_fd=%d is_conn=%d nick='%s'",
-            // client_sock, client_index, clients[client_index].socket_fd,
-            // clients[client_index].is_connected, clients[client_index].nick);
+/**
+ * @brief STRT: pokud může být hra spuštěna, spusť hru
+ */
+static void on_start(MessageContext *m){
+    ClientContext *client = m->client;
+    GameRoom *room = m->room;
 
+    if(room->owner_index != m->client_index){
+        client_send(client, ESTR, "Pouze owner");
+        return;
+    }
 
-            pthread_mutex_lock(&clients_mutex);
+    if(room->ready_count < room->player_count){
+        client_send(client, ESTR, "Ne všichni jsou připraveni");
+        return;
+    }
+    GameInstance *game = game_create(room);
 
-            // jen když to pořád odpovídá tomuhle socketu (ochrana proti reconnect swapu)
-            if (clients[client_index].socket_fd == client_sock) {
-                clients[client_index].last_status = clients[client_index].status;
-                clients[client_index].is_connected = 0;
-                clients[client_index].is_active = 0;
-                clients[client_index].disconnect_time = time(NULL);
-                clients[client_index].socket_fd = -1;
-            }
+    if(!game){
+        client_send(client, ESTR, "Chyba při vytváření");
+        return;
+    }
 
-            pthread_mutex_unlock(&clients_mutex);
+    room->game_instance = game;
 
-            // DLOG("DISCONNECT slot=%d (after) ctx_fd=%d is_conn=%d disc_time=%ld",
-            // client_index, clients[client_index].socket_fd,
-            // clients[client_index].is_connected, (long)clients[client_index].disconnect_time);
+    if(game_start(game) != 0){
+        client_send(client, ESTR, "Chyba při startu");
+        game_destroy(game);
+        room->game_instance = NULL;
+        return;
+    }
 
+    room_set_status(room, ROOM_PLAYING);
 
-            close(client_sock); // zavřít fd vlákna
-            if (message_body) free(message_body);
-            break;
-        }
+    broadcast_to_room_locked(room, STRT, "Hra začíná!", -1);
 
-        
-        if(message_status < 0) {
-            // Chyba protokolu
-            LOG_ERROR("Chyba protokolu: kód %d (fd=%d)\n", message_status, client_sock);
-            // printf("Chyba protokolu: kód %d (fd=%d)\n", message_status, client_sock);
-            if(message_body) free(message_body);
-            close(client_sock);
-            break;
-        }
+    // tady "odpřipravíme" hráče, abychom po hře mohli kontrolovat, zda chtějí pokračovat
+    for(int i = 0; i < room->player_count; i++){
+        int idx = room->player_indexes[i];
 
-        pthread_mutex_lock(&clients_mutex);
-        client->last_heartbeat = time(NULL);
-        pthread_mutex_unlock(&clients_mutex);
+        // unready
+        set_player_ready(room->room_id, idx, 0);
+    }
 
-        LOG_INFO("Přijato: type='%s' len=%d body='%s'\n", 
-               header.type_msg, 
-               header.message_len,
-               message_body ? message_body : "(empty)");
+    send_game_start(room);
+}
 
-        int should_disconnect = 0;
+/**
+ * @brief QUIT v místnosti: opusť (a případně smaž) místnost a odpoj se
+ */
+static void on_room_quit(MessageContext *m){
+    leave_room(m->room_id, m->client->player_id);
+    delete_room(m->room_id);
+    m->should_disconnect = 1;
+}
 
-        pthread_mutex_lock(&clients_mutex);
+/**
+ * @brief Neznámý příkaz v místnosti
+ */
+static void on_room_unknown(MessageContext *m){
+    client_send_error(m->client, "Nejsi v místnosti");
+    shutdown(m->client_sock, SHUT_RDWR);
+}
 
-        switch(client->status){
-            case DISCONNECTED: {
+// ________ ON_TURN / ON_WAIT ________
 
-                if(strcmp(header.type_msg, LOGI) == 0) {
-                    if(!message_body || strlen(message_body) == 0 || strlen(message_body) > NICK_LEN) {
-                        send_error(client->socket_fd, "Neplatná délka nicku");
-                        close(client_sock);
-                        break;
-                    }
+/**
+ * @brief TAKP: hráč chce lízat z balíčku
+ */
+static void on_take_pack(MessageContext *m){
+    int result = game_process_move(m->game, m->client_index, MSG_TAKP, m->message_body);
 
-                    // Tady je potřeba pokus o rozparsování, pokud se ve zprávě nachází | delimeter
-                    char nick[NICK_LEN + 1] = {0};
-                    char token[TOKEN_LEN + 1] = {0};
-                    int has_token = 0;
-                    
-                    const char *sep = strchr(message_body, '|');
-
-                    // Pokud přišel požadavek s tokenem
-                    if (sep) {
-                        size_t nick_len = sep - message_body;
-                        
-                        const char *token_ptr = sep + 1;
-                        size_t token_len_received = strlen(token_ptr);
-
-                        if (nick_len == 0 || nick_len > NICK_LEN) {
-                            send_error(client->socket_fd, "Neplatná délka nicku");
-                            break;
-                        }
+    // Tah byl úspěšný - informuj VŠECHNY hráče v místnosti o změně stavu
+    if(result == 0){
+        send_state_to_players(m->room);
+    }
 
-                        if (token_len_received != TOKEN_LEN) {
-                            send_error(client->socket_fd, "Neplatná délka tokenu");
-                            break; 
-                        }
+    // Chybové stavy
+    else if(result == -2){
+        client_send_error(m->client, "Již jsi lízl");
+    }
+    else if(result == -3){
+        client_send_error(m->client, "Již jsi vyhodil");
+    }
+    else if(result == -4){
+        client_send_error(m->client, "První hráč v prvním kole nelíže");
+    }
+    else if(result == -5){
+        client_send_error(m->client, "Obracím balíček, zkus to znovu");
+    }
+    else if(result == -6){
+        client_send_error(m->client, "Balíček je prázdný, vezmi vyhozenou kartu");
+    }
+    else{
+        client_send_error(m->client, "Neplatný tah");
+    }
+}
 
-                        memcpy(nick, message_body, nick_len);
-                        nick[nick_len] = '\0';
+/**
+ * @brief TAKT: hráč chce vzít vyhozenou kartu
+ */
+static void on_take_thrown(MessageContext *m){
+    int result = game_process_move(m->game, m->client_index, MSG_TAKT, m->message_body);
 
-                        memcpy(token, token_ptr, TOKEN_LEN);
-                        token[TOKEN_LEN] = '\0';
+    if(result == 0){
+        send_state_to_players(m->room);
+    }
 
-                        has_token = 1;
-                        printf("Reconnect pokus: nick=%s, token=%s\n", nick, token);
-                    }
-                    // Pokud nepřišel požadavek s tokenem
-                    else{
-                        size_t nick_len = strlen(message_body);
+    // Chybové stavy
+    else if(result == -2){
+        client_send_error(m->client, "Již jsi lízl");
+    } else if (result == -3){
+        client_send_error(m->client, "Balíček je prázdný");
+    }
+    else{
+        client_send_error(m->client, "Neplatný tah");
+    }
+}
 
-                        if(nick_len == 0 || nick_len > NICK_LEN){
-                            send_error(client->socket_fd, "Neplatná délka nicku");
-                            break;
-                        }
-                        strncpy(nick, message_body, NICK_LEN);
-                        nick[NICK_LEN] = '\0';
+/**
+ * @brief UNLO: vylož karty
+ */
+static void on_unload(MessageContext *m){
+    int result = game_process_move(m->game, m->client_index, MSG_UNLO, m->message_body);
 
-                        printf("Nové připojení: nick=%s\n", nick);
-                    }
-                
-                    // DLOG("LOGI recv slot=%d fd=%d body='%s'", client_index, client_sock, message_body);
-
-                    // POKUS O RECONNECT - najdi hráče podle nicku
-                    int existing_idx = find_player_by_nick(nick);
-                    LOG_INFO("Nick: %s, has_token:%d, token:%s", nick, has_token, token);
-
-                    // DLOG("RECO CHECK nick='%s' token_recv='%s' token_ctx='%s' has_token=%d existing_idx=%d existing_is_conn=%d existing_fd=%d",
-                    // nick, token, (existing_idx>=0 ? clients[existing_idx].token : "-"),
-                    // has_token, existing_idx,
-                    // existing_idx>=0 ? clients[existing_idx].is_connected : -1,
-                    // existing_idx>=0 ? clients[existing_idx].socket_fd : -1);
-
-
-                    
-                    if(existing_idx >= 0) {
-                        if(clients[existing_idx].is_connected /*|| !has_token*/){
-                            LOG_DEBUG("DEBUG: Jméno je obsazené (is_connected=1)\n");
-                            send_error(client->socket_fd, "Uživatel již existuje");
-                            close(client->socket_fd);
-                            break;
-                        }
-                        // DLOG("RECO TOKEN CMP idx=%d recv='%s' ctx='%s' strcmp=%d",
-                        // existing_idx, token, clients[existing_idx].token,
-                        // strcmp(clients[existing_idx].token, token));
-
-                        // Porovnání tokenů
-                        // if (strcmp(clients[existing_idx].token, token) != 0){
-                        //     send_error(client->socket_fd, "Neplatný token");
-                        //     break;
-                        // }
-                        if (existing_idx != client_index){
-                            // DLOG("RECO SWAP newfd=%d -> idx=%d (oldfd=%d)",
-                            // client_sock, existing_idx, clients[existing_idx].socket_fd);
-
-                            clients[existing_idx].socket_fd = client_sock;
-                            clients[existing_idx].is_active = 1;
-
-                            client->socket_fd = -1;
-                            client->is_active = 0;
-
-                            client_index = existing_idx;
-                            client = &clients[client_index];
-                        } else{
-                            client->socket_fd = client_sock;
-                            client->is_active = 1;
-                        }
+    if(result == 0){
+        send_state_to_players(m->room);
+    }else if(result == -69){
+        client_send_error(m->client, "Akci nelze provést (neměl bys čím zavřít)");
+    }
+    else{
+        client_send_error(m->client, "Neplatná postupka");
+    }
+}
 
-                            clients[client_index].is_connected = 1;
-                            clients[client_index].last_heartbeat = time(NULL);
-                            clients[client_index].status = clients[client_index].last_status;
-                            
-                            pthread_mutex_unlock(&clients_mutex);
-                            send_message(clients[client_index].socket_fd, RECO, "Reconnect úspěšný");
-
-                            // Na základě posledního statu před odhlášením pošli poslední stav
-                            // Stav se nemohl změnit, protože klient byl odpojen ve chvíli, kdy druhý uživatel nemohl učinit další tah
-                            switch(client->last_status){
-                                case CONNECTED:
-                                    send_message(client->socket_fd, OKAY, "LOBBY");
-                                    break;
-                                
-                                case IN_ROOM:
-                                    send_message(client->socket_fd, OKAY, "LOBBY");
-                                    break;
-
-                                case ON_TURN:
-                                    send_message(client->socket_fd, OKAY, "TURN");
-                                    break;
-                                
-                                case ON_WAIT:
-                                    send_message(client->socket_fd, OKAY, "WAIT");
-                                    break;
-
-                                case GAME_DONE:
-                                    send_message(client->socket_fd, OKAY, "LOBBY");
-                                    break;
-
-                                case PAUSED:
-                                    send_message(client->socket_fd, OKAY, "PAUSED");
-                                    break;
-                                
-                                default:
-                                    send_message(client->socket_fd, OKAY, "LOBBY");
-                                    break;
-                        }
-                            LOG_INFO("Reconnect úspesny");
-                            usleep(10000);
-
-                            pthread_mutex_lock(&clients_mutex);
-                            GameRoom *room = clients[client_index].current_room;
-                            int room_id = room ? room->room_id : -1;
-                            pthread_mutex_unlock(&clients_mutex);
-                            
-                            if (room) {
-                                GameInstance *game = NULL;
-
-                                pthread_mutex_lock(&clients_mutex);
-                                game = room->game_instance;
-
-                                if (game && game->state == GAME_STATE_PAUSED) {
-                                    game_resume(game);
-                                }
-                                pthread_mutex_unlock(&clients_mutex);
-
-
-                                pthread_mutex_lock(&clients_mutex);
-                                game = room->game_instance;
-                                pthread_mutex_unlock(&clients_mutex);
-
-                                if (game) {
-                                    char full_state[4096];
-                                    if (game_get_full_state(game, client_index,
-                                                            full_state, sizeof(full_state)) > 0) {
-                                        send_message(clients[client_index].socket_fd,
-                                                    STAT, full_state);
-                                    }
-
-                                    broadcast_to_room(room_id, RESU, "Hráč se vrátil do hry, obnovuji hru", -1);
-                                } else{
-                                    client->status = CONNECTED;
-                                }
-                            }
-                            break;
-                        }
-                    
-                    
-                    // Nejedná se o reconnect, ale o nového hráče
-                    LOG_DEBUG("Vytvářím nového hráče '%s' na slotu %d\n", nick, client_index);
-                    strncpy(client->nick, nick, NICK_LEN);
-                    client->nick[NICK_LEN] = '\0';
-                    client->status = CONNECTED;
-                    client->is_connected = 1;
-                    client->invalid_message_count = 0;
-                    client->socket_fd = client_sock;
-                    client->player_id = client_index;
-                    generate_token(client->token, TOKEN_LEN); 
-                    
-                    // Vygenerovaný token pošli s potvrzovací zprávou
-                    char message[40];
-                    snprintf(message, sizeof(message), "Vítej ve hře!|%s", client->token);
-                    send_message(client->socket_fd, OKAY, message);
-
-                    LOG_INFO("Nový klient '%s' přihlášen (fd=%d, slot=%d, token=%s)\n", 
-                           client->nick, client->socket_fd, client_index, client->token);
-                    
-                } else if(strcmp(header.type_msg, QUIT) == 0) {
-                    should_disconnect = 1;
-                    
-                }
-                // Pokud přijde dřív PING než LOGI, je to v pořádku -> ignorování
-                else if(strcmp(header.type_msg, PING) == 0){
-                    continue;
-                } 
-                
-                // Pokud přijde cokoliv jiného než očekáváno, odpoj klienta
-                else {
-                    send_error(client->socket_fd, "Očekáván příkaz LOGI");
-                    should_disconnect = 1;
-                }
-                break;
-            }
+/**
+ * @brief ADDC: přilož kartu k existující postupce
+ */
+static void on_add_card(MessageContext *m){
+    int result = game_process_move(m->game, m->client_index, MSG_ADDC, m->message_body);
+
+    if(result == 0){
+        // Úspěch -> broadcast všem hráčům v místnosti
+        send_state_to_players(m->room);
+        client_send(m->client, OKAY, "Karta přiložena");
+    } else {
+        client_send_error(m->client, "Kartu nelze k této postupce přiložit");
+    }
+}
 
-            case CONNECTED: {
-                // Uživatel se odpojuje
-                if(strcmp(header.type_msg, QUIT) == 0) {
-                    should_disconnect = 1;
-                    
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován -> žádná reakce netřeba
-
-                } 
-                // Zašli klientovi aktuální místnosti, pokud existují
-                else if(strcmp(header.type_msg, RLIS) == 0) {
-                    char room_list[4096];
-                    int count = get_room_list(room_list, sizeof(room_list));
-
-                    if(count > 0){
-                        send_message(client->socket_fd, RLIS, room_list);
-                    } else{
-                        send_message(client->socket_fd, ELIS, "Žádné místnosti");
-                    }
-                
-                } 
-                // Vytvoř místnost, pokud to lze a připoj tvůrce do místnosti
-                else if(strcmp(header.type_msg, RCRT) == 0) {
-                    if(!message_body || strlen(message_body) == 0) {
-                        send_message(client->socket_fd, ECRT, "Chybí název");
-                        break;
-                    }
-                    
-                    int room_id = create_room(message_body, client->player_id);
-                    
-                    if(room_id >= 0){
-                        char room_id_str[12];
-                        snprintf(room_id_str, sizeof(room_id_str), "%d", room_id);
-                        
-                        client->status = IN_ROOM;
-                        client->current_room = find_room(room_id);
-                        
-                        send_message(client->socket_fd, OCRT, room_id_str);
-                        send_message(client->socket_fd, BOSS, "1");
-
-                        pthread_mutex_unlock(&clients_mutex);
-                        broadcast(RLIS, "");
-                        pthread_mutex_lock(&clients_mutex);
-                    } else{
-                        send_message(client->socket_fd, ECRT, "Nelze vytvořit");
-                    }
-                    
-                } 
-                // Pokud existuje požadovaná místnost, připoj klienta do místnosti, pokud tak může učinit
-                else if(strcmp(header.type_msg, RCNT) == 0) {
-                    if(!message_body || strlen(message_body) == 0){
-                        send_message(client->socket_fd, ECNT, "Chybí ID");
-                        break;
+/**
+ * @brief THRW: vyhoď kartu, předej tah nebo ukonči hru
+ */
+static void on_throw(MessageContext *m){
+    ClientContext *client = m->client;
+
+    int result = game_process_move(m->game, m->client_index, MSG_THRW, m->message_body);
+
+    if(result == 0){
+        // Zkontroluj, zda hra neskončila
+        GameRoom *room = m->room;
+        if(room->game_instance){
+            GameInstance *game = (GameInstance*)room->game_instance;
+
+            if(game->state == GAME_STATE_FINISHED){
+                // Hra skončila!
+                broadcast_to_room_locked(room, OKAY, client->nick, -1);
+
+                // Vrať všechny do IN_ROOM
+                for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+                    int idx = room->player_indexes[i];
+                    if(idx != -1 && idx < max_clients){
+                        client_set_status(&clients[idx], GAME_DONE);
                     }
+                }
+            } else {
+                client_set_status(client, ON_WAIT);
+
+                int next_idx = room->player_indexes[game->current_player_index];
+                if(next_idx != -1 && next_idx < max_clients){
+                    client_set_status(&clients[next_idx], ON_TURN);
+                }
 
-                    int room_id = atoi(message_body);
+                send_state_to_players(room);
 
-                    if(connect_room(room_id, client->player_id) >= 0){
-                        client->status = IN_ROOM;
-                        client->current_room = find_room(room_id);
+                for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++) {
+                    int idx = room->player_indexes[i];
 
-                        send_message(client->socket_fd, OCNT, message_body);
-                    } else {
-                        send_message(client->socket_fd, ECNT, "Nelze připojit");
+                    if(idx != -1 && idx < max_clients) {
+                        if(clients[idx].status == ON_TURN) {
+                            client_send(&clients[idx], TURN, "Jsi na tahu");
+                        } else {
+                            client_send(&clients[idx], WAIT, "Čekej, hraje soupeř");
+                        }
                     }
-                    
-                } 
-                // Pokud cokoliv jiného, odpoj klienta
-                else {
-                    send_error(client->socket_fd, "Neznámý příkaz (CONNECTED)");
-                    client->invalid_message_count++;
-                    should_disconnect = 1;
                 }
-                break;
             }
+        }
+    }
 
-            case IN_ROOM: {
-                GameRoom *room = client->current_room;
-                
-                if(!room){
-                    send_error(client->socket_fd, "Nejsi v místnosti");
-                    client->status = CONNECTED;
-                    break;
-                }
-                
-                int room_id = room->room_id;
-                // Pokud lze, odpoj klienta z místnosti, předej vedení, případně smaž místnost
-                if(strcmp(header.type_msg, RDIS) == 0){
-                    pthread_mutex_unlock(&clients_mutex);
-                    
-                    leave_room(room_id, client_index);
-                    if(delete_room(room_id) == -1){
-                        broadcast_to_room(room_id, BOSS, "Byl jsi jmenován vlastníkem", -1);
-                    }
-                    
-                    pthread_mutex_lock(&clients_mutex);
-                    
-                    client->current_room = NULL;
-                    client->status = CONNECTED;
-
-                    send_message(client->socket_fd, ODIS, "Opuštěno");
-                    
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován -> reakce netřeba
-
-                } 
-                // Od/připrav klienta v místnosti
-                else if(strcmp(header.type_msg, REDY) == 0){
-                    int ready = (message_body && message_body[0] == '1') ? 1 : 0;
-
-                    if(set_player_ready(room_id, client_index, ready) == 0){
-                        char ready_players_str[128];
-                        char room_info[1024];
-                        
-                        room = find_room(room_id);
-                        if(room){
-                            snprintf(ready_players_str, sizeof(ready_players_str), 
-                                    "(%d/%d)", room->ready_count, room->max_players);
-                        }
+    // Chybové stavy
+    else if (result == -2){
+        client_send_error(client, "Nejdříve musíš líznout.");
+    }
+    else if (result == -3){
+        client_send_error(client, "Nemůžeš vyhodit, ale můžeš zavřít!");
+    }
+    else{
+        client_send_error(client, "Nemůžeš vyhodit tuto kartu");
+    }
+}
 
-                        pthread_mutex_unlock(&clients_mutex);
-                        
-                        get_room_info(room_id, room_info, sizeof(room_info));
-                        broadcast_to_room(room_id, PRDY, ready_players_str, -1);
-                        broadcast_to_room(room_id, RINF, room_info, -1);
-                        
-                        pthread_mutex_lock(&clients_mutex);
-                    } else{
-                        send_error(client->socket_fd, "Chyba ready");
-                    }
-                    
-                } 
-                // Pokud může být hra spuštěna, spusť hru
-                else if(strcmp(header.type_msg, STRT) == 0){          
-                    if(room->owner_index != client_index){
-                        send_message(client->socket_fd, ESTR, "Pouze owner");
-                        break;
-                    }
+/**
+ * @brief CLOS: zavři hru a rozešli výsledky
+ */
+static void on_close(MessageContext *m){
+    ClientContext *client = m->client;
+    GameInstance *game = m->game;
 
-                    if(room->ready_count < room->player_count){
-                        send_message(client->socket_fd, ESTR, "Ne všichni jsou připraveni");
-                        break;
-                    }
-                    GameInstance *game = game_create(room);
-                    
-                    if(!game){
-                        send_message(client->socket_fd, ESTR, "Chyba při vytváření");
-                        break;
-                    }
+    int result = game_process_move(game, m->client_index, MSG_CLOS, m->message_body);
 
-                    room->game_instance = game;
+    if(result == 0){
+        // Hra skončila!
+        char end_report[1024] = {0};
+        int offset = 0;
 
-                    if(game_start(game) != 0){
-                        send_message(client->socket_fd, ESTR, "Chyba při startu");
-                        game_destroy(game);
-                        room->game_instance = NULL;
-                        break;
-                    }
+        engine_calculate_scores(game);
 
-                    room->status = ROOM_PLAYING;
-                    
-                    pthread_mutex_unlock(&clients_mutex);
-                    broadcast_to_room(room_id, STRT, "Hra začíná!", -1);
-                    pthread_mutex_lock(&clients_mutex);
+        offset += snprintf(end_report + offset, sizeof(end_report) - offset, "W:%s", client->nick);
 
-                    // tady "odpřipravíme" hráče, abychom po hře mohli kontrolovat, zda chtějí pokračovat
-                    for(int i = 0; i < room->player_count; i++){
-                        int idx = room->player_indexes[i];
+        for(int i = 0; i < game->player_count; i++){
+            int c_inx = game->players[i].client_index;
 
-                        // unready
-                        set_player_ready(room->room_id, idx, 0);
-                    }
+            if(c_inx != -1){
+                offset += snprintf(end_report + offset, sizeof(end_report) - offset, "|P:%s:%d:%d:%d",
+            clients[c_inx].nick, game->players[i].score, game->players[i].cards_played, game->players[i].turns_played);
+            }
+        }
 
-                    room = find_room(room_id);
-                    if(room && room->game_instance){
-                        game = (GameInstance*)room->game_instance;
-
-                        for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                            int idx = room->player_indexes[i];
-
-                            if(idx != -1 && idx < MAX_CLIENTS){
-                                int current_player_idx = room->player_indexes[game->current_player_index];
-                                
-                                if(idx == current_player_idx){
-                                    clients[idx].status = ON_TURN;
-                                    send_message(clients[idx].socket_fd, TURN, "Jsi na tahu");
-                                } else{
-                                    clients[idx].status = ON_WAIT;
-                                    send_message(clients[idx].socket_fd, WAIT, "Čekej");
-                                }
-
-                                char hand_cards[2048];
-                                if(game_get_player_cards(game, idx, hand_cards, sizeof(hand_cards)) > 0){
-                                    send_message(clients[idx].socket_fd, CRDS, hand_cards);
-                                }
-                            }
-                        }
-                    }
-                    
-                } else if(strcmp(header.type_msg, QUIT) == 0) {
-                    leave_room(room_id, client->player_id);
-                    delete_room(room_id);
-                    should_disconnect = 1;
-                    
-                } else {
-                    send_error(client_sock, "Nejsi v místnosti");
-                    close(client_sock);
-                }
-                break;
+        broadcast_to_room_locked(m->room, GEND, end_report, -1);
+
+        // Vlož hráče do ukončené hry
+        GameRoom *room = m->room;
+        for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+            int idx = room->player_indexes[i];
+            if(idx != -1 && idx < max_clients){
+                client_set_status(&clients[idx], GAME_DONE);
             }
+        }
+    }
+    else{
+        client_send_error(client, "Nemůžeš zavřít");
+    }
+}
 
-            case ON_TURN: {
-                GameRoom *room = client->current_room;
+/**
+ * @brief HINT: nápověda tahu (solver nad rukou a stolem), stav hry nemění
+ */
+static void on_hint(MessageContext *m){
+    char hint[GAME_HINT_BUFFER];
+    int written = game_get_hint(m->game, m->client_index, hint, sizeof(hint));
+
+    if(written >= 0){
+        client_send_len(m->client, OINT, hint, written);
+    } else if(written == -2){
+        client_send_error(m->client, "Nápověda příliš často, zkus to později");
+    } else{
+        client_send_error(m->client, "Nápovědu nelze spočítat");
+    }
+}
 
-                if(!room || !room->game_instance){
-                    send_error(client->socket_fd, "Hra neběží");
-                    client->status = CONNECTED;
-                    break;
-                }
-                
-                GameInstance *game = (GameInstance*)room->game_instance;
-                int room_id = room->room_id;
-
-                // Hráč chce lízat z balíčku
-                if(strcmp(header.type_msg, TAKP) == 0){
-                    // Lízni z balíčku
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        // Tah byl úspěšný - informuj VŠECHNY hráče v místnosti o změně stavu
-                        room = find_room(room_id);
-                        if(room && room->game_instance){
-                            game = (GameInstance*)room->game_instance;
-
-                            // Projdeme všechny sloty pro hráče v místnosti
-                            for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                int idx = room->player_indexes[i];
-                                
-                                // Kontrola, zda je na tomto indexu připojený klient
-                                if(idx != -1 && idx < MAX_CLIENTS){
-                                    char full_state[4096];
-                                    int target_client_index = clients[idx].player_id;
-
-                                    // Vygenerujeme personalizovaný stav pro konkrétního klienta
-                                    int written = game_get_full_state(game, target_client_index, full_state, sizeof(full_state));
-                                    
-                                    if(written > 0){
-                                        // Pošleme aktualizovaná data (UPDT) každému hráči
-                                        send_message(clients[idx].socket_fd, "STAT", full_state);
-                                    }
-                                }
-                            }
-                        }
-                    }
+/**
+ * @brief QUIT během hry: pozastav hru a odpoj se
+ */
+static void on_game_quit(MessageContext *m){
+    game_pause(m->game, "Hráč se odpojil");
+    m->should_disconnect = 1;
+}
 
-                    // Chybové stavy
-                    else if(result == -2){
-                        send_error(client->socket_fd, "Již jsi lízl");
-                    }
-                    else if(result == -3){
-                        send_error(client->socket_fd, "Již jsi vyhodil");
-                    }
-                    else if(result == -4){
-                        send_error(client->socket_fd, "První hráč v prvním kole nelíže");
-                    }
-                    else if(result == -5){
-                        send_error(client->socket_fd, "Obracím balíček, zkus to znovu");
-                    }
-                    else{
-                        send_error(client->socket_fd, "Neplatný tah");
-                    }
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován
+/**
+ * @brief Neznámý příkaz hráče na tahu
+ */
+static void on_turn_unknown(MessageContext *m){
+    client_send_error(m->client, "Neznámý příkaz (ON_TURN)");
+    shutdown(m->client_sock, SHUT_RDWR);
+}
 
-                }
-                // Hráč chce vzít vyhozenou kartu
-                else if(strcmp(header.type_msg, TAKT) == 0){
-                    // Lízni z vyhozených
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        room = find_room(room_id);
-                        if(room && room->game_instance){
-                            game = (GameInstance *)room->game_instance;
-                            for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                int idx = room->player_indexes[i];
-
-                                if(idx != -1 && idx < MAX_CLIENTS){
-                                    char full_state[4096];
-                                    int target_index = clients[idx].player_id;
-
-                                    int written = game_get_full_state(game, target_index, full_state, sizeof(full_state));
-
-                                    if(written > 0){
-                                        send_message(clients[idx].socket_fd, STAT, full_state);
-                                    }
-                                }
-                            }
-                        }
-                    }
+/**
+ * @brief Hráč, který čeká, posílá herní příkaz
+ */
+static void on_wait_unknown(MessageContext *m){
+    client_send_error(m->client, "Nejsi na tahu");
+}
 
-                    // Chybové stavy
-                    else if(result == -2){
-                        send_error(client->socket_fd, "Již jsi lízl");
-                    } else if (result == -3){
-                        send_error(client->socket_fd, "Balíček je prázdný");
-                    }
-                    else{
-                        send_error(client->socket_fd, "Neplatný tah");
-                    }
-                }
-                else if(strcmp(header.type_msg, UNLO) == 0){
-                    // Vylož karty
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        room = find_room(room_id);
-                        if(room && room->game_instance){
-                            game = (GameInstance *)room->game_instance;
-                            for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                int idx = room->player_indexes[i];
-
-                                if(idx != -1 && idx < MAX_CLIENTS){
-                                    char full_state[4096];
-                                    int target_index = clients[idx].player_id;
-
-                                    int written = game_get_full_state(game, target_index, full_state, sizeof(full_state));
-
-                                    if(written > 0){
-                                        send_message(clients[idx].socket_fd, STAT, full_state);
-                                    }
-                                }
-                            }
-                        }
-                    }else if(result == -69){
-                        send_error(client->socket_fd, "Akci nelze provést (neměl bys čím zavřít)");
-                    }
-                    else{
-                        send_error(client->socket_fd, "Neplatná postupka");
-                    }
-                } else if(strcmp(header.type_msg, ADDC) == 0){
-                    // Přilož kartu k existující postupce
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        // Úspěch -> broadcast všem hráčům v místnosti
-                        room = find_room(room_id);
-                        if(room && room->game_instance){
-                            for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                int idx = room->player_indexes[i];
-                                if(idx != -1 && idx < MAX_CLIENTS){
-                                    char full_state[4096];
-                                    int target_id = clients[idx].player_id;
-                                    
-                                    if(game_get_full_state(game, target_id, full_state, sizeof(full_state)) > 0){
-                                        send_message(clients[idx].socket_fd, "STAT", full_state);
-                                    }
-                                }
-                            }
-                        }
-                        send_message(client->socket_fd, OKAY, "Karta přiložena");
-                    } else {
-                        send_error(client->socket_fd, "Kartu nelze k této postupce přiložit");
-                    }
-                }
-                else if(strcmp(header.type_msg, THRW) == 0){
-                    // Vyhoď kartu
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        // Zkontroluj, zda hra neskončila
-                        room = find_room(room_id);
-                        if(room && room->game_instance){
-                            game = (GameInstance*)room->game_instance;
-                            
-                            if(game->state == GAME_STATE_FINISHED){
-                                // Hra skončila!
-                                pthread_mutex_unlock(&clients_mutex);
-                                broadcast_to_room(room_id, OKAY, client->nick, -1);
-                                pthread_mutex_lock(&clients_mutex);
-                                
-                                // Vrať všechny do IN_ROOM
-                                for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                    int idx = room->player_indexes[i];
-                                    if(idx != -1 && idx < MAX_CLIENTS){
-                                        clients[idx].status = GAME_DONE;
-                                    }
-                                }
-                            } else {
-                                client->status = ON_WAIT;
-
-                                int next_idx = room->player_indexes[game->current_player_index];
-                                if(next_idx != -1 && next_idx < MAX_CLIENTS){
-                                    clients[next_idx].status = ON_TURN;
-                                }
-
-                                for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++) {
-                                    int idx = room->player_indexes[i];
-                                    
-                                    if(idx != -1 && idx < MAX_CLIENTS) {
-                                        char full_state[4096];
-                                        int target_id = clients[idx].player_id;
-                                        
-                                        int written = game_get_full_state(game, target_id, full_state, sizeof(full_state));
-                                        
-                                        if(written > 0) {
-                                            send_message(clients[idx].socket_fd, "STAT", full_state);
-                                            
-                                            if(clients[idx].status == ON_TURN) {
-                                                send_message(clients[idx].socket_fd, TURN, "Jsi na tahu");
-                                            } else {
-                                                send_message(clients[idx].socket_fd, WAIT, "Čekej, hraje soupeř");
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
+// ________ PAUSED ________
 
-                    // Chybové stavy
-                    else if (result == -2){
-                        send_error(client->socket_fd, "Nejdříve musíš líznout.");
-                    }
-                    else if (result == -3){
-                        send_error(client->socket_fd, "Nemůžeš vyhodit, ale můžeš zavřít!");
-                    }
-                    else{
-                        send_error(client->socket_fd, "Nemůžeš vyhodit tuto kartu");
-                    }
-                }
-                else if(strcmp(header.type_msg, CLOS) == 0){
-                    // Zavři hru
-                    int result = game_process_move(game, client_index, header.type_msg, message_body);
-                    
-                    if(result == 0){
-                        // Hra skončila!
-                        char end_report[1024] = {0};
-                        int offset = 0;
-
-                        pthread_mutex_unlock(&clients_mutex);
-                        game_calculate_scores(game);
-                        pthread_mutex_lock(&clients_mutex);
-
-                        offset += snprintf(end_report + offset, sizeof(end_report) - offset, "W:%s", client->nick);
-
-                        for(int i = 0; i < game->player_count; i++){
-                            int c_inx = game->players[i].client_index;
-
-                            if(c_inx != -1){
-                                offset += snprintf(end_report + offset, sizeof(end_report) - offset, "|P:%s:%d:%d:%d", 
-                            clients[c_inx].nick, game->players[i].score, game->players[i].cards_played, game->players[i].turns_played);
-                            }
-                        }
+/**
+ * @brief Cokoliv kromě QUIT/PONG během pauzy
+ */
+static void on_paused_unknown(MessageContext *m){
+    client_send(m->client, NOTI, "Hra pozastavena");
+}
 
-                        pthread_mutex_unlock(&clients_mutex);
-                        broadcast_to_room(room_id, GEND, end_report, -1);
-                        pthread_mutex_lock(&clients_mutex);
-                        
-                        // Vlož hráče do ukončené hry
-                        room = find_room(room_id);
-                        if(room){
-                            for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                                int idx = room->player_indexes[i];
-                                if(idx != -1 && idx < MAX_CLIENTS){
-                                    clients[idx].status = GAME_DONE;
-                                }
-                            }
-                        }
-                    }
-                    else{
-                        send_error(client->socket_fd, "Nemůžeš zavřít");
-                    }
-                }
-                else if(strcmp(header.type_msg, QUIT) == 0){
-                    game_pause(game, "Hráč se odpojil");
-                    should_disconnect = 1;
-                }
-                else {
-                    send_error(client->socket_fd, "Neznámý příkaz (ON_TURN)");
-                    close(client_sock);
-                }
-                break;
+// ________ GAME_DONE ________
+
+/**
+ * @brief PLAG: hráč chce hrát znovu, hra začne, až chtějí oba
+ */
+static void on_play_again(MessageContext *m){
+    ClientContext *client = m->client;
+    GameRoom *room = m->room;
+    int room_id = m->room_id;
+
+    // logika taková, že se čeká na oba hráče
+    for(int i = 0; i < room->player_count; i++){
+        int c_idx = room->player_indexes[i];
+
+
+        if(client->player_id == c_idx){
+            if(strcmp(m->message_body, "1")){
+                set_player_ready(room->room_id, c_idx, 1);
+                LOG_INFO("Hráč idx:%d chce hrát znovu!", c_idx);
+        }
+            else
+            {
+                set_player_ready(room->room_id, c_idx, 0);
+                LOG_INFO("Hráč idx:%d už nechce hrát znovu!", c_idx);
             }
+        }
+    }
 
-            case ON_WAIT: {
-                GameRoom *room = client->current_room;
+    if(room->ready_count != room->player_count){
+        client_send(client, ESTR, "Čekání na protihráče");
+        return;
+    }
 
-                if(!room || !room->game_instance){
-                    send_error(client->socket_fd, "Hra neběží");
-                    client->status = CONNECTED;
-                    break;
-                }
+    game_destroy(m->game);
 
-                GameInstance *game = (GameInstance*)room->game_instance;
+    GameInstance *game = game_create(room);
 
-                if(strcmp(header.type_msg, QUIT) == 0){
-                    game_pause(game, "Hráč se odpojil");
-                    should_disconnect = 1;
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován
+    if(!game){
+        client_send(client, ESTR, "Chyba při vytváření");
+        return;
+    }
 
-                } else {
-                    send_error(client->socket_fd, "Nejsi na tahu");
-                }
-                break;
-            }
+    room->game_instance = game;
 
-            case PAUSED: {
-                if(strcmp(header.type_msg, QUIT) == 0) {
-                    should_disconnect = 1;
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován
+    if(game_start(game) != 0){
+        client_send(client, ESTR, "Chyba.");
+        game_destroy(game);
+        room->game_instance = NULL;
+        return;
+    }
 
-                } else {
-                    send_message(client->socket_fd, NOTI, "Hra pozastavena");
-                }
-                break;
-            }
+    room_set_status(room, ROOM_PLAYING);
 
-            case GAME_DONE: {
-                GameRoom *room = client->current_room;
+    broadcast_to_room_locked(room, STRT, "Hra začíná!", -1);
 
-                if(!room || !room->game_instance){
-                    send_error(client->socket_fd, "Hra neběží");
-                    client->status = CONNECTED;
-                    break;
-                }
-                
-                GameInstance *game = (GameInstance*)room->game_instance;
-                int room_id = room->room_id;
+    send_game_start(room);
 
-                if(strcmp(header.type_msg, QUIT) == 0) {
-                    should_disconnect = 1;
-                }
-                else if (strcmp(header.type_msg, PLAG) == 0){
-                    // logika taková, že se čeká na oba hráče
-                    for(int i = 0; i < room->player_count; i++){
-                        int c_idx = room->player_indexes[i];
-
-                        
-                        if(client->player_id == c_idx){
-                            if(strcmp(message_body, "1")){
-                                set_player_ready(room->room_id, c_idx, 1);
-                                LOG_INFO("Hráč idx:%d chce hrát znovu!", c_idx);
-                        }
-                            else 
-                            {
-                                set_player_ready(room->room_id, c_idx, 0);
-                                LOG_INFO("Hráč idx:%d už nechce hrát znovu!", c_idx);
-                            }
-                        }
-                    }
+    if(room->game_instance){
+        game = (GameInstance*)room->game_instance;
 
-                    if(room->ready_count != room->player_count){
-                        send_message(client->socket_fd, ESTR, "Čekání na protihráče");
-                        break;
-                    }
-                    
-                    game_destroy(game);
-
-                    GameInstance *game = game_create(room);
-                    
-                    if(!game){
-                        send_message(client->socket_fd, ESTR, "Chyba při vytváření");
-                        break;
-                    }
+        // Projdeme všechny sloty pro hráče v místnosti
+        for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+            int idx = room->player_indexes[i];
 
-                    room->game_instance = game;
+            // Kontrola, zda je na tomto indexu připojený klient
+            if(idx != -1 && idx < max_clients){
+                set_player_ready(room->room_id, clients[idx].player_id, 0);
 
-                    if(game_start(game) != 0){
-                        send_message(client->socket_fd, ESTR, "Chyba.");
-                        game_destroy(game);
-                        room->game_instance = NULL;
-                        break;
-                    }
+                // Pošleme aktualizovaná data každému hráči (vstup do hry -> celý STAT)
+                send_state_to_client(game, &clients[idx], 0);
+            }
+        }
 
-                    room->status = ROOM_PLAYING;
-                    
-                    pthread_mutex_unlock(&clients_mutex);
-                    broadcast_to_room(room_id, STRT, "Hra začíná!", -1);
-                    pthread_mutex_lock(&clients_mutex);
-
-                    room = find_room(room_id);
-                    if(room && room->game_instance){
-                        game = (GameInstance*)room->game_instance;
-
-                        for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                            int idx = room->player_indexes[i];
-
-                            if(idx != -1 && idx < MAX_CLIENTS){
-                                int current_player_idx = room->player_indexes[game->current_player_index];
-                                
-                                if(idx == current_player_idx){
-                                    clients[idx].status = ON_TURN;
-                                    send_message(clients[idx].socket_fd, TURN, "Jsi na tahu");
-                                } else{
-                                    clients[idx].status = ON_WAIT;
-                                    send_message(clients[idx].socket_fd, WAIT, "Čekej");
-                                }
-
-                                char hand_cards[2048];
-                                if(game_get_player_cards(game, idx, hand_cards, sizeof(hand_cards)) > 0){
-                                    send_message(clients[idx].socket_fd, CRDS, hand_cards);
-                                }
-                            }
-                        }
-                    }
+    }
+    LOG_DEBUG("ROOM DEBUG: room_id=%d status=%d player_count=%d ready_count=%d game_instance=%p",
+            room_id,
+            room ? room->status : -1,
+            room ? room->player_count : -1,
+            room ? room->ready_count : -1,
+            room ? room->game_instance : NULL);
+
+    for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
+        int idx = room->player_indexes[i];
+
+        if(idx == -1){
+            LOG_DEBUG("ROOM[%d]: slot=%d EMPTY", room_id, i);
+            continue;
+        }
 
-                    room = find_room(room_id);
-                    if(room && room->game_instance){
-                        game = (GameInstance*)room->game_instance;
-
-                        // Projdeme všechny sloty pro hráče v místnosti
-                        for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                            int idx = room->player_indexes[i];
-                            
-                            // Kontrola, zda je na tomto indexu připojený klient
-                            if(idx != -1 && idx < MAX_CLIENTS){
-                                char full_state[4096];
-                                int target_client_index = clients[idx].player_id;
-                                set_player_ready(room->room_id, target_client_index, 0);
-
-                                // Vygenerujeme personalizovaný stav pro konkrétního klienta
-                                int written = game_get_full_state(game, target_client_index, full_state, sizeof(full_state));
-                                
-                                if(written > 0){
-                                    // Pošleme aktualizovaná data (UPDT) každému hráči
-                                    send_message(clients[idx].socket_fd, "STAT", full_state);
-                                }
-                            }
-                        }
+        if(idx < 0 || idx >= max_clients){
+            LOG_DEBUG("ROOM[%d]: slot=%d INVALID idx=%d", room_id, i, idx);
+            continue;
+        }
 
-                    }
-                    LOG_DEBUG("ROOM DEBUG: room_id=%d status=%d player_count=%d ready_count=%d game_instance=%p",
-                            room_id,
-                            room ? room->status : -1,
-                            room ? room->player_count : -1,
-                            room ? room->ready_count : -1,
-                            room ? room->game_instance : NULL);
-
-                    for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-                        int idx = room->player_indexes[i];
-
-                        if(idx == -1){
-                            LOG_DEBUG("ROOM[%d]: slot=%d EMPTY", room_id, i);
-                            continue;
-                        }
+        LOG_DEBUG(
+            "ROOM[%d]: slot=%d idx=%d nick='%s' socket=%d connected=%d active=%d status=%d player_id=%d last_heartbeat=%llu",
+            room_id,
+            i,
+            idx,
+            clients[idx].nick,
+            clients[idx].socket_fd,
+            clients[idx].is_connected,
+            clients[idx].is_active,
+            clients[idx].status,
+            clients[idx].player_id,
+            (unsigned long long)clients[idx].last_heartbeat
+        );
+    }
 
-                        if(idx < 0 || idx >= MAX_CLIENTS){
-                            LOG_DEBUG("ROOM[%d]: slot=%d INVALID idx=%d", room_id, i, idx);
-                            continue;
-                        }
+    if(room && room->game_instance){
+        GameInstance *g = (GameInstance*)room->game_instance;
 
-                        LOG_DEBUG(
-                            "ROOM[%d]: slot=%d idx=%d nick='%s' socket=%d connected=%d active=%d status=%d player_id=%d last_heartbeat=%ld",
-                            room_id,
-                            i,
-                            idx,
-                            clients[idx].nick,
-                            clients[idx].socket_fd,
-                            clients[idx].is_connected,
-                            clients[idx].is_active,
-                            clients[idx].status,
-                            clients[idx].player_id,
-                            clients[idx].last_heartbeat
-                        );
-                    }
+        LOG_DEBUG(
+            "GAME DEBUG: current_player_index=%d state=%d",
+            g->current_player_index,
+            g->state
+        );
+    }
+}
+
+/**
+ * @brief LBBY: vrať hráče do lobby (oba dva -> druhý nemá na co čekat), smaž místnost
+ */
+static void on_back_to_lobby(MessageContext *m){
+    GameRoom *room = m->room;
+    int room_id = m->room_id;
+
+    broadcast_to_room_locked(room, LBBY, "", -1);
+
+    game_destroy(m->game);
+    for(int i = 0; i < room->max_players; i++){
+        if(i != -1){
+            int c_idx = room->player_indexes[i];
+            leave_room(room_id, c_idx);
+            client_set_status(&clients[c_idx], CONNECTED);
+            clients[c_idx].current_room = NULL;
+        }
+    }
+}
 
-                    if(room && room->game_instance){
-                        GameInstance *g = (GameInstance*)room->game_instance;
+/**
+ * @brief CNNT: hráč po hře odchází do lobby
+ */
+static void on_game_leave(MessageContext *m){
+    client_set_status(m->client, CONNECTED);
+    leave_room(m->room_id, m->client->player_id);
+    m->client->current_room = NULL;
+    client_send(m->client, LBBY, "Dohrál jsi");
+}
 
-                        LOG_DEBUG(
-                            "GAME DEBUG: current_player_index=%d state=%d",
-                            g->current_player_index,
-                            g->state
-                        );
-                    }
-                } else if(strcmp(header.type_msg, PONG) == 0) {
-                    // Heartbeat aktualizován
+/**
+ * @brief Cokoliv jiného po skončení hry -> zpět do místnosti
+ */
+static void on_done_unknown(MessageContext *m){
+    client_send(m->client, NOTI, "Hra skončila");
+    client_set_status(m->client, IN_ROOM);
+}
 
-                }
-                else if(strcmp(header.type_msg, LBBY) == 0){
-                    // vrať hráče do lobby (oba dva -> druhý nemá na co čekat)
-                    // smazaní místnosti
-                    pthread_mutex_unlock(&clients_mutex);
-                    broadcast_to_room(room_id, LBBY, "", -1);
-                    pthread_mutex_lock(&clients_mutex);
-
-                    game_destroy(game);
-                    for(int i = 0; i < room->max_players; i++){
-                        if(i != -1){
-                            int c_idx = room->player_indexes[i];
-                            leave_room(room_id, c_idx);
-                            clients[c_idx].status = CONNECTED;
-                            clients[c_idx].current_room = NULL;
-                        }
-                    }
-                    
-                    
-                }else if(strcmp(header.type_msg, CNNT) == 0){
-                    client->status = CONNECTED;
-                    leave_room(client->current_room->room_id, client->player_id);
-                    send_message(client->socket_fd, LBBY, "Dohrál jsi");
-                }else {
-                    send_message(client->socket_fd, NOTI, "Hra skončila");
-                    for(int i = 0; i < MAX_CLIENTS; i++){
+// Dispatch tabulka: (stav klienta, typ zprávy) -> obsluha, neuvedené zprávy jdou do fallback
+static const StatusDispatch dispatch_table[PLAYER_STATUS_COUNT] = {
+    [DISCONNECTED] = {
+        .guard = NULL,
+        .fallback = on_expect_login,
+        .handlers = {
+            [MSG_LOGI] = on_login,
+            [MSG_QUIT] = on_quit,
+            [MSG_PING] = on_ignore,         // Pokud přijde dřív PING než LOGI, je to v pořádku
+        },
+    },
+    [CONNECTED] = {
+        .guard = NULL,
+        .fallback = on_lobby_unknown,
+        .handlers = {
+            [MSG_QUIT] = on_quit,
+            [MSG_PONG] = on_ignore,
+            [MSG_RLIS] = on_room_list,
+            [MSG_RCRT] = on_room_create,
+            [MSG_RCNT] = on_room_connect,
+            [MSG_DLTA] = on_delta,
+        },
+    },
+    [IN_ROOM] = {
+        .guard = guard_room,
+        .fallback = on_room_unknown,
+        .handlers = {
+            [MSG_RDIS] = on_room_leave,
+            [MSG_PONG] = on_ignore,
+            [MSG_REDY] = on_ready,
+            [MSG_STRT] = on_start,
+            [MSG_QUIT] = on_room_quit,
+            [MSG_DLTA] = on_delta,
+        },
+    },
+    [ON_WAIT] = {
+        .guard = guard_game,
+        .room_only = 1,
+        .fallback = on_wait_unknown,
+        .handlers = {
+            [MSG_QUIT] = on_game_quit,
+            [MSG_PONG] = on_ignore,
+            [MSG_DLTA] = on_delta,
+            [MSG_HINT] = on_hint,
+        },
+    },
+    [ON_TURN] = {
+        .guard = guard_game,
+        .room_only = 1,
+        .fallback = on_turn_unknown,
+        .handlers = {
+            [MSG_TAKP] = on_take_pack,
+            [MSG_PONG] = on_ignore,
+            [MSG_TAKT] = on_take_thrown,
+            [MSG_UNLO] = on_unload,
+            [MSG_ADDC] = on_add_card,
+            [MSG_THRW] = on_throw,
+            [MSG_CLOS] = on_close,
+            [MSG_QUIT] = on_game_quit,
+            [MSG_DLTA] = on_delta,
+            [MSG_HINT] = on_hint,
+        },
+    },
+    [PAUSED] = {
+        .guard = NULL,
+        .fallback = on_paused_unknown,
+        .handlers = {
+            [MSG_QUIT] = on_quit,
+            [MSG_PONG] = on_ignore,
+        },
+    },
+    [GAME_DONE] = {
+        .guard = guard_game,
+        .fallback = on_done_unknown,
+        .handlers = {
+            [MSG_QUIT] = on_quit,
+            [MSG_PLAG] = on_play_again,
+            [MSG_PONG] = on_ignore,
+            [MSG_LBBY] = on_back_to_lobby,
+            [MSG_CNNT] = on_game_leave,
+        },
+    },
+};
+
+int client_process_message(ThreadContext *ctx, const ProtocolHeader *header, char *message_body){
+    // Doba obsluhy: od naparsované zprávy po vložení poslední odpovědi do odchozí fronty
+    uint64_t started_ns = metrics_now_ns();
+    MessageContext m = {
+        .ctx = ctx,
+        .client_sock = ctx->socket_fd,
+        .client_index = ctx->client_index,
+        .client = &clients[ctx->client_index],
+        .header = header,
+        .message_body = message_body,
+        .room = NULL,
+        .game = NULL,
+        .room_id = -1,
+        .should_disconnect = 0,
+    };
+
+    LOG_LIMITED(LOG_INFO, LOG_RATE_LIMIT_CLIENT, "Přijato: type='%s' len=%d body='%s'\n",
+           header->type_msg,
+           header->message_len,
+           message_body ? message_body : "(empty)");
+
+    // Místnost zamčená při vstupu (obsluha může current_room změnit, odemyká se tato).
+    // Na zámek místnosti se nečeká s clients_mutex (tah v jedné místnosti by zdržel lobby i ostatní místnosti),
+    // current_room se mění jen pod zámkem původní i nové místnosti -> po zamčení se ověří znovu
+    GameRoom *locked_room;
+    int clients_locked;
+    for(;;){
+        pthread_mutex_lock(&clients_mutex);
+        m.client->last_heartbeat = timer_now_ms();
+        locked_room = m.client->current_room;
+        clients_locked = 1;
+        if(!locked_room){
+            break;
+        }
+        pthread_mutex_unlock(&clients_mutex);
+        clients_locked = 0;
 
-                    }
-                    client->status = IN_ROOM;
-                }
+        pthread_mutex_lock(&locked_room->lock);
+        if(m.client->current_room == locked_room){
+            PlayerStatus current = m.client->status;
+            if(current >= 0 && current < PLAYER_STATUS_COUNT && dispatch_table[current].room_only){
+                break;
+            }
+
+            // Obsluha potřebuje i tabulku klientů -> znovu v pořadí clients_mutex -> místnost
+            pthread_mutex_unlock(&locked_room->lock);
+            pthread_mutex_lock(&clients_mutex);
+            pthread_mutex_lock(&locked_room->lock);
+            clients_locked = 1;
+            if(m.client->current_room == locked_room){
                 break;
             }
+            pthread_mutex_unlock(&clients_mutex);
+            clients_locked = 0;
+        }
+        pthread_mutex_unlock(&locked_room->lock);
+    }
+
+    PlayerStatus status = m.client->status;
+    TRACE(MSG_IN, m.client_index, locked_room ? locked_room->room_id : -1, trace_fourcc(header->type_msg),
+          header->message_len, status);
+    if(status >= 0 && status < PLAYER_STATUS_COUNT && header->type >= 0 && header->type < MSG_COUNT){
+        const StatusDispatch *dispatch = &dispatch_table[status];
+
+        if(!dispatch->guard || dispatch->guard(&m)){
+            MessageHandler handler = dispatch->handlers[header->type];
+
+            // Herní tahy drží jen zámek místnosti -> tahy v různých místnostech běží souběžně
+            if(dispatch->room_only && clients_locked && m.room == locked_room){
+                pthread_mutex_unlock(&clients_mutex);
+                clients_locked = 0;
+            }
+            (handler ? handler : dispatch->fallback)(&m);
         }
+    }
 
+    if(locked_room){
+        pthread_mutex_unlock(&locked_room->lock);
+    }
+    if(clients_locked){
         pthread_mutex_unlock(&clients_mutex);
+    }
+
+    metrics_add(METRIC_FRAMES_IN, 1);
+    metrics_record_latency(status, header->type, metrics_now_ns() - started_ns);
+    return m.should_disconnect;
+}
+
+void client_connection_closed(ThreadContext *ctx, int message_status){
+    int client_sock = ctx->socket_fd;
+    int client_index = ctx->client_index;
+    ClientContext *client = &clients[client_index];
+
+    if (message_status == -1) {
+        LOG_INFO("Klient se odpojil (fd=%d, idx=%d, nick=%s)\n",
+                client_sock, client_index, clients[client_index].nick);
+        TRACE(DISCONNECT, client_index, -1, client_sock, 0, 0);
+
+        pthread_mutex_lock(&clients_mutex);
 
-        if(message_body) {
-            free(message_body);
-            message_body = NULL;
+        // jen když to pořád odpovídá tomuhle socketu (ochrana proti reconnect swapu)
+        if (clients[client_index].socket_fd == client_sock) {
+            GameRoom *room = clients[client_index].current_room;
+            if (room) {
+                pthread_mutex_lock(&room->lock);
+            }
+            clients[client_index].last_status = clients[client_index].status;
+            if (room) {
+                pthread_mutex_unlock(&room->lock);
+            }
+            clients[client_index].is_connected = 0;
+            clients[client_index].is_active = 0;
+            client_mark_disconnected_locked(&clients[client_index]);
+            clients[client_index].socket_fd = -1;
         }
 
-        if(should_disconnect) {
-            break;
+        pthread_mutex_unlock(&clients_mutex);
+    } else if(message_status < 0) {
+        // Chyba protokolu
+        LOG_LIMITED(LOG_ERROR, LOG_RATE_LIMIT_CLIENT, "Chyba protokolu: kód %d (fd=%d)\n", message_status, client_sock);
+        TRACE(INVALID_FRAME, client_index, -1, message_status, client_sock, 0);
+        metrics_add(METRIC_INVALID_FRAMES, 1);
+
+        // Odpověď přes odchozí frontu slotu -> nevloží se doprostřed rozepsané zprávy a neblokuje reaktor
+        if(message_status == -2){
+            pthread_mutex_lock(&clients_mutex);
+            if(client->socket_fd == client_sock){
+                client_send_error(client, "Invalid data");
+            }
+            pthread_mutex_unlock(&clients_mutex);
         }
     }
 
+    // Slot mezitím převzalo nové spojení (reconnect) -> jen zavři vlastní socket
+    pthread_mutex_lock(&clients_mutex);
+    int slot_taken = client->socket_fd != -1 && client->socket_fd != client_sock;
+    pthread_mutex_unlock(&clients_mutex);
 
-    if(client->current_room){
-        if(!client->current_room->game_instance){
-            leave_room(client->current_room->room_id, client->player_id);
-        } else printf("POZOR: Hráč v místnosti se hrou\n");
+    if(slot_taken){
+        LOG_INFO("Slot %d převzalo jiné spojení, zavírám fd=%d\n", client_index, client_sock);
+        out_queue_detach(&client->out, client_sock);
+        close(client_sock);
+        return;
     }
+
     // Cleanup
     LOG_INFO("Klient %s se odpojuje (fd=%d, slot=%d)\n", 
            client->nick[0] ? client->nick : "unknown", client_sock, client_index);
 
     pthread_mutex_lock(&clients_mutex);
 
-    if (client->current_room) {
+    GameRoom *room = client->current_room;
+    if (room) {
+        pthread_mutex_lock(&room->lock);
+
+        if(!room->game_instance){
+            leave_room(room->room_id, client->player_id);
+        } else printf("POZOR: Hráč v místnosti se hrou\n");
+
         char notify_msg[128];
         snprintf(notify_msg, sizeof(notify_msg), "Hráč %s se odpojil.", client->nick);
+        broadcast_to_room_locked(room, PAUS, notify_msg, client_index);
         
-        pthread_mutex_unlock(&clients_mutex);
-        broadcast_to_room(client->current_room->room_id, PAUS, notify_msg, client_index);
-        pthread_mutex_lock(&clients_mutex);
-        
-        if (client->current_room->game_instance) {
-            game_pause((GameInstance*)client->current_room->game_instance, "Hra pozastavena - čeká se na reconnect");
+        if (room->game_instance) {
+            game_pause((GameInstance*)room->game_instance, "Hra pozastavena - čeká se na reconnect");
         }
     }
     if(client_sock > 0) {
+        out_queue_detach(&client->out, client_sock);
         close(client_sock);
     }
     
     client->socket_fd = -1;
     client->is_connected = 0;
-    client->disconnect_time = time(NULL);
+    client_mark_disconnected_locked(client);
     client->is_active = 0;
     client->last_status = client->status;
-    client->status = DISCONNECTED;
+    client_set_status(client, DISCONNECTED);
+
+    if (room) {
+        pthread_mutex_unlock(&room->lock);
+    }
+
+    // Nepřihlášený klient (bez nicku) slot nedrží
+    client_slot_release_locked(client_index);
 
     // DEBUG: Výpis stavu po odpojení
-    LOG_DEBUG("  -> Po odpojení: nick='%s', socket_fd=%d, is_connected=%d, disconnect_time=%ld, status=%d, last_status=%d\n",
-           client->nick, client->socket_fd, client->is_connected, client->disconnect_time, client->status, client->last_status);
+    LOG_DEBUG("  -> Po odpojení: nick='%s', socket_fd=%d, is_connected=%d, disconnect_time=%llu, status=%d, last_status=%d\n",
+           client->nick, client->socket_fd, client->is_connected, (unsigned long long)client->disconnect_time, client->status, client->last_status);
 
     // PONECHÁME: nick, player_id, status, current_room pro reconnect!
     
     pthread_mutex_unlock(&clients_mutex);
+}
+
+void* client_handler(void* arg){
+    // Předání kontextu uživatele
+    ThreadContext ctx = *(ThreadContext*)arg;
+    free(arg);
+
+    client_attach(&ctx);
+    LOG_INFO("Vlákno spuštěno pro klienta (fd=%d, index=%d)\n", ctx.socket_fd, ctx.client_index);
+
+    // Vstupní buffer spojení (čte po velkých blocích, zprávy vydává bez dalších syscallů)
+    FrameBuffer input;
+    frame_buffer_init(&input);
+
+    int message_status = 0;
+    while(1){
+        ProtocolHeader header;
+        memset(&header, 0, sizeof(header));
+        char* message_body = NULL;
 
+        message_status = frame_read_message(&input, ctx.socket_fd, &header, &message_body);
+        if(message_status < 0){
+            break;
+        }
+
+        if(client_process_message(&ctx, &header, message_body)) {
+            message_status = 0;
+            break;
+        }
+    }
+
+    frame_buffer_free(&input);
+    client_connection_closed(&ctx, message_status);
     return NULL;
-}
\ No newline at end of file
+}
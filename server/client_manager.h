@@ -4,6 +4,8 @@
 #include <pthread.h>
 #include "protocol.h"
 #include "room_manager.h"
+#include "outbound.h"
+#include "timer_wheel.h"
 
 #define HEARTBEAT_TIMEOUT 10
 #define RECONNECT_TIMEOUT 120
@@ -15,41 +17,111 @@ typedef enum {DISCONNECTED,
               ON_WAIT,
               ON_TURN,
               PAUSED,
-              GAME_DONE
+              GAME_DONE,
+              PLAYER_STATUS_COUNT   // Počet stavů (rozměr dispatch tabulky)
 } PlayerStatus;
 
 
-// Struktura udržování dat pro konkrétního hráče (klienta)
-typedef struct{
+// Struktura udržování dat pro konkrétního hráče (klienta), každý slot začíná na vlastní cache line
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))){
     int socket_fd;                          // Socket klienta
     int player_id;                          // Herní ID klienta
     char nick[NICK_LEN+1];                  // Nick klienta
     PlayerStatus status;                    // Status klienta
     int is_active;                          // Status aktivnosti klienta
     int invalid_message_count;              // Counter nevalidních zpráv klienta
-    time_t last_heartbeat;                  // Heartbeat pro pingování klienta
-    time_t disconnect_time;                 // Čas odpojení
+    uint64_t last_heartbeat;                // Heartbeat pro pingování klienta (monotónní ms)
+    uint64_t disconnect_time;               // Čas odpojení (monotónní ms)
     int is_connected;                       // Stav připojení
     GameRoom *current_room;                 // Momentální místnost klienta
     PlayerStatus last_status;               // Poslední stav klienta
-    char token[11];                         // token pro reconnect
+    char token[TOKEN_LEN_MAX + 1];          // token pro reconnect
+    int reconnect_waiting;                  // Započten mezi čekajícími na reconnect (pod clients_mutex)
+    int delta_stat;                         // Klient si vyžádal DLTA místo STAT po tazích
+    uint32_t stat_version;                  // Verze stavu hry, kterou klient má (pod zámkem místnosti)
+    OutQueue out;                           // Odchozí fronta (od ní dál se slot při client_slot_reset nemaže)
+    TimerNode ping_timer;                   // Periodický PING
+    TimerNode heartbeat_timer;              // Vypršení heartbeatu
+    TimerNode reconnect_timer;              // Vypršení lhůty pro reconnect
 } ClientContext;
 
-// Kontext klienta pro klientské vlákno
+// Počty klientů pro správcovské rozhraní (čtení bez zámku, každá hodnota zvlášť atomicky)
+typedef struct{
+    int status[PLAYER_STATUS_COUNT];        // Přihlášení klienti podle stavu (DISCONNECTED se nepočítá)
+    int reconnect_wait;                     // Odpojení klienti v lhůtě pro reconnect
+    int timers;                             // Naplánované časovače (stav po posledním ticku)
+} ClientGauges;
+
+// Kontext klientského spojení (klientské vlákno nebo reaktor)
 typedef struct{
     int socket_fd;
     int client_index;
 } ThreadContext;
 
-// Pole zaregistrovaných klientů
-extern ClientContext clients[MAX_CLIENTS];
+// Pole zaregistrovaných klientů (alokováno při startu na kapacitu max_clients)
+extern ClientContext *clients;
+// Kapacita pole klientů
+extern int max_clients;
+// Časové kolo serveru pro klienty i místnosti (přístup přes server_timer_*)
+extern TimerWheel server_timers;
 // Mutex pro přístup do pole
 extern pthread_mutex_t clients_mutex;
 
 /**
- * @brief Inicializace pole klientů, provede základní nastavení pole, může mít nekonečněkrát modifikováno
+ * @brief Alokace a inicializace pole klientů, provede základní nastavení pole a naplní zásobník volných slotů
+ * @param capacity Počet slotů
+ * @return 0: SUCCESS, -1: ERROR (malloc)
+ */
+int initialize_clients(int capacity);
+
+/**
+ * @brief Přidělí volný slot klienta v O(1) (volat pod clients_mutex)
+ * @return Index slotu, -1: žádný volný slot
+ */
+int client_slot_acquire_locked();
+
+/**
+ * @brief Vrátí slot do zásobníku volných slotů, pokud je opravdu volný (bez socketu a bez nicku), volat pod clients_mutex
+ * @param client_index Index slotu
+ */
+void client_slot_release_locked(int client_index);
+
+/**
+ * @brief Odešle zprávu klientovi přes jeho odchozí frontu (nikdy neblokuje, lze volat pod zámky)
+ * @param client Klient
+ * @param type_msg Typ zprávy
+ * @param message Tělo zprávy
+ * @return out_queue_send() returns
  */
-void initialize_clients();
+int client_send(ClientContext *client, const char *type_msg, const char *message);
+
+/**
+ * @brief Jako client_send, délka těla je známá předem
+ * @param client Klient
+ * @param type_msg Typ zprávy
+ * @param message Tělo zprávy
+ * @param msg_len Délka těla
+ * @return out_queue_send() returns
+ */
+int client_send_len(ClientContext *client, const char *type_msg, const char *message, size_t msg_len);
+
+/**
+ * @brief Jako client_send, tělo je složené z částí (zápis vektorem bez slévání do jednoho bufferu)
+ * @param client Klient
+ * @param type_msg Typ zprávy
+ * @param parts Části těla
+ * @param count Počet částí
+ * @return out_queue_sendv() returns
+ */
+int client_sendv(ClientContext *client, const char *type_msg, const struct iovec *parts, int count);
+
+/**
+ * @brief Odešle klientovi chybovou zprávu (ERRR) přes jeho odchozí frontu
+ * @param client Klient
+ * @param err_msg Text chyby
+ * @return out_queue_send() returns
+ */
+int client_send_error(ClientContext *client, const char *err_msg);
 
 /**
  * @brief Odstranění klienta z pole klientů
@@ -57,22 +129,77 @@ void initialize_clients();
  */
 void remove_client(int client_socket);
 
+/**
+ * @brief Změní stav klienta a s ním počty klientů podle stavu (client_gauges)
+ * @param client Klient
+ * @param status Nový stav (volat pod zámkem, který stav klienta chrání: místnost nebo clients_mutex)
+ */
+void client_set_status(ClientContext *client, PlayerStatus status);
 
 /**
- * @brief Mozek serveru, člení herní status klienta, kontroluje zprávy a podle nich odesílá instrukce
+ * @brief Přečte počty klientů podle stavu, čekajících na reconnect a časovačů (bez zámků)
+ * @param gauges Výstup
+ */
+void client_gauges(ClientGauges *gauges);
+
+
+/**
+ * @brief Převezme nově přijaté spojení do slotu klienta (inicializace kontextu klienta)
+ * @param ctx Kontext spojení (socket a index)
+ */
+void client_attach(ThreadContext *ctx);
+
+/**
+ * @brief Mozek serveru, člení herní status klienta, kontroluje zprávu a podle ní odesílá instrukce
+ * @param ctx Kontext spojení, při reconnectu se v něm mění index klienta
+ * @param header Hlavička přijaté zprávy
+ * @param message_body Tělo přijaté zprávy
+ * @return 1: klient má být odpojen, 0: pokračuj
+ */
+int client_process_message(ThreadContext *ctx, const ProtocolHeader *header, char *message_body);
+
+/**
+ * @brief Úklid po ukončení spojení (pozastavení hry, uvolnění místnosti, zavření socketu)
+ * @param ctx Kontext spojení
+ * @param message_status Návratová hodnota čtení zprávy, která spojení ukončila (0: QUIT/odpojení serverem)
+ */
+void client_connection_closed(ThreadContext *ctx, int message_status);
+
+/**
+ * @brief Klientské vlákno (režim vlákno na klienta), čte zprávy a předává je client_process_message
  * @param arg Obsahuje context klienta pro klientské vlákno (socket a index)
  */
 void *client_handler(void* arg);
 
 /**
- * @brief Hledá hráče v poli všech hráčů na základě nicku
+ * @brief Hledá hráče v poli všech hráčů na základě nicku (hash index, volat pod clients_mutex)
  * @param nick Přezdívka uživatele
- * @return
+ * @return index slotu, -1: nenalezen
  */
 int find_player_by_nick(const char* nick);
 
 /**
- * @brief Kontroluje délku nejdelšího odpojení pro smazání klienta z paměti a maximální rozsah pro heartbeat 
+ * @brief Hledá hráče podle reconnect tokenu (hash index, volat pod clients_mutex)
+ * @param token Token přidělený při přihlášení
+ * @return index slotu, -1: nenalezen
+ */
+int find_player_by_token(const char* token);
+
+/**
+ * @brief Naplánuje časovač v server_timers (vláknově bezpečné, lze volat pod libovolným zámkem)
+ * @param timer Časovač
+ * @param deadline_ms Monotónní deadline v ms
+ */
+void server_timer_schedule(TimerNode *timer, uint64_t deadline_ms);
+
+/**
+ * @brief Zruší časovač v server_timers (vláknově bezpečné, lze volat pod libovolným zámkem)
+ * @param timer Časovač
+ */
+void server_timer_cancel(TimerNode *timer);
+
+/**
+ * @brief Obslouží všechny vypršené časovače (PING, heartbeat, reconnect, tahy her), práce úměrná počtu vypršených
  */
 void check_client_timeouts();
 
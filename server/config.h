@@ -9,8 +9,14 @@
 #define SERVER_ADDRESS ""       
 // Port serveru, na kterém bude naslouchat
 #define SERVER_PORT 10000
-// Maximální množství klientů k obsloužení
-#define MAX_CLIENTS 10
+// Výchozí kapacita tabulky klientů (--max-clients=N)
+#define DEFAULT_MAX_CLIENTS 10
+// Horní mez kapacity tabulek klientů a místností
+#define MAX_TABLE_CAPACITY 1000000
+// Výchozí délka fronty listen() nezávislá na kapacitě klientů (--backlog=N)
+#define LISTEN_BACKLOG 128
+// Velikost cache line pro zarovnání slotů tabulek
+#define CACHE_LINE_SIZE 64
 // Magic pro protokolové zprávy
 #define MAGIC "JOKE"
 // Interval PING zprávy
@@ -36,8 +42,14 @@
 #define MAX_ROOM_LIMIT 2
 // Maximální počet disconnectů
 #define MAX_DISCONNECT_COUNT 3
-// Definice délky tokenu pro reconnect
-#define TOKEN_LEN 3
+// Nejkratší token pro reconnect (s kapacitou tabulky klientů se prodlužuje)
+#define TOKEN_LEN_MIN 3
+// Nejdelší token pro reconnect (velikost pole v ClientContext)
+#define TOKEN_LEN_MAX 10
+// Počet možných tokenů na slot klienta, podle kterého se volí délka (kolize při generování zůstanou vzácné)
+#define TOKEN_SPACE_PER_CLIENT 1024
+// Počet pokusů o vygenerování unikátního tokenu
+#define TOKEN_ATTEMPTS 16
 // Definice počtu přijatelných argumentů z cmd line
 #define ARGUMENT_COUNT 3
 // ______________________________
@@ -55,9 +67,22 @@
 #define DECK_CARDS_COUNT 108
 #define MAX_SEQUENCE_CARDS 15
 #define MAX_SEQUENCES 50
-
-// Nastavení místnosti (room_manager.h)
-#define MAX_ROOMS 7
+// Změny stavu mezi dvěma STAT/DLTA (víc -> plný STAT)
+#define MAX_GAME_CHANGES 32
+// Buffery STAT: sdílený stůl (všechny karty + oddělovače), ID postupek a verze, soukromá ruka a tah
+#define GAME_SNAPSHOT_BUFFER 512
+#define GAME_SNAPSHOT_TAIL_BUFFER 512
+#define GAME_PRIVATE_STATE_BUFFER 256
+
+// Časový rozpočet solveru pro nápovědu HINT (µs), hledání běží pod zámkem místnosti
+#define HINT_BUDGET_US 2000
+// Nejkratší odstup dvou běhů solveru pro jednoho hráče (ms), opakovaný HINT nad stejnou verzí jde z cache
+#define HINT_MIN_INTERVAL_MS 250
+// Buffer odpovědi OINT (uložená nápověda hráče)
+#define GAME_HINT_BUFFER 256
+
+// Nastavení místnosti (room_manager.h), výchozí kapacita tabulky místností (--max-rooms=N)
+#define DEFAULT_MAX_ROOMS 7
 #define MAX_PLAYERS_PER_ROOM 2
 #define ROOM_NAME_LEN 15
 // ___________________________________________________________
@@ -66,11 +91,91 @@
 
 
 // ________ TIMEOUT INTERVAL (server_manager.h) ________
-#define TIMEOUT_CHECK_INTERVAL 3
+// Délka ticku časového kola (ms)
+#define TIMER_TICK_MS 100
+// Interval PING zpráv přihlášeným klientům (ms)
+#define CLIENT_PING_INTERVAL_MS 3000
+// Nejdelší čekání na dokončení klientských vláken při ukončení serveru (ms)
+#define SHUTDOWN_WAIT_MS 2000
 // _____________________________________________________
 
 
+
+// ________ EPOLL REAKTOR (reactor.h) ________
+// Maximální počet reaktorových vláken (--reactor=N)
+#define MAX_REACTOR_THREADS 64
+// Počet událostí vyzvednutých jedním voláním epoll_wait
+#define REACTOR_MAX_EVENTS 64
+// Timeout (ms) pro dokončení odesílání na neblokujícím socketu
+#define SEND_POLL_TIMEOUT 5000
+// ___________________________________________
+
+
+// ________ ODCHOZÍ FRONTY (outbound.h) ________
+// Maximální počet zpráv ve frontě klienta (mocnina dvou)
+#define OUT_QUEUE_MAX_FRAMES 64
+// Výchozí limit neodeslaných bajtů na klienta (--out-queue=B)
+#define OUT_QUEUE_MAX_BYTES 65536
+// Počet zpráv zapsaných jedním sendmsg při dopisování fronty
+#define OUT_FLUSH_IOV 16
+// Maximální počet částí těla jedné zprávy (out_queue_sendv)
+#define OUT_SEND_MAX_PARTS 8
+// _____________________________________________
+
+
+// ________ LOGGER (logger.h) ________
+// Výchozí počet záznamů v kruhové frontě loggeru (--async-log, mocnina dvou)
+#define LOG_RING_RECORDS 4096
+// Délka textu jednoho záznamu (delší zpráva se ořízne)
+#define LOG_RECORD_MESSAGE 200
+// Nejvíc záznamů zapsaných zapisovacím vláknem před jedním fflush
+#define LOG_WRITER_BATCH 512
+// Uspání zapisovacího vlákna při prázdné frontě (ms)
+#define LOG_WRITER_IDLE_MS 2
+// Výchozí limit zpráv za sekundu z jednoho místa volání LOG_* (0: bez omezení)
+#define LOG_RATE_LIMIT 200
+// Limit pro místa, která může vyvolat klient (příchozí zprávy, chyby protokolu, plná fronta)
+#define LOG_RATE_LIMIT_CLIENT 20
+// ____________________________________
+
+
+// ________ BINÁRNÍ TRASOVÁNÍ (trace.h) ________
+// Výchozí horní mez velikosti souboru trasování v MB (--trace-size=MB)
+#define TRACE_DEFAULT_MB 64
+// Největší povolená velikost souboru trasování v MB
+#define TRACE_MAX_MB 4096
+// _____________________________________________
+
+
+// ________ METRIKY (metrics.h) ________
+// Počet oddílů čítačů (vlákna se do nich přidělují dokola, reaktorová vlákna by měla mít každé svůj)
+#define METRICS_SHARDS 16
+// Počet košů histogramu doby obsluhy zprávy (poslední koš: vše delší)
+#define METRICS_LATENCY_BUCKETS 24
+// Horní mez prvního koše jako mocnina dvou ns (10: ~1 us)
+#define METRICS_LATENCY_MIN_SHIFT 10
+// _____________________________________
+
+
+// ________ SPRÁVCOVSKÉ ROZHRANÍ (admin.h) ________
+// Interval zveřejňování snímku stavu serveru (ms)
+#define ADMIN_PUBLISH_MS 1000
+// Timeout čtení požadavku a zápisu odpovědi jednoho dotazu (ms)
+#define ADMIN_IO_TIMEOUT_MS 1000
+// Nejdelší čtená část požadavku (stačí první řádek)
+#define ADMIN_REQUEST_MAX 1024
+// Počáteční velikost bufferu odpovědi
+#define ADMIN_BUFFER_MIN 4096
+// Délka fronty listen() správcovského socketu
+#define ADMIN_BACKLOG 8
+// Nejdelší cesta UNIX socketu včetně '\0' (sun_path)
+#define ADMIN_PATH_MAX 108
+// _______________________________________________
+
+
 #define MAX_GARBAGE 16
+// Velikost vstupního kruhového bufferu spojení (mocnina dvou, frame_buffer.h)
+#define FRAME_RING_SIZE 4096
 
 
 
@@ -0,0 +1,208 @@
+#include "frame_buffer.h"
+#include "config.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#define FRAME_RING_MASK (FRAME_RING_SIZE - 1)
+// Počáteční kapacita těla zprávy
+#define FRAME_BODY_MIN 256
+
+#if (FRAME_RING_SIZE & FRAME_RING_MASK) != 0 || FRAME_RING_SIZE < HEADER_LEN
+#error "FRAME_RING_SIZE must be a power of two >= HEADER_LEN"
+#endif
+
+void frame_buffer_init(FrameBuffer *fb){
+    fb->head = 0;
+    fb->tail = 0;
+    fb->state = FRAME_SEEK_MAGIC;
+    fb->magic_matched = 0;
+    fb->garbage = 0;
+    memset(&fb->header, 0, sizeof(fb->header));
+    fb->body = NULL;
+    fb->body_cap = 0;
+    fb->body_len = 0;
+    fb->recv_calls = 0;
+    fb->frames = 0;
+}
+
+void frame_buffer_free(FrameBuffer *fb){
+    free(fb->body);
+    fb->body = NULL;
+    fb->body_cap = 0;
+}
+
+ssize_t frame_buffer_fill(FrameBuffer *fb, int sock, int flags){
+    size_t used = fb->tail - fb->head;
+    size_t pos = fb->tail & FRAME_RING_MASK;
+
+    // Souvislé volné místo od pozice zápisu do konce pole (nebo do pozice čtení)
+    size_t space = FRAME_RING_SIZE - used;
+    if(space > FRAME_RING_SIZE - pos){
+        space = FRAME_RING_SIZE - pos;
+    }
+    if(space == 0){
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    fb->recv_calls++;
+    ssize_t r = recv(sock, fb->ring + pos, space, flags);
+    if(r > 0){
+        fb->tail += r;
+        metrics_add(METRIC_BYTES_IN, (unsigned long)r);
+    }
+    return r;
+}
+
+/**
+ * @brief Zkopíruje count bajtů z pozice čtení (přes hranici pole) a posune ji
+ */
+static void ring_take(FrameBuffer *fb, char *dst, size_t count){
+    size_t pos = fb->head & FRAME_RING_MASK;
+    size_t first = FRAME_RING_SIZE - pos;
+    if(first > count){
+        first = count;
+    }
+    memcpy(dst, fb->ring + pos, first);
+    memcpy(dst + first, fb->ring, count - first);
+    fb->head += count;
+}
+
+/**
+ * @brief Zajistí kapacitu těla pro zprávu dané délky
+ * @return 0: SUCCESS, -1: malloc error
+ */
+static int body_reserve(FrameBuffer *fb, size_t len){
+    if(fb->body && fb->body_cap >= len + 1){
+        return 0;
+    }
+
+    size_t cap = fb->body_cap ? fb->body_cap : FRAME_BODY_MIN;
+    while(cap < len + 1){
+        cap *= 2;
+    }
+
+    char *body = realloc(fb->body, cap);
+    if(!body){
+        return -1;
+    }
+    fb->body = body;
+    fb->body_cap = cap;
+    return 0;
+}
+
+int frame_buffer_next(FrameBuffer *fb, ProtocolHeader *header_out, char **message_out){
+    while(1){
+        size_t avail = fb->tail - fb->head;
+
+        switch(fb->state){
+            case FRAME_SEEK_MAGIC: {
+                // Stejná pravidla jako read_full_message: každý bajt, který nedokončí MAGIC, je bordel
+                while(avail > 0){
+                    char c = fb->ring[fb->head & FRAME_RING_MASK];
+                    fb->head++;
+                    avail--;
+
+                    if(c == MAGIC[fb->magic_matched]){
+                        fb->magic_matched++;
+                        if(fb->magic_matched == MAGIC_LEN){
+                            break;
+                        }
+                    } else{
+                        // "JOKE" nemá vlastní prefix shodný se sufixem -> stačí zkusit začátek
+                        fb->magic_matched = (c == MAGIC[0]) ? 1 : 0;
+                    }
+
+                    if(++fb->garbage >= MAX_GARBAGE){
+                        return -2; // moc bordelu
+                    }
+                }
+
+                if(fb->magic_matched < MAGIC_LEN){
+                    return 0;
+                }
+                // garbage počítá i shodné znaky MAGIC -> víc znamená, že se přeskakoval bordel
+                if(fb->garbage > MAGIC_LEN - 1){
+                    metrics_add(METRIC_GARBAGE_RESYNCS, 1);
+                }
+                fb->magic_matched = 0;
+                fb->garbage = 0;
+                fb->state = FRAME_READ_HEADER;
+                break;
+            }
+
+            case FRAME_READ_HEADER: {
+                if(avail < HEADER_LEN - MAGIC_LEN){
+                    return 0;
+                }
+
+                char rest[HEADER_LEN - MAGIC_LEN];
+                char len_str[LENGTH_LEN + 1];
+                ring_take(fb, rest, sizeof(rest));
+
+                memcpy(fb->header.magic, MAGIC, MAGIC_LEN);
+                fb->header.magic[MAGIC_LEN] = '\0';
+
+                memcpy(fb->header.type_msg, rest, MSG_TYPE_LEN);
+                fb->header.type_msg[MSG_TYPE_LEN] = '\0';
+
+                memcpy(len_str, rest + MSG_TYPE_LEN, LENGTH_LEN);
+                len_str[LENGTH_LEN] = '\0';
+
+                fb->state = FRAME_SEEK_MAGIC;
+                fb->header.type = msg_type_decode(fb->header.type_msg);
+                if (fb->header.type == MSG_UNKNOWN) return -3;
+                if (!validate_message_len(len_str)) return -4;
+
+                fb->header.message_len = atoi(len_str);
+                if (body_reserve(fb, fb->header.message_len) != 0) return -5;
+
+                fb->body_len = 0;
+                fb->state = FRAME_READ_BODY;
+                break;
+            }
+
+            case FRAME_READ_BODY: {
+                size_t missing = fb->header.message_len - fb->body_len;
+                size_t take = avail < missing ? avail : missing;
+                ring_take(fb, fb->body + fb->body_len, take);
+                fb->body_len += take;
+
+                if(fb->body_len < (size_t)fb->header.message_len){
+                    return 0;
+                }
+
+                fb->body[fb->body_len] = '\0';
+                fb->state = FRAME_SEEK_MAGIC;
+                fb->frames++;
+
+                *header_out = fb->header;
+                *message_out = fb->body;
+                return 1;
+            }
+        }
+    }
+}
+
+int frame_read_message(FrameBuffer *fb, int client_sock, ProtocolHeader *header_out, char **message_out){
+    while(1){
+        int status = frame_buffer_next(fb, header_out, message_out);
+        if(status == 1){
+            return 0;
+        }
+        if(status < 0){
+            return status;
+        }
+
+        ssize_t r = frame_buffer_fill(fb, client_sock, 0);
+        if(r < 0 && errno == EINTR){
+            continue;
+        }
+        if(r <= 0){
+            return -1;
+        }
+    }
+}
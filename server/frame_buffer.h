@@ -0,0 +1,74 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "protocol.h"
+
+// Stav parseru zpráv
+typedef enum{
+    FRAME_SEEK_MAGIC,           // Hledání "JOKE" (nejvýše MAX_GARBAGE bajtů)
+    FRAME_READ_HEADER,          // Čekání na typ a délku zprávy
+    FRAME_READ_BODY             // Čtení těla zprávy
+} FrameParseState;
+
+// Vstupní kruhový buffer spojení + rozpracovaná zpráva
+typedef struct{
+    char ring[FRAME_RING_SIZE];         // Přijatá, dosud nezpracovaná data
+    size_t head;                        // Pozice čtení (monotónní, maskuje se)
+    size_t tail;                        // Pozice zápisu (monotónní, maskuje se)
+
+    FrameParseState state;              // Stav parseru
+    int magic_matched;                  // Počet již shodných znaků MAGIC
+    int garbage;                        // Počet bajtů prohledaných při hledání MAGIC
+
+    ProtocolHeader header;              // Hlavička rozpracované zprávy
+    char *body;                         // Tělo zprávy (alokuje se při prvním použití, roste do MAX_MESSAGE_LEN)
+    size_t body_cap;                    // Kapacita těla
+    size_t body_len;                    // Již přijatá část těla
+
+    unsigned long recv_calls;           // Počet volání recv (statistika)
+    unsigned long frames;               // Počet zpracovaných zpráv (statistika)
+} FrameBuffer;
+
+/**
+ * @brief Inicializace prázdného bufferu
+ * @param fb Buffer spojení
+ */
+void frame_buffer_init(FrameBuffer *fb);
+
+/**
+ * @brief Uvolní paměť těla zprávy
+ * @param fb Buffer spojení
+ */
+void frame_buffer_free(FrameBuffer *fb);
+
+/**
+ * @brief Jedno volání recv do volného souvislého místa v kruhovém bufferu
+ * @param fb Buffer spojení
+ * @param sock Socket klienta
+ * @param flags Příznaky pro recv (MSG_DONTWAIT v reaktoru)
+ * @return návratová hodnota recv
+ */
+ssize_t frame_buffer_fill(FrameBuffer *fb, int sock, int flags);
+
+/**
+ * @brief Vyzvedne další celou zprávu z již přijatých dat (bez systémových volání)
+ * @param fb Buffer spojení
+ * @param header_out Hlavička zprávy
+ * @param message_out Ukazatel na tělo (platí do dalšího volání, ukončeno '\0')
+ * @return 1: zpráva připravena, 0: chybí data, <0: chyba protokolu (kódy jako read_full_message)
+ */
+int frame_buffer_next(FrameBuffer *fb, ProtocolHeader *header_out, char **message_out);
+
+/**
+ * @brief Blokující čtení jedné zprávy (režim vlákno na klienta), recv volá jen když buffer nemá celou zprávu
+ * @param fb Buffer spojení
+ * @param client_sock Klientský socket
+ * @param header_out Hlavička zprávy
+ * @param message_out Ukazatel na tělo (platí do dalšího volání)
+ * @return 0: SUCCESS, -1: odpojení, ostatní <0 jako read_full_message
+ */
+int frame_read_message(FrameBuffer *fb, int client_sock, ProtocolHeader *header_out, char **message_out);
+
+#endif
@@ -0,0 +1,532 @@
+#include "game_engine.h"
+#include "meld.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Zaznamená změnu stavu do logu (při přetečení jen označí, že je potřeba plný STAT)
+ */
+static void engine_change_record(GameInstance *game, GameChangeKind kind, PlayerGameState *player, Card card, uint16_t seq_id){
+    game->changes_recorded++;
+
+    if(game->change_count >= MAX_GAME_CHANGES){
+        game->changes_overflow = 1;
+        return;
+    }
+
+    GameChange *change = &game->changes[game->change_count++];
+    change->kind = (uint8_t)kind;
+    change->player = player ? (uint8_t)(player - game->players) : 0;
+    change->card = card;
+    change->seq_id = seq_id;
+}
+
+/**
+ * @brief Najde vyloženou kombinaci podle cíle z ADDC
+ *
+ * Cíl je buď ID kombinace ze STAT (jen číslice), nebo u starších klientů řetězec kódů karet
+ * v pořadí na stole. Kódy se hledají přes otisk meld_hash, shoda otisku se ověří po kartách.
+ * Dvě stejné kombinace podle kódů nerozliší (vrací první), podle ID ano.
+ * @param game Instance hry
+ * @param target Cíl z těla ADDC (před '|')
+ * @return Kombinace, NULL: nenalezena
+ */
+static CardSequence *engine_find_sequence(GameInstance *game, const char *target){
+    size_t len = strlen(target);
+
+    if(len == 0){
+        return NULL;
+    }
+
+    // ID: kombinace se jen přidávají, ID je pořadí vyložení
+    if(strspn(target, "0123456789") == len){
+        if(len > 5){
+            return NULL;
+        }
+        int id = atoi(target);
+        if(id < 1 || id > game->sequence_count){
+            return NULL;
+        }
+        return &game->sequences[id - 1];
+    }
+
+    // Řetězec kódů
+    if(len % 2 != 0 || len / 2 > MAX_SEQUENCE_CARDS){
+        return NULL;
+    }
+
+    Card cards[MAX_SEQUENCE_CARDS];
+    int count = (int)(len / 2);
+    for(int i = 0; i < count; i++){
+        cards[i] = card_from_chars(target + i * 2);
+        if(cards[i] == CARD_NONE){
+            return NULL;
+        }
+    }
+
+    uint32_t hash = meld_hash(cards, count);
+    for(int i = 0; i < game->sequence_count; i++){
+        CardSequence *seq = &game->sequences[i];
+
+        if(seq->hash != hash || seq->count != count){
+            continue;
+        }
+
+        int j = 0;
+        while(j < count && card_face(seq->cards[j]) == cards[j]){
+            j++;
+        }
+        if(j == count){
+            return seq;
+        }
+    }
+    return NULL;
+}
+
+int engine_setup(GameInstance *game, const int *client_indexes, int count, uint64_t seed){
+    if(!game || !client_indexes || count < 1 || count > MAX_ROOM_PLAYERS){
+        return -1;
+    }
+
+    memset(game, 0, sizeof(GameInstance));
+    game->state = GAME_STATE_LOBBY;
+    game->current_player_index = 0;
+    game->seed = seed;
+    rng_seed(&game->rng, seed);
+
+    for(int i = 0; i < count; i++){
+        PlayerGameState *player = &game->players[game->player_count];
+
+        player->client_index = client_indexes[i];
+        player->position = game->player_count;
+        player->is_active = 1;
+        card_hand_clear(&player->hand);
+
+        // Určení hráče pro výhoz
+        player->takes_15 = game->player_count == 0;
+
+        game->player_count++;
+    }
+    return 0;
+}
+
+int engine_start(GameInstance *game){
+    if(!game || game->state != GAME_STATE_LOBBY){
+        return -1;
+    }
+
+    game->state = GAME_STATE_STARTING;
+    engine_init_deck(game);
+    if(engine_deal_cards(game) != 0){
+        game->state = GAME_STATE_LOBBY;
+        return -1;
+    }
+
+    // Nastavení výhozového balíčku
+    if(game->deck_count > 0){
+        game->deck_count--;
+        game->discard_deck[0] = game->deck[game->deck_count];
+        game->discard_count = 1;
+    }
+
+    // Rozdaný stav dostanou klienti celý (STAT), log změn začíná až prvním tahem
+    game->state_version = 1;
+    engine_changes_reset(game);
+
+    for(int i = 0; i < game->player_count; i++){
+        if(game->players[i].takes_15){
+            game->current_player_index = i;
+            break;
+        }
+    }
+
+    game->state = GAME_STATE_PLAYING;
+    return 0;
+}
+
+PlayerGameState *engine_find_player(GameInstance *game, int client_index){
+    for(int i = 0; i < game->player_count; i++){
+        if(game->players[i].client_index == client_index){
+            return &game->players[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief TAKP - hráč líže z balíčku
+ */
+static int engine_take_pack(GameInstance *game, PlayerGameState *player){
+    // Kontrola, zda už nelízal
+    if(player->took_card == 1){
+        return -2;
+    }
+
+    // Kontrola, zda už nevyhodil
+    if(player->did_thrown == 1){
+        return -3;
+    }
+
+    // První hráč v prvním kole nelíže (má 15 karet)
+    if(player->takes_15 && player->turns_played == 0){
+        return -4;
+    }
+
+    // Prázdný balíček: zamíchá se odhazovací balíček (bez vrchní karty), hráč to zkusí znovu
+    if(game->deck_count == 0){
+        return engine_reshuffle_discard(game) == 0 ? -5 : -6;
+    }
+
+    // Ruka nepojme třetí exemplář karty -> karta zůstane v balíčku, tah se odmítne
+    if(card_hand_add(&player->hand, game->deck[game->deck_count - 1]) != 0){
+        return -1;
+    }
+    game->deck_count--;
+    engine_change_record(game, CHANGE_HAND_ADD, player, game->deck[game->deck_count], 0);
+
+    player->turns_played++;
+    player->took_card = 1;
+    return 0;
+}
+
+/**
+ * @brief TAKT - hráč líže vyhozenou kartu
+ */
+static int engine_take_thrown(GameInstance *game, PlayerGameState *player){
+    // Kontrola, zda už nelízal
+    if(player->took_card == 1){
+        return -2;
+    }
+
+    if(game->discard_count == 0){
+        return -3;
+    }
+
+    if(player->takes_15 == 1 && player->turns_played == 0){
+        return -3;
+    }
+
+    // Lízni vrchní kartu z trashe
+    if(card_hand_add(&player->hand, game->discard_deck[game->discard_count - 1]) != 0){
+        return -1;
+    }
+    game->discard_count--;
+    engine_change_record(game, CHANGE_HAND_ADD, player, game->discard_deck[game->discard_count], 0);
+    engine_change_record(game, CHANGE_DISCARD, NULL, 0, 0);
+
+    player->turns_played++;
+    player->took_card = 1;
+    return 0;
+}
+
+/**
+ * @brief UNLO - hráč vykládá karty (set nebo postupka)
+ */
+static int engine_unload(GameInstance *game, PlayerGameState *player, const char *message_body){
+    if(!message_body){
+        return -1;
+    }
+
+    int len = strlen(message_body);
+
+    // každá karta má 2 znaky, min. 3 karty
+    if(len < 6 || (len % 2) != 0){
+        return -1;
+    }
+
+    int parsed_count = len / 2;
+    if(parsed_count >= player->hand.count || parsed_count > MAX_HAND_CARD){
+        return -69;
+    }
+
+    // rozparsování karet a ověření, že je hráč má v ruce (odebírá se z kopie ruky -> hlídá i počet exemplářů)
+    Card cards_to_unload[MAX_HAND_CARD];
+    CardHand remaining_hand = player->hand;
+
+    for(int i = 0; i < parsed_count; i++){
+        cards_to_unload[i] = card_from_chars(message_body + i * 2);
+
+        if(cards_to_unload[i] == CARD_NONE || card_hand_remove(&remaining_hand, cards_to_unload[i]) != 0){
+            return -1;
+        }
+    }
+
+    // SET (stejná hodnota, různé barvy) nebo POSTUPKA (stejná barva, navazující hodnoty, eso dole i nahoře)
+    // Run různých barev se nepodporuje (kód odebrán -> fragments/run.txt)
+    Meld meld;
+    MeldKind kind = meld_classify(cards_to_unload, parsed_count, &meld);
+
+    if(kind == MELD_INVALID || game->sequence_count >= MAX_SEQUENCES){
+        return -1;
+    }
+
+    // Odebrání karet z ruky (kopie ruky už je bez nich)
+    player->hand = remaining_hand;
+    for(int i = 0; i < parsed_count; i++){
+        engine_change_record(game, CHANGE_HAND_REMOVE, player, cards_to_unload[i], 0);
+    }
+    player->cards_played += parsed_count;
+
+    // Na stůl v kanonickém pořadí (postupka vzestupně se žolíky na jejich místech)
+    CardSequence *seq = &game->sequences[game->sequence_count++];
+    seq->kind = (uint8_t)kind;
+    seq->count = meld.count;
+    seq->id = (uint16_t)game->sequence_count;
+    seq->owner_client_index = player->client_index;
+    memcpy(seq->cards, meld.cards, meld.count);
+    seq->hash = meld_hash(seq->cards, seq->count);
+    engine_change_record(game, CHANGE_MELD_NEW, player, 0, seq->id);
+
+    return 0;
+}
+
+/**
+ * @brief ADDC - přiložení karty k vyložené kombinaci
+ */
+static int engine_add_card(GameInstance *game, PlayerGameState *player, const char *message_body){
+    if(!message_body){
+        return -1;
+    }
+
+    // Rozdělení zprávy podle '|' (cíl do vlastního bufferu, tělo zůstane beze změny)
+    const char *pipe = strchr(message_body, '|');
+    char target[MAX_SEQUENCE_CARDS * 2 + 1];
+    size_t target_len = pipe ? (size_t)(pipe - message_body) : 0;
+
+    if(!pipe || target_len >= sizeof(target)){
+        return -1;
+    }
+    memcpy(target, message_body, target_len);
+    target[target_len] = '\0';
+
+    // Ověření, že hráč má kartu v ruce
+    Card new_card = card_from_code(pipe + 1);
+    if(new_card == CARD_NONE || card_hand_copies(&player->hand, new_card) == 0){
+        return -1;
+    }
+
+    if(player->hand.count == 1){
+        return -1;
+    }
+
+    // Nalezení cílové sekvence (ID ze STAT, u starších klientů kódy karet)
+    CardSequence *target_seq = engine_find_sequence(game, target);
+
+    if(!target_seq || target_seq->count >= MAX_SEQUENCE_CARDS){
+        return -1;
+    }
+
+    // Validace: kombinace s novou kartou musí zůstat stejného druhu (set zůstane setem, postupka postupkou)
+    Card extended[MAX_SEQUENCE_CARDS];
+    memcpy(extended, target_seq->cards, target_seq->count);
+    extended[target_seq->count] = new_card;
+
+    Meld meld;
+    if(meld_classify(extended, target_seq->count + 1, &meld) != (MeldKind)target_seq->kind){
+        return -1;
+    }
+
+    // Provedení akce (karta na své místo v kanonickém pořadí)
+    memcpy(target_seq->cards, meld.cards, meld.count);
+    target_seq->count = meld.count;
+    target_seq->hash = meld_hash(target_seq->cards, target_seq->count);
+    engine_change_record(game, CHANGE_MELD_EXTEND, player, 0, target_seq->id);
+
+    // Odebrání karty z ruky hráče
+    card_hand_remove(&player->hand, new_card);
+    engine_change_record(game, CHANGE_HAND_REMOVE, player, new_card, 0);
+    player->cards_played++;
+
+    return 0;
+}
+
+/**
+ * @brief THRW - vyhození karty a předání tahu (prázdná ruka ukončí hru)
+ */
+static int engine_throw(GameInstance *game, PlayerGameState *player, const char *message_body){
+    if(!message_body || strlen(message_body) == 0){
+        return -1;
+    }
+
+    // Kontrola, zda už nevyhodil
+    if(player->did_thrown == 1){
+        return -1;
+    }
+
+    // Bez líznutí smí vyhodit jen první hráč v prvním kole (má 15 karet)
+    if(player->took_card == 0 && !(player->takes_15 && player->turns_played == 0)){
+        return -2;
+    }
+
+    if(player->hand.count == 1){
+        return -3;
+    }
+
+    // Najdi a odeber kartu z ruky
+    Card card = card_from_code(message_body);
+
+    if(card == CARD_NONE || card_hand_remove(&player->hand, card) != 0){
+        return -1;
+    }
+
+    // Přidej kartu na odhazovací hromádku
+    game->discard_deck[game->discard_count++] = card;
+    engine_change_record(game, CHANGE_HAND_REMOVE, player, card, 0);
+    engine_change_record(game, CHANGE_DISCARD, NULL, 0, 0);
+
+    // Reset flagů pro tohoto hráče
+    player->took_card = 0;
+    player->did_thrown = 0;
+    player->turns_played++;
+
+    // Zkontroluj, zda hráč nevyhrál (prázdná ruka)
+    if(player->hand.count == 0){
+        game->state = GAME_STATE_FINISHED;
+        return 0;
+    }
+
+    // Přejdi na dalšího hráče
+    engine_next_player(game);
+    engine_change_record(game, CHANGE_TURN, NULL, 0, 0);
+
+    return 0;
+}
+
+/**
+ * @brief CLOS - zavření hry poslední kartou
+ */
+static int engine_close(GameInstance *game, PlayerGameState *player, const char *message_body){
+    if(!message_body || strlen(message_body) == 0){
+        return -1;
+    }
+
+    // Kontrola, zda má pouze 1 kartu
+    if(player->hand.count != 1){
+        return -1;
+    }
+
+    // Poslední karta v ruce musí souhlasit
+    Card card = card_from_code(message_body);
+
+    if(card == CARD_NONE || card_hand_remove(&player->hand, card) != 0){
+        return -1;
+    }
+
+    // Přidej kartu na odhazovací hromádku
+    game->discard_deck[game->discard_count++] = card;
+    engine_change_record(game, CHANGE_HAND_REMOVE, player, card, 0);
+    engine_change_record(game, CHANGE_DISCARD, NULL, 0, 0);
+
+    // Hra končí
+    game->state = GAME_STATE_FINISHED;
+    return 0;
+}
+
+int engine_apply_move(GameInstance *game, int client_index, MessageType action, const char *message_body){
+    if(!game || game->state != GAME_STATE_PLAYING){
+        return -1;
+    }
+
+    PlayerGameState *player = engine_find_player(game, client_index);
+    if(!player){
+        return -1;
+    }
+
+    uint32_t recorded = game->changes_recorded;
+    int result;
+
+    switch(action){
+        case MSG_TAKP: result = engine_take_pack(game, player); break;
+        case MSG_TAKT: result = engine_take_thrown(game, player); break;
+        case MSG_UNLO: result = engine_unload(game, player, message_body); break;
+        case MSG_ADDC: result = engine_add_card(game, player, message_body); break;
+        case MSG_THRW: result = engine_throw(game, player, message_body); break;
+        case MSG_CLOS: result = engine_close(game, player, message_body); break;
+        default:       result = -7; break;
+    }
+
+    // Nová verze stavu, jen pokud tah něco změnil (i neúspěšný tah)
+    if(game->changes_recorded != recorded){
+        game->state_version++;
+    }
+    return result;
+}
+
+void engine_changes_reset(GameInstance *game){
+    game->delta_base = game->state_version;
+    game->change_count = 0;
+    game->changes_overflow = 0;
+}
+
+/**
+ * @brief Zamíchání balíčku (Fisher-Yates, rng_below bez zkreslení modulem)
+ */
+static void engine_shuffle_deck(GameInstance *game){
+    for(int i = game->deck_count - 1; i > 0; i--){
+        int j = (int)rng_below(&game->rng, (uint32_t)(i + 1));
+        Card temp = game->deck[i];
+        game->deck[i] = game->deck[j];
+        game->deck[j] = temp;
+    }
+}
+
+void engine_init_deck(GameInstance *game){
+    // 2 * 52 karet (balíček, barva, hodnota) a 4 žolíci, karta je přímo svým indexem
+    for(game->deck_count = 0; game->deck_count < CARD_COUNT; game->deck_count++){
+        game->deck[game->deck_count] = (Card)game->deck_count;
+    }
+    engine_shuffle_deck(game);
+}
+
+int engine_reshuffle_discard(GameInstance *game){
+    if(game->deck_count != 0 || game->discard_count < 2){
+        return -1;
+    }
+
+    // Karty v rukou a na stole zůstávají, kde jsou -> žádná karta není ve hře víckrát než v balíčcích
+    Card top = game->discard_deck[game->discard_count - 1];
+    memcpy(game->deck, game->discard_deck, (size_t)(game->discard_count - 1) * sizeof(Card));
+    game->deck_count = game->discard_count - 1;
+    game->discard_deck[0] = top;
+    game->discard_count = 1;
+
+    engine_shuffle_deck(game);
+    return 0;
+}
+
+int engine_deal_cards(GameInstance *game){
+    // Rozdání karet podle toho, kdo začíná (15/14)
+    for(int i = 0; i < game->player_count; i++){
+        PlayerGameState *player = &game->players[i];
+        int cards_per_player = player->takes_15 ? 15 : 14;
+        card_hand_clear(&player->hand);
+
+        for(int j = 0; j < cards_per_player && game->deck_count > 0; j++){
+            if(card_hand_add(&player->hand, game->deck[game->deck_count - 1]) != 0){
+                return -1;
+            }
+            game->deck_count--;
+        }
+    }
+    return 0;
+}
+
+void engine_next_player(GameInstance *game){
+    game->current_player_index = (game->current_player_index + 1) % game->player_count;
+}
+
+void engine_calculate_scores(GameInstance *game){
+    for(int i = 0; i < game->player_count; i++){
+        // Body za karty, které zůstaly v ruce
+        game->players[i].score = card_hand_value(&game->players[i].hand);
+    }
+}
+
+int engine_is_finished(const GameInstance *game){
+    for(int i = 0; i < game->player_count; i++){
+        if(game->players[i].hand.count == 0){
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+#ifndef GAME_ENGINE_H
+#define GAME_ENGINE_H
+
+/*
+ * Pravidla hry nad jednou GameInstance: míchání a rozdání, tahy TAKP/TAKT/UNLO/ADDC/THRW/CLOS,
+ * skóre a konec hry. Bez globálního stavu, zámků, časovačů a logování -> reentrantní, hry v různých
+ * vláknech se neovlivňují (zamykání instance je věc volajícího). Události tahu engine zapisuje
+ * do changes[] (GameChange), server z nich skládá DLTA, simulátory je mohou číst přímo.
+ * Linkuje se jen s card.c, meld.c a rng.c (knihovna zolik_engine).
+ */
+
+#include "config.h"
+#include "protocol.h"
+#include "card.h"
+#include "rng.h"
+#include <time.h>
+
+#define MAX_ROOM_PLAYERS 2
+#define MAX_HAND_CARD 15
+#define DECK_CARDS_COUNT 108
+#define MAX_SEQUENCE_CARDS 15
+#define MAX_SEQUENCES 50
+
+// Enum pro stavy hry
+typedef enum{
+    GAME_STATE_LOBBY,
+    GAME_STATE_STARTING,
+    GAME_STATE_PLAYING,
+    GAME_STATE_PAUSED,
+    GAME_STATE_FINISHED
+} GameState;
+
+// Struktura pro uchování postupek a setů (vyložených karet v pořadí na stole)
+typedef struct {
+    Card cards[MAX_SEQUENCE_CARDS];
+    uint8_t count;
+    uint8_t kind;                   // MeldKind (set / postupka), přikládáním se nemění
+    uint16_t id;                    // Stabilní ID v rámci hry (STAT, ADDC), 1..MAX_SEQUENCES
+    uint32_t hash;                  // meld_hash karet (ADDC podle kódů od starších klientů)
+    int owner_client_index;
+} CardSequence;
+
+// Druh změny stavu hry (podklad pro DLTA)
+typedef enum{
+    CHANGE_HAND_ADD,                // Karta přibyla do ruky hráče
+    CHANGE_HAND_REMOVE,             // Karta odešla z ruky hráče
+    CHANGE_MELD_NEW,                // Nová kombinace na stole
+    CHANGE_MELD_EXTEND,             // Přiložená karta (kombinace se může přeskládat)
+    CHANGE_DISCARD,                 // Jiná karta navrchu odhazovacího balíčku
+    CHANGE_TURN                     // Jiný hráč na tahu
+} GameChangeKind;
+
+// Jedna změna stavu hry
+typedef struct{
+    uint8_t kind;                   // GameChangeKind
+    uint8_t player;                 // Index do players[] (HAND_*)
+    Card card;                      // HAND_*
+    uint16_t seq_id;                // MELD_*
+} GameChange;
+
+// Struktura pro uchování herního stavu uživatele
+typedef struct {
+    int client_index;
+    int score;
+    int position;
+    int is_active;
+
+    int takes_15;
+
+    CardHand hand;                  // Karty v ruce (bitové masky, počet v hand.count)
+
+    int turns_played;
+    int cards_played;
+
+    int is_ready_for_next_round;
+    int did_thrown;
+    int took_card;
+    int did_closed;
+} PlayerGameState;
+
+// Poslední nápověda hráče (jen server, game_get_hint); ruka a stůl se mění jen se state_version
+typedef struct{
+    uint32_t version;               // state_version, pro kterou byla spočítána (0: žádná)
+    int len;                        // Délka odpovědi, -1: plán nelze spočítat
+    uint64_t solved_ms;             // Poslední běh solveru (omezení četnosti)
+    char text[GAME_HINT_BUFFER];
+} GameHint;
+
+// Struktura hry (předalokovaná v poolu, zarovnaná na cache line -> sousední hry nesdílí řádky)
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))){
+    int room_id;                    // Jen server (místnost, časovač), engine nepoužívá
+    GameState state;
+
+    PlayerGameState players[MAX_ROOM_PLAYERS];
+    int player_count;
+    int current_player_index;
+
+    uint64_t seed;                  // Seed míchání (stejný seed -> stejná rozdání, replay a benchmarky)
+    Rng rng;                        // Generátor hry (míchání), server ho používá jen pod zámkem místnosti
+
+    Card deck[DECK_CARDS_COUNT];
+    int deck_count;
+
+    Card discard_deck[DECK_CARDS_COUNT];
+    int discard_count;
+
+    CardSequence sequences[MAX_SEQUENCES];   // Jen přibývají, ID = pořadí vyložení
+    int sequence_count;
+
+    uint32_t state_version;         // Roste s každým tahem, který změnil stav
+    uint32_t delta_base;            // Verze, od které se vedou changes[]
+    GameChange changes[MAX_GAME_CHANGES];
+    int change_count;
+    int changes_overflow;           // Změn bylo víc, než se vejde -> plný STAT
+    uint32_t changes_recorded;      // Počet zaznamenaných změn celkem (detekce změny stavu tahem)
+
+    struct GameSnapshot *snapshot;  // Sdílená část STAT poslední sestavené verze (jen server, game_snapshot_acquire)
+
+    GameHint hints[MAX_ROOM_PLAYERS];   // Jen server: poslední nápověda hráčů (podle pořadí v players)
+
+    // Jen server: časovač tahu a log událostí
+    time_t round_start_time;
+    time_t turn_start_time;
+    int turn_timeout_seconds;       // Limit tahu (hlídá časovač tahu místnosti)
+
+    void* event_log;
+} GameInstance;
+
+/**
+ * @brief Připraví hru v lobby: vynuluje instanci a usadí hráče, první z nich vykládá (15 karet)
+ * @param game Instance hry
+ * @param client_indexes Identifikátory hráčů (server: indexy klientů, simulátor: libovolné různé)
+ * @param count Počet hráčů (nejvýše MAX_ROOM_PLAYERS)
+ * @param seed Seed míchání (stejný seed -> stejné rozdání)
+ * @return 0: SUCCESS, -1: ERROR (počet hráčů)
+ */
+int engine_setup(GameInstance *game, const int *client_indexes, int count, uint64_t seed);
+
+/**
+ * @brief Zamíchá, rozdá, otočí první vyhozenou kartu a předá tah hráči s 15 kartami
+ *
+ * Po startu je state_version 1 a log změn prázdný (rozdaný stav se posílá celý).
+ * @param game Instance hry v GAME_STATE_LOBBY
+ * @return 0: SUCCESS, -1: ERROR (hra už běží)
+ */
+int engine_start(GameInstance *game);
+
+/**
+ * @brief Provede tah hráče
+ *
+ * Změny stavu zapisuje do changes[] (přetečení jen označí changes_overflow), tah, který stav změnil,
+ * zvýší state_version. Tělo zprávy nemění.
+ * @param game Instance hry
+ * @param client_index Identifikátor hráče (viz engine_setup)
+ * @param action Akce (MSG_TAKP, MSG_TAKT, MSG_UNLO, MSG_ADDC, MSG_THRW, MSG_CLOS)
+ * @param message_body Tělo akce (karty, u ADDC "<ID postupky nebo její kódy>|<karta>")
+ * @return 0: SUCCESS, -1: neplatný tah, TAKP: -2 už lízl, -3 už vyhodil, -4 první tah s 15 kartami,
+ *         -5 došel balíček (zamíchán odhazovací), -6 není z čeho lízat (jen vrchní vyhozená karta), TAKT: -2 už lízl, -3 nelze vzít, UNLO: -69 nezbyla by karta
+ *         na zavření, THRW: -2 nejdřív líznout, -3 poslední kartou se zavírá, -7 neznámá akce
+ */
+int engine_apply_move(GameInstance *game, int client_index, MessageType action, const char *message_body);
+
+/**
+ * @brief Najde hráče podle identifikátoru
+ * @param game Instance hry
+ * @param client_index Identifikátor hráče
+ * @return Hráč, NULL: není ve hře
+ */
+PlayerGameState *engine_find_player(GameInstance *game, int client_index);
+
+/**
+ * @brief Začne nový log změn od aktuální verze stavu
+ * @param game Instance hry
+ */
+void engine_changes_reset(GameInstance *game);
+
+/**
+ * @brief Nový balíček všech karet zamíchaný generátorem hry (Fisher-Yates)
+ * @param game Instance hry
+ */
+void engine_init_deck(GameInstance *game);
+
+/**
+ * @brief Nový balíček z odhazovacího balíčku, vrchní vyhozená karta zůstává (volá se při prázdném balíčku)
+ * @param game Instance hry
+ * @return 0: SUCCESS, -1: ERROR (balíček není prázdný nebo pod vrchní kartou nic není)
+ */
+int engine_reshuffle_discard(GameInstance *game);
+
+/**
+ * @brief Rozdání karet hráčům (15 vykládajícímu, ostatním 14)
+ * @param game Instance hry
+ * @return 0: SUCCESS, -1: ERROR (karta se nevešla do ruky)
+ */
+int engine_deal_cards(GameInstance *game);
+
+/**
+ * @brief Předá tah dalšímu hráči
+ * @param game Instance hry
+ */
+void engine_next_player(GameInstance *game);
+
+/**
+ * @brief Výpočet skóre zbylých karet v rukách hráčů
+ * @param game Instance hry
+ */
+void engine_calculate_scores(GameInstance *game);
+
+/**
+ * @brief Kontrola ukončení hry (některý hráč nemá karty)
+ * @param game Instance hry
+ * @return 1: hra skončila, 0: jinak
+ */
+int engine_is_finished(const GameInstance *game);
+
+#endif
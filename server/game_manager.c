@@ -1,27 +1,101 @@
 #include "game_manager.h"
 #include "room_manager.h"
 #include "client_manager.h"
+#include "options.h"
 #include "logger.h"
+#include "solver.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-static GameInstance *active_games[MAX_ROOMS];
+static GameInstance **active_games = NULL;     // Hra podle ID místnosti (kapacita max_rooms)
+static GameInstance *game_pool = NULL;          // Předalokované hry, jeden souvislý blok
+static GameInstance **free_games = NULL;        // Zásobník volných her z poolu
+static int free_game_count = 0;
+static GamePoolStats pool_stats;
 static pthread_mutex_t games_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-void game_init(){
+/**
+ * @brief Vydá volnou hru z poolu, O(1) (volat pod games_mutex)
+ * @return Instance, NULL: pool vyčerpán
+ */
+static GameInstance *game_pool_acquire_locked(void){
+    if(free_game_count == 0){
+        pool_stats.exhausted++;
+        return NULL;
+    }
+
+    pool_stats.acquired++;
+    if(++pool_stats.in_use > pool_stats.high_water){
+        pool_stats.high_water = pool_stats.in_use;
+        LOG_DEBUG("Pool her: nové maximum %d/%d\n", pool_stats.high_water, pool_stats.capacity);
+    }
+    return free_games[--free_game_count];
+}
+
+/**
+ * @brief Vrátí hru do poolu, O(1) (volat pod games_mutex)
+ */
+static void game_pool_release_locked(GameInstance *game){
+    free_games[free_game_count++] = game;
+    pool_stats.in_use--;
+}
+
+/**
+ * @brief Začátek tahu: uloží čas a naplánuje časovač tahu místnosti
+ */
+static void game_turn_timer_arm(GameInstance *game){
+    game->turn_start_time = time(NULL);
+    server_timer_schedule(&rooms[game->room_id].turn_timer, timer_now_ms() + game->turn_timeout_seconds * 1000ULL);
+}
+
+int game_init(int room_capacity){
+    // Pool: jedna hra na místnost, zarovnaný blok
+    void *pool = NULL;
+    if(room_capacity <= 0 || posix_memalign(&pool, CACHE_LINE_SIZE, (size_t)room_capacity * sizeof(GameInstance)) != 0){
+        LOG_ERROR("Chyba: Nelze alokovat pool her (%d)\n", room_capacity);
+        return -1;
+    }
+
+    // Zápis do celého bloku namapuje stránky hned při startu, ne až při prvním game_create
+    memset(pool, 0, (size_t)room_capacity * sizeof(GameInstance));
+
+    GameInstance **games = (GameInstance**)calloc((size_t)room_capacity, sizeof(GameInstance*));
+    GameInstance **free_stack = (GameInstance**)malloc((size_t)room_capacity * sizeof(GameInstance*));
+    if(!games || !free_stack){
+        LOG_ERROR("Chyba: Malloc selhal (game_init)\n");
+        free(games);
+        free(free_stack);
+        free(pool);
+        return -1;
+    }
+
     pthread_mutex_lock(&games_mutex);
+    active_games = games;
+    game_pool = (GameInstance*)pool;
+    free_games = free_stack;
 
-    // Inicializace v paměti
-    for(int i = 0; i < MAX_ROOMS; i++){
-        active_games[i] = NULL;
+    // Pozpátku, aby se jako první vydávala hra na začátku bloku
+    free_game_count = 0;
+    for(int i = room_capacity - 1; i >= 0; i--){
+        free_games[free_game_count++] = &game_pool[i];
     }
 
+    memset(&pool_stats, 0, sizeof(pool_stats));
+    pool_stats.capacity = room_capacity;
     pthread_mutex_unlock(&games_mutex);
 
-    srand(time(NULL));
-    LOG_INFO("Herní systém nainicializován\n");
+    LOG_INFO("Herní systém nainicializován (pool %d her, %zu B)\n", room_capacity,
+             (size_t)room_capacity * sizeof(GameInstance));
+    return 0;
+}
+
+void game_pool_stats(GamePoolStats *stats){
+    pthread_mutex_lock(&games_mutex);
+    *stats = pool_stats;
+    pthread_mutex_unlock(&games_mutex);
 }
 
 GameInstance* game_create(struct GameRoom *room){
@@ -31,50 +105,35 @@ GameInstance* game_create(struct GameRoom *room){
         return NULL;
     }
 
-    // Hra v místnosti
-    GameInstance *game = (GameInstance*)malloc(sizeof(GameInstance));
+    // Hra v místnosti z poolu (stránky už namapované z game_init)
+    pthread_mutex_lock(&games_mutex);
+    GameInstance *game = game_pool_acquire_locked();
+    pthread_mutex_unlock(&games_mutex);
     if(!game){
-        LOG_ERROR("Chyba: Malloc selhal (game_create)\n");
+        LOG_ERROR("Chyba: Pool her vyčerpán (game_create)\n");
         return NULL;
     }
 
-    // Nastavení hry před začátkem
-    memset(game, 0, sizeof(GameInstance));
-    game->room_id = room->room_id;
-    game->state = GAME_STATE_LOBBY;
-    game->current_player_index = 0;
-    game->turn_timeout_seconds = 60; // Nevyužito
-    game->sequence_count = 0;
-    game->player_count = 0;
-
-    // Nastavení hráčů pro hru
+    // Hráči podle pořadí v místnosti, první vykládá (15 karet)
+    int client_indexes[MAX_PLAYERS_PER_ROOM];
+    int count = 0;
     for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-        int client_index = room->player_indexes[i];
-        if(client_index != -1){
-            PlayerGameState *player = &game->players[game->player_count];
-
-            player->client_index = client_index;
-            player->score = 0;
-            player->position = game->player_count;
-            player->is_active = 1;
-            player->hand_count = 0;
-            player->turns_played = 0;
-            player->cards_played = 0;
-            player->is_ready_for_next_round = 0;
-            player->did_closed = 0;
-            player->did_thrown = 0;
-            player->took_card = 0;
-
-            // Určení hráče pro výhoz
-            if(game->player_count == 0){
-                player->takes_15 = 1;
-            }else{
-                player->takes_15 = 0;
-            }
-
-            game->player_count++;
+        if(room->player_indexes[i] != -1){
+            client_indexes[count++] = room->player_indexes[i];
         }
     }
+
+    uint64_t seed = server_options.fixed_seed ? server_options.game_seed + (uint64_t)room->room_id : rng_os_seed();
+    if(engine_setup(game, client_indexes, count, seed) != 0){
+        LOG_ERROR("Chyba: Neplatný počet hráčů (%d)\n", count);
+        pthread_mutex_lock(&games_mutex);
+        game_pool_release_locked(game);
+        pthread_mutex_unlock(&games_mutex);
+        return NULL;
+    }
+    game->room_id = room->room_id;
+    game->turn_timeout_seconds = 60;
+
     LOG_INFO("Hra vytvořena s %d hráči\n", game->player_count);
 
     pthread_mutex_lock(&games_mutex);
@@ -90,16 +149,17 @@ void game_destroy(GameInstance *game){
     }
 
     LOG_INFO("Ničím hru pro místnost %d\n", game->room_id);
-
-    pthread_mutex_lock(&games_mutex);
-    active_games[game->room_id] = NULL;
-    pthread_mutex_unlock(&games_mutex);
+    server_timer_cancel(&rooms[game->room_id].turn_timer);
 
     if(game->event_log){
         free(game->event_log);
     }
+    game_snapshot_release(game->snapshot);
 
-    free(game);
+    pthread_mutex_lock(&games_mutex);
+    active_games[game->room_id] = NULL;
+    game_pool_release_locked(game);
+    pthread_mutex_unlock(&games_mutex);
 }
 
 int game_start(GameInstance *game){
@@ -114,749 +174,47 @@ int game_start(GameInstance *game){
         return -1;
     }
 
-    LOG_INFO("Spouštím hru v místnosti %d\n", game->room_id);
-
-    // Inicializace herních utilit
-    game->state = GAME_STATE_STARTING;
-    game_init_deck(game);
-    game_deal_cards(game);
+    LOG_INFO("Spouštím hru v místnosti %d (seed %llu)\n", game->room_id, (unsigned long long)game->seed);
 
-    // Nastavení výhozového balíčku
-    if(game->deck_count > 0){
-        game->deck_count--;
-        game->discard_deck[0] = game->deck[game->deck_count];
-        game->discard_count = 1;
-    }
-
-    for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
-        PlayerGameState *player = &game->players[i];
-
-        if(player->takes_15){
-            game->current_player_index = i;
-            LOG_INFO("Hru zahajuje hráč: s ID %d\n", player->client_index);
-            
-            game->turn_start_time = time(NULL);  // Nastavení herního startu 
-            game->state = GAME_STATE_PLAYING;
-            
-            return 0;
-}
+    if(engine_start(game) != 0){
+        LOG_ERROR("Chyba: Hru nelze spustit\n");
+        return -1;
     }
 
-    game->turn_start_time = time(NULL);
-    game->state = GAME_STATE_PLAYING;
-
+    // Nápovědy předchozí hry by měly stejné verze stavu
+    memset(game->hints, 0, sizeof(game->hints));
+    game_turn_timer_arm(game);
     LOG_INFO("Hra spuštěna, první hráč %d\n", game->players[game->current_player_index].client_index);
+    TRACE(GAME_START, game->players[game->current_player_index].client_index, game->room_id, game->player_count, 0, 0);
     return 0;
 }
 
-int game_process_move(GameInstance *game, int client_index, const char* action, const char* message_body){
+int game_process_move(GameInstance *game, int client_index, MessageType action, const char* message_body){
     // Kontrola parametrů
-    if(!game || !action){
-        return -1;
-    }
-
-    if(game->state != GAME_STATE_PLAYING){
-        LOG_ERROR("Hra neběží\n");
-        return -1;
-    }
-
-    // Najdi hráče
-    PlayerGameState *player = NULL;
-    for(int i = 0; i < game->player_count; i++){
-        if(game->players[i].client_index == client_index){
-            player = &game->players[i];
-            break;
-        }
-    }
-
-    if(!player){
-        LOG_ERROR("Hráč nenalezen\n");
-        return -1;
-    }
-
-    // TAKP - Hráč líže z balíčku
-    if(strcmp(action, "TAKP") == 0){
-        // Kontrola, zda už nelízal
-        if(player->took_card == 1){
-            LOG_INFO("Hráč %d už lízl\n", client_index);
-            return -2;
-        }
-        
-        // Kontrola, zda už nevyhodil
-        if(player->did_thrown == 1){
-            LOG_INFO("Hráč %d už vyhodil\n", client_index);
-            return -3;
-        }
-
-        // První hráč v prvním kole nelíže (má 15 karet)
-        if(player->takes_15 && player->turns_played == 0){
-            LOG_INFO("První hráč v prvním kole nelíže\n");
-            return -4;
-        }
-
-        // Lízni kartu
-        if(game->deck_count > 0){
-            game->deck_count--;
-            player->hand[player->hand_count++] = game->deck[game->deck_count];
-
-            LOG_INFO("Hráč %d si lízl kartu z balíčku\n", client_index);
-            player->turns_played++;
-            player->took_card = 1;
-            
-            return 0;
-        } else{
-            LOG_INFO("Chyba: Prázdný balíček (vytvářím nový)\n");
-            game_init_deck(game);
-            return -5;
-        }
-    }
-    
-    // TAKT - Hráč líže vyhozenou kartu
-    else if(strcmp(action, "TAKT") == 0){
-        // Kontrola, zda už nelízal
-        if(player->took_card == 1){
-            LOG_INFO("Hráč %d už lízl\n", client_index);
-            return -2;
-        }
-
-        if(game->discard_count == 0){
-            LOG_INFO("V balíčku nejsou žádné karty\n");
-            return -3;
-        }
-
-        if(player->takes_15 == 1 && player->turns_played == 0){
-            return -3;
-        }
-
-        // Lízni vrchní kartu z trashe
-        if(game->discard_count > 0){
-            game->discard_count--;
-            player->hand[player->hand_count++] = game->discard_deck[game->discard_count];
-
-            LOG_INFO("Hráč %d si lízl kartu z odhazovacího balíčku\n", client_index);
-            player->turns_played++;
-            player->took_card = 1;
-
-            return 0;
-        } else{
-            LOG_INFO("Chyba: Prázdný odhazovací balíček\n");
-            return -1;
-        }
-    }
-    
-    // UNLO - Hráč vykládá karty
-    else if (strcmp(action, "UNLO") == 0) {
-    if (!message_body) {
-        LOG_ERROR("Chybí data karet\n");
-        return -1;
-    }
-
-    int len = strlen(message_body);
-
-    // každá karta má 2 znaky, min. 3 karty
-    if (len < 6 || (len % 2) != 0) {
-        LOG_ERROR("Neplatný formát karet\n");
-        return -1;
-    }
-
-    int parsed_count = len / 2;
-    if (parsed_count < 3) {
-        LOG_INFO("Kombinace musí mít minimálně 3 karty\n");
-        return -1;
-    }
-
-    if(parsed_count >= player->hand_count){
-        return -69;
-    }
-
-    // rozparsování karet
-    char card_codes[15][3];
-    for (int i = 0; i < parsed_count; i++) {
-        card_codes[i][0] = message_body[i * 2];
-        card_codes[i][1] = message_body[i * 2 + 1];
-        card_codes[i][2] = '\0';
-    }
-
-    // ověř, že hráč má všechny karty v ruce
-    Card cards_to_unload[15];
-    int indices_in_hand[15];
-    int used_in_hand[100] = {0};
-
-    for (int i = 0; i < parsed_count; i++) {
-        int found = 0;
-        for (int j = 0; j < player->hand_count; j++) {
-            // Karta musí souhlasit kódem a nesmí být již vybraná pro tento UNLO
-            if (!used_in_hand[j] && strcmp(player->hand[j].code, card_codes[i]) == 0) {
-                cards_to_unload[i] = player->hand[j];
-                indices_in_hand[i] = j;
-                used_in_hand[j] = 1; 
-                found = 1;
-                break;
-            }
-        }
-
-        if (!found) {
-            LOG_INFO("Karta %s není v ruce hráče\n", card_codes[i]);
-            return -1;
-        }
-    }
-    
-    // SET - stejná hodnota, každá barva maximálně jednou
-    int is_set = 1;
-    
-    // Kontrola max 4 karty (4 barvy)
-    if (parsed_count > 4) {
-        is_set = 0;
-    }
-    
-    if (is_set) {        
-        // Najdi referenční hodnotu setu (první karta, co není žolík)
-        int first_value = -1;
-        for (int i = 0; i < parsed_count; i++) {
-            if (!cards_to_unload[i].is_joker) {
-                first_value = cards_to_unload[i].value;
-                break;
-            }
-        }
-
-        // musí existovat alespoň jedna normální karta
-        if (first_value == -1) {
-            is_set = 0;
-        }
-
-        // kontrola stejné hodnoty
-        for (int i = 0; i < parsed_count && is_set; i++) {
-            if (!cards_to_unload[i].is_joker && cards_to_unload[i].value != first_value) {
-                is_set = 0;
-            }
-        }
-
-        // kontrola unikátních barev
-        if (is_set) {
-            char suits_used[4];
-            int suits_count = 0;
-
-            for (int i = 0; i < parsed_count; i++) {
-                if (cards_to_unload[i].is_joker){
-                    continue;
-                }
-
-                char current_suit = cards_to_unload[i].suit[0];
-
-                for (int j = 0; j < suits_count; j++) {
-                    if (suits_used[j] == current_suit) {
-                        is_set = 0;
-                        break;
-                    }
-                }
-
-                if (!is_set) break;
-                
-                suits_used[suits_count++] = current_suit;
-            }
-        }
-
-        // max 4 barvy
-        if (is_set && parsed_count > 4)
-            is_set = 0;
-    }
-
-    // POSTUPKA (sequence) - stejná barva, rostoucí hodnoty
-    int is_sequence = 0;
-
-    if (!is_set) {
-        LOG_DEBUG("Zahajuji kontrolu POSTUPKY\n");
-        char first_suit = '\0';
-        int same_suit = 1;
-        
-        for (int i = 0; i < parsed_count; i++) {
-            if (!cards_to_unload[i].is_joker) {
-                if (first_suit == '\0') {
-                    first_suit = cards_to_unload[i].suit[0];
-                } else if (cards_to_unload[i].suit[0] != first_suit) {
-                    LOG_DEBUG("Rozdilne barvy: %c vs %c\n", first_suit, cards_to_unload[i].suit[0]);
-                    same_suit = 0;
-                    break;
-                }
-            }
-        }
-
-        if (same_suit && first_suit != '\0') {
-            Card sorted[15];
-            
-            for (int attempt = 0; attempt < 2; attempt++) {
-                LOG_DEBUG("Pokus %d (0=Eso nizke, 1=Eso vysoke)\n", attempt);
-                
-                // Naplnění a případná změna Esa
-                for (int i = 0; i < parsed_count; i++) {
-                    sorted[i] = cards_to_unload[i];
-                    if (attempt == 1 && !sorted[i].is_joker && sorted[i].value == 1) {
-                        sorted[i].value = 14;
-                        LOG_DEBUG("Menim Eso na hodnotu 14\n");
-                    }
-                }
-
-                // Seřazení (Bubble sort)
-                for (int i = 0; i < parsed_count - 1; i++) {
-                    for (int j = i + 1; j < parsed_count; j++) {
-                        if (sorted[i].is_joker) {
-                            // Žolíka vždy posuneme dozadu
-                            Card tmp = sorted[i]; sorted[i] = sorted[j]; sorted[j] = tmp;
-                        } 
-                        else if (!sorted[j].is_joker && sorted[i].value > sorted[j].value) {
-                            Card tmp = sorted[i]; sorted[i] = sorted[j]; sorted[j] = tmp;
-                        }
-                    }
-                }
-
-                // Kontrola posloupnosti
-                is_sequence = 1;
-                int jokers_avail = 0;
-                for(int i=0; i<parsed_count; i++) if(sorted[i].is_joker) jokers_avail++;
-
-                int start_idx = 0;
-                while(start_idx < parsed_count && sorted[start_idx].is_joker) start_idx++;
-                
-                if(start_idx >= parsed_count) {
-                    is_sequence = 1; // Samí žolíci
-                } else {
-                    int current_val = sorted[start_idx].value;
-                    for (int i = start_idx + 1; i < parsed_count; i++) {
-                        if (sorted[i].is_joker) continue;
-
-                        int gap = sorted[i].value - current_val;
-                        if (gap == 1) {
-                            current_val = sorted[i].value;
-                        } else if (gap > 1 && (gap - 1) <= jokers_avail) {
-                            LOG_DEBUG("Mezera %d zaplnena zolikem\n", gap);
-                            jokers_avail -= (gap - 1);
-                            current_val = sorted[i].value;
-                        } else {
-                            LOG_DEBUG("Prerusena posloupnost: %d -> %d (gap %d)\n", current_val, sorted[i].value, gap);
-                            is_sequence = 0;
-                            break;
-                        }
-                    }
-                }
-
-                if (is_sequence) {
-                    LOG_DEBUG("Postupka potvrzena v pokusu %d!\n", attempt);
-                    break;
-                }
-
-                // Pokud nemáme eso, druhý pokus nedává smysl
-                int has_ace = 0;
-                for(int i=0; i<parsed_count; i++) if(!cards_to_unload[i].is_joker && cards_to_unload[i].value == 1) has_ace = 1;
-                if(!has_ace) {
-                    LOG_DEBUG("Eso nenalezeno, koncim pokusy.\n");
-                    break;
-                }
-            }
-        } else {
-            LOG_DEBUG("Neplatna barva nebo zadne normalni karty.\n");
-        }
-    }
-
-    // return -1;
-    // 3. POSTUPKA různých barev (run) - rostoucí hodnoty, mohou být různé barvy (kod odebran -> fragments/run.txt)
-    int is_run = 0;
-    
-    // Kontrola platnosti
-    if (!is_set && !is_sequence && !is_run) {
-        LOG_INFO("Karty netvoří platnou kombinaci (set, postupka nebo run)\n");
+    if(!game){
         return -1;
     }
 
-    // Výpis typu kombinace (debug)
-    if (is_set) {
-        LOG_INFO("Kombinace: SET (stejná hodnota)\n");
-    } else if (is_sequence) {
-        LOG_INFO("Kombinace: POSTUPKA (stejná barva)\n");
-    } else if (is_run) {
-        LOG_INFO("Kombinace: RUN (různé barvy)\n");
-    }
+    int turn = game->current_player_index;
+    int result = engine_apply_move(game, client_index, action, message_body);
+    TRACE(MOVE, client_index, game->room_id, trace_fourcc(msg_type_name(action)), result, game->state_version);
 
-    // Seřaď indexy sestupně (aby se při mazání neposunuly)
-    for (int i = 0; i < parsed_count - 1; i++) {
-        for (int j = i + 1; j < parsed_count; j++) {
-            if (indices_in_hand[i] < indices_in_hand[j]) {
-                int tmp = indices_in_hand[i];
-                indices_in_hand[i] = indices_in_hand[j];
-                indices_in_hand[j] = tmp;
-            }
-        }
+    if(result != 0){
+        LOG_INFO("Tah %s hráče %d odmítnut (%d): %s\n", msg_type_name(action), client_index, result,
+                 message_body ? message_body : "");
+        return result;
     }
+    LOG_INFO("Hráč %d: %s %s\n", client_index, msg_type_name(action), message_body ? message_body : "");
 
-    // Odebrání karet z ruky
-    for (int i = 0; i < parsed_count; i++) {
-        int idx = indices_in_hand[i];
-        for (int j = idx; j < player->hand_count - 1; j++) {
-            player->hand[j] = player->hand[j + 1];
-        }
-        player->hand_count--;
-    }
-
-    player->cards_played += parsed_count;
-
-    LOG_INFO("Hráč %d vyložil %d karet\n", client_index, parsed_count);
-    
-    if (game->sequence_count >= MAX_SEQUENCES) {
-        LOG_INFO("Nelze přidat další sekvenci\n");
-        return -1;
-    }
-
-    CardSequence *seq = &game->sequences[game->sequence_count++];
-    seq->count = parsed_count;
-    seq->owner_client_index = player->client_index;
-
-    for (int i = 0; i < parsed_count; i++) {
-        seq->cards[i] = cards_to_unload[i];
+    if(game->state == GAME_STATE_FINISHED){
+        LOG_INFO("Hráč %d ukončil hru\n", client_index);
+    } else if(game->current_player_index != turn && game->players[game->current_player_index].is_active){
+        // Předání tahu: nový limit pro hráče na tahu
+        game_turn_timer_arm(game);
+        LOG_INFO("Na tahu je hráč %d\n", game->players[game->current_player_index].client_index);
     }
-
     return 0;
 }
-    // ADD CARD TO SEQUENCE
-   else if (strcmp(action, "ADDC") == 0) {
-    if (!message_body) return -1;
-
-    // Rozdělení zprávy podle '|'
-    char *pipe = strchr(message_body, '|');
-    if (!pipe) return -1;
-
-    *pipe = '\0';
-    const char *target_seq_str = message_body;
-    char *new_card_code = pipe + 1;
-
-    // Ověření, že hráč má kartu v ruce
-    int card_in_hand_idx = -1;
-    for (int i = 0; i < player->hand_count; i++) {
-        if (strcmp(player->hand[i].code, new_card_code) == 0) {
-            card_in_hand_idx = i;
-            break;
-        }
-    }
-    if (card_in_hand_idx == -1) return -1; // Karta není v ruce
-
-    if(player->hand_count == 1){
-        return -1;
-    }
-
-    // Nalezení cílové sekvence v game->sequences
-    CardSequence *target_seq = NULL;
-    for (int i = 0; i < game->sequence_count; i++) {
-        // Vytvoříme si dočasný string z kódů karet v sekvenci pro porovnání
-        char current_seq_str[MAX_SEQUENCE_CARDS * 3] = "";
-        for (int j = 0; j < game->sequences[i].count; j++) {
-            strcat(current_seq_str, game->sequences[i].cards[j].code);
-        }
-
-        if (strcmp(current_seq_str, target_seq_str) == 0) {
-            target_seq = &game->sequences[i];
-            break;
-        }
-    }
-
-    if (!target_seq) return -1; // Sekvence nenalezena
-    if (target_seq->count >= MAX_SEQUENCE_CARDS) return -1; // Plno
-
-    // Validace
-    Card new_card = player->hand[card_in_hand_idx];
-    int can_add = 0;
-    int add_at_start = 0; // 1 = přidat na začátek, 0 = na konec
-
-    // Zjistíme, zda jde o set (stejné hodnoty) nebo postupku
-    int is_set = 1;
-    int first_val = target_seq->cards[0].value;
-    for(int i = 0; i < target_seq->count; i++) {
-        if(!target_seq->cards[i].is_joker && target_seq->cards[i].value != first_val) {
-            is_set = 0; 
-            break;
-        }
-    }
-
-    if (is_set) {
-        if (new_card.is_joker || new_card.value == first_val) {
-            if (target_seq->count >= 4) {
-                can_add = 0; // Set může mít max 4 karty
-            } else {
-                // Kontrola, že barva ještě není použita
-                int suit_used = 0;
-                if (!new_card.is_joker) {
-                    for (int i = 0; i < target_seq->count; i++) {
-                        if (!target_seq->cards[i].is_joker && 
-                            target_seq->cards[i].suit[0] == new_card.suit[0]) {
-                            suit_used = 1;
-                            break;
-                        }
-                    }
-                }
-                
-                if (!suit_used) {
-                    can_add = 1;
-                }
-            }
-        }
-    } else {
-        // POSTUPKA - musí být stejná barva a hodnota navazující
-        char seq_suit = '\0';
-        for (int i = 0; i < target_seq->count; i++) {
-            if (!target_seq->cards[i].is_joker) {
-                seq_suit = target_seq->cards[i].suit[0];
-                break;
-            }
-        }
-        
-        if (seq_suit == '\0') {
-            // Všechny karty jsou jokery - přijmi jakoukoli kartu
-            can_add = 1;
-        } else if (new_card.is_joker) {
-            // Joker lze přidat vždy, ale musíme určit stranu
-            can_add = 1;
-
-            // Zjistíme, zda je v postupce vysoké Eso (A jako 14)
-            int has_high_ace = 0;
-            int has_king = 0;
-            for (int i = 0; i < target_seq->count; i++) {
-                if (!target_seq->cards[i].is_joker) {
-                    if (target_seq->cards[i].value == 1) has_high_ace = 1;
-                    if (target_seq->cards[i].value == 13) has_king = 1;
-                }
-            }
-
-            // Pokud je tam A i K, považujeme Eso za vysoké (konec postupky)
-            if (has_high_ace && has_king) {
-                // Napravo už není místo (za A=14 nic nejde), přidáme ho doleva
-                LOG_DEBUG("Detekována vysoká postupka končící Esem, přidávám žolíka doleva.\n");
-                add_at_start = 1;
-            } else {
-                // Standardně přidáváme doprava (na konec)
-                add_at_start = 0;
-            }
-        } else if (new_card.suit[0] == seq_suit) {
-            // Stejná barva - zkontroluj hodnotu
-            
-            // Spočítej skutečnou první a poslední hodnotu v posloupnosti (včetně jokerů)
-            int first_real_value = -1;
-            int last_real_value = -1;
-            int first_real_idx = -1;
-            int last_real_idx = -1;
-            
-            // Najdi první ne-joker
-            for (int i = 0; i < target_seq->count; i++) {
-                if (!target_seq->cards[i].is_joker) {
-                    first_real_value = target_seq->cards[i].value;
-                    first_real_idx = i;
-                    break;
-                }
-            }
-            
-            // Najdi poslední ne-joker
-            for (int i = target_seq->count - 1; i >= 0; i--) {
-                if (!target_seq->cards[i].is_joker) {
-                    last_real_value = target_seq->cards[i].value;
-                    last_real_idx = i;
-                    break;
-                }
-            }
-            
-            if (first_real_value == -1) {
-                // Všechny karty jsou jokery - přijmi jakoukoli
-                can_add = 1;
-            } else {
-                // Spočítej, kolik jokerů je před první kartou
-                int jokers_before = first_real_idx;
-                
-                // Spočítej, kolik jokerů je za poslední kartou
-                int jokers_after = target_seq->count - last_real_idx - 1;
-                
-                // Vypočítej skutečnou první hodnotu posloupnosti
-                int sequence_start = first_real_value - jokers_before;
-                
-                // Vypočítej skutečnou poslední hodnotu posloupnosti
-                int sequence_end = last_real_value + jokers_after;
-                
-                int new_value = new_card.value;
-                
-                // Přidání na konec
-                if (new_value == sequence_end + 1) {
-                    can_add = 1;
-                    add_at_start = 0;
-                }
-                // Eso za králem (pokud poslední hodnota je 13 a máme joker za ním)
-                else if (new_value == 1 && sequence_end == 13) {
-                    can_add = 1;
-                    add_at_start = 0;
-                }
-                // Eso za posledním (pokud sequence_end je 13 nebo vyšší díky jokerům)
-                else if (new_value == 1 && sequence_end >= 13) {
-                    can_add = 1;
-                    add_at_start = 0;
-                }
-                // Přidání na začátek
-                else if (new_value == sequence_start - 1) {
-                    can_add = 1;
-                    add_at_start = 1;
-                }
-                // Král před esem (A jako 1)
-                else if (new_value == 13 && sequence_start == 1) {
-                    can_add = 1;
-                    add_at_start = 1;
-                }
-                // Král před začátkem (pokud sequence_start je 1 nebo nižší díky jokerům)
-                else if (new_value == 13 && sequence_start <= 1) {
-                    can_add = 1;
-                    add_at_start = 1;
-                }
-            }
-        }
-    }
-
-    if (!can_add) {
-        LOG_INFO("Karta %s nejde přiložit k sekvenci\n", new_card_code);
-        return -1;
-    }
-
-    // Provedení akce
-    if (add_at_start) {
-        // Přidání na začátek - posuň všechny karty doprava
-        for (int i = target_seq->count; i > 0; i--) {
-            target_seq->cards[i] = target_seq->cards[i - 1];
-        }
-        target_seq->cards[0] = new_card;
-        target_seq->count++;
-    } else {
-        // Přidání na konec
-        target_seq->cards[target_seq->count++] = new_card;
-    }
-
-    // Odebrání karty z ruky hráče
-    for (int i = card_in_hand_idx; i < player->hand_count - 1; i++) {
-        player->hand[i] = player->hand[i + 1];
-    }
-    player->hand_count--;
-    player->cards_played++;
-
-    LOG_INFO("Hráč %d přiložil kartu %s k sekvenci\n", client_index, new_card_code);
-    
-    return 0;
-    }
-
-    // THRW - Vyhodit kartu
-    else if(strcmp(action, "THRW") == 0){
-        if(!message_body || strlen(message_body) == 0){
-            LOG_ERROR("Chybí kód karty\n");
-            return -1;
-        }
-
-        // Kontrola, zda už nevyhodil
-        if(player->did_thrown == 1){
-            LOG_INFO("Hráč %d už vyhodil\n", client_index);
-            return -1;
-        }
-
-        if(player->took_card == 0){
-            if(player->takes_15 && player->turns_played == 0){
-                // toto je okey -> prvni kolo s 15 kartami musi vyhodit
-            }
-            else{
-                return -2;
-            }
-            
-        }
-
-        if(player->hand_count == 1){
-            return -3;
-        }
-
-        // Najdi kartu v ruce
-        int card_index = -1;
-        
-        for(int i = 0; i < player->hand_count; i++){
-            char card_code[4];
-            snprintf(card_code, sizeof(card_code), "%s%s", 
-                    player->hand[i].name, player->hand[i].suit);
-            if(strcmp(message_body, card_code) == 0){
-                card_index = i;
-                break;
-            }
-        }
-
-        if(card_index == -1){
-            LOG_INFO("Karta '%s' nenalezena v ruce hráče\n", message_body);
-            return -1;
-        }
-
-        // Přidej kartu na odhazovací hromádku
-        game->discard_deck[game->discard_count++] = player->hand[card_index];
-
-        // Odeber kartu z ruky (shift)
-        for(int i = card_index; i < player->hand_count - 1; i++){
-            player->hand[i] = player->hand[i + 1];
-        }
-        player->hand_count--;
-
-        LOG_INFO("Hráč %d vyhodil kartu %s\n", client_index, message_body);
-
-        // Reset flagů pro tohoto hráče
-        player->took_card = 0;
-        player->did_thrown = 0;
-        player->turns_played++;
-
-        // Zkontroluj, zda hráč nevyhrál (prázdná ruka)
-        if(player->hand_count == 0){
-            LOG_INFO("Hráč %d vyhrál!\n", client_index);
-            game->state = GAME_STATE_FINISHED;
-            return 0;
-        }
-
-        // Přejdi na dalšího hráče
-        game_next_player(game);
-
-        return 0;
-    }
-    
-    // CLOS - Zavřít poslední kartou
-    else if(strcmp(action, "CLOS") == 0){
-        if(!message_body || strlen(message_body) == 0){
-            LOG_ERROR("Chybí kód karty\n");
-            return -1;
-        }
-
-        // Kontrola, zda má pouze 1 kartu
-        if(player->hand_count != 1){
-            LOG_INFO("Pro zavření musíš mít přesně 1 kartu (máš %d)\n", player->hand_count);
-            return -1;
-        }
-
-        // Najdi kartu v ruce
-        char card_code[4];
-        snprintf(card_code, sizeof(card_code), "%s%s", 
-                player->hand[0].name, player->hand[0].suit);
-
-        if(strcmp(message_body, card_code) != 0){
-            LOG_INFO("Karta '%s' nesedí s kartou v ruce '%s'\n", message_body, card_code);
-            return -1;
-        }
-
-        // Přidej kartu na odhazovací hromádku
-        game->discard_deck[game->discard_count++] = player->hand[0];
-
-        // Odeber z ruky
-        player->hand_count = 0;
-
-        LOG_INFO("Hráč %d zavřel hru!\n", client_index);
-
-        // Hra končí
-        game->state = GAME_STATE_FINISHED;
-
-        return 0;
-    }
-    
-    else{
-        LOG_ERROR("Neznámá akce: %s\n", action);
-        return -7;
-    }
-}
 
 int game_end_round(GameInstance *game){
     return 0;
@@ -893,6 +251,7 @@ int game_pause(GameInstance *game, const char* reason){
     LOG_INFO("Pozastavuji hru v místnosti %d: %s\n", game->room_id, reason);
 
     game->state = GAME_STATE_PAUSED;
+    server_timer_cancel(&rooms[game->room_id].turn_timer);
     return 0;
 }
 
@@ -908,7 +267,7 @@ int game_resume(GameInstance *game){
     LOG_INFO("Obnovuji hru v místnosti %d\n", game->room_id);
 
     game->state = GAME_STATE_PLAYING;
-    game->turn_start_time = time(NULL);
+    game_turn_timer_arm(game);
 
     return 0;
 }
@@ -930,38 +289,47 @@ int game_get_player_cards(GameInstance *game, int client_index, char* buffer, si
         return -1;
     }
 
-    char *current_pos = buffer;
-    size_t remaining_size = buffer_size;
-    int written = 0;
     // Naformátuj karty do požadovaného formátu
-    for(int i = 0; i < player->hand_count; i++){
-        if (i > 0) {
-            written = snprintf(current_pos, remaining_size, "|");
-            if (written < 0 || written >= remaining_size) {
-                break;
-            }
-            remaining_size -= written;
-            current_pos += written;
-        }
+    int written = card_hand_format(&player->hand, "|", buffer, buffer_size);
 
-        written = snprintf(
-            current_pos,
-            remaining_size,
-            "%s%s",
-            player->hand[i].name,
-            player->hand[i].suit
-        );
+    // Návratová hodnota: počet zapsaných znaků, nebo -1 v případě chyby
+    return written;
+}
 
-        if (written < 0 || written >= remaining_size) {
-            break;
+int game_get_hint(GameInstance *game, int client_index, char *buffer, size_t buffer_size){
+    if(!game || !buffer || buffer_size == 0){
+        return -1;
+    }
+
+    PlayerGameState *player = engine_find_player(game, client_index);
+    if(!player){
+        return -1;
+    }
+
+    // Opakovaný HINT nad stejným stavem -> uložená odpověď bez solveru
+    GameHint *hint = &game->hints[player - game->players];
+    if(hint->version != game->state_version){
+        uint64_t now = timer_now_ms();
+        if(hint->solved_ms != 0 && now - hint->solved_ms < HINT_MIN_INTERVAL_MS){
+            return -2;
         }
+        hint->solved_ms = now;
+        hint->version = game->state_version;
 
-        remaining_size -= written;
-        current_pos += written;
+        SolverPlan plan;
+        hint->len = -1;
+        if(solver_plan(&player->hand, game->sequences, game->sequence_count, HINT_BUDGET_US, &plan) == 0){
+            LOG_DEBUG("Nápověda hráči %d: %d karet, %lu uzlů%s\n", client_index, plan.discharged, plan.nodes,
+                      plan.complete ? "" : " (nedokončeno)");
+            hint->len = solver_plan_format(&plan, hint->text, sizeof(hint->text));
+        }
     }
 
-    // Návratová hodnota: počet zapsaných znaků, nebo -1 v případě chyby
-    return buffer_size - remaining_size;
+    if(hint->len < 0 || (size_t)hint->len >= buffer_size){
+        return -1;
+    }
+    memcpy(buffer, hint->text, (size_t)hint->len + 1);
+    return hint->len;
 }
 
 int game_get_player_state(GameInstance *game, int client_index, char* buffer, size_t buffer_size){
@@ -983,8 +351,92 @@ int game_get_player_state(GameInstance *game, int client_index, char* buffer, si
     return 1;
 }
 
-int game_get_full_state(GameInstance *game, int client_index, char *buffer, size_t buffer_size){
-    if(!game || !buffer || buffer_size == 0) return -1;
+/**
+ * @brief Sestaví sdílenou část STAT pro aktuální verzi stavu
+ * @return Snímek (refs = 1), NULL: ERROR (malloc, příliš velký stav)
+ */
+static GameSnapshot *game_snapshot_build(GameInstance *game){
+    char table[GAME_SNAPSHOT_BUFFER];
+    char tail[GAME_SNAPSHOT_TAIL_BUFFER];
+    size_t table_len = 0;
+    size_t tail_len = 0;
+    int written;
+
+    // "|vyhozená|postupky|"
+    table[table_len++] = '|';
+    if(game->discard_count > 0){
+        memcpy(table + table_len, card_code(game->discard_deck[game->discard_count - 1]), 2);
+        table_len += 2;
+    }
+    table[table_len++] = '|';
+
+    for(int i = 0; i < game->sequence_count; i++){
+        const CardSequence *seq = &game->sequences[i];
+
+        if(table_len + 1 + (size_t)seq->count * 2 + 1 > sizeof(table)) return NULL;
+        if(i > 0){
+            table[table_len++] = ',';
+        }
+        for(int j = 0; j < seq->count; j++){
+            memcpy(table + table_len, card_code(seq->cards[j]), 2);
+            table_len += 2;
+        }
+    }
+    table[table_len++] = '|';
+
+    // "|ID postupek|verze"
+    tail[tail_len++] = '|';
+    for(int i = 0; i < game->sequence_count; i++){
+        written = snprintf(tail + tail_len, sizeof(tail) - tail_len, i > 0 ? ",%u" : "%u", game->sequences[i].id);
+        if(written < 0 || (size_t)written >= sizeof(tail) - tail_len) return NULL;
+        tail_len += written;
+    }
+    written = snprintf(tail + tail_len, sizeof(tail) - tail_len, "|%u", game->state_version);
+    if(written < 0 || (size_t)written >= sizeof(tail) - tail_len) return NULL;
+    tail_len += written;
+
+    GameSnapshot *snapshot = (GameSnapshot*)malloc(sizeof(GameSnapshot) + table_len + tail_len);
+    if(!snapshot){
+        LOG_ERROR("Chyba: Malloc selhal (game_snapshot_build)\n");
+        return NULL;
+    }
+    atomic_init(&snapshot->refs, 1);
+    snapshot->version = game->state_version;
+    snapshot->table_len = table_len;
+    snapshot->tail_len = tail_len;
+    memcpy(snapshot->data, table, table_len);
+    memcpy(snapshot->data + table_len, tail, tail_len);
+    return snapshot;
+}
+
+GameSnapshot *game_snapshot_acquire(GameInstance *game){
+    if(!game){
+        return NULL;
+    }
+
+    // Stav se od posledního sestavení změnil -> přestav sdílenou část
+    if(!game->snapshot || game->snapshot->version != game->state_version){
+        GameSnapshot *snapshot = game_snapshot_build(game);
+        if(!snapshot){
+            return NULL;
+        }
+        game_snapshot_release(game->snapshot);
+        game->snapshot = snapshot;
+    }
+
+    atomic_fetch_add(&game->snapshot->refs, 1);
+    return game->snapshot;
+}
+
+void game_snapshot_release(GameSnapshot *snapshot){
+    if(snapshot && atomic_fetch_sub(&snapshot->refs, 1) == 1){
+        free(snapshot);
+    }
+}
+
+int game_get_state_parts(GameInstance *game, int client_index, const GameSnapshot *snapshot,
+                         struct iovec parts[GAME_STATE_PARTS], char *private_buffer, size_t private_size){
+    if(!game || !snapshot || !private_buffer) return -1;
 
     PlayerGameState *player = NULL;
     int enemy_card_count = 0;
@@ -995,266 +447,212 @@ int game_get_full_state(GameInstance *game, int client_index, char *buffer, size
         } else {
             // Přičítáme jen pokud je slot platný (např. index není -1)
             if(game->players[i].client_index != -1) {
-                enemy_card_count += game->players[i].hand_count;
+                enemy_card_count += game->players[i].hand.count;
             }
         }
     }
     if(!player) return -1;
 
-    char *ptr = buffer;
-    size_t rem = buffer_size;
-    int written;
+    // Ruka (soukromá)
+    int hand_len = card_hand_format(&player->hand, "", private_buffer, private_size);
+    if(hand_len < 0) return -2;
 
-    // Ruka
-    for(int i = 0; i < player->hand_count; i++){
-        written = snprintf(ptr, rem, "%s", player->hand[i].code);
-        if(written < 0 || (size_t)written >= rem) return -2;
-        ptr += written; rem -= written;
-    }
+    // TURN/WAIT a počet karet protihráče (soukromé) hned za rukou ve stejném bufferu
+    char *turn = private_buffer + hand_len + 1;
+    size_t turn_size = private_size - hand_len - 1;
+    int active_client_index = game->players[game->current_player_index].client_index;
+    int turn_len = snprintf(turn, turn_size, "%s|%d",
+                            active_client_index == client_index ? "TURN" : "WAIT", enemy_card_count);
+    if(turn_len < 0 || (size_t)turn_len >= turn_size) return -2;
+
+    // ruka + "|vyhozená|postupky|" + TURN|počet + "|ID|verze"
+    parts[0].iov_base = private_buffer;
+    parts[0].iov_len = hand_len;
+    parts[1].iov_base = (void*)snapshot->data;
+    parts[1].iov_len = snapshot->table_len;
+    parts[2].iov_base = turn;
+    parts[2].iov_len = turn_len;
+    parts[3].iov_base = (void*)(snapshot->data + snapshot->table_len);
+    parts[3].iov_len = snapshot->tail_len;
+
+    return (int)(hand_len + snapshot->table_len + turn_len + snapshot->tail_len);
+}
 
-    // Delim 1
-    written = snprintf(ptr, rem, "|");
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written; // Tady jsi v původním kódu aktualizaci měl
+int game_get_full_state(GameInstance *game, int client_index, char *buffer, size_t buffer_size){
+    if(!game || !buffer || buffer_size == 0) return -1;
 
-    // Discard pile
-    if(game->discard_count > 0){
-        written = snprintf(ptr, rem, "%s", game->discard_deck[game->discard_count-1].code);
-    } else {
-        written = 0; 
-    }
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written;
+    GameSnapshot *snapshot = game_snapshot_acquire(game);
+    if(!snapshot) return -2;
 
-    // Delim 2
-    written = snprintf(ptr, rem, "|");
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written;
+    struct iovec parts[GAME_STATE_PARTS];
+    char private_state[GAME_PRIVATE_STATE_BUFFER];
+    int len = game_get_state_parts(game, client_index, snapshot, parts, private_state, sizeof(private_state));
 
-    // Postupky
-    for(int i = 0; i < game->sequence_count; i++){
-        if(i > 0){
-            written = snprintf(ptr, rem, ",");
-            if(written < 0 || (size_t)written >= rem) return -2;
-            ptr += written; rem -= written;
-        }
-        for(int j = 0; j < game->sequences[i].count; j++){
-            written = snprintf(ptr, rem, "%s", game->sequences[i].cards[j].code);
-            if(written < 0 || (size_t)written >= rem) return -2;
-            ptr += written; rem -= written;
+    if(len >= 0 && (size_t)len >= buffer_size){
+        len = -2;
+    }
+    if(len >= 0){
+        char *ptr = buffer;
+        for(int i = 0; i < GAME_STATE_PARTS; i++){
+            memcpy(ptr, parts[i].iov_base, parts[i].iov_len);
+            ptr += parts[i].iov_len;
         }
+        *ptr = '\0';
     }
 
-    // Delim 3
-    written = snprintf(ptr, rem, "|");
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written;
+    game_snapshot_release(snapshot);
+    return len;
+}
 
-    int active_client_index = game->players[game->current_player_index].client_index;
+int game_get_delta_state(GameInstance *game, int client_index, uint32_t client_version, char *buffer, size_t buffer_size){
+    if(!game || !buffer || buffer_size == 0) return -1;
 
-    if(active_client_index == client_index) {
-        written = snprintf(ptr, rem, "TURN");
-    } else {
-        written = snprintf(ptr, rem, "WAIT");
-    }
+    // Delta jde jen na verzi, od které se log vede
+    if(game->changes_overflow || client_version != game->delta_base) return -1;
 
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written;
+    int self = -1;
+    for(int i = 0; i < game->player_count; i++){
+        if(game->players[i].client_index == client_index){
+            self = i;
+        }
+    }
+    if(self < 0) return -1;
 
-    // Delim 4
-    written = snprintf(ptr, rem, "|");
-    if(written < 0 || (size_t)written >= rem) return -2;
-    ptr += written; rem -= written;
+    char *ptr = buffer;
+    size_t rem = buffer_size;
+    int written;
+    int first = 1;
+    int discard_changed = 0;
+    int turn_changed = 0;
+    int enemy_changed = 0;
 
-    // Enemy card count
-    written = snprintf(ptr, rem, "%d", enemy_card_count);
-    if(written < 0 || (size_t)written >= rem) return -2;
+    written = snprintf(ptr, rem, "%u|%u|", game->delta_base, game->state_version);
+    if(written < 0 || (size_t)written >= rem) return -1;
     ptr += written; rem -= written;
 
-    return (int)(buffer_size - rem);
-}
+    // Ruka a kombinace v pořadí změn, vršek vyhozených, tah a počet karet protihráče jednou na konci
+    for(int i = 0; i < game->change_count; i++){
+        const GameChange *change = &game->changes[i];
 
-int game_validate_move(GameInstance *game, int client_index, const char* action){
-    // Už to dělá process_move
-    return 0;
-}
+        switch(change->kind){
+            case CHANGE_HAND_ADD:
+            case CHANGE_HAND_REMOVE:
+                if(change->player != self){
+                    enemy_changed = 1;
+                    continue;
+                }
+                written = snprintf(ptr, rem, "%sH%c%s", first ? "" : ",",
+                                   change->kind == CHANGE_HAND_ADD ? '+' : '-', card_code(change->card));
+                break;
 
-int game_check_timeout(GameInstance *game){
-    // Pro budoucí implementaci
-    return 0;
-}
+            case CHANGE_MELD_NEW:
+            case CHANGE_MELD_EXTEND: {
+                const CardSequence *seq = &game->sequences[change->seq_id - 1];
 
-int game_disconnect_handle(GameInstance *game, int client_index){
-    // Pro budoucí implementaci
-    return 0;
-}
+                written = snprintf(ptr, rem, "%s%c%u:", first ? "" : ",",
+                                   change->kind == CHANGE_MELD_NEW ? 'N' : 'A', seq->id);
+                if(written < 0 || (size_t)written >= rem) return -1;
+                ptr += written; rem -= written;
 
-int game_reconnect_handle(GameInstance *game, int client_index){
-    if(!game){
-        return -1;
-    }
+                // Aktuální obsah kombinace (přiložením se může přeskládat)
+                if((size_t)seq->count * 2 >= rem) return -1;
+                for(int j = 0; j < seq->count; j++){
+                    memcpy(ptr + j * 2, card_code(seq->cards[j]), 2);
+                }
+                written = seq->count * 2;
+                break;
+            }
 
-    LOG_INFO("Hráč %d se reconnectoval do hry\n", client_index);
+            case CHANGE_DISCARD:
+                discard_changed = 1;
+                continue;
 
-    for(int i = 0; i < game->player_count; i++){
-        if(game->players[i].client_index == client_index){
-            game->players[i].is_active = 1;
+            case CHANGE_TURN:
+                turn_changed = 1;
+                continue;
 
-            if(game->state == GAME_STATE_PAUSED){
-                game_resume(game);
-            }
-            return 0;
+            default:
+                continue;
         }
-    }
-    return -1;
-}
 
-void game_init_deck(GameInstance *game){
-    // Kontrola parametru
-    if(!game){
-        return;
+        if(written < 0 || (size_t)written >= rem) return -1;
+        ptr += written; rem -= written;
+        first = 0;
     }
 
-    // Definice karet
-    const char *suits[] = {"H", "D", "C", "S", "Y"};
-    const char *names[] = {"A", "2", "3", "4", "5", "6", "7", "8", "9", "X", "J", "Q", "K", "Y"};
-    int values[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 50};
-
-    // Vytvoření 52 * 2 karet
-    game->deck_count = 0;
-    for(int i = 0; i < 2; i++){
-        for(int j = 0; j < 4; j++){
-            for(int k = 0; k < 13; k++){
-                Card *card = &game->deck[game->deck_count];
-                card->id = game->deck_count;
-                strncpy(card->name, names[k], sizeof(card->name)-1);
-                card->name[sizeof(card->name)-1] = '\0';
-                strncpy(card->suit, suits[j], sizeof(card->suit)-1);
-                card->suit[sizeof(card->suit)-1] = '\0';
-                card->value = values[k];
-                card->is_joker = 0;
-                game->deck_count++;
-                char tmp[3];
-                snprintf(tmp, sizeof(tmp), "%s%s", card->name, card->suit);
-                strcpy(card->code, tmp);
-            }
-        }
+    if(discard_changed){
+        written = snprintf(ptr, rem, "%sD%s", first ? "" : ",",
+                           game->discard_count > 0 ? card_code(game->discard_deck[game->discard_count - 1]) : "");
+        if(written < 0 || (size_t)written >= rem) return -1;
+        ptr += written; rem -= written;
+        first = 0;
     }
 
-    // Přidání 4 jokerů
-    for(int i = 0; i < 4; i++){
-        Card *card = &game->deck[game->deck_count];
-        card->id = game->deck_count;
-        strncpy(card->name, names[13], sizeof(card->name)-1);
-        card->name[sizeof(card->name)-1] = '\0';
-        strncpy(card->suit, suits[4], sizeof(card->suit) - 1);
-        card->suit[sizeof(card->suit)-1] = '\0';
-        card->value = values[13];
-        card->is_joker = 1;
-        game->deck_count++;
-        char tmp[3];
-        snprintf(tmp, sizeof(tmp), "%s%s", card->name, card->suit);
-        strcpy(card->code, tmp);
+    if(turn_changed){
+        written = snprintf(ptr, rem, "%sT%d", first ? "" : ",", game->current_player_index == self);
+        if(written < 0 || (size_t)written >= rem) return -1;
+        ptr += written; rem -= written;
+        first = 0;
     }
 
-    // Zamíchání balíčku
-    // for(int i = game->deck_count-1; i >0; i--){
-    //     int j = rand() % (i+1);
-    //     Card temp = game->deck[i];
-    //     game->deck[i] = game->deck[j];
-    //     game->deck[j] = temp;
-    // }
-
-    LOG_INFO("Balíček inicializován a zamíchán (%d karet)\n", game->deck_count);
+    if(enemy_changed){
+        int enemy_card_count = 0;
+        for(int i = 0; i < game->player_count; i++){
+            if(i != self && game->players[i].client_index != -1){
+                enemy_card_count += game->players[i].hand.count;
+            }
+        }
+        written = snprintf(ptr, rem, "%sE%d", first ? "" : ",", enemy_card_count);
+        if(written < 0 || (size_t)written >= rem) return -1;
+        ptr += written; rem -= written;
+    }
 
+    *ptr = '\0';
+    return (int)(buffer_size - rem);
 }
 
-void game_deal_cards(GameInstance *game){
+void game_delta_reset(GameInstance *game){
     if(!game){
         return;
     }
 
-    // Rozdání karet podle toho, kdo začíná (15/14)
-    for(int i = 0; i < game->player_count; i++){
-        PlayerGameState *player = &game->players[i];
-        int cards_per_player = player->takes_15 ? 15 : 14;
-        player->hand_count = 0;
-
-        for(int j = 0; j < cards_per_player && game->deck_count > 0; j++){
-            game->deck_count--;
-            player->hand[player->hand_count++] = game->deck[game->deck_count];
-        }
+    engine_changes_reset(game);
+}
 
-        LOG_INFO("Hráč %d dostal %d karet\n", player->client_index, player->hand_count);
-    }
+int game_validate_move(GameInstance *game, int client_index, MessageType action){
+    // Už to dělá process_move
+    return 0;
 }
 
-void game_next_player(GameInstance *game){
-    if(!game){
-        return;
+int game_check_timeout(GameInstance *game){
+    if(!game || game->state != GAME_STATE_PLAYING){
+        return 0;
     }
 
-    int start = game->current_player_index;
-
-    do{
-        game->current_player_index = (game->current_player_index + 1) % game->player_count;
-
-        if(game->players[game->current_player_index].is_active){
-            game->turn_start_time = time(NULL);
-            LOG_INFO("Na tahu je hráč %d\n", game->players[game->current_player_index].client_index);
-        }
-        return;
-    } while(game->current_player_index != start);
-
-    LOG_INFO("Žádní aktivní hráči, ukončuji hru\n");
-    game->state = GAME_STATE_FINISHED;
+    return time(NULL) - game->turn_start_time >= game->turn_timeout_seconds;
 }
 
-void game_calculate_scores(GameInstance *game) {
-    const char *names[] = {"A", "2", "3", "4", "5", "6", "7", "8", "9", "X", "J", "Q", "K", "Y"};
-    int values[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 50};
-    int num_variants = sizeof(names) / sizeof(names[0]);
-
-    // printf("\n[SCORE_CALC] Zahajuji vypocet skore pro hru.\n");
-
-    pthread_mutex_lock(&clients_mutex);
-    for (int i = 0; i < game->player_count; i++) {
-        // int previous_score = game->players[i].score;
-        game->players[i].score = 0; 
-        
-        // printf("  [PLAYER %d] Karty v ruce (%d): ", i, game->players[i].hand_count);
-
-        for (int j = 0; j < game->players[i].hand_count; j++) {
-            int found = 0;
-            for (int k = 0; k < num_variants; k++) {
-                if (strcmp(game->players[i].hand[j].name, names[k]) == 0) {
-                    game->players[i].score += values[k];
-                    // printf("%s(+%d) ", game->players[i].hand[j].name, values[k]);
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found) {
-                // printf(" ERR(%s) ", game->players[i].hand[j].name);
-            }
-        }
-        // printf("\n  [PLAYER %d] Vysledne skore: %d (predchozi bylo: %d)\n", 
-            //    i, game->players[i].score, previous_score);
-    }
-    pthread_mutex_unlock(&clients_mutex);
-    
-    // printf("[SCORE_CALC] Vypocet dokoncen.\n\n");
+int game_disconnect_handle(GameInstance *game, int client_index){
+    // Pro budoucí implementaci
+    return 0;
 }
 
-int game_is_finished(GameInstance *game){
+int game_reconnect_handle(GameInstance *game, int client_index){
     if(!game){
-        return 0;
+        return -1;
     }
 
+    LOG_INFO("Hráč %d se reconnectoval do hry\n", client_index);
+
     for(int i = 0; i < game->player_count; i++){
-        if(game->players[i].hand_count == 0){
-            return 1;
+        if(game->players[i].client_index == client_index){
+            game->players[i].is_active = 1;
+
+            if(game->state == GAME_STATE_PAUSED){
+                game_resume(game);
+            }
+            return 0;
         }
     }
-    return 0;
-}
\ No newline at end of file
+    return -1;
+}
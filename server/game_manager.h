@@ -2,90 +2,28 @@
 #define GAME_MANAGER_H
 
 #include "config.h"
+#include "protocol.h"
+#include "game_engine.h"
 #include <pthread.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
 
 #define MAX_ROOM_NAME 10
-#define MAX_ROOM_PLAYERS 2
-#define MAX_HAND_CARD 15
-#define DECK_CARDS_COUNT 108
-#define MAX_SEQUENCE_CARDS 15
-#define MAX_SEQUENCES 50
-
 
 typedef struct GameRoom GameRoom;
 struct ClientContext;
 
-// Enum pro stavy hry
-typedef enum{
-    GAME_STATE_LOBBY,
-    GAME_STATE_STARTING,
-    GAME_STATE_PLAYING,
-    GAME_STATE_PAUSED,
-    GAME_STATE_FINISHED
-} GameState;
-
-// Struktura pro uchování karty
-typedef struct {
-    int id;
-    char name[2];
-    int value;
-    char suit[2];
-    int is_joker;
-    char code[3];
-} Card;
-
-// Struktura pro uchování postupek a setů (vyložených karet)
-typedef struct {
-    Card cards[MAX_SEQUENCE_CARDS];
-    int count;
-    int owner_client_index;
-} CardSequence;
-
-// Struktura pro uchování herního stavu uživatele
-typedef struct {
-    int client_index;
-    int score;
-    int position;
-    int is_active;
-
-    int takes_15;
-
-    Card hand[MAX_HAND_CARD];
-    int hand_count;
-
-    int turns_played;
-    int cards_played;
-
-    int is_ready_for_next_round;
-    int did_thrown;
-    int took_card;
-    int did_closed;
-} PlayerGameState;
-
-// Struktura hry
-typedef struct{
-    int room_id;
-    GameState state;
-
-    PlayerGameState players[MAX_ROOM_PLAYERS];
-    int player_count;
-    int current_player_index;
-
-    Card deck[DECK_CARDS_COUNT];
-    int deck_count;
+// Sdílená část STAT (stejná pro všechny hráče), sestavená jednou na verzi stavu
+typedef struct GameSnapshot{
+    atomic_int refs;                // Počet držitelů (hra + odesílající)
+    uint32_t version;               // state_version, pro kterou byl sestaven
+    size_t table_len;               // "|vyhozená|postupky|"
+    size_t tail_len;                // "|ID postupek|verze"
+    char data[];                    // table + tail
+} GameSnapshot;
 
-    Card discard_deck[DECK_CARDS_COUNT];
-    int discard_count;
-
-    CardSequence sequences[MAX_SEQUENCES];
-    int sequence_count;
-
-    time_t round_start_time;
-    time_t turn_start_time;
-    int turn_timeout_seconds;
-
-    void* event_log;
-} GameInstance;
+// Části STAT pro jednoho hráče: ruka, sdílený stůl, TURN/WAIT|počet, sdílený konec
+#define GAME_STATE_PARTS 4
 
 // Callbacky nevyužity 
 typedef void (*SendToPlayerCallback)(int client_index, const char* msg_type, const char *message);
@@ -98,13 +36,30 @@ typedef struct{
     NotifyRoomCallback notify_room;
 } GameCallbacks;
 
+// Obsazenost poolu her (pro dimenzování --max-rooms podle špičky souběžných stolů)
+typedef struct{
+    int capacity;                   // Počet předalokovaných her
+    int in_use;                     // Právě rozehrané hry
+    int high_water;                 // Nejvíc souběžných her od startu
+    unsigned long acquired;         // Celkem vydaných her
+    unsigned long exhausted;        // Žádostí, na které pool nestačil
+} GamePoolStats;
+
+/**
+ * @brief Základní inicializace aktivních her, předalokuje a předem osahá pool her (bez page faultů při hře)
+ * @param room_capacity Kapacita tabulky místností (jedna hra na místnost)
+ * @return 0: SUCCESS, -1: ERROR (malloc)
+ */
+int game_init(int room_capacity);
+
 /**
- * @brief Základní inicializace aktivních her
+ * @brief Kopie počítadel poolu her
+ * @param stats Výstup
  */
-void game_init();
+void game_pool_stats(GamePoolStats *stats);
 
 /**
- * @brief Vytvoření hry v místnosti
+ * @brief Vytvoření hry v místnosti (instance z poolu, hráči a seed přes engine_setup)
  * @param room Instance místnosti
  * @return Instance na hru, NULL
  */
@@ -124,14 +79,16 @@ void game_destroy(GameInstance *game);
 int game_start(GameInstance *game);
 
 /**
- * @brief Kontroluje, jestli tah hráčem je validní
+ * @brief Provede tah hráče (engine_apply_move), při předání tahu naplánuje časovač a tah zaloguje
+ *
+ * Změny stavu se zapisují do changes[], tah, který stav změnil, zvýší state_version.
  * @param game Instance na hru
  * @param client_index Klientský index
- * @param action Vykonávaná akce
- * @param message_body Tělo akce (karty)
- * @return <0: ERROR, 0: validní tah
+ * @param action Vykonávaná akce (MSG_TAKP, MSG_TAKT, MSG_UNLO, MSG_ADDC, MSG_THRW, MSG_CLOS)
+ * @param message_body Tělo akce (karty, u ADDC "<ID postupky nebo její kódy>|<karta>")
+ * @return <0: ERROR (kódy viz engine_apply_move), 0: validní tah
  */
-int game_process_move(GameInstance *game, int client_index, const char* action, const char* message_body);
+int game_process_move(GameInstance *game, int client_index, MessageType action, const char* message_body);
 
 /**
  * @brief
@@ -172,6 +129,17 @@ int game_resume(GameInstance *game);
  */
 int game_get_player_cards(GameInstance *game, int client_index, char* buffer, size_t buffer_size);
 
+/**
+ * @brief Nápověda tahu (HINT): plán solveru nad rukou hráče a stolem, v rozpočtu HINT_BUDGET_US
+ * Plán se pro hráče počítá nejvýš jednou na state_version (dál z cache) a nejvýš jednou za HINT_MIN_INTERVAL_MS.
+ * @param game Instance hry
+ * @param client_index Klientský index (hráč)
+ * @param buffer Buffer pro zprávu (formát solver_plan_format)
+ * @param buffer_size Velikost bufferu
+ * @return -1: ERROR, -2: příliš častý dotaz, int: Počet zapsaných znaků: SUCCESS
+ */
+int game_get_hint(GameInstance *game, int client_index, char *buffer, size_t buffer_size);
+
 /**
  * @brief Vrací state hráče
  * @param game Instance na hru
@@ -184,6 +152,8 @@ int game_get_player_state(GameInstance *game, int client_index, char* buffer, si
 
 /**
  * @brief Formátuje stav hry pro klienty a předává informace o kartách v ruce, vyhozené kartě, počet karet protihráče a tah nebo opak
+ *
+ * Formát: ruka|vyhozená|postupky (čárkou)|TURN/WAIT|karty protihráče|ID postupek (čárkou, ve stejném pořadí)|verze stavu
  * @param game Instance hry
  * @param client_index Klientský index (hráč)
  * @param buffer Buffer pro zprávu (řetězec)
@@ -193,65 +163,84 @@ int game_get_player_state(GameInstance *game, int client_index, char* buffer, si
 int game_get_full_state(GameInstance *game, int client_index, char *buffer, size_t buffer_size);
 
 /**
- * @brief Původně funkce pro demodulaci funkce process_move (pro budoucí užití)
+ * @brief Sdílená část STAT pro aktuální verzi stavu (sestaví se jednou na verzi, pak se jen půjčuje)
  * @param game Instance hry
- * @param client_index Klientský index
- * @param action Tah hry
- * @return 0
+ * @return Snímek s referencí pro volajícího (uvolnit game_snapshot_release), NULL: ERROR
  */
-int game_validate_move(GameInstance *game, int client_index, const char* action);
+GameSnapshot *game_snapshot_acquire(GameInstance *game);
 
 /**
- * @brief Funkce pro budoucí implementaci
- * @param game Instance na hru
- * @return 0
+ * @brief Uvolní referenci na snímek
+ * @param snapshot Snímek (NULL se ignoruje)
  */
-int game_check_timeout(GameInstance *game);
+void game_snapshot_release(GameSnapshot *snapshot);
 
 /**
- * @brief Pro budoucí implementaci
- * @param game Instance na hru
- * @param client_index Klientský index
- * @return 0
+ * @brief Rozloží STAT hráče na části pro zápis vektorem: soukromé části se zapíší do private_buffer,
+ * sdílené ukazují do snímku (musí žít do odeslání)
+ * @param game Instance hry
+ * @param client_index Klientský index (hráč)
+ * @param snapshot Sdílená část (game_snapshot_acquire)
+ * @param parts Výstupní části (GAME_STATE_PARTS)
+ * @param private_buffer Buffer pro ruku a TURN/WAIT|počet
+ * @param private_size Velikost bufferu (GAME_PRIVATE_STATE_BUFFER)
+ * @return -1: ERROR, -2: malý buffer, int: Celková délka zprávy: SUCCESS
  */
-int game_disconnect_handle(GameInstance *game, int client_index);
+int game_get_state_parts(GameInstance *game, int client_index, const GameSnapshot *snapshot,
+                         struct iovec parts[GAME_STATE_PARTS], char *private_buffer, size_t private_size);
 
 /**
- * @brief Navrácení hráče do hry po reconnectu
- * @param game Instance na hru
- * @param client_index Klientský index
- * @return -1: ERROR, 0: SUCCESS
+ * @brief Formátuje změny stavu od delta_base pro klienty s DLTA
+ *
+ * Formát: základní verze|nová verze|změny (čárkou). Změny: H+XS / H-XS (vlastní ruka), N<id>:<karty> (nová
+ * kombinace), A<id>:<karty> (přiložení, celá kombinace), D<karta> (vršek vyhozených, prázdné: žádná),
+ * T1 / T0 (na tahu / čeká), E<počet> (karty protihráče).
+ * @param game Instance hry
+ * @param client_index Klientský index (hráč)
+ * @param client_version Verze stavu, kterou klient má
+ * @param buffer Buffer pro zprávu (řetězec)
+ * @param buffer_size Velikost bufferu
+ * @return -1: klient potřebuje plný STAT (jiná verze, přetečení logu, buffer), int: Velikost zprávy: SUCCESS
  */
-int game_reconnect_handle(GameInstance *game, int client_index);
+int game_get_delta_state(GameInstance *game, int client_index, uint32_t client_version, char *buffer, size_t buffer_size);
 
 /**
- * @brief Inicializace hrního balíčku, zamíchání karet
- * @param game Instance na hru
+ * @brief Po rozeslání stavu všem hráčům začne nový log změn od aktuální verze
+ * @param game Instance hry
  */
-void game_init_deck(GameInstance *game);
+void game_delta_reset(GameInstance *game);
 
 /**
- * @brief Rozdání karet uživatelům
- * @param game Instance na hru
+ * @brief Původně funkce pro demodulaci funkce process_move (pro budoucí užití)
+ * @param game Instance hry
+ * @param client_index Klientský index
+ * @param action Tah hry
+ * @return 0
  */
-void game_deal_cards(GameInstance *game);
+int game_validate_move(GameInstance *game, int client_index, MessageType action);
 
 /**
- * @brief Přepnutí hráče na tahu
+ * @brief Kontrola limitu tahu, volá ji časovač tahu hry
  * @param game Instance na hru
+ * @return 1: hráč na tahu překročil limit, 0: jinak
  */
-void game_next_player(GameInstance *game);
+int game_check_timeout(GameInstance *game);
 
 /**
- * @brief Výpočet skore zbylých karet v rukách hráčů
+ * @brief Pro budoucí implementaci
  * @param game Instance na hru
+ * @param client_index Klientský index
+ * @return 0
  */
-void game_calculate_scores(GameInstance *game);
+int game_disconnect_handle(GameInstance *game, int client_index);
 
 /**
- * @brief Kontrola ukončení hry
+ * @brief Navrácení hráče do hry po reconnectu
  * @param game Instance na hru
+ * @param client_index Klientský index
+ * @return -1: ERROR, 0: SUCCESS
  */
-int game_is_finished(GameInstance *game);
+int game_reconnect_handle(GameInstance *game, int client_index);
+
 
 #endif
\ No newline at end of file
@@ -1,17 +1,40 @@
 #include "logger.h"
+#include "config.h"
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 
 static FILE *log_file = NULL;
-static log_level_t min_log_level;
+log_level_t log_min_level = LOG_DEBUG;
 static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static const char *level_str[] = {
     "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
 };
 
+// Záznam asynchronního loggeru: text zformátuje producent (argumenty jsou jen jeho), hlavičku zapisovač
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))) {
+    atomic_size_t sequence;             // Pořadí slotu (pos: volný pro zápis, pos + 1: připravený ke čtení)
+    struct timespec time;
+    unsigned long thread;
+    const char *file;
+    int line;
+    log_level_t level;
+    char message[LOG_RECORD_MESSAGE];
+} LogRecord;
+
+static LogRecord *log_ring = NULL;      // NULL: synchronní režim
+static size_t log_ring_mask = 0;
+static atomic_size_t log_head = 0;      // Další pozice producentů (CAS)
+static size_t log_tail = 0;             // Další pozice zapisovače (jen zapisovací vlákno)
+static atomic_ulong log_dropped_count = 0;
+static atomic_int log_writer_running = 0;
+static pthread_t log_writer;
+
 int log_init(const char *filename, log_level_t min_level)
 {
     // Pokud existuje soubor resp. lze vytvorit -> načti do modu append (nepřepisuj původní)
@@ -23,24 +46,197 @@ int log_init(const char *filename, log_level_t min_level)
     if (!log_file)
         return -1;
 
-    min_log_level = min_level;
+    log_min_level = min_level;
     return 0;
 }
 
+/**
+ * @brief Zapíše jeden řádek logu (volat pod log_mutex)
+ */
+static void log_write_line_locked(const struct timespec *ts, log_level_t level, unsigned long thread,
+                                  const char *file, int line, const char *message)
+{
+    // Zapisovač píše záznamy v pořadí času, strftime stačí jednou za sekundu
+    static time_t cached_second = (time_t)-1;
+    static char timebuf[32];
+
+    if (ts->tv_sec != cached_second) {
+        struct tm tm;
+        localtime_r(&ts->tv_sec, &tm);
+        strftime(timebuf, sizeof(timebuf), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_second = ts->tv_sec;
+    }
+
+    fprintf(log_file, "[%s] [%s] [TID:%lu] %s:%d: %s\n", timebuf, level_str[level], thread, file, line, message);
+}
+
+/**
+ * @brief Vyzvedne a zapíše nejvýše LOG_WRITER_BATCH záznamů, jeden fflush na dávku
+ * @return Počet zapsaných záznamů
+ */
+static int log_drain_batch(void)
+{
+    static unsigned long reported_drops = 0;
+    int written = 0;
+
+    pthread_mutex_lock(&log_mutex);
+
+    while (written < LOG_WRITER_BATCH) {
+        LogRecord *record = &log_ring[log_tail & log_ring_mask];
+
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != log_tail + 1)
+            break;
+
+        log_write_line_locked(&record->time, record->level, record->thread, record->file, record->line,
+                              record->message);
+
+        // Slot se uvolní pro producenty o jedno kolo fronty dál
+        atomic_store_explicit(&record->sequence, log_tail + log_ring_mask + 1, memory_order_release);
+        log_tail++;
+        written++;
+    }
+
+    // Ztráty hlásí zapisovač sám, producent při plné frontě jen přičte čítač
+    unsigned long drops = atomic_load_explicit(&log_dropped_count, memory_order_relaxed);
+    if (drops != reported_drops) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        char message[128];
+        snprintf(message, sizeof(message), "Plná fronta loggeru, zahozeno %lu záznamů (celkem %lu)",
+                 drops - reported_drops, drops);
+        log_write_line_locked(&now, LOG_WARN, (unsigned long)pthread_self(), __FILE__, __LINE__, message);
+        reported_drops = drops;
+        written++;
+    }
+
+    if (written > 0)
+        fflush(log_file);
+
+    pthread_mutex_unlock(&log_mutex);
+    return written;
+}
+
+/**
+ * @brief Zapisovací vlákno: vybírá frontu po dávkách, při prázdné frontě spí LOG_WRITER_IDLE_MS
+ */
+static void *log_writer_main(void *arg)
+{
+    (void)arg;
+    const struct timespec idle = {0, LOG_WRITER_IDLE_MS * 1000000L};
+
+    while (atomic_load_explicit(&log_writer_running, memory_order_acquire)) {
+        if (log_drain_batch() == 0)
+            nanosleep(&idle, NULL);
+    }
+
+    // Dopiš, co producenti stihli vložit před ukončením
+    while (log_drain_batch() > 0)
+        ;
+    return NULL;
+}
+
+int log_start_async(size_t records)
+{
+    if (!log_file || log_ring || records < 2 || (records & (records - 1)) != 0)
+        return -1;
+
+    LogRecord *ring = aligned_alloc(CACHE_LINE_SIZE, records * sizeof(LogRecord));
+    if (!ring)
+        return -1;
+
+    for (size_t i = 0; i < records; i++)
+        atomic_init(&ring[i].sequence, i);
+
+    // Zapisovač volá fflush jednou za dávku, buffer musí dávku pojmout
+    setvbuf(log_file, NULL, _IOFBF, LOG_WRITER_BATCH * 256);
+
+    log_ring = ring;
+    log_ring_mask = records - 1;
+    atomic_store(&log_head, 0);
+    log_tail = 0;
+    atomic_store(&log_writer_running, 1);
+
+    if (pthread_create(&log_writer, NULL, log_writer_main, NULL) != 0) {
+        atomic_store(&log_writer_running, 0);
+        log_ring = NULL;
+        free(ring);
+        return -1;
+    }
+    return 0;
+}
+
+unsigned long log_dropped(void)
+{
+    return atomic_load_explicit(&log_dropped_count, memory_order_relaxed);
+}
+
 void log_close(void)
 {
+    // Zastav zapisovač, ten před koncem vyprázdní frontu
+    if (log_ring) {
+        atomic_store_explicit(&log_writer_running, 0, memory_order_release);
+        pthread_join(log_writer, NULL);
+        free(log_ring);
+        log_ring = NULL;
+    }
+
     if (log_file && log_file != stdout)
         fclose(log_file);
 }
 
+/**
+ * @brief Vloží záznam do fronty bez zámku, při plné frontě ho zahodí
+ */
+static void log_enqueue(log_level_t level, const char *file, int line, const char *fmt, va_list args)
+{
+    size_t pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+    LogRecord *record;
+
+    for (;;) {
+        record = &log_ring[pos & log_ring_mask];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // Zapisovač nestíhá: ztráta je omezená na záznamy nad kapacitu fronty
+            atomic_fetch_add_explicit(&log_dropped_count, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+        }
+    }
+
+    clock_gettime(CLOCK_REALTIME, &record->time);
+    record->thread = (unsigned long)pthread_self();
+    record->file = file;
+    record->line = line;
+    record->level = level;
+    vsnprintf(record->message, sizeof(record->message), fmt, args);
+
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+}
+
 void log_msg(log_level_t level,
              const char *file,
              int line,
              const char *fmt, ...)
 {
-    if (level < min_log_level)
+    if (level < log_min_level)
         return;
 
+    va_list args;
+    va_start(args, fmt);
+
+    if (log_ring) {
+        log_enqueue(level, file, line, fmt, args);
+        va_end(args);
+        return;
+    }
+
     pthread_mutex_lock(&log_mutex);
 
     time_t now = time(NULL);
@@ -59,8 +255,6 @@ void log_msg(log_level_t level,
         file,
         line);
 
-    va_list args;
-    va_start(args, fmt);
     vfprintf(log_file, fmt, args);
     va_end(args);
 
@@ -70,6 +264,32 @@ void log_msg(log_level_t level,
     pthread_mutex_unlock(&log_mutex);
 }
 
+int log_rate_allow(LogRateLimit *limit, unsigned per_second, log_level_t level, const char *file, int line)
+{
+    if (per_second == 0)
+        return 1;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    // Nové okno otevře jediné vlákno (CAS), to vypíše i souhrn potlačených
+    long window = atomic_load_explicit(&limit->window, memory_order_relaxed);
+    if (now.tv_sec != window &&
+        atomic_compare_exchange_strong_explicit(&limit->window, &window, (long)now.tv_sec,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        atomic_store_explicit(&limit->count, 0, memory_order_relaxed);
+        unsigned suppressed = atomic_exchange_explicit(&limit->suppressed, 0, memory_order_relaxed);
+        if (suppressed > 0)
+            log_msg(level, file, line, "Potlačeno %u zpráv z tohoto místa (limit %u/s)", suppressed, per_second);
+    }
+
+    if (atomic_fetch_add_explicit(&limit->count, 1, memory_order_relaxed) < per_second)
+        return 1;
+
+    atomic_fetch_add_explicit(&limit->suppressed, 1, memory_order_relaxed);
+    return 0;
+}
+
 void log_delete(void)
 {
     if (!log_file || log_file == stdout) {
@@ -80,9 +300,9 @@ void log_delete(void)
 
     int fd = fileno(log_file);
     if (fd != -1) {
-        ftruncate(fd, 0);            
+        ftruncate(fd, 0);
         fseek(log_file, 0, SEEK_SET);
     }
 
     pthread_mutex_unlock(&log_mutex);
-}
\ No newline at end of file
+}
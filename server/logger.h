@@ -11,16 +11,41 @@
 #define LOGGER_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "config.h"
+
+// Číselné úrovně pro preprocesor (LOG_COMPILE_LEVEL)
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_FATAL 4
+
+// Nejnižší úroveň přeložená do binárky (make LOG_LEVEL=INFO), nižší volání se vůbec nevyhodnotí
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
 
 // Výčtový typ levelů loggeru
 typedef enum {
-    LOG_DEBUG,
-    LOG_INFO,
-    LOG_WARN,
-    LOG_ERROR,
-    LOG_FATAL
+    LOG_DEBUG = LOG_LEVEL_DEBUG,
+    LOG_INFO = LOG_LEVEL_INFO,
+    LOG_WARN = LOG_LEVEL_WARN,
+    LOG_ERROR = LOG_LEVEL_ERROR,
+    LOG_FATAL = LOG_LEVEL_FATAL
 } log_level_t;
 
+// Stav omezovače jednoho místa volání (statický v makru, okno jedna sekunda)
+typedef struct {
+    atomic_long window;                 // Sekunda aktuálního okna (CLOCK_MONOTONIC_COARSE)
+    atomic_uint count;                  // Zprávy v okně
+    atomic_uint suppressed;             // Potlačené zprávy od posledního souhrnu
+} LogRateLimit;
+
+/** Minimální úroveň za běhu (log_init), makra ji kontrolují před vyhodnocením argumentů */
+extern log_level_t log_min_level;
+
 // Makro sloužící pro rychlý výpis do konzole
 #define DLOG(fmt, ...) \
     fprintf(stderr, "[T%lu] " fmt "\n", (unsigned long)pthread_self(), ##__VA_ARGS__)
@@ -33,7 +58,22 @@ typedef enum {
 int  log_init(const char *filename, log_level_t min_level);
 
 /**
- * @brief Funkce pro řádné uzavření souboru
+ * @brief Přepne logger do asynchronního režimu (volat po log_init, před startem ostatních vláken)
+ *
+ * log_msg pak jen zformátuje text do záznamu pevné délky v kruhové frontě (bez zámku), hlavičku,
+ * zápis a fflush po dávkách dělá zapisovací vlákno. Při plné frontě se záznam zahodí a započítá.
+ * @param records Počet záznamů fronty (mocnina dvou)
+ * @return 0: SUCCESS, -1: ERROR
+ */
+int log_start_async(size_t records);
+
+/**
+ * @brief Počet záznamů zahozených kvůli plné frontě asynchronního loggeru
+ */
+unsigned long log_dropped(void);
+
+/**
+ * @brief Funkce pro řádné uzavření souboru (asynchronní režim nejdřív dopíše frontu)
  */
 void log_close(void);
 
@@ -54,11 +94,33 @@ void log_msg(log_level_t level,
  */
 void log_delete(void);
 
-/* Makra – automaticky file + line */
-#define LOG_DEBUG(...) log_msg(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_INFO(...)  log_msg(LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_WARN(...)  log_msg(LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_ERROR(...) log_msg(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_FATAL(...) log_msg(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+/**
+ * @brief Omezovač místa volání: nejvýše per_second zpráv za sekundu, zbytek jen spočítá
+ *
+ * První propuštěná zpráva v novém okně předtím zapíše souhrn "potlačeno X" za předchozí okna.
+ * @param limit Stav místa volání
+ * @param per_second Limit zpráv za sekundu (0: bez omezení)
+ * @param level Úroveň souhrnu
+ * @param file Soubor místa volání
+ * @param line Řádek místa volání
+ * @return 1: zprávu zapsat, 0: potlačit
+ */
+int log_rate_allow(LogRateLimit *limit, unsigned per_second, log_level_t level, const char *file, int line);
+
+/* Zápis s omezením na místo volání: pod LOG_COMPILE_LEVEL se nepřeloží, pod log_min_level se argumenty nevyhodnotí */
+#define LOG_LIMITED(level, per_second, ...) do { \
+    if ((level) >= LOG_COMPILE_LEVEL && (level) >= log_min_level) { \
+        static LogRateLimit log_callsite_limit; \
+        if (log_rate_allow(&log_callsite_limit, (per_second), (level), __FILE__, __LINE__)) \
+            log_msg((level), __FILE__, __LINE__, __VA_ARGS__); \
+    } \
+} while (0)
+
+/* Makra – automaticky file + line, výchozí limit LOG_RATE_LIMIT na místo volání */
+#define LOG_DEBUG(...) LOG_LIMITED(LOG_DEBUG, LOG_RATE_LIMIT, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_LIMITED(LOG_INFO,  LOG_RATE_LIMIT, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_LIMITED(LOG_WARN,  LOG_RATE_LIMIT, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_LIMITED(LOG_ERROR, LOG_RATE_LIMIT, __VA_ARGS__)
+#define LOG_FATAL(...) LOG_LIMITED(LOG_FATAL, LOG_RATE_LIMIT, __VA_ARGS__)
 
 #endif
@@ -3,29 +3,116 @@
 #include "game_manager.h"
 #include "client_manager.h"
 #include "logger.h"
+#include "options.h"
+#include "trace.h"
+#include "metrics.h"
 #include <stdlib.h>
 #include <stdio.h>
 
+/**
+ * @brief Souhrn metrik do logu: čítače a doba obsluhy podle typu zprávy (sečteno přes stavy hráče)
+ */
+static void log_metrics_summary(void){
+    MetricsSnapshot *snapshot = malloc(sizeof(MetricsSnapshot));
+    if(!snapshot){
+        return;
+    }
+    metrics_snapshot(snapshot);
+
+    for(int c = 0; c < METRIC_COUNTER_COUNT; c++){
+        LOG_INFO("Metrika %s: %lu\n", metrics_counter_name((MetricCounter)c), snapshot->counters[c]);
+    }
+
+    for(int type = 0; type < MSG_COUNT; type++){
+        unsigned long count = 0, sum_ns = 0;
+        unsigned long buckets[METRICS_LATENCY_BUCKETS] = {0};
+
+        for(int status = 0; status < PLAYER_STATUS_COUNT; status++){
+            count += snapshot->latency[status][type].count;
+            sum_ns += snapshot->latency[status][type].sum_ns;
+            for(int b = 0; b < METRICS_LATENCY_BUCKETS; b++){
+                buckets[b] += snapshot->latency[status][type].buckets[b];
+            }
+        }
+        if(count == 0){
+            continue;
+        }
+
+        LOG_INFO("Obsluha %s: %lu zpráv, průměr %.1f us, p50 <= %.1f us, p99 <= %.1f us\n",
+                 msg_type_name((MessageType)type), count, sum_ns / 1000.0 / count,
+                 metrics_quantile_ns(buckets, count, 0.50) / 1000.0, metrics_quantile_ns(buckets, count, 0.99) / 1000.0);
+    }
+    free(snapshot);
+}
+
 /**
  * Vstupní bod programu, startuje server.
  */
 int main(int argc, char** argv){
+    // Přepínače (--reactor, ...), zůstanou jen poziční argumenty
+    if(options_parse(&argc, argv) != 0){
+        options_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // SIGINT/SIGTERM ukončí smyčku acceptu (maska se musí nastavit před prvním vláknem)
+    server_signals_init();
+
     // Inicializace loggeru
     log_init("server.log", LOG_DEBUG);
 
     // Vymazání dat
     log_delete();
+
+    // Zápis logu mimo vlákna klientů (--async-log)
+    if(server_options.async_log_records > 0 && log_start_async((size_t)server_options.async_log_records) != 0){
+        printf("ERROR: Nelze spustit asynchronní logger\n");
+        log_close();
+        return EXIT_FAILURE;
+    }
     LOG_INFO("Server startuje");
 
-    // Základní inicializace klientů, místností a hry
-    initialize_clients();
-    initialize_rooms();
-    game_init();
+    // Binární trasování událostí (--trace)
+    if(server_options.trace_path &&
+       trace_open(server_options.trace_path, (size_t)server_options.trace_mb * 1024 * 1024) != 0){
+        printf("ERROR: Nelze otevřít soubor trasování %s\n", server_options.trace_path);
+        log_close();
+        return EXIT_FAILURE;
+    }
+
+    // Základní inicializace klientů, místností a hry (tabulky podle --max-clients / --max-rooms)
+    if(initialize_clients(server_options.max_clients) != 0 ||
+       initialize_rooms(server_options.max_rooms) != 0 ||
+       game_init(server_options.max_rooms) != 0){
+        printf("ERROR: Nelze alokovat tabulky klientů a místností\n");
+        trace_close();
+        log_close();
+        return EXIT_FAILURE;
+    }
+
+    // Start serveru, vrátí se po SIGINT/SIGTERM
+    int threads_left = start_server(argc, argv);
+
+    // Špička souběžných her pro dimenzování --max-rooms
+    GamePoolStats pool;
+    game_pool_stats(&pool);
+    LOG_INFO("Pool her: maximum %d/%d souběžně, vydáno %lu, nedostatek %lu\n",
+             pool.high_water, pool.capacity, pool.acquired, pool.exhausted);
+
+    log_metrics_summary();
+
+    if(server_options.async_log_records > 0){
+        LOG_INFO("Logger: zahozeno %lu záznamů\n", log_dropped());
+    }
 
-    // Start serveru
-    start_server(argc, argv);
+    // Běžící klientská vlákna by zapisovala do uvolněné fronty loggeru a odmapovaného trasování -> úklid až koncem procesu
+    if(threads_left > 0){
+        LOG_WARN("Log a trasování zůstávají otevřené (%d klientských vláken běží)\n", threads_left);
+        return 0;
+    }
 
     // Řádné uzavření souboru
+    trace_close();
     LOG_INFO("Server se ukončuje");
     log_close();
 
@@ -33,5 +120,8 @@ int main(int argc, char** argv){
 }
 
 // ================== SPUŠTĚNÍ =====================
-// ./zolik_server <adresa:Optional> <port:Optional>
+// ./zolik_server [--reactor[=N]] [--out-queue=B] [--slow-client=drop|coalesce|disconnect]
+//               [--max-clients=N] [--max-rooms=N] [--backlog=N] [--seed=N] [--async-log[=N]]
+//               [--trace=SOUBOR] [--trace-size=MB] [--admin=PORT|CESTA]
+//               <adresa:Optional> <port:Optional>
 // =================================================
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "meld.h"
+
+/**
+ * @brief Hodnota karty podle bitu masky hodnot (bit b -> hodnota b + 1, bit 13 -> eso nahoře)
+ */
+static inline int meld_low_value(uint16_t mask){
+    return __builtin_ctz(mask) + 1;
+}
+
+static inline int meld_high_value(uint16_t mask){
+    return 32 - __builtin_clz(mask);
+}
+
+uint32_t meld_hash(const Card *cards, int count){
+    uint32_t hash = 2166136261u;
+
+    for(int i = 0; i < count; i++){
+        hash ^= card_face(cards[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+MeldKind meld_classify(const Card *cards, int count, Meld *meld){
+    if(count <= 0 || count > MAX_SEQUENCE_CARDS){
+        return MELD_INVALID;
+    }
+
+    Card by_suit[CARD_SUITS];           // Normální karta podle barvy (set)
+    Card by_rank[CARD_RANKS];           // Normální karta podle hodnoty (postupka)
+    Card jokers[MAX_SEQUENCE_CARDS];
+    int joker_count = 0;
+    int normal_count = 0;
+    uint16_t ranks = 0;                 // Bit r: hodnota r mezi normálními kartami
+    unsigned suits = 0;                 // Bit s: barva s mezi normálními kartami
+    int rank_dup = 0;                   // Některá hodnota dvakrát (postupka nemožná)
+    int suit_dup = 0;                   // Některá barva dvakrát (set nemožný)
+
+    // Jeden průchod: masky hodnot a barev, karty rovnou do přihrádek
+    for(int i = 0; i < count; i++){
+        Card card = cards[i];
+
+        if(card >= CARD_COUNT){
+            return MELD_INVALID;
+        }
+        if(card_is_joker(card)){
+            jokers[joker_count++] = card;
+            continue;
+        }
+
+        int rank = card_rank(card);
+        int suit = card_suit(card);
+
+        rank_dup |= (ranks >> rank) & 1;
+        suit_dup |= (suits >> suit) & 1;
+        ranks |= (uint16_t)(1u << rank);
+        suits |= 1u << suit;
+        by_rank[rank] = card;
+        by_suit[suit] = card;
+        normal_count++;
+
+        // Víc barev i víc hodnot: není set ani postupka
+        if((suits & (suits - 1)) && (ranks & (ranks - 1))){
+            return MELD_INVALID;
+        }
+    }
+
+    if(normal_count == 0){
+        return MELD_INVALID;
+    }
+
+    meld->count = (uint8_t)count;
+    meld->joker_positions = 0;
+
+    // SET - jedna hodnota, různé barvy, nejvýše 4 karty
+    if(count <= CARD_SUITS && !suit_dup && __builtin_popcount(ranks) == 1){
+        int pos = 0;
+
+        for(int suit = 0; suit < CARD_SUITS; suit++){
+            if((suits >> suit) & 1u){
+                meld->cards[pos++] = by_suit[suit];
+            }
+        }
+        for(int j = 0; j < joker_count; j++){
+            meld->joker_positions |= (uint16_t)(1u << pos);
+            meld->cards[pos++] = jokers[j];
+        }
+
+        meld->kind = MELD_SET;
+        meld->low = (uint8_t)meld_low_value(ranks);
+        return MELD_SET;
+    }
+
+    // POSTUPKA - jedna barva, různé hodnoty, mezery vyplní žolíci
+    if(__builtin_popcount(suits) != 1 || rank_dup){
+        return MELD_INVALID;
+    }
+
+    // Eso dole (bit 0 = hodnota 1), jinak eso nahoře (bit 13 = hodnota 14)
+    uint16_t mask = ranks;
+    int ace_high = 0;
+    int gaps = meld_high_value(mask) - meld_low_value(mask) + 1 - normal_count;
+
+    if(gaps > joker_count && (ranks & 1u)){
+        mask = (uint16_t)((ranks & ~1u) | (1u << (MELD_ACE_HIGH - 1)));
+        ace_high = 1;
+        gaps = meld_high_value(mask) - meld_low_value(mask) + 1 - normal_count;
+    }
+    if(gaps > joker_count){
+        return MELD_INVALID;
+    }
+
+    // Zbylé žolíky nahoru, dokud je kam (za esem nic), pak dolů, co se nevejde, zůstane nahoře
+    int low = meld_low_value(mask);
+    int high = meld_high_value(mask);
+    int spare = joker_count - gaps;
+    int top_limit = (!ace_high && (ranks & 1u)) ? CARD_RANKS : MELD_ACE_HIGH;
+    int bottom_limit = ace_high ? 2 : 1;
+
+    int up = spare < top_limit - high ? spare : top_limit - high;
+    spare -= up;
+    int down = spare < low - bottom_limit ? spare : low - bottom_limit;
+    low -= down;
+
+    // Pozice i má hodnotu low + i, normální karty na své pozice, zbytek žolíci
+    int joker_next = 0;
+    for(int pos = 0; pos < count; pos++){
+        int value = low + pos;
+        int bit = value == MELD_ACE_HIGH ? 0 : value - 1;
+
+        if(value <= MELD_ACE_HIGH && ((mask >> (value - 1)) & 1u)){
+            meld->cards[pos] = by_rank[bit];
+        } else{
+            meld->joker_positions |= (uint16_t)(1u << pos);
+            meld->cards[pos] = jokers[joker_next++];
+        }
+    }
+
+    meld->kind = MELD_SEQUENCE;
+    meld->low = (uint8_t)low;
+    return MELD_SEQUENCE;
+}
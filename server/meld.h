@@ -0,0 +1,46 @@
+#ifndef MELD_H
+#define MELD_H
+
+#include "config.h"
+#include "card.h"
+
+#define MELD_ACE_HIGH 14                // Hodnota esa nad králem
+
+// Druh vyložené kombinace
+typedef enum{
+    MELD_INVALID = 0,
+    MELD_SET,                           // Stejná hodnota, každá barva nejvýše jednou (max. 4 karty)
+    MELD_SEQUENCE                       // Stejná barva, navazující hodnoty, eso dole nebo nahoře
+} MeldKind;
+
+// Výsledek klasifikace: karty v kanonickém pořadí
+typedef struct{
+    MeldKind kind;
+    uint8_t count;
+    Card cards[MAX_SEQUENCE_CARDS];     // Set: podle barvy, žolíci na konci. Postupka: vzestupně, žolíci v mezerách
+    uint16_t joker_positions;           // Bit i: cards[i] je žolík
+    uint8_t low;                        // Hodnota první pozice (set: hodnota setu, postupka: 1..14)
+} Meld;
+
+/**
+ * @brief Rozpozná kombinaci z multimnožiny karet (pořadí vstupu nehraje roli), O(n) přes bitové masky
+ *
+ * Set má přednost před postupkou. Minimální počet karet nehlídá (UNLO vyžaduje 3, ADDC přikládá k existující).
+ * @param cards Karty
+ * @param count Počet karet (nejvýše MAX_SEQUENCE_CARDS)
+ * @param meld Výsledek (při MELD_INVALID nedefinovaný)
+ * @return druh kombinace, MELD_INVALID: karty netvoří set ani postupku
+ */
+MeldKind meld_classify(const Card *cards, int count, Meld *meld);
+
+/**
+ * @brief Otisk obsahu kombinace v daném pořadí (FNV-1a přes kódy karet, balíček nehraje roli)
+ *
+ * Slouží ke zpětně kompatibilnímu hledání kombinace podle řetězce kódů (starší klienti v ADDC).
+ * @param cards Karty
+ * @param count Počet karet
+ * @return otisk
+ */
+uint32_t meld_hash(const Card *cards, int count);
+
+#endif
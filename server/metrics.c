@@ -0,0 +1,123 @@
+#include "metrics.h"
+#include <string.h>
+#include <time.h>
+
+// Oddíl čítačů; vlákno dostane vlastní při prvním zápisu (reaktory a časovač bez sdílení cache line)
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))){
+    atomic_ulong counters[METRIC_COUNTER_COUNT];
+    MetricsLatency latency[PLAYER_STATUS_COUNT][MSG_COUNT];
+} MetricsShard;
+
+static MetricsShard metrics_shards[METRICS_SHARDS];
+static atomic_uint metrics_next_shard = 0;
+static __thread MetricsShard *metrics_local = NULL;
+
+static const char *counter_names[METRIC_COUNTER_COUNT] = {
+#define METRICS_NAME_ENTRY(name, label) [METRIC_##name] = label,
+    METRICS_COUNTERS(METRICS_NAME_ENTRY)
+#undef METRICS_NAME_ENTRY
+};
+
+/**
+ * @brief Oddíl volajícího vlákna; vláken je víc než oddílů (vlákno na klienta) -> přidělují se dokola
+ */
+static MetricsShard* metrics_shard(void){
+    if(!metrics_local){
+        unsigned index = atomic_fetch_add_explicit(&metrics_next_shard, 1, memory_order_relaxed);
+        metrics_local = &metrics_shards[index % METRICS_SHARDS];
+    }
+    return metrics_local;
+}
+
+uint64_t metrics_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_add(MetricCounter counter, unsigned long value){
+    atomic_fetch_add_explicit(&metrics_shard()->counters[counter], value, memory_order_relaxed);
+}
+
+void metrics_record_latency(int status, MessageType type, uint64_t elapsed_ns){
+    if(status < 0 || status >= PLAYER_STATUS_COUNT || type < 0 || type >= MSG_COUNT){
+        return;
+    }
+
+    // Koš podle nejvyššího bitu: 0 pod 2^MIN_SHIFT ns, dál vždy dvojnásobek
+    int bucket = 0;
+    if(elapsed_ns >> METRICS_LATENCY_MIN_SHIFT){
+        bucket = 64 - __builtin_clzll(elapsed_ns) - METRICS_LATENCY_MIN_SHIFT;
+        if(bucket > METRICS_LATENCY_BUCKETS - 1){
+            bucket = METRICS_LATENCY_BUCKETS - 1;
+        }
+    }
+
+    MetricsLatency *latency = &metrics_shard()->latency[status][type];
+    atomic_fetch_add_explicit(&latency->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&latency->sum_ns, elapsed_ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&latency->buckets[bucket], 1, memory_order_relaxed);
+}
+
+void metrics_snapshot(MetricsSnapshot *snapshot){
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for(int s = 0; s < METRICS_SHARDS; s++){
+        MetricsShard *shard = &metrics_shards[s];
+
+        for(int c = 0; c < METRIC_COUNTER_COUNT; c++){
+            snapshot->counters[c] += atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
+        }
+        for(int status = 0; status < PLAYER_STATUS_COUNT; status++){
+            for(int type = 0; type < MSG_COUNT; type++){
+                MetricsLatency *latency = &shard->latency[status][type];
+                unsigned long count = atomic_load_explicit(&latency->count, memory_order_relaxed);
+                if(count == 0){
+                    continue;
+                }
+
+                snapshot->latency[status][type].count += count;
+                snapshot->latency[status][type].sum_ns += atomic_load_explicit(&latency->sum_ns, memory_order_relaxed);
+                for(int b = 0; b < METRICS_LATENCY_BUCKETS; b++){
+                    snapshot->latency[status][type].buckets[b] +=
+                        atomic_load_explicit(&latency->buckets[b], memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
+
+uint64_t metrics_bucket_upper_ns(int bucket){
+    if(bucket >= METRICS_LATENCY_BUCKETS - 1){
+        return UINT64_MAX;
+    }
+    return 1ULL << (METRICS_LATENCY_MIN_SHIFT + bucket);
+}
+
+uint64_t metrics_quantile_ns(const unsigned long *buckets, unsigned long count, double quantile){
+    if(count == 0){
+        return 0;
+    }
+
+    // Pořadí vzorku kvantilu (1..count)
+    unsigned long rank = (unsigned long)(quantile * (double)count);
+    if(rank < count && (double)rank < quantile * (double)count){
+        rank++;
+    }
+    if(rank == 0){
+        rank = 1;
+    }
+
+    unsigned long seen = 0;
+    for(int b = 0; b < METRICS_LATENCY_BUCKETS; b++){
+        seen += buckets[b];
+        if(seen >= rank){
+            return metrics_bucket_upper_ns(b);
+        }
+    }
+    return metrics_bucket_upper_ns(METRICS_LATENCY_BUCKETS - 1);
+}
+
+const char* metrics_counter_name(MetricCounter counter){
+    return counter >= 0 && counter < METRIC_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
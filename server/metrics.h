@@ -0,0 +1,90 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "config.h"
+#include "protocol.h"
+#include "client_manager.h"
+
+// Čítače serveru: X(název, název pro export)
+#define METRICS_COUNTERS(X) \
+    X(BYTES_IN,           "bytes_in") \
+    X(BYTES_OUT,          "bytes_out") \
+    X(FRAMES_IN,          "frames_in") \
+    X(FRAMES_OUT,         "frames_out") \
+    X(INVALID_FRAMES,     "invalid_frames") \
+    X(GARBAGE_RESYNCS,    "garbage_resyncs") \
+    X(HEARTBEAT_TIMEOUTS, "heartbeat_timeouts") \
+    X(RECONNECTS,         "reconnects")
+
+typedef enum{
+#define METRICS_ENUM_ENTRY(name, label) METRIC_##name,
+    METRICS_COUNTERS(METRICS_ENUM_ENTRY)
+#undef METRICS_ENUM_ENTRY
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+// Histogram doby obsluhy jedné zprávy; koš i počítá dobu pod 2^(METRICS_LATENCY_MIN_SHIFT + i) ns, poslední zbytek
+typedef struct{
+    atomic_ulong count;
+    atomic_ulong sum_ns;
+    atomic_ulong buckets[METRICS_LATENCY_BUCKETS];
+} MetricsLatency;
+
+// Součet všech oddílů v okamžiku volání metrics_snapshot (hodnoty od startu serveru)
+typedef struct{
+    unsigned long counters[METRIC_COUNTER_COUNT];
+    struct{
+        unsigned long count;
+        unsigned long sum_ns;
+        unsigned long buckets[METRICS_LATENCY_BUCKETS];
+    } latency[PLAYER_STATUS_COUNT][MSG_COUNT];
+} MetricsSnapshot;
+
+/**
+ * @brief Přičte hodnotu k čítači v oddílu volajícího vlákna (bez zámku)
+ * @param counter Čítač
+ * @param value Přírůstek
+ */
+void metrics_add(MetricCounter counter, unsigned long value);
+
+/**
+ * @brief Zapíše dobu obsluhy zprávy do histogramu (typ zprávy × stav hráče při příjmu)
+ * @param status Stav hráče před obsluhou
+ * @param type Typ zprávy
+ * @param elapsed_ns Doba od naparsování zprávy po vložení poslední odpovědi
+ */
+void metrics_record_latency(int status, MessageType type, uint64_t elapsed_ns);
+
+/**
+ * @brief Sečte oddíly všech vláken (čtení bez zámku, jednotlivé hodnoty jsou atomické)
+ * @param snapshot Výstup
+ */
+void metrics_snapshot(MetricsSnapshot *snapshot);
+
+/**
+ * @brief Horní mez koše histogramu v ns (poslední koš: UINT64_MAX)
+ */
+uint64_t metrics_bucket_upper_ns(int bucket);
+
+/**
+ * @brief Odhad kvantilu z košů histogramu (horní mez koše, do kterého kvantil padne)
+ * @param buckets Koše histogramu
+ * @param count Počet vzorků
+ * @param quantile Kvantil (0..1)
+ * @return Doba v ns, 0: bez vzorků
+ */
+uint64_t metrics_quantile_ns(const unsigned long *buckets, unsigned long count, double quantile);
+
+/**
+ * @brief Název čítače pro export
+ */
+const char* metrics_counter_name(MetricCounter counter);
+
+/**
+ * @brief Monotónní čas v ns pro měření doby obsluhy
+ */
+uint64_t metrics_now_ns(void);
+
+#endif
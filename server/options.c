@@ -0,0 +1,169 @@
+#include "options.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+ServerOptions server_options = {
+    .reactor_threads = 0,
+    .out_queue_bytes = OUT_QUEUE_MAX_BYTES,
+    .slow_client_policy = SLOW_CLIENT_COALESCE,
+    .max_clients = DEFAULT_MAX_CLIENTS,
+    .max_rooms = DEFAULT_MAX_ROOMS,
+    .listen_backlog = LISTEN_BACKLOG,
+    .fixed_seed = 0,
+    .game_seed = 0,
+    .async_log_records = 0,
+    .trace_path = NULL,
+    .trace_mb = TRACE_DEFAULT_MB,
+    .admin_endpoint = NULL,
+};
+
+/**
+ * @brief Převede řetězec na celé číslo v daném rozsahu
+ * @return 0: SUCCESS, -1: ERROR
+ */
+static int parse_int(const char *str, long min, long max, int *out){
+    if(!str || *str == '\0'){
+        return -1;
+    }
+
+    char *endptr;
+    errno = 0;
+    long value = strtol(str, &endptr, 10);
+    if(errno != 0 || *endptr != '\0' || value < min || value > max){
+        return -1;
+    }
+
+    *out = (int)value;
+    return 0;
+}
+
+int options_parse(int *argc, char **argv){
+    int positional = 1;
+
+    for(int i = 1; i < *argc; i++){
+        const char *arg = argv[i];
+
+        // Poziční argumenty ponech na začátku pole
+        if(strncmp(arg, "--", 2) != 0){
+            argv[positional++] = argv[i];
+            continue;
+        }
+
+        const char *name = arg + 2;
+        const char *value = strchr(name, '=');
+        size_t name_len = value ? (size_t)(value - name) : strlen(name);
+        if(value){
+            value++;
+        }
+
+        if(name_len == strlen("reactor") && strncmp(name, "reactor", name_len) == 0){
+            // Bez hodnoty -> jeden reaktor na jádro
+            if(!value){
+                long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                server_options.reactor_threads = cpus > 0 ? (int)cpus : 1;
+                if(server_options.reactor_threads > MAX_REACTOR_THREADS){
+                    server_options.reactor_threads = MAX_REACTOR_THREADS;
+                }
+            } else if(parse_int(value, 0, MAX_REACTOR_THREADS, &server_options.reactor_threads) != 0){
+                printf("ERROR: Neplatný počet reaktorů '%s'\n", value);
+                return -1;
+            }
+        } else if(name_len == strlen("out-queue") && strncmp(name, "out-queue", name_len) == 0){
+            // Fronta musí pojmout alespoň jednu zprávu maximální délky
+            if(parse_int(value, HEADER_LEN + MAX_MESSAGE_LEN, 64 * 1024 * 1024, &server_options.out_queue_bytes) != 0){
+                printf("ERROR: Neplatná velikost odchozí fronty '%s'\n", value ? value : "");
+                return -1;
+            }
+        } else if(name_len == strlen("slow-client") && strncmp(name, "slow-client", name_len) == 0){
+            if(value && strcmp(value, "drop") == 0){
+                server_options.slow_client_policy = SLOW_CLIENT_DROP;
+            } else if(value && strcmp(value, "coalesce") == 0){
+                server_options.slow_client_policy = SLOW_CLIENT_COALESCE;
+            } else if(value && strcmp(value, "disconnect") == 0){
+                server_options.slow_client_policy = SLOW_CLIENT_DISCONNECT;
+            } else{
+                printf("ERROR: Neplatná politika pro pomalé klienty '%s'\n", value ? value : "");
+                return -1;
+            }
+        } else if(name_len == strlen("max-clients") && strncmp(name, "max-clients", name_len) == 0){
+            if(parse_int(value, 1, MAX_TABLE_CAPACITY, &server_options.max_clients) != 0){
+                printf("ERROR: Neplatný počet klientů '%s'\n", value ? value : "");
+                return -1;
+            }
+        } else if(name_len == strlen("max-rooms") && strncmp(name, "max-rooms", name_len) == 0){
+            if(parse_int(value, 1, MAX_TABLE_CAPACITY, &server_options.max_rooms) != 0){
+                printf("ERROR: Neplatný počet místností '%s'\n", value ? value : "");
+                return -1;
+            }
+        } else if(name_len == strlen("backlog") && strncmp(name, "backlog", name_len) == 0){
+            if(parse_int(value, 1, 65535, &server_options.listen_backlog) != 0){
+                printf("ERROR: Neplatná délka fronty listen '%s'\n", value ? value : "");
+                return -1;
+            }
+        } else if(name_len == strlen("seed") && strncmp(name, "seed", name_len) == 0){
+            char *endptr;
+            errno = 0;
+            unsigned long long seed = value && *value ? strtoull(value, &endptr, 10) : 0;
+            if(!value || *value == '\0' || *value == '-' || errno != 0 || *endptr != '\0'){
+                printf("ERROR: Neplatný seed '%s'\n", value ? value : "");
+                return -1;
+            }
+            server_options.fixed_seed = 1;
+            server_options.game_seed = (uint64_t)seed;
+        } else if(name_len == strlen("async-log") && strncmp(name, "async-log", name_len) == 0){
+            // Bez hodnoty -> výchozí velikost fronty
+            int records = LOG_RING_RECORDS;
+            if(value && (parse_int(value, 2, 1 << 20, &records) != 0 || (records & (records - 1)) != 0)){
+                printf("ERROR: Neplatná velikost fronty loggeru '%s' (mocnina dvou)\n", value);
+                return -1;
+            }
+            server_options.async_log_records = records;
+        } else if(name_len == strlen("trace") && strncmp(name, "trace", name_len) == 0){
+            if(!value || *value == '\0'){
+                printf("ERROR: Chybí soubor trasování (--trace=soubor)\n");
+                return -1;
+            }
+            server_options.trace_path = value;
+        } else if(name_len == strlen("trace-size") && strncmp(name, "trace-size", name_len) == 0){
+            if(parse_int(value, 1, TRACE_MAX_MB, &server_options.trace_mb) != 0){
+                printf("ERROR: Neplatná velikost trasování '%s' (1-%d MB)\n", value ? value : "", TRACE_MAX_MB);
+                return -1;
+            }
+        } else if(name_len == strlen("admin") && strncmp(name, "admin", name_len) == 0){
+            // Cesta (obsahuje '/') -> UNIX socket, jinak port na loopbacku
+            int port;
+            if(!value || (!strchr(value, '/') && parse_int(value, 1, 65535, &port) != 0) ||
+               strlen(value) >= ADMIN_PATH_MAX){
+                printf("ERROR: Neplatné správcovské rozhraní '%s' (port nebo cesta k UNIX socketu)\n", value ? value : "");
+                return -1;
+            }
+            server_options.admin_endpoint = value;
+        } else{
+            printf("ERROR: Neznámý přepínač '%s'\n", arg);
+            return -1;
+        }
+    }
+
+    argv[positional] = NULL;
+    *argc = positional;
+    return 0;
+}
+
+void options_usage(const char *prog){
+    printf("Použití: %s [přepínače] <adresa:Optional> <port:Optional>\n", prog);
+    printf("  --reactor[=N]    epoll reaktory místo vlákna na klienta (bez N: počet jader, max %d)\n", MAX_REACTOR_THREADS);
+    printf("  --out-queue=B    limit odchozí fronty klienta v bajtech (výchozí %d)\n", OUT_QUEUE_MAX_BYTES);
+    printf("  --slow-client=P  plná fronta: drop | coalesce (výchozí) | disconnect\n");
+    printf("  --max-clients=N  kapacita tabulky klientů (výchozí %d)\n", DEFAULT_MAX_CLIENTS);
+    printf("  --max-rooms=N    kapacita tabulky místností (výchozí %d)\n", DEFAULT_MAX_ROOMS);
+    printf("  --backlog=N      délka fronty listen() (výchozí %d)\n", LISTEN_BACKLOG);
+    printf("  --seed=N         pevný seed míchání (seed hry = N + ID místnosti), jinak ze systému\n");
+    printf("  --async-log[=N]  logger se zapisovacím vláknem, fronta N záznamů (výchozí %d)\n", LOG_RING_RECORDS);
+    printf("  --trace=SOUBOR   binární trasování událostí do kruhového souboru (zolik_tracedump)\n");
+    printf("  --trace-size=MB  horní mez velikosti souboru trasování (výchozí %d)\n", TRACE_DEFAULT_MB);
+    printf("  --admin=PORT|CESTA  Prometheus /metrics a JSON /status na 127.0.0.1:PORT nebo UNIX socketu\n");
+}
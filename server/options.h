@@ -0,0 +1,42 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "outbound.h"
+
+// Struktura běhového nastavení serveru (přepínače z příkazové řádky)
+typedef struct{
+    int reactor_threads;        // 0: vlákno na klienta, >0: počet epoll reaktorů
+    int out_queue_bytes;        // Limit odchozí fronty klienta v bajtech
+    SlowClientPolicy slow_client_policy;    // Co dělat s klientem, který nestíhá číst
+    int max_clients;            // Kapacita tabulky klientů
+    int max_rooms;              // Kapacita tabulky místností
+    int listen_backlog;         // Délka fronty nepřijatých spojení (listen)
+    int fixed_seed;             // 1: hry míchají z game_seed (reprodukovatelná rozdání), 0: seed ze systému
+    uint64_t game_seed;         // Základ seedu her (seed hry = game_seed + ID místnosti)
+    int async_log_records;      // 0: synchronní logger, >0: asynchronní se frontou o tolika záznamech
+    const char *trace_path;     // Soubor binárního trasování (NULL: vypnuto)
+    int trace_mb;               // Horní mez velikosti souboru trasování v MB
+    const char *admin_endpoint; // Port (127.0.0.1) nebo cesta UNIX socketu správcovského rozhraní (NULL: vypnuto)
+} ServerOptions;
+
+/** Aktuální běhové nastavení serveru */
+extern ServerOptions server_options;
+
+/**
+ * @brief Zpracuje přepínače "--nazev[=hodnota]" a odebere je z argv, poziční argumenty (adresa, port) ponechá
+ * @param argc Ukazatel na počet argumentů (po návratu počet pozičních argumentů)
+ * @param argv Pole argumentů z cmd (přeuspořádá se na místě)
+ * @return 0: SUCCESS, -1: neznámý nebo nevalidní přepínač
+ */
+int options_parse(int *argc, char **argv);
+
+/**
+ * @brief Vypíše nápovědu k použití serveru
+ * @param prog Název spustitelného souboru (argv[0])
+ */
+void options_usage(const char *prog);
+
+#endif
@@ -0,0 +1,533 @@
+#include "outbound.h"
+#include "protocol.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define OUT_QUEUE_MASK (OUT_QUEUE_MAX_FRAMES - 1)
+
+#if (OUT_QUEUE_MAX_FRAMES & OUT_QUEUE_MASK) != 0
+#error "OUT_QUEUE_MAX_FRAMES must be a power of two"
+#endif
+
+static int writer_epoll_fd = -1;
+static int writer_wake_fd = -1;                 // eventfd pro ukončení (v epollu s data.ptr = NULL)
+static pthread_t writer;
+static size_t queue_max_bytes = OUT_QUEUE_MAX_BYTES;
+static SlowClientPolicy slow_policy = SLOW_CLIENT_COALESCE;
+
+// Typy zpráv, u kterých stačí doručit poslední verzi (snímky stavu)
+static const char *coalescible_types[] = { STAT, RLIS, RINF, PRDY, PING };
+
+// Souhrn všech front pro správcovské rozhraní (mění se pod zámkem fronty, čte bez zámku)
+static atomic_ulong total_bytes = 0;
+static atomic_ulong total_frames = 0;
+static atomic_ulong peak_bytes = 0;
+static atomic_ulong total_dropped = 0;
+static atomic_ulong total_coalesced = 0;
+
+/**
+ * @brief Promítne změnu obsahu fronty do souhrnu (záporné hodnoty odečítají)
+ */
+static void queue_account(const OutQueue *q, long bytes, long frames){
+    atomic_fetch_add_explicit(&total_bytes, (unsigned long)bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_frames, (unsigned long)frames, memory_order_relaxed);
+
+    unsigned long peak = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    while(q->bytes > peak &&
+          !atomic_compare_exchange_weak_explicit(&peak_bytes, &peak, q->bytes, memory_order_relaxed, memory_order_relaxed)){
+    }
+}
+
+/**
+ * @brief Celková délka částí těla zprávy
+ */
+static size_t parts_length(const struct iovec *parts, int count){
+    size_t len = 0;
+    for(int i = 0; i < count; i++){
+        len += parts[i].iov_len;
+    }
+    return len;
+}
+
+OutFrame *out_frame_create_v(const char *type_msg, const struct iovec *parts, int count){
+    size_t msg_len = parts_length(parts, count);
+    if(msg_len > MAX_MESSAGE_LEN){
+        return NULL;
+    }
+
+    OutFrame *frame = (OutFrame*)malloc(sizeof(OutFrame) + HEADER_LEN + msg_len);
+    if(!frame){
+        return NULL;
+    }
+    atomic_init(&frame->refs, 1);
+    frame->len = HEADER_LEN + msg_len;
+    build_header(frame->data, type_msg, msg_len);
+
+    char *ptr = frame->data + HEADER_LEN;
+    for(int i = 0; i < count; i++){
+        memcpy(ptr, parts[i].iov_base, parts[i].iov_len);
+        ptr += parts[i].iov_len;
+    }
+    return frame;
+}
+
+OutFrame *out_frame_create(const char *type_msg, const char *message, size_t msg_len){
+    struct iovec part = { .iov_base = (void*)message, .iov_len = msg_len };
+    return out_frame_create_v(type_msg, &part, 1);
+}
+
+void out_frame_release(OutFrame *frame){
+    if(frame && atomic_fetch_sub(&frame->refs, 1) == 1){
+        free(frame);
+    }
+}
+
+void outbound_stats(OutboundStats *stats){
+    stats->bytes = atomic_load_explicit(&total_bytes, memory_order_relaxed);
+    stats->frames = atomic_load_explicit(&total_frames, memory_order_relaxed);
+    stats->peak_bytes = atomic_load_explicit(&peak_bytes, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&total_dropped, memory_order_relaxed);
+    stats->coalesced = atomic_load_explicit(&total_coalesced, memory_order_relaxed);
+}
+
+void out_queue_init(OutQueue *q){
+    memset(q, 0, sizeof(OutQueue));
+    pthread_mutex_init(&q->lock, NULL);
+    q->fd = -1;
+}
+
+/**
+ * @brief Uvolní všechny neodeslané zprávy
+ */
+static void queue_clear_locked(OutQueue *q){
+    queue_account(q, -(long)q->bytes, -(long)(q->tail - q->head));
+    while(q->head != q->tail){
+        out_frame_release(q->frames[q->head & OUT_QUEUE_MASK]);
+        q->head++;
+    }
+    q->head = q->tail = 0;
+    q->head_off = 0;
+    q->bytes = 0;
+}
+
+/**
+ * @brief Odebere socket z writer epollu (pokud čeká na EPOLLOUT)
+ */
+static void queue_disarm_locked(OutQueue *q){
+    if(q->armed && q->fd >= 0){
+        epoll_ctl(writer_epoll_fd, EPOLL_CTL_DEL, q->fd, NULL);
+    }
+    q->armed = 0;
+}
+
+/**
+ * @brief Spojení je nepoužitelné -> zahoď frontu, další zprávy ignoruj až do nového attach
+ */
+static void queue_break_locked(OutQueue *q){
+    queue_disarm_locked(q);
+    queue_clear_locked(q);
+    q->broken = 1;
+}
+
+/**
+ * @brief Požádá writer vlákno o dopsání fronty, až půjde do socketu zapisovat
+ */
+static void queue_arm_locked(OutQueue *q){
+    if(q->armed){
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLOUT | EPOLLONESHOT;
+    ev.data.ptr = q;
+
+    // Socket už může být v epollu z dřívějška (ONESHOT ho jen deaktivuje)
+    if(epoll_ctl(writer_epoll_fd, EPOLL_CTL_MOD, q->fd, &ev) < 0){
+        if(errno != ENOENT || epoll_ctl(writer_epoll_fd, EPOLL_CTL_ADD, q->fd, &ev) < 0){
+            LOG_ERROR("Nelze zaregistrovat fd=%d ve writer epollu (errno=%d)\n", q->fd, errno);
+            queue_break_locked(q);
+            return;
+        }
+    }
+    q->armed = 1;
+}
+
+/**
+ * @brief Posune začátek fronty o odeslané bajty
+ */
+static void queue_consume_locked(OutQueue *q, size_t sent){
+    unsigned head = q->head;
+    q->bytes -= sent;
+    long consumed = (long)sent;
+
+    while(sent > 0){
+        OutFrame *frame = q->frames[q->head & OUT_QUEUE_MASK];
+        size_t rest = frame->len - q->head_off;
+
+        if(sent < rest){
+            q->head_off += sent;
+            break;
+        }
+        sent -= rest;
+        out_frame_release(frame);
+        q->head++;
+        q->head_off = 0;
+    }
+    queue_account(q, -consumed, -(long)(q->head - head));
+}
+
+/**
+ * @brief Neblokující zápis co největší části fronty (jedno sendmsg na dávku zpráv)
+ * @return 0: fronta prázdná, 1: socket je plný, -1: chyba spojení
+ */
+static int queue_flush_locked(OutQueue *q){
+    while(q->head != q->tail){
+        struct iovec iov[OUT_FLUSH_IOV];
+        int iovcnt = 0;
+
+        for(unsigned i = q->head; i != q->tail && iovcnt < OUT_FLUSH_IOV; i++, iovcnt++){
+            OutFrame *frame = q->frames[i & OUT_QUEUE_MASK];
+            size_t off = (i == q->head) ? q->head_off : 0;
+            iov[iovcnt].iov_base = frame->data + off;
+            iov[iovcnt].iov_len = frame->len - off;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent = sendmsg(q->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(sent < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK){
+                return 1;
+            }
+            return -1;
+        }
+        metrics_add(METRIC_BYTES_OUT, (unsigned long)sent);
+        queue_consume_locked(q, sent);
+    }
+    return 0;
+}
+
+/**
+ * @brief Samostatný snímek (STAT, RLIS, ...), který nahrazuje starší verzi a na jiných zprávách nezávisí
+ */
+static int frame_coalescible(const char *type_msg){
+    for(size_t i = 0; i < sizeof(coalescible_types) / sizeof(coalescible_types[0]); i++){
+        if(memcmp(type_msg, coalescible_types[i], MSG_TYPE_LEN) == 0){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Zapíše snímek na místo nejnovějšího dosud vůbec neodeslaného snímku stejného typu
+ * Za nahrazovaným smí ve frontě být jen jiné snímky: DLTA, TURN, CRDS, ... navazují na starší stav
+ * a nový snímek by je předběhl (DLTA by pak klient aplikoval na verzi, kterou už nemá).
+ * @return 1: nahrazeno (zpráva je ve frontě), 0: není co nahradit
+ */
+static int queue_coalesce_locked(OutQueue *q, OutFrame *frame){
+    const char *type_msg = frame->data + MAGIC_LEN;
+    if(!frame_coalescible(type_msg)){
+        return 0;
+    }
+
+    // Rozepsanou první zprávu nelze nahradit
+    unsigned first = q->head + (q->head_off > 0 ? 1 : 0);
+    for(unsigned i = q->tail; i != first; i--){
+        OutFrame *old = q->frames[(i - 1) & OUT_QUEUE_MASK];
+        if(!frame_coalescible(old->data + MAGIC_LEN)){
+            return 0;
+        }
+        if(memcmp(old->data + MAGIC_LEN, type_msg, MSG_TYPE_LEN) != 0){
+            continue;
+        }
+
+        atomic_fetch_add(&frame->refs, 1);
+        q->frames[(i - 1) & OUT_QUEUE_MASK] = frame;
+        q->bytes = q->bytes - old->len + frame->len;
+        queue_account(q, (long)frame->len - (long)old->len, 0);
+        out_frame_release(old);
+        q->coalesced++;
+        atomic_fetch_add_explicit(&total_coalesced, 1, memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Zařadí zprávu na konec fronty podle politiky pro pomalé klienty
+ * @param skip Počet bajtů zprávy, které už byly odeslány (jen pro prázdnou frontu)
+ */
+static int queue_append_locked(OutQueue *q, OutFrame *frame, size_t skip){
+    if(q->tail - q->head >= OUT_QUEUE_MAX_FRAMES || q->bytes + frame->len - skip > queue_max_bytes){
+        if(slow_policy == SLOW_CLIENT_DROP){
+            q->dropped++;
+            atomic_fetch_add_explicit(&total_dropped, 1, memory_order_relaxed);
+            TRACE(OUT_DROP, -1, -1, trace_fourcc(frame->data + MAGIC_LEN), frame->len - HEADER_LEN, q->fd);
+            LOG_LIMITED(LOG_WARN, LOG_RATE_LIMIT_CLIENT, "Plná odchozí fronta fd=%d, zpráva zahozena (celkem %lu)\n", q->fd, q->dropped);
+            return -2;
+        }
+        if(slow_policy == SLOW_CLIENT_COALESCE && queue_coalesce_locked(q, frame)){
+            // Délka snímku se mezi verzemi mění jen málo -> limit bajtů se tu znovu nekontroluje
+            return 0;
+        }
+
+        // SLOW_CLIENT_DISCONNECT, případně nelze nic nahradit -> klient by měl nekonzistentní stav
+        LOG_WARN("Pomalý klient fd=%d (%zu B ve frontě), odpojuji\n", q->fd, q->bytes);
+        shutdown(q->fd, SHUT_RDWR);
+        queue_break_locked(q);
+        return -3;
+    }
+
+    atomic_fetch_add(&frame->refs, 1);
+    if(q->head == q->tail){
+        q->head_off = skip;
+    }
+    q->frames[q->tail & OUT_QUEUE_MASK] = frame;
+    q->tail++;
+    q->bytes += frame->len - skip;
+    queue_account(q, (long)(frame->len - skip), 1);
+
+    queue_arm_locked(q);
+    return q->broken ? -3 : 0;
+}
+
+int out_queue_push(OutQueue *q, OutFrame *frame){
+    pthread_mutex_lock(&q->lock);
+
+    if(q->fd < 0 || q->broken){
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    TRACE(MSG_OUT, -1, -1, trace_fourcc(frame->data + MAGIC_LEN), frame->len - HEADER_LEN, q->fd);
+    metrics_add(METRIC_FRAMES_OUT, 1);
+
+    size_t skip = 0;
+    if(q->head == q->tail){
+        // Prázdná fronta -> zkus rovnou socket
+        ssize_t sent;
+        do{
+            sent = send(q->fd, frame->data, frame->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while(sent < 0 && errno == EINTR);
+        if(sent > 0){
+            metrics_add(METRIC_BYTES_OUT, (unsigned long)sent);
+        }
+
+        if(sent == (ssize_t)frame->len){
+            pthread_mutex_unlock(&q->lock);
+            return 0;
+        }
+        if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+            queue_break_locked(q);
+            pthread_mutex_unlock(&q->lock);
+            return -1;
+        }
+        skip = sent > 0 ? (size_t)sent : 0;
+    }
+
+    int result = queue_append_locked(q, frame, skip);
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int out_queue_sendv(OutQueue *q, const char *type_msg, const struct iovec *parts, int count){
+    size_t msg_len = parts_length(parts, count);
+    if(msg_len > MAX_MESSAGE_LEN || count > OUT_SEND_MAX_PARTS){
+        return -2;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    if(q->fd < 0 || q->broken){
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    TRACE(MSG_OUT, -1, -1, trace_fourcc(type_msg), msg_len, q->fd);
+    metrics_add(METRIC_FRAMES_OUT, 1);
+
+    size_t skip = 0;
+    if(q->head == q->tail){
+        // Prázdná fronta -> hlavička na zásobníku + části těla jedním zápisem, bez alokace a kopírování
+        char header_buffer[HEADER_LEN];
+        build_header(header_buffer, type_msg, msg_len);
+
+        struct iovec iov[1 + OUT_SEND_MAX_PARTS];
+        int iovcnt = 0;
+        iov[iovcnt].iov_base = header_buffer;
+        iov[iovcnt++].iov_len = HEADER_LEN;
+        for(int i = 0; i < count; i++){
+            if(parts[i].iov_len > 0){
+                iov[iovcnt++] = parts[i];
+            }
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t sent;
+        do{
+            sent = sendmsg(q->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while(sent < 0 && errno == EINTR);
+        if(sent > 0){
+            metrics_add(METRIC_BYTES_OUT, (unsigned long)sent);
+        }
+
+        if(sent == (ssize_t)(HEADER_LEN + msg_len)){
+            pthread_mutex_unlock(&q->lock);
+            return 0;
+        }
+        if(sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+            queue_break_locked(q);
+            pthread_mutex_unlock(&q->lock);
+            return -1;
+        }
+        skip = sent > 0 ? (size_t)sent : 0;
+    }
+
+    // Socket je plný nebo fronta neprázdná -> zprávu je nutné uložit (části se slijí do jedné kopie)
+    OutFrame *frame = out_frame_create_v(type_msg, parts, count);
+    if(!frame){
+        pthread_mutex_unlock(&q->lock);
+        return -2;
+    }
+    int result = queue_append_locked(q, frame, skip);
+    pthread_mutex_unlock(&q->lock);
+
+    out_frame_release(frame);
+    return result;
+}
+
+int out_queue_send(OutQueue *q, const char *type_msg, const char *message, size_t msg_len){
+    struct iovec part = { .iov_base = (void*)message, .iov_len = msg_len };
+    return out_queue_sendv(q, type_msg, &part, 1);
+}
+
+void out_queue_attach(OutQueue *q, int fd){
+    pthread_mutex_lock(&q->lock);
+    queue_disarm_locked(q);
+    queue_clear_locked(q);
+    q->fd = fd;
+    q->broken = 0;
+    pthread_mutex_unlock(&q->lock);
+}
+
+void out_queue_detach(OutQueue *q, int fd){
+    pthread_mutex_lock(&q->lock);
+    if(q->fd == fd){
+        queue_disarm_locked(q);
+        queue_clear_locked(q);
+        q->fd = -1;
+        q->broken = 0;
+    }
+    pthread_mutex_unlock(&q->lock);
+}
+
+size_t out_queue_pending(OutQueue *q){
+    pthread_mutex_lock(&q->lock);
+    size_t bytes = q->bytes;
+    pthread_mutex_unlock(&q->lock);
+    return bytes;
+}
+
+/**
+ * @brief Writer vlákno: dopisuje fronty, jejichž socket je znovu zapisovatelný
+ */
+static void* writer_thread(void *arg){
+    (void)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    LOG_INFO("Writer vlákno spuštěno (epoll fd=%d)\n", writer_epoll_fd);
+
+    while(1){
+        int n = epoll_wait(writer_epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            LOG_ERROR("epoll_wait (writer) selhal (errno=%d)\n", errno);
+            break;
+        }
+
+        for(int i = 0; i < n; i++){
+            // Probuzení z outbound_stop -> neodeslané zprávy zůstanou, proces končí
+            if(!events[i].data.ptr){
+                return NULL;
+            }
+            OutQueue *q = (OutQueue*)events[i].data.ptr;
+
+            pthread_mutex_lock(&q->lock);
+            q->armed = 0;
+            if(q->fd >= 0 && !q->broken){
+                int status = queue_flush_locked(q);
+                if(status == 1){
+                    queue_arm_locked(q);
+                } else if(status < 0){
+                    queue_break_locked(q);
+                }
+            }
+            pthread_mutex_unlock(&q->lock);
+        }
+    }
+    return NULL;
+}
+
+int outbound_start(size_t max_bytes, SlowClientPolicy policy){
+    queue_max_bytes = max_bytes;
+    slow_policy = policy;
+
+    writer_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(writer_epoll_fd < 0){
+        LOG_ERROR("epoll_create1 (writer) selhal (errno=%d)\n", errno);
+        return -1;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    writer_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(writer_wake_fd < 0 || epoll_ctl(writer_epoll_fd, EPOLL_CTL_ADD, writer_wake_fd, &ev) < 0 ||
+       pthread_create(&writer, NULL, writer_thread, NULL) != 0){
+        LOG_ERROR("Nelze spustit writer vlákno\n");
+        if(writer_wake_fd >= 0){
+            close(writer_wake_fd);
+            writer_wake_fd = -1;
+        }
+        close(writer_epoll_fd);
+        writer_epoll_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void outbound_stop(void){
+    if(writer_wake_fd < 0){
+        return;
+    }
+
+    uint64_t one = 1;
+    if(write(writer_wake_fd, &one, sizeof(one)) != sizeof(one)){
+        LOG_ERROR("Nelze probudit writer vlákno (errno=%d)\n", errno);
+        return;
+    }
+    pthread_join(writer, NULL);
+
+    // epoll zůstává otevřený: fronty ho smí dál armovat, jen už je nikdo nedopíše
+    close(writer_wake_fd);
+    writer_wake_fd = -1;
+}
@@ -0,0 +1,148 @@
+#ifndef OUTBOUND_H
+#define OUTBOUND_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
+#include "config.h"
+
+// Politika pro pomalé klienty (plná odchozí fronta)
+typedef enum{
+    SLOW_CLIENT_DROP,                   // Novou zprávu zahodit
+    SLOW_CLIENT_COALESCE,               // Přepsat starší snímek stejného typu na jeho místě (STAT, RLIS, ...), pokud za ním nejsou navazující zprávy, jinak odpojit
+    SLOW_CLIENT_DISCONNECT              // Klienta odpojit
+} SlowClientPolicy;
+
+// Předem serializovaná zpráva (hlavička + tělo), sdílená více frontami (broadcast)
+typedef struct{
+    atomic_int refs;                    // Počet front (a tvůrce), které zprávu drží
+    size_t len;                         // Délka dat
+    char data[];                        // "JOKE" + typ + délka + tělo
+} OutFrame;
+
+// Omezená odchozí fronta jednoho klienta, vyprazdňuje ji neblokující zápis a writer vlákno
+typedef struct{
+    pthread_mutex_t lock;               // Zámek fronty (v pořadí zámků vždy poslední)
+    int fd;                             // Socket, do kterého se zapisuje (-1: bez spojení)
+    int broken;                         // Chyba zápisu / odpojen politikou -> další zprávy se zahazují
+    int armed;                          // Socket čeká ve writer epollu na EPOLLOUT
+
+    OutFrame *frames[OUT_QUEUE_MAX_FRAMES];     // Kruhová fronta zpráv
+    unsigned head;                      // Index první neodeslané zprávy (monotónní)
+    unsigned tail;                      // Index pro vložení (monotónní)
+    size_t head_off;                    // Již odeslaná část první zprávy
+    size_t bytes;                       // Neodeslané bajty ve frontě
+
+    unsigned long dropped;              // Zahozené zprávy (statistika)
+    unsigned long coalesced;            // Nahrazené starší zprávy (statistika)
+} OutQueue;
+
+// Souhrn všech odchozích front (udržují ho operace front, čte správcovské rozhraní bez zámků)
+typedef struct{
+    unsigned long bytes;                // Neodeslané bajty
+    unsigned long frames;               // Zprávy ve frontách
+    unsigned long peak_bytes;           // Nejdelší fronta od startu serveru
+    unsigned long dropped;              // Zahozené zprávy (politika pomalých klientů)
+    unsigned long coalesced;            // Nahrazené zprávy
+} OutboundStats;
+
+/**
+ * @brief Spustí writer vlákno, které dopisuje fronty klientů s plným socketem
+ * @param max_bytes Limit neodeslaných bajtů na klienta
+ * @param policy Politika pro pomalé klienty
+ * @return 0: SUCCESS, -1: ERROR
+ */
+int outbound_start(size_t max_bytes, SlowClientPolicy policy);
+
+/**
+ * @brief Zastaví a připojí writer vlákno (při ukončení serveru, před uzavřením loggeru)
+ */
+void outbound_stop(void);
+
+/**
+ * @brief Přečte souhrn všech odchozích front (každá hodnota zvlášť atomicky)
+ * @param stats Výstup
+ */
+void outbound_stats(OutboundStats *stats);
+
+/**
+ * @brief Inicializace prázdné fronty (jednou za běh serveru)
+ * @param q Fronta
+ */
+void out_queue_init(OutQueue *q);
+
+/**
+ * @brief Připojí frontu k novému socketu, neodeslaná data předchozího spojení zahodí
+ * @param q Fronta
+ * @param fd Socket klienta
+ */
+void out_queue_attach(OutQueue *q, int fd);
+
+/**
+ * @brief Odpojí frontu od socketu (před jeho zavřením), jen pokud fronta stále patří tomuto socketu
+ * @param q Fronta
+ * @param fd Socket klienta
+ */
+void out_queue_detach(OutQueue *q, int fd);
+
+/**
+ * @brief Vytvoří předem serializovanou zprávu (refs = 1 pro volajícího)
+ * @param type_msg Typ zprávy
+ * @param message Tělo zprávy
+ * @param msg_len Délka těla
+ * @return Zpráva nebo NULL (příliš dlouhá zpráva, malloc error)
+ */
+OutFrame *out_frame_create(const char *type_msg, const char *message, size_t msg_len);
+
+/**
+ * @brief Vytvoří předem serializovanou zprávu z částí těla (slije je do jedné kopie, refs = 1)
+ * @param type_msg Typ zprávy
+ * @param parts Části těla v pořadí
+ * @param count Počet částí
+ * @return Zpráva nebo NULL (příliš dlouhá zpráva, malloc error)
+ */
+OutFrame *out_frame_create_v(const char *type_msg, const struct iovec *parts, int count);
+
+/**
+ * @brief Uvolní referenci na zprávu
+ * @param frame Zpráva
+ */
+void out_frame_release(OutFrame *frame);
+
+/**
+ * @brief Vloží sdílenou zprávu do fronty (pokud je fronta prázdná, zkusí ji rovnou odeslat), nikdy neblokuje
+ * @param q Fronta
+ * @param frame Zpráva (fronta si bere vlastní referenci)
+ * @return 0: odesláno/zařazeno, -1: bez spojení, -2: zahozeno (plná fronta), -3: klient odpojen politikou
+ */
+int out_queue_push(OutQueue *q, OutFrame *frame);
+
+/**
+ * @brief Odešle zprávu přes frontu; při prázdné frontě jde přímo na socket bez alokace, nikdy neblokuje
+ * @param q Fronta
+ * @param type_msg Typ zprávy
+ * @param message Tělo zprávy
+ * @param msg_len Délka těla
+ * @return out_queue_push() returns
+ */
+int out_queue_send(OutQueue *q, const char *type_msg, const char *message, size_t msg_len);
+
+/**
+ * @brief Odešle zprávu složenou z částí těla (sdílené + soukromé); při prázdné frontě jedním sendmsg
+ * přímo z částí bez kopírování, jinak se části slijí do jedné zprávy ve frontě
+ * @param q Fronta
+ * @param type_msg Typ zprávy
+ * @param parts Části těla v pořadí
+ * @param count Počet částí (nejvýše OUT_SEND_MAX_PARTS)
+ * @return out_queue_push() returns
+ */
+int out_queue_sendv(OutQueue *q, const char *type_msg, const struct iovec *parts, int count);
+
+/**
+ * @brief Počet neodeslaných bajtů ve frontě
+ * @param q Fronta
+ */
+size_t out_queue_pending(OutQueue *q);
+
+#endif
@@ -8,6 +8,9 @@
 #include <arpa/inet.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/uio.h>
 
 ssize_t custom_receive(int sock, void* buf, size_t count){
     // celkové množství přečtených
@@ -34,7 +37,18 @@ ssize_t custom_send(int sock, const void* buf, size_t count){
 
     // dokud délka odeslané zprávy není dlouhá požadované délce, odesílej
     while(total_sent < count){
-        ssize_t bytes_sent = send(sock, buffer + total_sent, count - total_sent, 0);
+        ssize_t bytes_sent = send(sock, buffer + total_sent, count - total_sent, MSG_NOSIGNAL);
+        if(bytes_sent < 0 && errno == EINTR){
+            continue;
+        }
+        // Neblokující socket (reaktor) -> počkej, až půjde zapisovat
+        if(bytes_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+            if(poll(&pfd, 1, SEND_POLL_TIMEOUT) <= 0){
+                return -1;
+            }
+            continue;
+        }
         if(bytes_sent <= 0){
             return bytes_sent;
         }
@@ -43,22 +57,39 @@ ssize_t custom_send(int sock, const void* buf, size_t count){
     return total_sent;
 }
 
+// Názvy zpráv indexované výčtem MessageType
+static const char* const MESSAGE_NAMES[MSG_COUNT] = {
+#define MSG_NAME_ENTRY(name, a, b, c, d) [MSG_##name] = #name,
+    PROTOCOL_MESSAGES(MSG_NAME_ENTRY)
+#undef MSG_NAME_ENTRY
+};
+
+MessageType msg_type_decode(const char* type_msg){
+    uint32_t fourcc = FOURCC(type_msg[0], type_msg[1], type_msg[2], type_msg[3]);
+
+    // switch nad konstantami překladač převede na vyhledávání v celých číslech
+    switch(fourcc){
+#define MSG_DECODE_ENTRY(name, a, b, c, d) case FOURCC(a, b, c, d): return MSG_##name;
+        PROTOCOL_MESSAGES(MSG_DECODE_ENTRY)
+#undef MSG_DECODE_ENTRY
+        default:
+            return MSG_UNKNOWN;
+    }
+}
+
+const char* msg_type_name(MessageType type){
+    if(type < 0 || type >= MSG_COUNT){
+        return "????";
+    }
+    return MESSAGE_NAMES[type];
+}
+
 int validate_message(const char* message){
-    size_t len = strlen(message);
-    if(len != MSG_TYPE_LEN || message == NULL){
+    if(message == NULL || strlen(message) != MSG_TYPE_LEN){
         return 0;
     }
 
-    // kontrola, jestli zpráva existuje v množině zpráv
-    for(size_t i = 0; i < VM_COUNT; i++){
-        // printf("%s ? %s\n", VALID_MESSAGES[i], message);
-        if(strcmp(VALID_MESSAGES[i], message) == 0){
-            return 1;
-        }
-    }
-    
-    // zpráva nenalezena
-    return 0;
+    return msg_type_decode(message) != MSG_UNKNOWN;
 }
 
 int validate_message_len(const char* message){
@@ -128,7 +159,8 @@ int read_full_message(int client_sock, ProtocolHeader* header_out, char** messag
     len_str[LENGTH_LEN] = '\0';
 
     if (strcmp(header_out->magic, MAGIC) != 0) return -2;
-    if (!validate_message(header_out->type_msg)) return -3;
+    header_out->type = msg_type_decode(header_out->type_msg);
+    if (header_out->type == MSG_UNKNOWN) return -3;
     if (!validate_message_len(len_str)) return -4;
 
     message_len = atoi(len_str);
@@ -148,43 +180,95 @@ int read_full_message(int client_sock, ProtocolHeader* header_out, char** messag
 
 
 
-int send_message(int client_sock, const char* type_msg, const char* message){
-    int msg_len = strlen(message);
-    if(msg_len > MAX_MESSAGE_LEN){
-        return -1;
+void build_header(char *header_out, const char* type_msg, size_t msg_len){
+    memcpy(header_out, MAGIC, MAGIC_LEN);
+
+    // typ zprávy doplněný mezerami na MSG_TYPE_LEN (jako "%-4s")
+    size_t i = 0;
+    for(; i < MSG_TYPE_LEN && type_msg[i] != '\0'; i++){
+        header_out[MAGIC_LEN + i] = type_msg[i];
+    }
+    for(; i < MSG_TYPE_LEN; i++){
+        header_out[MAGIC_LEN + i] = ' ';
     }
 
-    char header_buffer[HEADER_LEN + 1];
-    if (msg_len < 0 || msg_len > 9999) {
-    // Chyba nebo logování, protože zpráva je příliš dlouhá/krátká
-        return -1; 
+    // délka jako 4 číslice (jako "%04zu")
+    char *len_out = header_out + MAGIC_LEN + MSG_TYPE_LEN;
+    for(int d = LENGTH_LEN - 1; d >= 0; d--){
+        len_out[d] = (char)('0' + msg_len % 10);
+        msg_len /= 10;
     }
+}
+
+ssize_t custom_sendv(int sock, struct iovec *iov, int iovcnt){
+    size_t total_sent = 0;
 
-    // zapíšeme do bufferu magic + type_msg + msg_len
-    snprintf(header_buffer, HEADER_LEN + 1, "%s%-4s%04d", MAGIC, type_msg, msg_len);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
 
-    int total_len = HEADER_LEN + msg_len;
-    char* packet = malloc(total_len+1);
-    if(!packet){
-        return -2;
+    while(msg.msg_iovlen > 0){
+        ssize_t bytes_sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+        if(bytes_sent < 0 && errno == EINTR){
+            continue;
+        }
+        // Neblokující socket (reaktor) -> počkej, až půjde zapisovat
+        if(bytes_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+            if(poll(&pfd, 1, SEND_POLL_TIMEOUT) <= 0){
+                return -1;
+            }
+            continue;
+        }
+        if(bytes_sent <= 0){
+            return bytes_sent;
+        }
+        total_sent += bytes_sent;
+
+        // posuň iovec za odeslaná data (částečný zápis)
+        size_t rest = bytes_sent;
+        while(msg.msg_iovlen > 0 && rest >= msg.msg_iov->iov_len){
+            rest -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if(msg.msg_iovlen > 0){
+            msg.msg_iov->iov_base = (char*)msg.msg_iov->iov_base + rest;
+            msg.msg_iov->iov_len -= rest;
+        }
+    }
+    return total_sent;
+}
+
+int send_message_len(int client_sock, const char* type_msg, const char* message, size_t msg_len){
+    if(msg_len > MAX_MESSAGE_LEN){
+        return -1;
     }
 
-    packet[total_len] = '\0';
-    memcpy(packet, header_buffer, HEADER_LEN);
-    memcpy(packet + HEADER_LEN, message, msg_len);
+    // hlavička na zásobníku, hlavička + tělo jedním vektorovým zápisem
+    char header_buffer[HEADER_LEN];
+    build_header(header_buffer, type_msg, msg_len);
 
-    int sent = custom_send(client_sock, packet, total_len);
-    LOG_INFO("Sending to client socket %d: %s\n", client_sock, packet);
-    free(packet);
+    struct iovec iov[2] = {
+        { .iov_base = header_buffer, .iov_len = HEADER_LEN },
+        { .iov_base = (void*)message, .iov_len = msg_len }
+    };
+
+    ssize_t total_len = HEADER_LEN + msg_len;
+    ssize_t sent = custom_sendv(client_sock, iov, msg_len > 0 ? 2 : 1);
+    LOG_DEBUG("Sending to client socket %d: %.4s (%zu B)\n", client_sock, type_msg, msg_len);
 
     if(sent != total_len){
         return -3;
     }
-
-    
     return 0;
 }
 
+int send_message(int client_sock, const char* type_msg, const char* message){
+    return send_message_len(client_sock, type_msg, message, strlen(message));
+}
+
 int send_error(int client_sock, const char* err_msg){
     return send_message(client_sock, "ERRR", err_msg);
 }
\ No newline at end of file
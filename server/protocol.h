@@ -2,7 +2,9 @@
 #define PROTOCOL_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include "config.h"
 
 #define MAGIC_LEN 4                                             // Délka magicu ("JOKE")
@@ -58,62 +60,80 @@
 #define RESU "RESU"         // RESUme - server informuje o znovuobnovení hry po opětovném připojení
 #define RECO "RECO"         // RECOnnect - server informuje klienta, že reconnect byl úspěšný
 #define CNNT "CNNT"         
+#define DLTA "DLTA"         // DeLTA - klient si zapíná změny stavu místo STAT, server posílá změny stavu hry
+#define HINT "HINT"         // HINT - klient žádá nápovědu tahu (co vyložit a přiložit)
+#define OINT "OINT"         // Okay hINT - server posílá nápovědu: karty z ruky|vyložení|přiložení
+
+// Typ zprávy jako 32bitové číslo (4 znaky, první znak v nejnižším bajtu)
+#define FOURCC(a, b, c, d) ((uint32_t)(unsigned char)(a) | ((uint32_t)(unsigned char)(b) << 8) | \
+                            ((uint32_t)(unsigned char)(c) << 16) | ((uint32_t)(unsigned char)(d) << 24))
+
+// Seznam všech zpráv protokolu: X(název, znaky), z něj se generuje výčet, názvy i dekódování
+#define PROTOCOL_MESSAGES(X) \
+    X(LOGI, 'L', 'O', 'G', 'I') \
+    X(LOGO, 'L', 'O', 'G', 'O') \
+    X(OKAY, 'O', 'K', 'A', 'Y') \
+    X(QUIT, 'Q', 'U', 'I', 'T') \
+    X(RCRT, 'R', 'C', 'R', 'T') \
+    X(RDIS, 'R', 'D', 'I', 'S') \
+    X(RCNT, 'R', 'C', 'N', 'T') \
+    X(RLIS, 'R', 'L', 'I', 'S') \
+    X(ERRR, 'E', 'R', 'R', 'R') \
+    X(OCRT, 'O', 'C', 'R', 'T') \
+    X(OCNT, 'O', 'C', 'N', 'T') \
+    X(ECRT, 'E', 'C', 'R', 'T') \
+    X(ECNT, 'E', 'C', 'N', 'T') \
+    X(ODIS, 'O', 'D', 'I', 'S') \
+    X(EDIS, 'E', 'D', 'I', 'S') \
+    X(REDY, 'R', 'E', 'D', 'Y') \
+    X(EEDY, 'E', 'E', 'D', 'Y') \
+    X(OEDY, 'O', 'E', 'D', 'Y') \
+    X(BOSS, 'B', 'O', 'S', 'S') \
+    X(TURN, 'T', 'U', 'R', 'N') \
+    X(WAIT, 'W', 'A', 'I', 'T') \
+    X(PRDY, 'P', 'R', 'D', 'Y') \
+    X(STRT, 'S', 'T', 'R', 'T') \
+    X(CRDS, 'C', 'R', 'D', 'S') \
+    X(RINF, 'R', 'I', 'N', 'F') \
+    X(NOTI, 'N', 'O', 'T', 'I') \
+    X(TAKP, 'T', 'A', 'K', 'P') \
+    X(THRW, 'T', 'H', 'R', 'W') \
+    X(TAKT, 'T', 'A', 'K', 'T') \
+    X(UNLO, 'U', 'N', 'L', 'O') \
+    X(ADDC, 'A', 'D', 'D', 'C') \
+    X(CSEQ, 'C', 'S', 'E', 'Q') \
+    X(STAT, 'S', 'T', 'A', 'T') \
+    X(GEND, 'G', 'E', 'N', 'D') \
+    X(CLOS, 'C', 'L', 'O', 'S') \
+    X(PLAG, 'P', 'L', 'A', 'G') \
+    X(LBBY, 'L', 'B', 'B', 'Y') \
+    X(PING, 'P', 'I', 'N', 'G') \
+    X(PONG, 'P', 'O', 'N', 'G') \
+    X(PAUS, 'P', 'A', 'U', 'S') \
+    X(RESU, 'R', 'E', 'S', 'U') \
+    X(RECO, 'R', 'E', 'C', 'O') \
+    X(CNNT, 'C', 'N', 'N', 'T') \
+    X(DLTA, 'D', 'L', 'T', 'A') \
+    X(HINT, 'H', 'I', 'N', 'T') \
+    X(OINT, 'O', 'I', 'N', 'T')
+
+// Výčet všech zpráv (index do dispatch tabulek)
+typedef enum{
+    MSG_UNKNOWN = -1,                   // Neznámá zpráva
+#define MSG_ENUM_ENTRY(name, a, b, c, d) MSG_##name,
+    PROTOCOL_MESSAGES(MSG_ENUM_ENTRY)
+#undef MSG_ENUM_ENTRY
+    MSG_COUNT                           // Počet známých zpráv
+} MessageType;
 
 // Struktura pro hlavičku zprávy
 typedef struct{
     char magic[MAGIC_LEN + 1];
     char type_msg[MSG_TYPE_LEN + 1];
+    MessageType type;                   // Typ zprávy dekódovaný při parsování
     int message_len;
 } ProtocolHeader;
 
-// Pole všech zpráv
-static const char* const VALID_MESSAGES[] = {
-    "LOGI",
-    "LOGO",
-    "OKAY",
-    "QUIT",
-    "RCRT",
-    "RDIS",
-    "RCNT",
-    "RLIS",
-    "ERRR",
-    "OCRT",
-    "OCNT",
-    "ECRT",
-    "ECNT",
-    "ODIS",
-    "EDIS",
-    "REDY",
-    "EEDY",
-    "OEDY",
-    "BOSS",
-    "TURN",
-    "WAIT",
-    "PRDY",
-    "STRT",
-    "CRDS",
-    "RINF",
-    "NOTI",
-    "TAKP",
-    "THRW",
-    "TAKT",
-    "UNLO",
-    "ADDC",
-    "CSEQ",
-    "STAT",
-    "GEND",
-    "CLOS",
-    "PLAG",
-    "LBBY",
-    "PING",
-    "PONG",
-    "PAUS",
-    "RESU",
-    "RECO",
-    "CNNT"
-};
-static const size_t VM_COUNT = sizeof(VALID_MESSAGES) / sizeof(VALID_MESSAGES[0]);
-
 /**
  * Přijímání zpráv, které se stará o plné přijetí zprávy. Cyklem přijímá zprávy, dokud zpráva není celá.
  * @param sock socket klienta, od kterého přijímá zprávu
@@ -130,6 +150,20 @@ ssize_t custom_receive(int sock, void* buf, size_t count);
  */
 ssize_t custom_send(int sock, const void* buf, size_t count);
 
+/**
+ * @brief Převede 4 znaky typu zprávy na výčet (jedno porovnání celých čísel místo strcmp přes všechny zprávy)
+ * @param type_msg Typ zprávy (alespoň MSG_TYPE_LEN znaků)
+ * @return Typ zprávy, MSG_UNKNOWN: neznámá zpráva
+ */
+MessageType msg_type_decode(const char* type_msg);
+
+/**
+ * @brief Vrací textový název typu zprávy
+ * @param type Typ zprávy
+ * @return Název (4 znaky), "????" pro neznámý typ
+ */
+const char* msg_type_name(MessageType type);
+
 /**
  * @brief Kontroluje, jestli přijatá zpráva je mezi definovanými zprávami (typ)
  * @param message Testovaná zpráva
@@ -144,22 +178,49 @@ int validate_message(const char* message);
 int validate_message_len(const char* message);
 
 /**
- * @brief Čte zprávu po částech, parsuje na části hlavičky a validuje pomocí funkcí
+ * @brief Čte zprávu po částech, parsuje na části hlavičky a validuje pomocí funkcí.
+ * Původní parser (recv po bajtech), server používá frame_read_message, tady zůstává pro srovnání v bench_frames.
  * @param clinet_sock Klientský socket
  * @param header_out Hlavička zprávy (buffer)
  * @param message_out Zpráva (buffer)
  * @returns -1: Pokud je formát hlavičky v nesprávném formátu (délka je nesprávná)
  * @returns -2: Pokud je hlavička nesprávná (!= JOKE)
- * @returns -3: Pokud přijatá zpráva není známá (neexistuje v VALID_MESSAGES)
+ * @returns -3: Pokud přijatá zpráva není známá (není v PROTOCOL_MESSAGES)
  */
 int read_full_message(int client_sock, ProtocolHeader* header_out, char** message_out);
 
 /**
- * @brief Stará se o build a odesílání zpráv
+ * @brief Odesílá vektor bufferů (sendmsg) do té doby, dokud není vše odesláno
+ * @param sock Klientský socket
+ * @param iov Pole bufferů (při částečném zápisu se upravuje)
+ * @param iovcnt Počet bufferů
+ */
+ssize_t custom_sendv(int sock, struct iovec *iov, int iovcnt);
+
+/**
+ * @brief Sestaví 12B hlavičku zprávy ("JOKE" + typ + délka) bez ukončovací nuly
+ * @param header_out Buffer o velikosti alespoň HEADER_LEN
+ * @param type_msg Typ zprávy
+ * @param msg_len Délka těla zprávy (0 až MAX_MESSAGE_LEN)
+ */
+void build_header(char *header_out, const char* type_msg, size_t msg_len);
+
+/**
+ * @brief Odesílá zprávu známé délky: hlavička na zásobníku, hlavička + tělo jedním zápisem, bez alokace
+ * @param client_sock Klientský socket
+ * @param type_msg Typ zprávy
+ * @param message Tělo zprávy (nemusí být ukončené nulou)
+ * @param msg_len Délka těla
+ * @return -1: přiliš dlouhá zpráva, -3 odeslání menšího množství dat, 0: SUCCESS
+ */
+int send_message_len(int client_sock, const char* type_msg, const char* message, size_t msg_len);
+
+/**
+ * @brief Stará se o build a odesílání zpráv (délku těla spočítá strlen)
  * @param client_sock Klientský socket
  * @param type_msg Typ zprávy
  * @param message Skutečná zpráva
- * @return -1: přiliš dlouhá zpráva/chyba, -2 malloc error, -3 odeslání menšího množství dat, 0: SUCCESS
+ * @return send_message_len() returns
  */
 int send_message(int client_sock, const char* type_msg, const char* message);
 
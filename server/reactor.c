@@ -0,0 +1,197 @@
+#include "reactor.h"
+#include "client_manager.h"
+#include "protocol.h"
+#include "frame_buffer.h"
+#include "logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+// Stav jednoho spojení, vlastní ho vždy právě jeden reaktor (bez zamykání)
+typedef struct{
+    ThreadContext ctx;                                  // Socket a index klienta
+    FrameBuffer input;                                  // Vstupní kruhový buffer a rozpracovaná zpráva
+} Connection;
+
+// Reaktor = jedna epoll instance obsluhovaná jedním vláknem
+typedef struct{
+    int epoll_fd;
+    int wake_fd;                                        // eventfd pro ukončení (v epollu s data.ptr = NULL)
+    pthread_t thread;
+} Reactor;
+
+static Reactor reactors[MAX_REACTOR_THREADS];
+static int reactor_count = 0;
+static atomic_uint next_reactor = 0;
+
+/**
+ * @brief Ukončí spojení: odregistruje socket z epollu a předá úklid client_connection_closed
+ */
+static void connection_close(Reactor *reactor, Connection *conn, int message_status){
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, conn->ctx.socket_fd, NULL);
+    client_connection_closed(&conn->ctx, message_status);
+    frame_buffer_free(&conn->input);
+    free(conn);
+}
+
+/**
+ * @brief Obslouží připravenost ke čtení: jedno recv, poté zpracuje všechny celé zprávy v bufferu
+ */
+static void connection_readable(Reactor *reactor, Connection *conn){
+    ssize_t r = frame_buffer_fill(&conn->input, conn->ctx.socket_fd, MSG_DONTWAIT);
+    if(r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)){
+        return;
+    }
+    if(r <= 0){
+        connection_close(reactor, conn, -1);
+        return;
+    }
+
+    while(1){
+        ProtocolHeader header;
+        char *message_body = NULL;
+
+        int status = frame_buffer_next(&conn->input, &header, &message_body);
+        if(status == 0){
+            return;
+        }
+        if(status < 0){
+            connection_close(reactor, conn, status);
+            return;
+        }
+
+        if(client_process_message(&conn->ctx, &header, message_body)){
+            connection_close(reactor, conn, 0);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Smyčka reaktorového vlákna
+ */
+static void* reactor_thread(void *arg){
+    Reactor *reactor = (Reactor*)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    LOG_INFO("Reaktor spuštěn (epoll fd=%d)\n", reactor->epoll_fd);
+
+    while(1){
+        int n = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            LOG_ERROR("epoll_wait selhal (errno=%d)\n", errno);
+            break;
+        }
+
+        for(int i = 0; i < n; i++){
+            // Probuzení z reactor_stop -> spojení zůstanou, proces končí
+            if(!events[i].data.ptr){
+                return NULL;
+            }
+            // Chyba i zavření spojení se projeví jako recv() <= 0
+            connection_readable(reactor, (Connection*)events[i].data.ptr);
+        }
+    }
+    return NULL;
+}
+
+int reactor_start(int thread_count){
+    if(thread_count <= 0 || thread_count > MAX_REACTOR_THREADS){
+        return -1;
+    }
+
+    for(int i = 0; i < thread_count; i++){
+        reactors[i].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if(reactors[i].epoll_fd < 0){
+            LOG_ERROR("epoll_create1 selhal (errno=%d)\n", errno);
+            return -1;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        reactors[i].wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(reactors[i].wake_fd < 0 || epoll_ctl(reactors[i].epoll_fd, EPOLL_CTL_ADD, reactors[i].wake_fd, &ev) < 0){
+            LOG_ERROR("Nelze připravit eventfd reaktoru %d (errno=%d)\n", i, errno);
+            if(reactors[i].wake_fd >= 0){
+                close(reactors[i].wake_fd);
+            }
+            close(reactors[i].epoll_fd);
+            return -1;
+        }
+
+        if(pthread_create(&reactors[i].thread, NULL, reactor_thread, &reactors[i]) != 0){
+            LOG_ERROR("Nelze spustit reaktorové vlákno %d\n", i);
+            close(reactors[i].wake_fd);
+            close(reactors[i].epoll_fd);
+            return -1;
+        }
+        reactor_count++;
+    }
+
+    LOG_INFO("Spuštěno %d epoll reaktorů\n", reactor_count);
+    return 0;
+}
+
+void reactor_stop(void){
+    uint64_t one = 1;
+    for(int i = 0; i < reactor_count; i++){
+        if(write(reactors[i].wake_fd, &one, sizeof(one)) != sizeof(one)){
+            LOG_ERROR("Nelze probudit reaktor %d (errno=%d)\n", i, errno);
+        }
+    }
+
+    // Po návratu už žádný reaktor neobsluhuje zprávy
+    for(int i = 0; i < reactor_count; i++){
+        pthread_join(reactors[i].thread, NULL);
+    }
+    LOG_INFO("Zastaveno %d epoll reaktorů\n", reactor_count);
+    reactor_count = 0;
+}
+
+int reactor_add_client(int client_sock, int client_index){
+    if(reactor_count == 0){
+        return -1;
+    }
+
+    int flags = fcntl(client_sock, F_GETFL, 0);
+    if(flags < 0 || fcntl(client_sock, F_SETFL, flags | O_NONBLOCK) < 0){
+        return -1;
+    }
+
+    Connection *conn = (Connection*)malloc(sizeof(Connection));
+    if(!conn){
+        return -1;
+    }
+    conn->ctx.socket_fd = client_sock;
+    conn->ctx.client_index = client_index;
+    frame_buffer_init(&conn->input);
+
+    client_attach(&conn->ctx);
+
+    Reactor *reactor = &reactors[atomic_fetch_add(&next_reactor, 1) % reactor_count];
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.ptr = conn;
+
+    if(epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_sock, &ev) < 0){
+        LOG_ERROR("epoll_ctl ADD selhal (fd=%d, errno=%d)\n", client_sock, errno);
+        free(conn);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "config.h"
+
+/**
+ * @brief Spustí pevnou sadu epoll reaktorů (režim --reactor), každý ve vlastním vlákně
+ * @param thread_count Počet reaktorových vláken (1 až MAX_REACTOR_THREADS)
+ * @return 0: SUCCESS, -1: ERROR
+ */
+int reactor_start(int thread_count);
+
+/**
+ * @brief Probudí a počká na všechny reaktory (ukončení serveru), otevřená spojení neuzavírá
+ */
+void reactor_stop(void);
+
+/**
+ * @brief Předá přijatý socket jednomu z reaktorů (round-robin), socket přepne do neblokujícího režimu
+ * @param client_sock Socket klienta z acceptu
+ * @param client_index Index přiděleného slotu v poli klientů
+ * @return 0: SUCCESS, -1: ERROR (socket zůstává otevřený, uklízí volající)
+ */
+int reactor_add_client(int client_sock, int client_index);
+
+#endif
@@ -0,0 +1,92 @@
+#include "rng.h"
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/random.h>
+
+/**
+ * @brief Krok splitmix64 (rozvinutí seedu do stavu xoshiro)
+ */
+static uint64_t splitmix64(uint64_t *state){
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(Rng *rng, uint64_t seed){
+    uint64_t state = seed;
+
+    for(int i = 0; i < 4; i++){
+        rng->s[i] = splitmix64(&state);
+    }
+}
+
+uint64_t rng_next(Rng *rng){
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+uint32_t rng_below(Rng *rng, uint32_t bound){
+    uint64_t m = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+
+    // Odmítnutí malé části rozsahu, kterou by modulo zvýhodnilo
+    if(low < bound){
+        uint32_t threshold = -bound % bound;
+        while(low < threshold){
+            m = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+uint64_t rng_os_seed(void){
+    uint64_t seed;
+    ssize_t got;
+
+    do{
+        got = getrandom(&seed, sizeof(seed), 0);
+    } while(got < 0 && errno == EINTR);
+
+    if(got == (ssize_t)sizeof(seed)){
+        return seed;
+    }
+
+    // Bez getrandom: čas s nanosekundami a adresa na zásobníku (ASLR)
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t state = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ (uint64_t)(uintptr_t)&ts;
+    return splitmix64(&state);
+}
+
+void rng_token(char *token, int length, const char *charset){
+    static __thread Rng thread_rng;
+    static __thread int thread_seeded = 0;
+    uint32_t charset_size = (uint32_t)strlen(charset);
+
+    if(!thread_seeded){
+        rng_seed(&thread_rng, rng_os_seed());
+        thread_seeded = 1;
+    }
+
+    for(int i = 0; i < length; i++){
+        token[i] = charset[rng_below(&thread_rng, charset_size)];
+    }
+    token[length] = '\0';
+}
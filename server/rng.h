@@ -0,0 +1,50 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Generátor xoshiro256** (rychlý, 256 bitů stavu), každá hra má vlastní -> bez sdíleného stavu mezi vlákny
+typedef struct{
+    uint64_t s[4];
+} Rng;
+
+/**
+ * @brief Nastaví stav generátoru ze 64bitového seedu (rozvinutí přes splitmix64)
+ *
+ * Stejný seed dává stejnou posloupnost (opakování rozdání pro replay a benchmarky).
+ * @param rng Generátor
+ * @param seed Seed
+ */
+void rng_seed(Rng *rng, uint64_t seed);
+
+/**
+ * @brief Další 64bitové číslo
+ * @param rng Generátor
+ * @return náhodné číslo
+ */
+uint64_t rng_next(Rng *rng);
+
+/**
+ * @brief Rovnoměrné číslo z rozsahu 0..bound-1 bez zkreslení modulem (Lemireho násobení s odmítáním)
+ * @param rng Generátor
+ * @param bound Horní mez (> 0)
+ * @return číslo 0..bound-1
+ */
+uint32_t rng_below(Rng *rng, uint32_t bound);
+
+/**
+ * @brief Seed z kryptografického zdroje systému (getrandom, záložně čas a adresa)
+ * @return seed
+ */
+uint64_t rng_os_seed(void);
+
+/**
+ * @brief Vláknově bezpečné generování tokenu (vlastní generátor každého vlákna seedovaný z rng_os_seed)
+ * @param token Buffer o velikosti alespoň length + 1
+ * @param length Počet znaků
+ * @param charset Povolené znaky
+ */
+void rng_token(char *token, int length, const char *charset);
+
+#endif
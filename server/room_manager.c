@@ -2,18 +2,101 @@
 #include "client_manager.h"
 #include  "game_manager.h"
 #include "logger.h"
+#include "trace.h"
 #include "protocol.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
-GameRoom rooms[MAX_ROOMS];  // pole místností
+GameRoom *rooms = NULL;     // pole místností
+int max_rooms = 0;          // kapacita pole místností
 pthread_mutex_t rooms_mutex = PTHREAD_MUTEX_INITIALIZER;    // mutex
 
-void initialize_rooms(){
+// Zásobník volných místností (chráněno rooms_mutex)
+static int *free_room_ids = NULL;
+static int free_room_count = 0;
+
+// Předem serializovaný seznam místností (RLIS), chráněno rooms_mutex
+static OutFrame *room_list_cache = NULL;            // Sdílená zpráva (NULL: žádné místnosti)
+static int room_list_cache_count = 0;               // Počet místností v uložené zprávě
+static unsigned long room_list_cache_version = 0;   // Verze, ze které byla zpráva sestavena
+static unsigned long room_list_version = 1;         // Aktuální verze stavu místností
+
+/**
+ * @brief Označí seznam místností jako zastaralý (volat pod rooms_mutex)
+ */
+static void room_list_changed_locked(){
+    room_list_version++;
+}
+
+// Založené místnosti podle stavu pro správcovské rozhraní (mění se pod rooms_mutex, čtou bez zámku)
+static atomic_int rooms_per_status[ROOM_STATUS_COUNT];
+
+/**
+ * @brief Přičte založenou místnost k počtu jejího stavu (volat pod rooms_mutex)
+ */
+static void room_count_locked(RoomStatus status, int delta){
+    if(status >= 0 && status < ROOM_STATUS_COUNT){
+        atomic_fetch_add_explicit(&rooms_per_status[status], delta, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Změní stav místnosti, založená místnost se přesune mezi počty (volat pod rooms_mutex)
+ */
+static void room_status_set_locked(GameRoom *room, RoomStatus status){
+    if(room->room_id >= 0){
+        room_count_locked(room->status, -1);
+        room_count_locked(status, 1);
+    }
+    room->status = status;
+}
+
+/**
+ * @brief Časovač tahu vypršel, kontrola limitu proběhne pod zámkem místnosti
+ */
+static void room_turn_timer_expired(TimerNode *timer){
+    GameRoom *room = (GameRoom*)timer->arg;
+
+    pthread_mutex_lock(&room->lock);
+    GameInstance *game = (GameInstance*)room->game_instance;
+    if(game && game_check_timeout(game)){
+        LOG_INFO("Hráč %d překročil limit tahu (%ds) v místnosti %d\n",
+                 game->players[game->current_player_index].client_index, game->turn_timeout_seconds, game->room_id);
+    }
+    pthread_mutex_unlock(&room->lock);
+}
+
+/**
+ * @brief Vrátí právě zrušenou místnost do zásobníku volných (volat pod rooms_mutex)
+ */
+static void room_release_locked(int room_id){
+    free_room_ids[free_room_count++] = room_id;
+}
+
+int initialize_rooms(int capacity){
+    // Jeden souvislý, na cache line zarovnaný blok pro všechny místnosti
+    void *table = NULL;
+    if(capacity <= 0 || posix_memalign(&table, CACHE_LINE_SIZE, (size_t)capacity * sizeof(GameRoom)) != 0){
+        LOG_ERROR("Nelze alokovat tabulku místností (%d)\n", capacity);
+        return -1;
+    }
+
+    free_room_ids = (int*)malloc((size_t)capacity * sizeof(int));
+    if(!free_room_ids){
+        LOG_ERROR("Nelze alokovat zásobník volných místností\n");
+        free(table);
+        return -1;
+    }
+
     pthread_mutex_lock(&rooms_mutex);
+    rooms = (GameRoom*)table;
+    max_rooms = capacity;
+    free_room_count = 0;
+
     // Inicializace celého pole místností
-    for(int i = 0; i < MAX_ROOMS; i++){
+    for(int i = 0; i < max_rooms; i++){
         rooms[i].room_id = -1;                          // neaktivní místnost
         rooms[i].room_name[0] = '\0';                   // prázdný řetězec
         rooms[i].status = ROOM_WAITING;                 // Nevytvořená místnost
@@ -22,6 +105,8 @@ void initialize_rooms(){
         rooms[i].max_players = MAX_PLAYERS_PER_ROOM;    // Nastavení maximálního počtu hráčů z configu
         rooms[i].ready_count = 0;                       // Hráči nejsou
         rooms[i].game_instance = NULL;                  // NULL pointer
+        pthread_mutex_init(&rooms[i].lock, NULL);
+        timer_init(&rooms[i].turn_timer, room_turn_timer_expired, &rooms[i]);
         
         // Inicializace pole hráčů pro každou místnost
         for (int j = 0; j < MAX_PLAYERS_PER_ROOM; j++){
@@ -29,8 +114,14 @@ void initialize_rooms(){
             rooms[i].ready_players[j] = 0;
         }
     }
+
+    // Pozpátku, aby se místnosti přidělovaly od nejnižšího ID
+    for(int i = max_rooms - 1; i >= 0; i--){
+        room_release_locked(i);
+    }
     pthread_mutex_unlock(&rooms_mutex);
-    LOG_INFO("Místnosti nainicializovány\n");
+    LOG_INFO("Místnosti nainicializovány (max_rooms=%d)\n", max_rooms);
+    return 0;
 }
 
 int start_game_in_room(int room_id){
@@ -50,7 +141,7 @@ int start_game_in_room(int room_id){
     }
 
     room->game_instance = game;
-    room->status = ROOM_PLAYING;
+    room_set_status(room, ROOM_PLAYING);
 
     if(game_start(game) != 0){
         game_destroy(game);
@@ -67,26 +158,20 @@ int create_room(const char* room_name, int creator_index) {
 
     pthread_mutex_lock(&rooms_mutex);
 
-    // Nalezení volného slotu pro místnost
-    int room_id = -1;
-    for (int i = 0; i < MAX_ROOMS; i++) {
-        if (rooms[i].room_id == -1) {
-            room_id = i;    // Místnost nalezena
-            break;
-        }
-    }
+    // Volná místnost ze zásobníku (O(1))
+    int room_id = free_room_count > 0 ? free_room_ids[--free_room_count] : -1;
+    pthread_mutex_unlock(&rooms_mutex);
 
     // Pokud místnost nenalezena
     if (room_id == -1) {
-        pthread_mutex_unlock(&rooms_mutex);
         return -1;
     }
 
-    // Inicializace nalezené místnosti
+    // Inicializace nalezené místnosti (dokud nemá room_id, není v seznamu vidět)
     GameRoom *room = &rooms[room_id];
+    pthread_mutex_lock(&room->lock);
     
     // Nastavení základních údajů
-    room->room_id = room_id;
     strncpy(room->room_name, room_name, ROOM_NAME_LEN);
     room->room_name[ROOM_NAME_LEN] = '\0';
     room->owner_index = creator_index;
@@ -105,10 +190,17 @@ int create_room(const char* room_name, int creator_index) {
     room->player_count = 1;
     room->ready_count = 0; // Zakladatel začíná jako NOT READY
 
+    // Zveřejnění místnosti
+    pthread_mutex_lock(&rooms_mutex);
+    room->room_id = room_id;
+    room_count_locked(room->status, 1);
+    room_list_changed_locked();
     pthread_mutex_unlock(&rooms_mutex);
+    pthread_mutex_unlock(&room->lock);
 
     LOG_INFO("Vytvořena nová místnost: %s (ID: %d)\n", room->room_name, room->room_id);
     LOG_INFO("Vlastník (index %d) zapsán do slotu 0 místnosti %d\n", creator_index, room->room_id);
+    TRACE(ROOM_CREATE, creator_index, room->room_id, 0, 0, 0);
 
     // room_id pro klienta
     return room_id; 
@@ -116,7 +208,7 @@ int create_room(const char* room_name, int creator_index) {
 
 int connect_room(int room_id, int client_index){
     // Nevalidní identifikátor
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
@@ -164,16 +256,18 @@ int connect_room(int room_id, int client_index){
         }
     }
 
+    room_list_changed_locked();
     pthread_mutex_unlock(&rooms_mutex);
 
     LOG_INFO("Klient %d připojen k místnosti %d (%d/%d)\n", client_index, room_id, room->player_count, room->max_players);
+    TRACE(ROOM_JOIN, client_index, room_id, room->player_count, 0, 0);
 
     return room_id;
 }
 
 int leave_room(int room_id, int client_index){
     // Test parametrů
-    if (room_id < 0 || room_id >= MAX_ROOMS){
+    if (room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
@@ -209,15 +303,20 @@ int leave_room(int room_id, int client_index){
         LOG_ERROR("Chyba: Klient %d nebyl v místnosti %d nalezen\n", client_index, room_id);
         return -1;
     }
+    room_list_changed_locked();
 
     LOG_INFO("Klient %d opustil místnost %d (%d/%d)\n", client_index, room_id, room->player_count, room->max_players);
     LOG_INFO("Místnost %d : player count == %d\n", room_id, room->player_count);
+    TRACE(ROOM_LEAVE, client_index, room_id, room->player_count, 0, 0);
 
     // Pokud je místnost prázdná -> smaž
     if(room->player_count == 0){
         LOG_INFO("Místnost %d je prázdná -- mažu\n", room_id);
+        TRACE(ROOM_DELETE, client_index, room_id, 0, 0, 0);
+        room_count_locked(room->status, -1);
         room->room_id = -1;
         room->room_name[0] = '\0';
+        room_release_locked(room_id);
         pthread_mutex_unlock(&rooms_mutex);
         return 0;
     }
@@ -237,7 +336,7 @@ int leave_room(int room_id, int client_index){
 }
 
 GameRoom* find_room(int room_id){
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return NULL;
     }
 
@@ -249,34 +348,36 @@ GameRoom* find_room(int room_id){
 }
 
 GameRoom* find_client_room(int client_index){
-    pthread_mutex_lock(&rooms_mutex);
-
-    for(int i = 0; i < MAX_ROOMS; i++){
-        if(rooms[i].room_id == -1){
-            continue;
+    // Hráče místnosti chrání její zámek -> prochází se místnost po místnosti
+    for(int i = 0; i < max_rooms; i++){
+        int found = 0;
+
+        pthread_mutex_lock(&rooms[i].lock);
+        if(rooms[i].room_id != -1){
+            for(int j = 0; j < MAX_PLAYERS_PER_ROOM; j++){
+                if(rooms[i].player_indexes[j] == client_index){
+                    found = 1;
+                    break;
+                }
+            }
         }
+        pthread_mutex_unlock(&rooms[i].lock);
 
-        for(int j = 0; j< MAX_PLAYERS_PER_ROOM; j++){
-            if(rooms[i].player_indexes[j] == client_index){
-                pthread_mutex_unlock(&rooms_mutex);
-                return &rooms[i]; // vrať místnost, ve které se nachází
-            }
+        if(found){
+            return &rooms[i]; // vrať místnost, ve které se nachází
         }
     }
-    pthread_mutex_unlock(&rooms_mutex);
     return NULL;
 }
 
 int set_player_ready(int room_id, int client_index, int ready){
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
-    pthread_mutex_lock(&rooms_mutex);
     GameRoom *room = &rooms[room_id];
 
     if(room->room_id == -1){
-        pthread_mutex_unlock(&rooms_mutex);
         return -1;
     }
 
@@ -296,11 +397,9 @@ int set_player_ready(int room_id, int client_index, int ready){
             LOG_INFO("Klient %d v místnosti %d: %s (ready: %d/%d)\n",
             client_index, room_id, ready? "READY" : "NOT READY", room->ready_count, room->player_count);
 
-            pthread_mutex_unlock(&rooms_mutex);
             return 0;
         }
     }
-    pthread_mutex_unlock(&rooms_mutex);
     return -1;
 }
 
@@ -313,7 +412,7 @@ int check_all_ready(GameRoom *room){
 }
 
 int start_game(int room_id){
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
@@ -341,14 +440,15 @@ int start_game(int room_id){
     }
 
     // Změn status místnosti
-    room->status = ROOM_PLAYING;
+    room_status_set_locked(room, ROOM_PLAYING);
+    room_list_changed_locked();
     pthread_mutex_unlock(&rooms_mutex);
     LOG_INFO("Hra začíná v místnosti %d\n", room_id);
     return 0;
 }
 
 int end_game(int room_id){
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
     pthread_mutex_lock(&rooms_mutex);
@@ -361,7 +461,8 @@ int end_game(int room_id){
     }
 
     // Změň status místnosti
-    room->status = ROOM_FINISHED;
+    room_status_set_locked(room, ROOM_FINISHED);
+    room_list_changed_locked();
     pthread_mutex_unlock(&rooms_mutex);
 
     LOG_INFO("Hra v místnosti %d skončila\n", room_id);
@@ -369,7 +470,7 @@ int end_game(int room_id){
 }
 
 int delete_room(int room_id){
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
@@ -390,31 +491,33 @@ int delete_room(int room_id){
     }
 
     // Přepiš data místnosti (při vytvoření nové se přepíše zbytek)
+    room_count_locked(room->status, -1);
     room->room_id = -1;
     room->room_name[0] = '\0';
+    room_release_locked(room_id);
+    room_list_changed_locked();
 
     pthread_mutex_unlock(&rooms_mutex);
     LOG_INFO("Místnost %d smazána\n", room_id);
+    TRACE(ROOM_DELETE, -1, room_id, 0, 0, 0);
 
     return 0;
 }
 
-int get_room_list(char *buffer, size_t buffer_size){
-    if(!buffer || buffer_size == 0){
-        return 0;
-    }
-
-    pthread_mutex_lock(&rooms_mutex);
-
+/**
+ * @brief Formátuje seznam místností do bufferu (volat pod rooms_mutex)
+ * @return Počet zapsaných místností
+ */
+static int room_list_format_locked(char *buffer, size_t buffer_size, size_t *out_len){
     buffer[0] = '\0';
+    size_t len = 0;
     int count = 0;
 
-    for(int i = 0; i < MAX_ROOMS; i++){
+    for(int i = 0; i < max_rooms; i++){
         if(rooms[i].room_id == -1){
             continue;
         }
 
-        char room_line[256];
         const char *status_str;
 
         switch(rooms[i].status){
@@ -435,37 +538,97 @@ int get_room_list(char *buffer, size_t buffer_size){
                 break;
         }
 
-        snprintf(room_line, sizeof(room_line), "%d|%s|(%d/%d)|%s,\n", 
+        int written = snprintf(buffer + len, buffer_size - len, "%d|%s|(%d/%d)|%s,\n", 
         rooms[i].room_id, rooms[i].room_name, rooms[i].player_count, rooms[i].max_players, status_str);
 
-        if(strlen(buffer) + strlen(room_line) < buffer_size -1){
-            strcat(buffer, room_line);
-            count++;
-        }else{
+        // Řádek se nevešel celý -> odřízni ho a skonči
+        if(written < 0 || (size_t)written >= buffer_size - len - 1){
+            buffer[len] = '\0';
             break;
         }
+        len += written;
+        count++;
+    }
+
+    if(out_len){
+        *out_len = len;
     }
+    return count;
+}
+
+int get_room_list(char *buffer, size_t buffer_size){
+    if(!buffer || buffer_size == 0){
+        return 0;
+    }
+
+    pthread_mutex_lock(&rooms_mutex);
+    int count = room_list_format_locked(buffer, buffer_size, NULL);
     pthread_mutex_unlock(&rooms_mutex);
     return count;
 }
 
+OutFrame *room_list_frame(int *count){
+    pthread_mutex_lock(&rooms_mutex);
+
+    // Stav místností se od posledního sestavení změnil -> přestav sdílenou zprávu
+    if(room_list_cache_version != room_list_version){
+        char room_list[ROOM_LIST_BUFFER];
+        size_t len = 0;
+        int list_count = room_list_format_locked(room_list, sizeof(room_list), &len);
+
+        OutFrame *frame = list_count > 0 ? out_frame_create(RLIS, room_list, len) : NULL;
+        if(list_count == 0 || frame){
+            out_frame_release(room_list_cache);
+            room_list_cache = frame;
+            room_list_cache_count = list_count;
+            room_list_cache_version = room_list_version;
+        }
+    }
+
+    OutFrame *frame = room_list_cache;
+    if(frame){
+        atomic_fetch_add(&frame->refs, 1);
+    }
+    if(count){
+        *count = frame ? room_list_cache_count : 0;
+    }
+    pthread_mutex_unlock(&rooms_mutex);
+    return frame;
+}
+
+void room_list_invalidate(){
+    pthread_mutex_lock(&rooms_mutex);
+    room_list_changed_locked();
+    pthread_mutex_unlock(&rooms_mutex);
+}
+
+void room_set_status(GameRoom *room, RoomStatus status){
+    pthread_mutex_lock(&rooms_mutex);
+    if(room->status != status){
+        room_status_set_locked(room, status);
+        room_list_changed_locked();
+    }
+    pthread_mutex_unlock(&rooms_mutex);
+}
+
+void room_status_counts(int counts[ROOM_STATUS_COUNT]){
+    for(int i = 0; i < ROOM_STATUS_COUNT; i++){
+        counts[i] = atomic_load_explicit(&rooms_per_status[i], memory_order_relaxed);
+    }
+}
+
 int get_room_info(int room_id, char *buffer, size_t buffer_size){
     if(!buffer || buffer_size == 0){
         return -1;
     }
 
-    if(room_id < 0 || room_id >= MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return -1;
     }
 
-    pthread_mutex_lock(&clients_mutex);
-    pthread_mutex_lock(&rooms_mutex);
-
     GameRoom *room = &rooms[room_id];
 
     if(room->room_id == -1){
-        pthread_mutex_unlock(&rooms_mutex);
-        pthread_mutex_unlock(&clients_mutex);
         return -1;
     }
 
@@ -476,7 +639,7 @@ int get_room_info(int room_id, char *buffer, size_t buffer_size){
     // Načti do bufferu ve formátu "<nick>|<ready_count>|<vlastník/host>"
     for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
         int client_index = room->player_indexes[i];
-        if(client_index != -1 && client_index < MAX_CLIENTS){
+        if(client_index != -1 && client_index < max_clients){
             offset += snprintf(temp + offset, sizeof(temp) - offset, 
                              "%s|%s|%s,", 
                              clients[client_index].nick, 
@@ -488,42 +651,49 @@ int get_room_info(int room_id, char *buffer, size_t buffer_size){
     strncpy(buffer, temp, buffer_size - 1);
     buffer[buffer_size - 1] = '\0';
 
-    pthread_mutex_unlock(&rooms_mutex);
-    pthread_mutex_unlock(&clients_mutex);
-
     // Vrať délku bufferu
     return strlen(buffer);
 }
 
 void broadcast_to_room(int room_id, const char* type_msg, const char* message, int except_client_index){
-    if(room_id < 0 || room_id > MAX_ROOMS){
+    if(room_id < 0 || room_id >= max_rooms){
         return;
     }
 
-    pthread_mutex_lock(&rooms_mutex);
-    pthread_mutex_lock(&clients_mutex);
-
     GameRoom *room = &rooms[room_id];
+    pthread_mutex_lock(&room->lock);
+    broadcast_to_room_locked(room, type_msg, message, except_client_index);
+    pthread_mutex_unlock(&room->lock);
+}
 
+void broadcast_to_room_locked(GameRoom *room, const char* type_msg, const char* message, int except_client_index){
     if(room->room_id == -1){
-        pthread_mutex_unlock(&clients_mutex);
-        pthread_mutex_unlock(&rooms_mutex);
-        
         return;
     }
 
-    // Pošli data všem v místnosti
+    int recipients[MAX_PLAYERS_PER_ROOM];
+    int recipient_count = 0;
+
+    // Odpojení hráči mají odchozí frontu odpojenou od socketu, zpráva se jim zahodí
     for(int i = 0; i < MAX_PLAYERS_PER_ROOM; i++){
         int client_index = room->player_indexes[i];
 
-        if(client_index != -1 && client_index != except_client_index && client_index < MAX_CLIENTS){
-            int sock = clients[client_index].socket_fd;
-
-            if(sock > 0){
-                send_message(sock, type_msg, message);
-            }
+        if(client_index != -1 && client_index != except_client_index && client_index < max_clients){
+            recipients[recipient_count++] = client_index;
         }
     }
-    pthread_mutex_unlock(&clients_mutex);
-    pthread_mutex_unlock(&rooms_mutex);
-}
\ No newline at end of file
+
+    if(recipient_count == 0){
+        return;
+    }
+
+    // Zpráva se serializuje jednou, fronty příjemců sdílí stejná data
+    OutFrame *frame = out_frame_create(type_msg, message, strlen(message));
+    if(!frame){
+        return;
+    }
+    for(int i = 0; i < recipient_count; i++){
+        out_queue_push(&clients[recipients[i]].out, frame);
+    }
+    out_frame_release(frame);
+}
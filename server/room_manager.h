@@ -3,12 +3,14 @@
 
 #include <pthread.h>
 #include "config.h"
+#include "outbound.h"
+#include "timer_wheel.h"
 
 struct GameInstance;
 
-#define MAX_ROOMS 7
 #define MAX_PLAYERS_PER_ROOM 2
 #define ROOM_NAME_LEN 15
+#define ROOM_LIST_BUFFER 4096
 
 /**
  * @brief Enum sloužící pro popis stavu místnosti
@@ -17,13 +19,14 @@ typedef enum{
     ROOM_WAITING,           // Místnost čeká na hráče -- všechny nevytvořené místnosti
     ROOM_READY,             // Místnost je připravena ke hře
     ROOM_PLAYING,           // Místnost hraje
-    ROOM_FINISHED           // Místnost dohrála
+    ROOM_FINISHED,          // Místnost dohrála
+    ROOM_STATUS_COUNT       // Počet stavů (rozměr statistik)
 } RoomStatus;
 
 /**
- * @brief Struktura udržující herní místnost
+ * @brief Struktura udržující herní místnost (každý slot začíná na vlastní cache line)
  */
-typedef struct GameRoom{
+typedef struct __attribute__((aligned(CACHE_LINE_SIZE))) GameRoom{
     int room_id;                                    // Identifikátor místnosti
     char room_name[ROOM_NAME_LEN+1];                // Název místnosti
     RoomStatus status;                              // Status místnosti
@@ -37,20 +40,37 @@ typedef struct GameRoom{
     int ready_count;                                // Číslo připravených hráčů
     
     void* game_instance;                            // Ukazatel na herní instanci
+
+    pthread_mutex_t lock;                           // Zámek místnosti (místnost, její hra a stav jejích hráčů)
+    TimerNode turn_timer;                           // Časovač tahu hry v místnosti (server_timers)
 } GameRoom;
 
-/** Pole všech existujících místností */
-extern GameRoom rooms[MAX_ROOMS];                      
-/** Mutex pro místnosti */
+/*
+ * Zamykání:
+ *  - GameRoom.lock chrání data místnosti, její GameInstance a status klientů, kteří jsou v místnosti.
+ *    Herní tahy (ON_TURN / ON_WAIT) běží jen pod tímto zámkem, místnosti se navzájem neblokují.
+ *  - clients_mutex chrání tabulku klientů (sloty, nicky, sockety, current_room), rooms_mutex tabulku
+ *    místností (volné sloty, zveřejnění room_id, seznam RLIS a položky v něm zobrazené).
+ *  - Pořadí: clients_mutex -> GameRoom.lock -> rooms_mutex -> games_mutex. Kdo drží zámek místnosti,
+ *    už nesmí zamknout clients_mutex. Zámky odchozích front a časového kola jsou listové.
+ */
+
+/** Pole všech místností (alokováno při startu na kapacitu max_rooms) */
+extern GameRoom *rooms;
+/** Kapacita pole místností */
+extern int max_rooms;
+/** Mutex pro tabulku místností */
 extern pthread_mutex_t rooms_mutex;
 
 /**
- * @brief Základní inicializace místností
+ * @brief Alokace a základní inicializace místností, naplní zásobník volných místností
+ * @param capacity Počet místností
+ * @return 0: SUCCESS, -1: ERROR (malloc)
  */
-void initialize_rooms();
+int initialize_rooms(int capacity);
 
 /**
- * @brief Spouští hru, pokud jsou všichni hráči připraveni
+ * @brief Spouští hru, pokud jsou všichni hráči připraveni (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @return 0 - SUCCESS, -1 - ERROR
  */
@@ -65,7 +85,7 @@ int start_game_in_room(int room_id);
 int create_room(const char* room_name, int creator_index);
 
 /**
- * @brief Umožňuje připojení k místnosti
+ * @brief Umožňuje připojení k místnosti (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @param client_index Index uživatele, který se chce připojit
  * @return -1: nevalidní identifikátor, -2: neexistující místnost, -3: Místnost již hraje, -4: Místnost plná, -5: Klient je v místnosti, room_id: SUCCESS
@@ -73,7 +93,7 @@ int create_room(const char* room_name, int creator_index);
 int connect_room(int room_id, int client_index);
 
 /**
- * @brief Umožňuje opustit aktuálně připojenou místnost
+ * @brief Umožňuje opustit aktuálně připojenou místnost (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @param client_index Index uživatele, který se odpojuje
  * @returns -1: ERROR, 0 SUCCESS
@@ -95,7 +115,7 @@ GameRoom* find_room(int room_id);
 GameRoom* find_client_room(int client_index);
 
 /**
- * @brief Nastavuje hráče na stav připravený
+ * @brief Nastavuje hráče na stav připravený (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @param client_index Klientský index
  * @param ready Binární hodnota -> 0 = unready, 1 = ready
@@ -111,21 +131,21 @@ int set_player_ready(int room_id, int client_index, int ready);
 int check_all_ready(GameRoom *room);
 
 /**
- * @brief Spouští hru
+ * @brief Spouští hru (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @return -1: ERROR, 0: SUCCESS
  */
 int start_game(int room_id);
 
 /**
- * @brief Ukončuje hru
+ * @brief Ukončuje hru (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @return -1: ERROR, 0: SUCCESS
  */
 int end_game(int room_id);
 
 /**
- * @brief Maže vytvořenou místnost
+ * @brief Maže vytvořenou místnost (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @return -1: ERROR, 0: SUCCESS
  */
@@ -140,7 +160,32 @@ int delete_room(int room_id);
 int get_room_list(char *buffer, size_t buffer_size);
 
 /**
- * @brief Shromažďuje informace o místnosti
+ * @brief Vrací sdílenou předem serializovanou zprávu RLIS, přestaví ji jen po změně místností
+ * @param count Výstup: počet místností ve zprávě (může být NULL)
+ * @return Zpráva s referencí pro volajícího (uvolnit out_frame_release), NULL: žádné místnosti / ERROR
+ */
+OutFrame *room_list_frame(int *count);
+
+/**
+ * @brief Označí seznam místností jako zastaralý (pro změny místnosti mimo room_manager)
+ */
+void room_list_invalidate();
+
+/**
+ * @brief Nastaví status místnosti a zneplatní seznam místností (volat pod zámkem místnosti)
+ * @param room Místnost
+ * @param status Nový status
+ */
+void room_set_status(GameRoom *room, RoomStatus status);
+
+/**
+ * @brief Počty založených místností podle stavu (bez zámku, pro správcovské rozhraní)
+ * @param counts Výstup
+ */
+void room_status_counts(int counts[ROOM_STATUS_COUNT]);
+
+/**
+ * @brief Shromažďuje informace o místnosti (volat pod zámkem místnosti)
  * @param room_id Identifikátor místnosti
  * @param buffer Buffer pro shromážděné informace
  * @param buffer_size Velikost bufferu
@@ -149,7 +194,7 @@ int get_room_list(char *buffer, size_t buffer_size);
 int get_room_info(int room_id, char *buffer, size_t buffer_size);
 
 /**
- * @brief Rozesílá zprávu všem v místnosti.
+ * @brief Rozesílá zprávu všem v místnosti, zámek místnosti si vezme sama (volající ho nesmí držet).
  * @param room_id Identifikátor místnosti
  * @param type_msg Typ zprávy z výčtového typu protocolu
  * @param message Zpráva pro klienta
@@ -157,4 +202,13 @@ int get_room_info(int room_id, char *buffer, size_t buffer_size);
  */
 void broadcast_to_room(int room_id, const char* type_msg, const char* message, int except_client_index);
 
+/**
+ * @brief Rozesílá zprávu všem v místnosti (volat pod zámkem místnosti)
+ * @param room Místnost
+ * @param type_msg Typ zprávy z výčtového typu protocolu
+ * @param message Zpráva pro klienta
+ * @param except_client_index -1 pro všechny klienty, jinak index klienta, komu zprávu neposílá
+ */
+void broadcast_to_room_locked(GameRoom *room, const char* type_msg, const char* message, int except_client_index);
+
 #endif
\ No newline at end of file
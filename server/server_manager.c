@@ -1,6 +1,11 @@
+// ppoll
+#define _GNU_SOURCE
 #include "server_manager.h"
 #include "config.h"
 #include "client_manager.h"
+#include "reactor.h"
+#include "admin.h"
+#include "options.h"
 #include "logger.h"
 
 #include <stdio.h>
@@ -13,6 +18,18 @@
 #include <ctype.h>
 #include <errno.h>
 #include <string.h>
+#include <signal.h>
+#include <poll.h>
+#include <stdatomic.h>
+
+// Požadavek na ukončení ze signal handleru (SIGINT/SIGTERM)
+static volatile sig_atomic_t stop_requested = 0;
+// Ukončování serveru -> časovač a čekání na klientská vlákna
+static atomic_int server_stopping = 0;
+// Maska signálů, se kterou hlavní vlákno čeká v ppoll (SIGINT/SIGTERM povolené jen tam)
+static sigset_t accept_wait_mask;
+// Běžící klientská vlákna (režim vlákno na klienta)
+static atomic_int client_threads_running = 0;
 
 void error(const char *msg){
     LOG_ERROR("%s\n", msg);
@@ -20,16 +37,100 @@ void error(const char *msg){
 }
 
 void* timeout_checker_thread(void* arg){
-    LOG_INFO("Timeout checker vlákno spuštěno (interval %ds)\n", TIMEOUT_CHECK_INTERVAL);
+    LOG_INFO("Timeout checker vlákno spuštěno (tick %dms)\n", TIMER_TICK_MS);
 
-    while(1){
-        sleep(TIMEOUT_CHECK_INTERVAL);
+    while(!atomic_load(&server_stopping)){
+        usleep(TIMER_TICK_MS * 1000);
         check_client_timeouts();
     }
 
     return NULL;
 }
 
+/**
+ * @brief Obsluha SIGINT/SIGTERM, jen nastaví příznak (doručuje se jen do ppoll hlavního vlákna)
+ */
+static void on_stop_signal(int sig){
+    (void)sig;
+    stop_requested = 1;
+}
+
+void server_signals_init(void){
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+
+    // Vlákna vytvořená později masku zdědí -> signál nepřeruší klienta ani reaktor
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &accept_wait_mask);
+    sigdelset(&accept_wait_mask, SIGINT);
+    sigdelset(&accept_wait_mask, SIGTERM);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+/**
+ * @brief Tělo klientského vlákna, počítá běžící vlákna pro ukončení serveru
+ */
+static void* client_thread_main(void *arg){
+    client_handler(arg);
+    atomic_fetch_sub(&client_threads_running, 1);
+    return NULL;
+}
+
+/**
+ * @brief Ukončí klientská vlákna: zavře čtení socketů a počká, až vlákna uklidí své sloty
+ * @return Počet vláken, která do SHUTDOWN_WAIT_MS neskončila
+ */
+static int stop_client_threads(void){
+    pthread_mutex_lock(&clients_mutex);
+    for(int i = 0; i < max_clients; i++){
+        if(clients[i].socket_fd >= 0){
+            shutdown(clients[i].socket_fd, SHUT_RDWR);
+        }
+    }
+    pthread_mutex_unlock(&clients_mutex);
+
+    for(int waited = 0; atomic_load(&client_threads_running) > 0 && waited < SHUTDOWN_WAIT_MS; waited += TIMER_TICK_MS){
+        usleep(TIMER_TICK_MS * 1000);
+    }
+    int left = atomic_load(&client_threads_running);
+    if(left > 0){
+        LOG_WARN("Klientská vlákna neskončila včas (%d)\n", left);
+    }
+    return left;
+}
+
+/**
+ * @brief Spustí klientské vlákno pro nové spojení (režim vlákno na klienta)
+ * @param client_sock Socket klienta
+ * @param client_index Index přiděleného slotu
+ * @return 0: SUCCESS, -1: ERROR
+ */
+static int spawn_client_thread(int client_sock, int client_index){
+    ThreadContext *context = (ThreadContext*)malloc(sizeof(ThreadContext));
+    if(!context){
+        return -1;
+    }
+    context->socket_fd = client_sock;
+    context->client_index = client_index;
+
+    pthread_t client_thread;
+    atomic_fetch_add(&client_threads_running, 1);
+    if(pthread_create(&client_thread, NULL, client_thread_main, (void*)context) != 0){
+        atomic_fetch_sub(&client_threads_running, 1);
+        free(context);
+        return -1;
+    }
+    pthread_detach(client_thread);  // Po skončení vlákna OS udělá cleanup (uvolní paměť, kterou vlákno drželo)
+    return 0;
+}
+
 /**
  * @brief Kontroluje vloženou IP adresu - správný formát, počet teček, pouze čísla
  * @param ip Řetězec IP adresy
@@ -64,7 +165,7 @@ int is_valid_ip(const char *ip) {
     return parts == 4;
 }
 
-void start_server(int argc, char **argv){
+int start_server(int argc, char **argv){
     int server_fd, new_socket;          // Proměnné pro server socket a socket klienta
     struct sockaddr_in address;         // Struktura pro síťové nastavení (IPv4, adresy a portu)
     int addrlen = sizeof(address);      // Délka adresy
@@ -158,28 +259,57 @@ void start_server(int argc, char **argv){
         exit(EXIT_FAILURE);
     }
 
-    // Listen -> fronta 10 klientů
-    result = listen(server_fd, MAX_CLIENTS);
+    // Listen -> délka fronty nezávislá na kapacitě tabulky klientů (--backlog)
+    result = listen(server_fd, server_options.listen_backlog);
     if(result < 0){
         printf("ERROR: Listen (%d)\n", result);
         exit(EXIT_FAILURE);
     }
 
     // Výpis dosavadního stavu
-    printf("Server naslouchá na adrese %s:%d, přijímá %d klientů\n", act_add, act_port, MAX_CLIENTS);
+    printf("Server naslouchá na adrese %s:%d, přijímá %d klientů, %d místností (backlog %d)\n",
+           act_add, act_port, max_clients, max_rooms, server_options.listen_backlog);
+
 
+    // Writer vlákno pro odchozí fronty klientů
+    if(outbound_start(server_options.out_queue_bytes, server_options.slow_client_policy) != 0){
+        printf("ERROR: Nelze spustit writer vlákno\n");
+        exit(EXIT_FAILURE);
+    }
 
     // Vlákno pro kontrolu timeoutu (start)
     pthread_t timeout_thread;
-    if(pthread_create(&timeout_thread, NULL, timeout_checker_thread, NULL) != 0){
+    int timeout_started = pthread_create(&timeout_thread, NULL, timeout_checker_thread, NULL) == 0;
+    if(!timeout_started){
         printf("Chyba: Timeout thread\n");
     }
-    pthread_detach(timeout_thread);
 
-    // Smyčka přijímající klienty
-    for(;;){
+    // Režim epoll reaktorů (--reactor)
+    if(server_options.reactor_threads > 0){
+        if(reactor_start(server_options.reactor_threads) != 0){
+            printf("ERROR: Nelze spustit reaktory\n");
+            exit(EXIT_FAILURE);
+        }
+        printf("INFO: Režim epoll, %d reaktorů\n", server_options.reactor_threads);
+    }
+
+    // Správcovské rozhraní (--admin), jen loopback nebo UNIX socket
+    if(server_options.admin_endpoint){
+        if(admin_start(server_options.admin_endpoint) != 0){
+            printf("ERROR: Nelze spustit správcovské rozhraní na %s\n", server_options.admin_endpoint);
+            exit(EXIT_FAILURE);
+        }
+        printf("INFO: Správcovské rozhraní na %s\n", server_options.admin_endpoint);
+    }
+
+    // Smyčka přijímající klienty (do SIGINT/SIGTERM)
+    struct pollfd listen_poll = { .fd = server_fd, .events = POLLIN };
+    while(!stop_requested){
         printf("Čekám na klienta...\n");
-        // Čekání na klienta
+        // Čekání na klienta, signál ukončení se doručí jen během ppoll
+        if(ppoll(&listen_poll, 1, NULL, &accept_wait_mask) < 0){
+            continue;
+        }
         new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen);
         // DLOG("ACCEPT fd=%d", new_socket);
         if(new_socket < 0){
@@ -190,43 +320,65 @@ void start_server(int argc, char **argv){
         // Struktura klientů připojených k serveru
         pthread_mutex_lock(&clients_mutex);
 
-        int client_index = -1; // Nastav na "neplatný" index
-        for(int i = 0; i < MAX_CLIENTS; i++){
-            if(clients[i].socket_fd == -1 && clients[i].nick[0] == '\0'){
-                client_index = i;
-                break; // Místo nalezeno
-            }
-        }
+        // Volný slot ze zásobníku (O(1)), -1: "neplatný" index
+        int client_index = client_slot_acquire_locked();
+
         // Volné místo nalezeno -> přiřad klienta do pole
         if(client_index != -1){
             clients[client_index].socket_fd = new_socket;           // Nastav socket z acceptu
             clients[client_index].player_id = client_index + 1;     // Nastav index klienta (zde přičteme jedničku)
             clients[client_index].is_active = 1;                    // Připojil se -> je aktivní
-            clients[client_index].status = CONNECTED;               // Nastav serverový stav CONNECTED
-
-            ThreadContext *context = (ThreadContext*)malloc(sizeof(ThreadContext));
-            context->socket_fd = new_socket;
-            context->client_index = client_index;
-
-            // DLOG("ASSIGN slot=%d fd=%d", client_index, new_socket);  // Debugovací výpis
-
-            pthread_t client_thread;
-            if(pthread_create(&client_thread, NULL, client_handler, (void*)context) < 0){
-                error("Chyba: pthread_create\n");
-                send_error(new_socket, "Cannot connect at the moment (pthread_error)");
-                close(new_socket);
-                clients[client_index].socket_fd = -1;   // Defaultní hodnota pro nepřipojeného klienta
-                clients[client_index].is_active = 0;
-            } else{
-                pthread_detach(client_thread);  // Po skončení vlákna OS udělá cleanup (uvolní paměť, kterou vlákno drželo)
-                LOG_INFO("Novy hrac pripojen (FD: %d, ID: %d)\n", new_socket, clients[client_index].player_id);
-            }
-        } 
+            client_set_status(&clients[client_index], CONNECTED);   // Nastav serverový stav CONNECTED
+        }
+        pthread_mutex_unlock(&clients_mutex);
+
         // Nenalezeno volné místo -> informuj klienta a odpoj ho
-        else{
+        if(client_index == -1){
             send_error(new_socket, "Cannot connect at the moment (FULL)");
             close(new_socket); // Zavři klienta
+            continue;
+        }
+
+        // Předání spojení reaktoru nebo novému vláknu
+        int dispatched;
+        if(server_options.reactor_threads > 0){
+            dispatched = reactor_add_client(new_socket, client_index);
+        } else{
+            dispatched = spawn_client_thread(new_socket, client_index);
+        }
+
+        if(dispatched != 0){
+            LOG_ERROR("Nelze převzít spojení (fd=%d)\n", new_socket);
+            out_queue_detach(&clients[client_index].out, new_socket);
+            send_error(new_socket, "Cannot connect at the moment (dispatch error)");
+            close(new_socket);
+
+            pthread_mutex_lock(&clients_mutex);
+            clients[client_index].socket_fd = -1;   // Defaultní hodnota pro nepřipojeného klienta
+            clients[client_index].is_active = 0;
+            client_slot_release_locked(client_index);
+            pthread_mutex_unlock(&clients_mutex);
+        } else{
+            LOG_INFO("Novy hrac pripojen (FD: %d, ID: %d)\n", new_socket, client_index + 1);
         }
-        pthread_mutex_unlock(&clients_mutex);
     }
+
+    // Ukončení: nové spojení už nepřijde, zprávy přestanou obsluhovat reaktory i klientská vlákna
+    LOG_INFO("Server se zastavuje (signál)\n");
+    close(server_fd);
+    atomic_store(&server_stopping, 1);
+    if(timeout_started){
+        pthread_join(timeout_thread, NULL);
+    }
+    int left = 0;
+    if(server_options.reactor_threads > 0){
+        reactor_stop();
+    } else{
+        left = stop_client_threads();
+    }
+
+    // Writer a správcovské vlákno logují a trasují -> musí skončit před uzavřením loggeru a trasování
+    admin_stop();
+    outbound_stop();
+    return left;
 }
\ No newline at end of file
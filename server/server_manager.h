@@ -3,11 +3,20 @@
 
 #include "config.h"
 
+/**
+ * @brief Zablokuje SIGINT/SIGTERM ve volajícím vlákně a nastaví jejich obsluhu
+ * (volat v main před spuštěním prvního vlákna, signál pak přijímá jen smyčka acceptu)
+ */
+void server_signals_init(void);
+
 /**
  * @brief Provádí základní síťovou inicializaci (socket, bind, listen, accept, [send, receive], close)
+ * Vrací se po SIGINT/SIGTERM, když reaktory i klientská vlákna přestanou obsluhovat zprávy
+ * a writer i správcovské vlákno skončí
  * @param argc Počet argumentů předaných přes argc
  * @param argv Pole argumentů z cmd
+ * @return 0: žádné další vlákno neběží, >0: počet klientských vláken, která neskončila včas
  */
-void start_server(int argc, char **argv);
+int start_server(int argc, char **argv);
 
 #endif
@@ -0,0 +1,106 @@
+#include "slot_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief FNV-1a hash řetězce
+ */
+static uint32_t slot_index_hash(const char *key){
+    uint32_t hash = 2166136261u;
+    while(*key){
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int slot_index_init(SlotIndex *index, int capacity, SlotKeyFn key_of){
+    // Nejmenší mocnina dvou alespoň dvojnásobku kapacity
+    uint32_t size = 2;
+    while(size < (uint32_t)capacity * 2){
+        size <<= 1;
+    }
+
+    index->entries = (SlotIndexEntry*)malloc(size * sizeof(SlotIndexEntry));
+    if(!index->entries){
+        return -1;
+    }
+    for(uint32_t i = 0; i < size; i++){
+        index->entries[i].slot = -1;
+        index->entries[i].hash = 0;
+    }
+    index->mask = size - 1;
+    index->count = 0;
+    index->key_of = key_of;
+    return 0;
+}
+
+int slot_index_find(const SlotIndex *index, const char *key){
+    uint32_t hash = slot_index_hash(key);
+
+    for(uint32_t i = hash & index->mask; ; i = (i + 1) & index->mask){
+        const SlotIndexEntry *entry = &index->entries[i];
+        if(entry->slot == -1){
+            return -1;
+        }
+        if(entry->hash == hash && strcmp(index->key_of(entry->slot), key) == 0){
+            return entry->slot;
+        }
+    }
+}
+
+int slot_index_insert(SlotIndex *index, int slot){
+    // Zaplnění nejvýše polovina -> sondování vždy narazí na prázdnou položku
+    if((uint32_t)(index->count + 1) * 2 > index->mask + 1){
+        return -1;
+    }
+
+    const char *key = index->key_of(slot);
+    uint32_t hash = slot_index_hash(key);
+
+    uint32_t i = hash & index->mask;
+    while(index->entries[i].slot != -1){
+        if(index->entries[i].hash == hash && strcmp(index->key_of(index->entries[i].slot), key) == 0){
+            return -1;
+        }
+        i = (i + 1) & index->mask;
+    }
+
+    index->entries[i].slot = slot;
+    index->entries[i].hash = hash;
+    index->count++;
+    return 0;
+}
+
+void slot_index_remove(SlotIndex *index, int slot){
+    uint32_t hash = slot_index_hash(index->key_of(slot));
+
+    // Nalezení položky slotu
+    uint32_t i = hash & index->mask;
+    while(index->entries[i].slot != slot){
+        if(index->entries[i].slot == -1){
+            return;     // Slot v indexu není
+        }
+        i = (i + 1) & index->mask;
+    }
+
+    // Posun následujících položek zpět, aby sondování nenarazilo na díru
+    uint32_t j = i;
+    for(;;){
+        j = (j + 1) & index->mask;
+        if(index->entries[j].slot == -1){
+            break;
+        }
+
+        uint32_t ideal = index->entries[j].hash & index->mask;
+        // Položku j lze přesunout na i, pokud její ideální pozice neleží v (i, j]
+        if(((j - ideal) & index->mask) >= ((j - i) & index->mask)){
+            index->entries[i] = index->entries[j];
+            i = j;
+        }
+    }
+
+    index->entries[i].slot = -1;
+    index->entries[i].hash = 0;
+    index->count--;
+}
@@ -0,0 +1,57 @@
+#ifndef SLOT_INDEX_H
+#define SLOT_INDEX_H
+
+#include <stdint.h>
+
+/**
+ * Vrátí klíč (řetězec) uložený ve slotu tabulky, index si klíče nekopíruje
+ */
+typedef const char *(*SlotKeyFn)(int slot);
+
+// Jedna položka otevřené adresace
+typedef struct{
+    int slot;                   // Index do tabulky (-1: prázdné)
+    uint32_t hash;              // Uložený hash klíče (rychlé porovnání, posun při mazání)
+} SlotIndexEntry;
+
+// Hash index řetězec -> slot (lineární sondování, mazání posunem bez náhrobků)
+typedef struct{
+    SlotIndexEntry *entries;    // Pole položek (velikost mocnina dvou)
+    uint32_t mask;              // Velikost pole - 1
+    int count;                  // Počet obsazených položek
+    SlotKeyFn key_of;           // Přístup ke klíči slotu
+} SlotIndex;
+
+/**
+ * @brief Alokace indexu pro danou kapacitu (zaplnění nejvýše 50 %)
+ * @param index Index
+ * @param capacity Maximální počet klíčů
+ * @param key_of Funkce vracející klíč slotu
+ * @return 0: SUCCESS, -1: ERROR (malloc)
+ */
+int slot_index_init(SlotIndex *index, int capacity, SlotKeyFn key_of);
+
+/**
+ * @brief Najde slot podle klíče
+ * @param index Index
+ * @param key Hledaný klíč
+ * @return index slotu, -1: nenalezeno
+ */
+int slot_index_find(const SlotIndex *index, const char *key);
+
+/**
+ * @brief Vloží slot pod jeho aktuální klíč (key_of(slot) už musí být nastaven)
+ * @param index Index
+ * @param slot Slot
+ * @return 0: SUCCESS, -1: ERROR (klíč již existuje / plno)
+ */
+int slot_index_insert(SlotIndex *index, int slot);
+
+/**
+ * @brief Odstraní slot z indexu (volat dřív, než se klíč ve slotu smaže)
+ * @param index Index
+ * @param slot Slot
+ */
+void slot_index_remove(SlotIndex *index, int slot);
+
+#endif
@@ -0,0 +1,523 @@
+#include "solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SOLVER_FACES (CARD_SUITS * CARD_RANKS + 1)     // 52 kódů + žolík
+#define SOLVER_JOKER_FACE (CARD_SUITS * CARD_RANKS)
+#define SOLVER_CLOCK_MASK 255                           // Čas se kontroluje jednou za 256 uzlů
+
+// Kombinace pro hledání: potřebné kódy z ruky (každý nejvýše jednou) a počet žolíků
+typedef struct{
+    uint8_t faces[MAX_SEQUENCE_CARDS];
+    uint8_t naturals;
+    uint8_t jokers;
+    uint8_t count;
+    int points;
+    int meld;                           // Index do vyjmenovaných kombinací
+} SolverCandidate;
+
+// Stav prohledávání do hloubky
+typedef struct{
+    const SolverCandidate *candidates;
+    int candidate_count;
+    uint8_t counts[SOLVER_FACES];       // Zbylé karty v ruce podle kódu
+    uint8_t attach_targets[SOLVER_FACES]; // Na kolik kombinací na stole jde kód přiložit
+    int limit;                          // Nejvíc karet z ruky (jedna zůstane na zavření)
+    int upper;                          // Víc karet z ruky dostat nejde (konec hledání)
+
+    int chosen[SOLVER_MAX_PLAN_MELDS];
+    int depth;
+    int best[SOLVER_MAX_PLAN_MELDS];
+    int best_depth;
+    int best_discharged;
+    int best_points;
+
+    unsigned long nodes;
+    uint64_t deadline_ns;               // 0: bez omezení
+    int stopped;
+} SolverSearch;
+
+static uint64_t solver_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline int solver_face(Card card){
+    return card_is_joker(card) ? SOLVER_JOKER_FACE : card_face(card);
+}
+
+static inline Card solver_face_card(int face){
+    return face == SOLVER_JOKER_FACE ? (Card)CARD_JOKER : (Card)face;
+}
+
+/**
+ * @brief Počty karet v ruce podle kódu
+ */
+static void solver_hand_counts(const CardHand *hand, uint8_t counts[SOLVER_FACES]){
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        for(int rank = 0; rank < CARD_RANKS; rank++){
+            counts[suit * CARD_RANKS + rank] = (uint8_t)(((hand->ranks[suit] >> rank) & 1u) +
+                                                         ((hand->doubles[suit] >> rank) & 1u));
+        }
+    }
+    counts[SOLVER_JOKER_FACE] = hand->jokers;
+}
+
+/**
+ * @brief Ověří kombinaci přes meld_classify a přidá ji do výstupu
+ * @return nový počet kombinací
+ */
+static int solver_add_meld(const Card *cards, int count, MeldKind expect, Meld *melds, int n, int max){
+    if(n < max && meld_classify(cards, count, &melds[n]) == expect){
+        return n + 1;
+    }
+    return n;
+}
+
+/**
+ * @brief Je hodnota 1..14 v barvě v ruce (14: eso nahoře)
+ */
+static inline int solver_has_value(uint16_t ranks, int value){
+    return (ranks >> (value == MELD_ACE_HIGH ? 0 : value - 1)) & 1u;
+}
+
+int solver_enumerate_melds(const CardHand *hand, Meld *melds, int max){
+    int n = 0;
+    int jokers = hand->jokers;
+    Card cards[MAX_SEQUENCE_CARDS];
+
+    // Sety: každá podmnožina barev dané hodnoty, doplněná žolíky do 3..4 karet
+    for(int rank = 0; rank < CARD_RANKS; rank++){
+        unsigned present = 0;
+
+        for(int suit = 0; suit < CARD_SUITS; suit++){
+            present |= ((hand->ranks[suit] >> rank) & 1u) << suit;
+        }
+
+        for(unsigned subset = present; subset; subset = (subset - 1) & present){
+            int naturals = 0;
+
+            for(int suit = 0; suit < CARD_SUITS; suit++){
+                if((subset >> suit) & 1u){
+                    cards[naturals++] = card_make(suit, rank);
+                }
+            }
+            for(int j = 0; j <= jokers && naturals + j <= CARD_SUITS; j++){
+                if(naturals + j >= 3){
+                    n = solver_add_meld(cards, naturals + j, MELD_SET, melds, n, max);
+                }
+                cards[naturals + j] = CARD_JOKER;
+            }
+        }
+    }
+
+    // Postupky: okno hodnot lo..hi s kartami na obou krajích, mezery doplní žolíci. Žolík může nahradit
+    // i kartu uvnitř okna (ta pak zůstane pro jinou kombinaci), zbylí žolíci jdou na kraje.
+    for(int suit = 0; suit < CARD_SUITS; suit++){
+        uint16_t ranks = hand->ranks[suit];
+
+        for(int lo = 1; lo < MELD_ACE_HIGH; lo++){
+            if(!solver_has_value(ranks, lo)){
+                continue;
+            }
+
+            int naturals = 1;
+            int inner_count = 0;                // Hodnoty uvnitř okna, které ruka má
+
+            for(int hi = lo + 1; hi <= MELD_ACE_HIGH; hi++){
+                if(!solver_has_value(ranks, hi)){
+                    continue;
+                }
+                // Eso nemůže být na obou koncích (dvakrát stejná hodnota)
+                if(lo == 1 && hi == MELD_ACE_HIGH){
+                    break;
+                }
+                naturals++;
+
+                int length = hi - lo + 1;
+                int gaps = length - naturals;
+                if(gaps > jokers || length > MAX_SEQUENCE_CARDS){
+                    break;
+                }
+
+                // Nahrazené hodnoty: kombinace velikosti 0..spare z inner (Gosperův trik)
+                int spare = jokers - gaps;
+                for(int r = 0; r <= spare && r <= inner_count; r++){
+                    unsigned drop = (1u << r) - 1;
+
+                    while(drop < (1u << inner_count)){
+                        int count = 0;
+                        int top = lo;           // Nejvyšší hodnota karty pod esem nahoře
+                        int k = 0;
+
+                        for(int v = lo; v <= hi; v++){
+                            int natural = solver_has_value(ranks, v);
+
+                            if(natural && v != lo && v != hi){
+                                natural = !((drop >> k) & 1u);
+                                k++;
+                            }
+                            if(natural && v < MELD_ACE_HIGH){
+                                top = v;
+                            }
+                            cards[count++] = natural ? card_make(suit, v == MELD_ACE_HIGH ? 0 : v - 1) : CARD_JOKER;
+                        }
+
+                        int used = gaps + r;    // Žolíci v okně
+                        int kept = naturals - r;
+                        for(int extra = 0; used + extra <= jokers && count + extra <= MAX_SEQUENCE_CARDS; extra++){
+                            if(extra > 0){
+                                cards[count + extra - 1] = CARD_JOKER;
+                            }
+                            // Stejné karty s esem dole (okno 1..top) vyjmenuje to okno, meld_classify volí eso dole
+                            if(count + extra < 3 || (hi == MELD_ACE_HIGH && top - kept <= used + extra)){
+                                continue;
+                            }
+                            n = solver_add_meld(cards, count + extra, MELD_SEQUENCE, melds, n, max);
+                        }
+
+                        if(r == 0){
+                            break;
+                        }
+                        unsigned low_bit = drop & -drop;
+                        unsigned ripple = drop + low_bit;
+                        drop = (((ripple ^ drop) >> 2) / low_bit) | ripple;
+                    }
+                }
+
+                // Horní kraj se pro další okna stává vnitřní hodnotou
+                inner_count++;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Dá se karta přiložit ke kombinaci (druh kombinace se nezmění)
+ */
+static int solver_can_attach(const CardSequence *seq, Card card, Meld *meld){
+    Card extended[MAX_SEQUENCE_CARDS];
+
+    if(seq->count >= MAX_SEQUENCE_CARDS){
+        return 0;
+    }
+    memcpy(extended, seq->cards, seq->count);
+    extended[seq->count] = card;
+    return meld_classify(extended, seq->count + 1, meld) == (MeldKind)seq->kind;
+}
+
+int solver_enumerate_attachments(const CardHand *hand, const CardSequence *sequences, int sequence_count,
+                                 SolverAttach *attaches, int max){
+    uint8_t counts[SOLVER_FACES];
+    int n = 0;
+    Meld meld;
+
+    solver_hand_counts(hand, counts);
+    for(int face = 0; face < SOLVER_FACES; face++){
+        if(counts[face] == 0){
+            continue;
+        }
+        for(int s = 0; s < sequence_count && n < max; s++){
+            if(solver_can_attach(&sequences[s], solver_face_card(face), &meld)){
+                attaches[n].seq_id = sequences[s].id;
+                attaches[n].card = solver_face_card(face);
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Větší kombinace (a dražší) napřed, hledání tak rychle najde dobrý plán
+ */
+static int solver_candidate_cmp(const void *a, const void *b){
+    const SolverCandidate *ca = (const SolverCandidate*)a;
+    const SolverCandidate *cb = (const SolverCandidate*)b;
+
+    if(ca->count != cb->count){
+        return cb->count - ca->count;
+    }
+    if(ca->points != cb->points){
+        return cb->points - ca->points;
+    }
+    return ca->meld - cb->meld;
+}
+
+/**
+ * @brief Odhad přiložení zbylých karet ke stolu (každý kód nejvýše na tolik kombinací, kolik ho přijme)
+ */
+static void solver_attach_estimate(const SolverSearch *s, int *cards, int *points){
+    *cards = 0;
+    *points = 0;
+
+    for(int face = 0; face < SOLVER_FACES; face++){
+        int n = s->counts[face] < s->attach_targets[face] ? s->counts[face] : s->attach_targets[face];
+
+        *cards += n;
+        *points += n * card_value(solver_face_card(face));
+    }
+}
+
+static int solver_candidate_available(const SolverSearch *s, const SolverCandidate *c){
+    if(s->counts[SOLVER_JOKER_FACE] < c->jokers){
+        return 0;
+    }
+    for(int i = 0; i < c->naturals; i++){
+        if(s->counts[c->faces[i]] == 0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void solver_candidate_take(SolverSearch *s, const SolverCandidate *c, int delta){
+    s->counts[SOLVER_JOKER_FACE] = (uint8_t)(s->counts[SOLVER_JOKER_FACE] + delta * c->jokers);
+    for(int i = 0; i < c->naturals; i++){
+        s->counts[c->faces[i]] = (uint8_t)(s->counts[c->faces[i]] + delta);
+    }
+}
+
+/**
+ * @brief Prohledávání kombinací vyložení (kombinace v pořadí kandidátů, stejnou lze použít znovu z druhého balíčku)
+ */
+static void solver_search(SolverSearch *s, int start, int used, int points){
+    s->nodes++;
+    if((s->nodes & SOLVER_CLOCK_MASK) == 0 && s->deadline_ns && solver_now_ns() > s->deadline_ns){
+        s->stopped = 1;
+    }
+    if(s->stopped || s->best_discharged >= s->upper){
+        return;
+    }
+
+    // Hodnocení uzlu: vyložené karty a odhad přiložení zbytku
+    int attach_cards, attach_points;
+    solver_attach_estimate(s, &attach_cards, &attach_points);
+
+    int discharged = used + attach_cards < s->limit ? used + attach_cards : s->limit;
+    if(discharged > s->best_discharged ||
+       (discharged == s->best_discharged && points + attach_points > s->best_points)){
+        s->best_discharged = discharged;
+        s->best_points = points + attach_points;
+        s->best_depth = s->depth;
+        memcpy(s->best, s->chosen, sizeof(int) * s->depth);
+    }
+
+    if(s->depth >= SOLVER_MAX_PLAN_MELDS){
+        return;
+    }
+
+    for(int i = start; i < s->candidate_count; i++){
+        const SolverCandidate *c = &s->candidates[i];
+
+        if(used + c->count > s->limit || !solver_candidate_available(s, c)){
+            continue;
+        }
+
+        solver_candidate_take(s, c, -1);
+        s->chosen[s->depth++] = i;
+        solver_search(s, i, used + c->count, points + c->points);
+        s->depth--;
+        solver_candidate_take(s, c, +1);
+
+        if(s->stopped || s->best_discharged >= s->upper){
+            return;
+        }
+    }
+}
+
+int solver_plan(const CardHand *hand, const CardSequence *sequences, int sequence_count,
+                unsigned budget_us, SolverPlan *plan){
+    if(!hand || !plan || sequence_count < 0 || (sequence_count > 0 && !sequences)){
+        return -1;
+    }
+
+    uint64_t deadline = budget_us ? solver_now_ns() + (uint64_t)budget_us * 1000ULL : 0;
+    memset(plan, 0, sizeof(*plan));
+    plan->complete = 1;
+
+    if(hand->count <= 1){
+        return 0;
+    }
+
+    Meld melds[SOLVER_MAX_MELDS];
+    SolverCandidate candidates[SOLVER_MAX_MELDS];
+    SolverSearch s;
+    Meld attach_meld;
+    int meld_count = solver_enumerate_melds(hand, melds, SOLVER_MAX_MELDS);
+
+    memset(&s, 0, sizeof(s));
+    solver_hand_counts(hand, s.counts);
+    s.limit = hand->count - 1;
+    s.deadline_ns = deadline;
+
+    // Kódy, které jdou přiložit ke stolu (ty, které ruka má)
+    uint8_t useful[SOLVER_FACES] = {0};
+    for(int face = 0; face < SOLVER_FACES; face++){
+        if(s.counts[face] == 0){
+            continue;
+        }
+        for(int q = 0; q < sequence_count; q++){
+            s.attach_targets[face] += solver_can_attach(&sequences[q], solver_face_card(face), &attach_meld);
+        }
+        useful[face] = s.attach_targets[face] < s.counts[face] ? s.attach_targets[face] : s.counts[face];
+    }
+
+    // Kandidáti vyložení
+    for(int m = 0; m < meld_count; m++){
+        SolverCandidate *c = &candidates[m];
+
+        c->naturals = 0;
+        c->jokers = 0;
+        c->count = melds[m].count;
+        c->points = 0;
+        c->meld = m;
+        for(int i = 0; i < melds[m].count; i++){
+            Card card = melds[m].cards[i];
+
+            c->points += card_value(card);
+            if(card_is_joker(card)){
+                c->jokers++;
+            } else{
+                c->faces[c->naturals++] = (uint8_t)solver_face(card);
+                useful[solver_face(card)] = s.counts[solver_face(card)];
+            }
+        }
+        if(c->jokers > 0){
+            useful[SOLVER_JOKER_FACE] = s.counts[SOLVER_JOKER_FACE];
+        }
+    }
+    qsort(candidates, (size_t)meld_count, sizeof(SolverCandidate), solver_candidate_cmp);
+
+    // Horní mez: karty, které nejsou v žádné kombinaci ani nejdou přiložit, z ruky nedostane nic
+    s.upper = 0;
+    for(int face = 0; face < SOLVER_FACES; face++){
+        s.upper += useful[face];
+    }
+    if(s.upper > s.limit){
+        s.upper = s.limit;
+    }
+
+    s.candidates = candidates;
+    s.candidate_count = meld_count;
+    s.best_discharged = -1;
+    solver_search(&s, 0, 0, 0);
+
+    plan->nodes = s.nodes;
+    plan->complete = !s.stopped && meld_count < SOLVER_MAX_MELDS;
+
+    // Vyložení z nejlepšího uzlu
+    uint8_t counts[SOLVER_FACES];
+    solver_hand_counts(hand, counts);
+    for(int d = 0; d < s.best_depth; d++){
+        const SolverCandidate *c = &candidates[s.best[d]];
+
+        plan->melds[plan->meld_count++] = melds[c->meld];
+        plan->discharged += c->count;
+        plan->points += c->points;
+        counts[SOLVER_JOKER_FACE] -= c->jokers;
+        for(int i = 0; i < c->naturals; i++){
+            counts[c->faces[i]]--;
+        }
+    }
+
+    // Přiložení hladově: stůl i vlastní vyložení (ID podle pořadí vyložení), žolíci a vyšší hodnoty napřed
+    CardSequence table[MAX_SEQUENCES + SOLVER_MAX_PLAN_MELDS];
+    int table_count = 0;
+    for(int q = 0; q < sequence_count && table_count < MAX_SEQUENCES; q++){
+        table[table_count++] = sequences[q];
+    }
+    int next_id = sequence_count;
+    for(int m = 0; m < plan->meld_count; m++){
+        CardSequence *seq = &table[table_count++];
+
+        memcpy(seq->cards, plan->melds[m].cards, plan->melds[m].count);
+        seq->count = plan->melds[m].count;
+        seq->kind = (uint8_t)plan->melds[m].kind;
+        seq->id = (uint16_t)++next_id;
+    }
+
+    int order[SOLVER_FACES];
+    int order_count = 0;
+    order[order_count++] = SOLVER_JOKER_FACE;
+    for(int rank = CARD_RANKS - 1; rank >= 0; rank--){
+        for(int suit = 0; suit < CARD_SUITS; suit++){
+            order[order_count++] = suit * CARD_RANKS + rank;
+        }
+    }
+
+    int attached = 1;
+    while(attached && plan->discharged < s.limit){
+        attached = 0;
+
+        for(int o = 0; o < order_count && !attached; o++){
+            int face = order[o];
+            if(counts[face] == 0){
+                continue;
+            }
+            Card card = solver_face_card(face);
+
+            for(int q = 0; q < table_count; q++){
+                if(!solver_can_attach(&table[q], card, &attach_meld)){
+                    continue;
+                }
+                memcpy(table[q].cards, attach_meld.cards, attach_meld.count);
+                table[q].count = attach_meld.count;
+
+                plan->attaches[plan->attach_count].seq_id = table[q].id;
+                plan->attaches[plan->attach_count].card = card;
+                plan->attach_count++;
+                plan->discharged++;
+                plan->points += card_value(card);
+                counts[face]--;
+                attached = 1;
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+int solver_plan_format(const SolverPlan *plan, char *buffer, size_t buffer_size){
+    if(!plan || !buffer){
+        return -1;
+    }
+
+    size_t offset = 0;
+    int written = snprintf(buffer, buffer_size, "%d|", plan->discharged);
+    if(written < 0 || (size_t)written >= buffer_size){
+        return -1;
+    }
+    offset = (size_t)written;
+
+    for(int m = 0; m < plan->meld_count; m++){
+        const Meld *meld = &plan->melds[m];
+
+        if(offset + meld->count * 2 + 2 >= buffer_size){
+            return -1;
+        }
+        if(m > 0){
+            buffer[offset++] = ',';
+        }
+        for(int i = 0; i < meld->count; i++){
+            memcpy(buffer + offset, card_code(meld->cards[i]), 2);
+            offset += 2;
+        }
+    }
+    buffer[offset++] = '|';
+
+    for(int a = 0; a < plan->attach_count; a++){
+        written = snprintf(buffer + offset, buffer_size - offset, "%s%u:%s", a > 0 ? "," : "",
+                           plan->attaches[a].seq_id, card_code(plan->attaches[a].card));
+        if(written < 0 || (size_t)written >= buffer_size - offset){
+            return -1;
+        }
+        offset += (size_t)written;
+    }
+    buffer[offset] = '\0';
+    return (int)offset;
+}
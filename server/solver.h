@@ -0,0 +1,79 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "game_engine.h"
+#include "meld.h"
+
+#define SOLVER_MAX_MELDS 1024           // Nejvíc vyjmenovaných kombinací z jedné ruky (víc jen u dlouhých postupek se 3+ žolíky)
+#define SOLVER_MAX_PLAN_MELDS 8         // Nejvíc vyložení v plánu (15 karet po 3, jedna zůstane)
+
+// Přiložení karty k vyložené kombinaci (ADDC)
+typedef struct{
+    uint16_t seq_id;                    // ID kombinace (stůl nebo vyložení z plánu, viz solver_plan)
+    Card card;
+} SolverAttach;
+
+// Plán tahu: vyložení a přiložení, po kterých v ruce zbude co nejméně karet (aspoň jedna na zavření)
+typedef struct{
+    Meld melds[SOLVER_MAX_PLAN_MELDS];  // UNLO v tomto pořadí
+    int meld_count;
+    SolverAttach attaches[MAX_HAND_CARD + 1]; // ADDC v tomto pořadí (po vyložení)
+    int attach_count;
+    int discharged;                     // Počet karet, které plán dostane z ruky
+    int points;                         // Jejich bodová hodnota
+    int complete;                       // 1: prohledáno celé (nejlepší vyložení), 0: vypršel rozpočet nebo plný výčet
+    unsigned long nodes;                // Prohledané uzly
+} SolverPlan;
+
+/**
+ * @brief Vyjmenuje všechny platné kombinace (UNLO), které jdou složit z karet ruky
+ *
+ * Sety po barvách, postupky v barvě s esem dole i nahoře, žolíci v mezerách i na krajích. Každá
+ * multimnožina kódů jen jednou, karty v kanonickém pořadí meld_classify. Počet karet v ruce nehlídá.
+ * @param hand Ruka
+ * @param melds Výstup
+ * @param max Kapacita výstupu
+ * @return počet kombinací (nejvýše max)
+ */
+int solver_enumerate_melds(const CardHand *hand, Meld *melds, int max);
+
+/**
+ * @brief Vyjmenuje všechna platná přiložení karet z ruky ke kombinacím na stole (ADDC)
+ * @param hand Ruka
+ * @param sequences Kombinace na stole
+ * @param sequence_count Počet kombinací
+ * @param attaches Výstup (každý kód karty jednou na kombinaci)
+ * @param max Kapacita výstupu
+ * @return počet přiložení (nejvýše max)
+ */
+int solver_enumerate_attachments(const CardHand *hand, const CardSequence *sequences, int sequence_count,
+                                 SolverAttach *attaches, int max);
+
+/**
+ * @brief Najde plán s co největším počtem karet dostaných z ruky (při shodě s větším součtem bodů)
+ *
+ * Vyložení prohledává do hloubky s ořezáváním, přiložení ke stolu i k vlastním vyložením doplní hladově.
+ * Vyložení z plánu dostanou po provedení ID sequence_count + 1, + 2, ... (na ně odkazují přiložení).
+ * V ruce vždy zůstane aspoň jedna karta. Bez globálního stavu, volat lze z libovolného vlákna.
+ * @param hand Ruka
+ * @param sequences Kombinace na stole
+ * @param sequence_count Počet kombinací
+ * @param budget_us Časový rozpočet hledání v mikrosekundách (0: bez omezení)
+ * @param plan Výstup
+ * @return 0: SUCCESS, -1: ERROR (parametry)
+ */
+int solver_plan(const CardHand *hand, const CardSequence *sequences, int sequence_count,
+                unsigned budget_us, SolverPlan *plan);
+
+/**
+ * @brief Naformátuje plán pro klienta (OINT)
+ *
+ * Formát: karty z ruky|vyložení (čárkou, kódy karet)|přiložení (čárkou, <ID>:<karta>)
+ * @param plan Plán
+ * @param buffer Buffer
+ * @param buffer_size Velikost bufferu
+ * @return -1: ERROR (buffer), int: Velikost zprávy: SUCCESS
+ */
+int solver_plan_format(const SolverPlan *plan, char *buffer, size_t buffer_size);
+
+#endif
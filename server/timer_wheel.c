@@ -0,0 +1,153 @@
+#include "timer_wheel.h"
+#include <time.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+// Nejvzdálenější tick, který kolo pojme přímo
+#define TIMER_WHEEL_RANGE (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+uint64_t timer_now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * @brief Připojí časovač na konec seznamu slotu
+ */
+static void timer_link(TimerNode *head, TimerNode *timer){
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+/**
+ * @brief Odpojí časovač ze seznamu slotu
+ */
+static void timer_unlink(TimerNode *timer){
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/**
+ * @brief Zařadí časovač do úrovně podle vzdálenosti deadlinu od aktuálního ticku
+ */
+static void timer_wheel_place(TimerWheel *wheel, TimerNode *timer){
+    uint64_t expires = timer->expires;
+
+    // Prošlé deadliny do aktuálního slotu, vzdálené na okraj rozsahu (přeplánují se při kaskádě)
+    if(expires < wheel->current){
+        expires = wheel->current;
+    }
+    if(expires - wheel->current >= TIMER_WHEEL_RANGE){
+        expires = wheel->current + TIMER_WHEEL_RANGE - 1;
+    }
+
+    uint64_t delta = expires - wheel->current;
+    int level = 0;
+    while(level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))){
+        level++;
+    }
+
+    int slot = (int)((expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    timer_link(&wheel->slots[level][slot], timer);
+}
+
+/**
+ * @brief Přesune časovače slotu vyšší úrovně do nižších úrovní
+ */
+static void timer_wheel_cascade(TimerWheel *wheel, int level, int slot){
+    TimerNode *head = &wheel->slots[level][slot];
+
+    while(head->next != head){
+        TimerNode *timer = head->next;
+        timer_unlink(timer);
+        timer_wheel_place(wheel, timer);
+    }
+}
+
+void timer_wheel_init(TimerWheel *wheel, uint64_t now_ms, uint32_t tick_ms){
+    for(int level = 0; level < TIMER_WHEEL_LEVELS; level++){
+        for(int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++){
+            TimerNode *head = &wheel->slots[level][slot];
+            head->next = head;
+            head->prev = head;
+        }
+    }
+    wheel->tick_ms = tick_ms ? tick_ms : 1;
+    wheel->current = now_ms / wheel->tick_ms;
+    wheel->count = 0;
+}
+
+void timer_init(TimerNode *timer, TimerCallback callback, void *arg){
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->pending = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+void timer_schedule(TimerWheel *wheel, TimerNode *timer, uint64_t deadline_ms){
+    timer_cancel(wheel, timer);
+
+    // Zaokrouhlení nahoru -> časovač nevyprší před deadlinem
+    timer->expires = (deadline_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    timer->pending = 1;
+    timer_wheel_place(wheel, timer);
+    wheel->count++;
+}
+
+void timer_cancel(TimerWheel *wheel, TimerNode *timer){
+    if(!timer->pending){
+        return;
+    }
+
+    timer_unlink(timer);
+    timer->pending = 0;
+    wheel->count--;
+}
+
+TimerNode *timer_wheel_expire(TimerWheel *wheel, uint64_t now_ms){
+    uint64_t target = now_ms / wheel->tick_ms;
+
+    for(;;){
+        TimerNode *head = &wheel->slots[0][wheel->current & TIMER_WHEEL_MASK];
+
+        while(head->next != head){
+            TimerNode *timer = head->next;
+            timer_unlink(timer);
+
+            // Deadline za rozsahem kola -> zpět na správné místo
+            if(timer->expires > wheel->current){
+                timer_wheel_place(wheel, timer);
+                continue;
+            }
+
+            timer->pending = 0;
+            wheel->count--;
+            return timer;
+        }
+
+        // Prázdné kolo lze posunout rovnou, jinak tick po ticku
+        if(wheel->current >= target){
+            return NULL;
+        }
+        if(wheel->count == 0){
+            wheel->current = target;
+            return NULL;
+        }
+        wheel->current++;
+
+        // Začátek bloku nižší úrovně -> kaskáda z vyšších úrovní
+        for(int level = 1; level < TIMER_WHEEL_LEVELS; level++){
+            int slot = (int)((wheel->current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+            if((wheel->current & ((1ULL << (TIMER_WHEEL_BITS * level)) - 1)) != 0){
+                break;
+            }
+            timer_wheel_cascade(wheel, level, slot);
+        }
+    }
+}
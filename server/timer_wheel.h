@@ -0,0 +1,85 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Počet bitů (a tedy 2^bitů slotů) jedné úrovně kola
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+// Počet úrovní (rozsah 64^4 ticků, delší deadliny se přeplánují při kaskádě)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct TimerNode TimerNode;
+
+/**
+ * Obsluha vypršeného časovače, volá ji ten, kdo časovač vyzvedl z kola
+ */
+typedef void (*TimerCallback)(TimerNode *timer);
+
+// Časovač vložený přímo do vlastníka (klient, hra), kolo nic nealokuje
+struct TimerNode{
+    TimerNode *next;                // Obousměrný kruhový seznam slotu
+    TimerNode *prev;
+    uint64_t expires;               // Deadline v tickách
+    int pending;                    // 1: časovač je naplánován v kole
+    TimerCallback callback;         // Obsluha
+    void *arg;                      // Vlastník časovače
+};
+
+// Hierarchické časové kolo (není vláknově bezpečné, zamyká vlastník kola)
+typedef struct{
+    TimerNode slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];    // Hlavy seznamů slotů
+    uint64_t current;               // Aktuální tick kola
+    uint32_t tick_ms;               // Délka ticku v ms
+    int count;                      // Počet naplánovaných časovačů
+} TimerWheel;
+
+/**
+ * @brief Monotónní čas v milisekundách
+ * @return ms od libovolného pevného bodu (neskáče se změnou systémového času)
+ */
+uint64_t timer_now_ms(void);
+
+/**
+ * @brief Inicializace prázdného kola
+ * @param wheel Kolo
+ * @param now_ms Aktuální monotónní čas
+ * @param tick_ms Délka ticku (rozlišení deadlinů)
+ */
+void timer_wheel_init(TimerWheel *wheel, uint64_t now_ms, uint32_t tick_ms);
+
+/**
+ * @brief Inicializace nenaplánovaného časovače (nulová struktura je také nenaplánovaná)
+ * @param timer Časovač
+ * @param callback Obsluha
+ * @param arg Vlastník časovače
+ */
+void timer_init(TimerNode *timer, TimerCallback callback, void *arg);
+
+/**
+ * @brief Naplánuje (nebo přeplánuje) časovač na deadline, nikdy nevyprší dřív
+ * @param wheel Kolo
+ * @param timer Časovač
+ * @param deadline_ms Monotónní deadline v ms
+ */
+void timer_schedule(TimerWheel *wheel, TimerNode *timer, uint64_t deadline_ms);
+
+/**
+ * @brief Zruší naplánovaný časovač (nenaplánovaný ignoruje)
+ * @param wheel Kolo
+ * @param timer Časovač
+ */
+void timer_cancel(TimerWheel *wheel, TimerNode *timer);
+
+/**
+ * @brief Posune kolo k now_ms a vyzvedne jeden vypršený časovač
+ *
+ * Vyzvednutý časovač už v kole není, obsluhu volá volající. Kolo se čte znovu při každém
+ * volání, obsluha tedy smí mezi voláními plánovat a rušit časovače (i dočasně odemknout).
+ * @param wheel Kolo
+ * @param now_ms Aktuální monotónní čas
+ * @return vypršený časovač, NULL: nic dalšího nevypršelo
+ */
+TimerNode *timer_wheel_expire(TimerWheel *wheel, uint64_t now_ms);
+
+#endif
@@ -0,0 +1,103 @@
+#include "trace.h"
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+TraceHeader *trace_map = NULL;
+static size_t trace_map_size = 0;
+static uint64_t trace_mask = 0;
+static __thread uint32_t trace_tid = 0;
+
+/**
+ * @brief Čas v nanosekundách
+ */
+static uint64_t trace_clock_ns(clockid_t clock){
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int trace_open(const char *path, size_t max_bytes){
+    if(!path || trace_map || max_bytes < sizeof(TraceHeader) + 2 * sizeof(TraceRecord)){
+        return -1;
+    }
+
+    // Největší mocnina dvou záznamů, která se vejde do limitu
+    uint64_t capacity = 1;
+    while(sizeof(TraceHeader) + capacity * 2 * sizeof(TraceRecord) <= max_bytes){
+        capacity *= 2;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        return -1;
+    }
+
+    size_t size = sizeof(TraceHeader) + capacity * sizeof(TraceRecord);
+    if(ftruncate(fd, (off_t)size) != 0){
+        close(fd);
+        return -1;
+    }
+
+    // Sdílené mapování: záznamy přežijí i pád procesu (zůstanou v page cache)
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        return -1;
+    }
+
+    // Předem zapsané stránky: první zápis záznamu nečeká na page fault (sdílené mapování hlídá první zápis)
+    memset(map, 0, size);
+
+    TraceHeader *header = map;
+    header->magic = TRACE_MAGIC;
+    header->version = TRACE_VERSION;
+    header->record_size = sizeof(TraceRecord);
+    header->capacity = capacity;
+    header->start_realtime_ns = trace_clock_ns(CLOCK_REALTIME);
+    header->start_monotonic_ns = trace_clock_ns(CLOCK_MONOTONIC);
+    atomic_init(&header->next, 0);
+
+    trace_map_size = size;
+    trace_mask = capacity - 1;
+    trace_map = header;
+    return 0;
+}
+
+void trace_close(void){
+    if(!trace_map){
+        return;
+    }
+
+    TraceHeader *header = trace_map;
+    trace_map = NULL;
+    msync(header, trace_map_size, MS_SYNC);
+    munmap(header, trace_map_size);
+}
+
+void trace_write(TraceEvent event, int client_index, int room_id, uint32_t a, uint32_t b, uint32_t c){
+    TraceHeader *header = trace_map;
+    if(!header){
+        return;
+    }
+    if(trace_tid == 0){
+        trace_tid = (uint32_t)syscall(SYS_gettid);
+    }
+
+    uint64_t pos = atomic_fetch_add_explicit(&header->next, 1, memory_order_relaxed);
+    TraceRecord *record = (TraceRecord*)(header + 1) + (pos & trace_mask);
+
+    // Přepisovaný slot nejdřív zneplatni, typ události (s TID) se zapíše až po datech
+    atomic_store_explicit((_Atomic uint32_t*)&record->thread_event, TRACE_NONE, memory_order_relaxed);
+    record->timestamp_ns = trace_clock_ns(CLOCK_MONOTONIC);
+    record->room_id = room_id;
+    record->client_index = client_index;
+    record->a = a;
+    record->b = b;
+    record->c = c;
+    atomic_store_explicit((_Atomic uint32_t*)&record->thread_event,
+                          ((uint32_t)event << TRACE_THREAD_BITS) | trace_record_thread(trace_tid), memory_order_release);
+}
@@ -0,0 +1,113 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "config.h"
+
+#define TRACE_MAGIC 0x4352545AU         // "ZTRC" (little endian)
+#define TRACE_VERSION 2
+
+// Seznam událostí: X(název, popis payloadu a, b, c), z něj výčet i názvy pro zolik_tracedump
+#define TRACE_EVENTS(X) \
+    X(MSG_IN,            "typ", "délka", "status") \
+    X(MSG_OUT,           "typ", "délka", "fd") \
+    X(INVALID_FRAME,     "kód", "fd", "-") \
+    X(CONNECT,           "fd", "-", "-") \
+    X(LOGIN,             "fd", "-", "-") \
+    X(RECONNECT,         "fd", "-", "-") \
+    X(DISCONNECT,        "fd", "-", "-") \
+    X(HEARTBEAT_TIMEOUT, "fd", "-", "-") \
+    X(ROOM_CREATE,       "-", "-", "-") \
+    X(ROOM_JOIN,         "hráčů", "-", "-") \
+    X(ROOM_LEAVE,        "hráčů", "-", "-") \
+    X(ROOM_DELETE,       "-", "-", "-") \
+    X(GAME_START,        "hráčů", "-", "-") \
+    X(MOVE,              "typ", "výsledek", "verze") \
+    X(OUT_DROP,          "typ", "délka", "fd")
+
+// Výčet událostí (0 je nezapsaný slot)
+typedef enum{
+    TRACE_NONE = 0,
+#define TRACE_ENUM_ENTRY(name, a, b, c) TRACE_##name,
+    TRACE_EVENTS(TRACE_ENUM_ENTRY)
+#undef TRACE_ENUM_ENTRY
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+// Záznam pevné délky (32 B, dva na cache line)
+typedef struct{
+    uint64_t timestamp_ns;              // CLOCK_MONOTONIC
+    uint32_t thread_event;              // TID vlákna (bity 0-23, pid_max <= 2^22) a TraceEvent (bity 24-31),
+                                        // zapisuje se poslední (událost 0: slot se ještě píše)
+    int32_t room_id;                    // -1: bez místnosti
+    int32_t client_index;               // -1: bez klienta
+    uint32_t a;                         // Payload podle TRACE_EVENTS
+    uint32_t b;
+    uint32_t c;
+} TraceRecord;
+
+#define TRACE_THREAD_BITS 24
+
+_Static_assert(sizeof(TraceRecord) == 32, "TraceRecord musí mít 32 B");
+_Static_assert(TRACE_EVENT_COUNT <= 256, "TraceEvent se nevejde do 8 bitů thread_event");
+
+/** Událost záznamu (TRACE_NONE: slot se ještě píše) */
+static inline TraceEvent trace_record_event(uint32_t thread_event){
+    return (TraceEvent)(thread_event >> TRACE_THREAD_BITS);
+}
+
+/** TID vlákna, které záznam zapsalo */
+static inline uint32_t trace_record_thread(uint32_t thread_event){
+    return thread_event & ((1U << TRACE_THREAD_BITS) - 1);
+}
+
+// Hlavička souboru, za ní capacity záznamů; soubor je kruh, přepisují se nejstarší záznamy
+typedef struct{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint64_t capacity;                  // Počet záznamů (mocnina dvou)
+    uint64_t start_realtime_ns;         // CLOCK_REALTIME při otevření (převod na čas)
+    uint64_t start_monotonic_ns;        // CLOCK_MONOTONIC při otevření
+    _Atomic uint64_t next;              // Celkový počet zapsaných záznamů (další pozice)
+    uint8_t reserved[CACHE_LINE_SIZE - 40];
+} TraceHeader;
+
+/** Namapovaný soubor, NULL: trasování vypnuté */
+extern TraceHeader *trace_map;
+
+/**
+ * @brief Vytvoří (přepíše) soubor trasování a namapuje ho do paměti
+ * @param path Cesta k souboru
+ * @param max_bytes Horní mez velikosti souboru (kapacita se zaokrouhlí dolů na mocninu dvou záznamů)
+ * @return 0: SUCCESS, -1: ERROR
+ */
+int trace_open(const char *path, size_t max_bytes);
+
+/**
+ * @brief Odmapuje a zavře soubor trasování
+ */
+void trace_close(void);
+
+/**
+ * @brief Zapíše záznam (bez zámku, jedno atomické přičtení), volat přes makro TRACE
+ */
+void trace_write(TraceEvent event, int client_index, int room_id, uint32_t a, uint32_t b, uint32_t c);
+
+/**
+ * @brief Typ zprávy jako payload (4 znaky do uint32, čitelné dekodérem)
+ */
+static inline uint32_t trace_fourcc(const char *type_msg){
+    return (uint32_t)(unsigned char)type_msg[0] | ((uint32_t)(unsigned char)type_msg[1] << 8) |
+           ((uint32_t)(unsigned char)type_msg[2] << 16) | ((uint32_t)(unsigned char)type_msg[3] << 24);
+}
+
+/* Při vypnutém trasování jen jedno porovnání ukazatele */
+#define TRACE(event, client_index, room_id, a, b, c) do { \
+    if (trace_map) \
+        trace_write(TRACE_##event, (client_index), (room_id), (uint32_t)(a), (uint32_t)(b), (uint32_t)(c)); \
+} while (0)
+
+#endif